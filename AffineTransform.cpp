@@ -0,0 +1,60 @@
+#include "AffineTransform.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace plotter
+{
+
+AffineTransform AffineTransform::Translation(const double dx, const double dy)
+{
+    return { 1.0, 0.0, dx, 0.0, 1.0, dy };
+}
+
+AffineTransform AffineTransform::Scaling(const double scale_x, const double scale_y,
+    const double center_x, const double center_y)
+{
+    return { scale_x, 0.0, center_x * (1.0 - scale_x), 0.0, scale_y, center_y * (1.0 - scale_y) };
+}
+
+AffineTransform AffineTransform::Rotation(const double angle, const double center_x, const double center_y)
+{
+    const double cos = std::cos(angle);
+    const double sin = std::sin(angle);
+    return {
+        cos, -sin, center_x - cos * center_x + sin * center_y,
+        sin, cos, center_y - sin * center_x - cos * center_y,
+    };
+}
+
+AffineTransform AffineTransform::Shear(const double shear_x, const double shear_y)
+{
+    return { 1.0, shear_x, 0.0, shear_y, 1.0, 0.0 };
+}
+
+AffineTransform AffineTransform::operator*(const AffineTransform& other) const noexcept
+{
+    return {
+        xx * other.xx + xy * other.yx, xx * other.xy + xy * other.yy, xx * other.tx + xy * other.ty + tx,
+        yx * other.xx + yy * other.yx, yx * other.xy + yy * other.yy, yx * other.tx + yy * other.ty + ty,
+    };
+}
+
+AffineTransform AffineTransform::Inverse() const
+{
+    const double determinant = xx * yy - xy * yx;
+    if (determinant == 0.0 || !std::isfinite(determinant))
+    {
+        throw std::invalid_argument("Affine transform is not invertible");
+    }
+
+    const double inverse_xx = yy / determinant;
+    const double inverse_xy = -xy / determinant;
+    const double inverse_yx = -yx / determinant;
+    const double inverse_yy = xx / determinant;
+    return {
+        inverse_xx, inverse_xy, -(inverse_xx * tx + inverse_xy * ty),
+        inverse_yx, inverse_yy, -(inverse_yx * tx + inverse_yy * ty),
+    };
+}
+
+} // namespace plotter
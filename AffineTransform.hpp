@@ -0,0 +1,34 @@
+#pragma once
+
+namespace plotter
+{
+
+// Аффинное преобразование плоскости канваса: (x, y) -> (xx * x + xy * y + tx, yx * x + yy * y + ty).
+// Ось y направлена вниз, пиксель (x, y) занимает квадрат [x, x + 1) x [y, y + 1)
+struct AffineTransform
+{
+    double xx = 1.0;
+    double xy = 0.0;
+    double tx = 0.0;
+    double yx = 0.0;
+    double yy = 1.0;
+    double ty = 0.0;
+
+    static AffineTransform Translation(double dx, double dy);
+    // Масштаб относительно точки (center_x, center_y)
+    static AffineTransform Scaling(double scale_x, double scale_y, double center_x = 0.0, double center_y = 0.0);
+    // Поворот на angle радиан вокруг (center_x, center_y), положительный угол — по часовой стрелке на экране
+    static AffineTransform Rotation(double angle, double center_x = 0.0, double center_y = 0.0);
+    // Сдвиг: x += shear_x * y, y += shear_y * x
+    static AffineTransform Shear(double shear_x, double shear_y);
+
+    // Композиция: сначала other, затем *this
+    AffineTransform operator*(const AffineTransform& other) const noexcept;
+    // Бросает std::invalid_argument, если преобразование вырождено
+    [[nodiscard]] AffineTransform Inverse() const;
+
+    [[nodiscard]] double MapX(const double x, const double y) const noexcept { return xx * x + xy * y + tx; }
+    [[nodiscard]] double MapY(const double x, const double y) const noexcept { return yx * x + yy * y + ty; }
+};
+
+} // namespace plotter
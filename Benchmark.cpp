@@ -0,0 +1,151 @@
+#include "Benchmark.hpp"
+#include "json.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace bench
+{
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Nanoseconds = std::chrono::duration<double, std::nano>;
+
+    json::Node ToNode(const BenchmarkResult& result)
+    {
+        json::Dict params;
+        for (const auto& [key, value] : result.params)
+        {
+            params.emplace(key, value);
+        }
+        json::Array samples(result.samples_ns.begin(), result.samples_ns.end());
+
+        return json::Dict{
+            { "id", result.Id() },
+            { "name", result.name },
+            { "params", std::move(params) },
+            { "unit", result.unit },
+            { "items_per_iteration", result.items_per_iteration },
+            { "warmup_iterations", static_cast<double>(result.warmup_iterations) },
+            { "warmup_ms", result.warmup_ms },
+            { "iterations_per_sample", static_cast<double>(result.iterations_per_sample) },
+            { "median_ns", result.median_ns },
+            { "p99_ns", result.p99_ns },
+            { "mean_ns", result.mean_ns },
+            { "min_ns", result.min_ns },
+            { "max_ns", result.max_ns },
+            { "throughput", result.throughput },
+            { "samples_ns", std::move(samples) },
+        };
+    }
+} // anonymous namespace
+
+std::string BenchmarkResult::Id() const
+{
+    std::string id = name;
+    for (const auto& [key, value] : params)
+    {
+        id += '/' + key + '=' + value;
+    }
+    return id;
+}
+
+BenchmarkSuite::BenchmarkSuite(std::string name, BenchmarkOptions options)
+    : name_(std::move(name))
+    , options_(options)
+{
+}
+
+bool BenchmarkSuite::Run(const std::string& name, const Params& params, const std::string& unit,
+    const double items_per_iteration, const std::function<void()>& body)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.params = params;
+    result.unit = unit;
+    result.items_per_iteration = items_per_iteration;
+    if (!filter_.empty() && result.Id().find(filter_) == std::string::npos)
+    {
+        return false;
+    }
+
+    // Прогрев заодно оценивает время одного выполнения для подбора числа повторов в замере
+    const auto warmup_start = Clock::now();
+    Nanoseconds warmup_time{};
+    do
+    {
+        body();
+        ++result.warmup_iterations;
+        warmup_time = Clock::now() - warmup_start;
+    } while (warmup_time < options_.warmup_time);
+    result.warmup_ms = warmup_time.count() / 1e6;
+
+    const double iteration_ns = warmup_time.count() / static_cast<double>(result.warmup_iterations);
+    const double sample_ns = Nanoseconds(options_.min_sample_time).count();
+    result.iterations_per_sample = std::max(1LL, static_cast<long long>(std::ceil(sample_ns / iteration_ns)));
+
+    result.samples_ns.reserve(options_.samples);
+    for (int sample = 0; sample < options_.samples; ++sample)
+    {
+        const auto start = Clock::now();
+        for (long long i = 0; i < result.iterations_per_sample; ++i)
+        {
+            body();
+        }
+        const Nanoseconds elapsed = Clock::now() - start;
+        result.samples_ns.push_back(elapsed.count() / static_cast<double>(result.iterations_per_sample));
+    }
+
+    std::vector<double> sorted = result.samples_ns;
+    std::sort(sorted.begin(), sorted.end());
+    result.median_ns = Percentile(sorted, 50.0);
+    result.p99_ns = Percentile(sorted, 99.0);
+    result.mean_ns = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+    result.min_ns = sorted.front();
+    result.max_ns = sorted.back();
+    result.throughput = result.median_ns > 0.0 ? items_per_iteration * 1e9 / result.median_ns : 0.0;
+
+    if (progress_ != nullptr)
+    {
+        *progress_ << result.Id() << ": median " << result.median_ns / 1e3 << " us, p99 " << result.p99_ns / 1e3
+                   << " us, " << result.throughput / 1e6 << " M" << result.unit << "/s" << std::endl;
+    }
+    results_.push_back(std::move(result));
+    return true;
+}
+
+void BenchmarkSuite::WriteJson(std::ostream& os) const
+{
+    json::Array benchmarks;
+    benchmarks.reserve(results_.size());
+    for (const BenchmarkResult& result : results_)
+    {
+        benchmarks.push_back(ToNode(result));
+    }
+
+    const json::Dict options{
+        { "warmup_ms", static_cast<int>(options_.warmup_time.count()) },
+        { "samples", options_.samples },
+        { "min_sample_ms", static_cast<int>(options_.min_sample_time.count()) },
+    };
+    json::Print(json::Document(json::Dict{
+                    { "suite", name_ },
+                    { "options", options },
+                    { "benchmarks", std::move(benchmarks) },
+                }),
+        os);
+    os << '\n';
+}
+
+double Percentile(const std::vector<double>& sorted, const double percent)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const auto rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace bench
@@ -0,0 +1,91 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+
+// Не дает компилятору выбросить вычисление, результат которого больше нигде не используется
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Параметры замера одного бенчмарка, названия и значения, как они попадут в отчет
+using Params = std::vector<std::pair<std::string, std::string>>;
+
+struct BenchmarkOptions
+{
+    // Прогрев перед замерами: тело выполняется не меньше warmup_time и не меньше одного раза
+    std::chrono::milliseconds warmup_time{ 50 };
+    // Число замеров, по которым считаются медиана и p99
+    int samples = 30;
+    // Замер повторяет тело столько раз, чтобы длиться не меньше min_sample_time
+    std::chrono::milliseconds min_sample_time{ 5 };
+};
+
+// Результат бенчмарка. Времена — наносекунды на одно выполнение тела
+struct BenchmarkResult
+{
+    std::string name;
+    Params params;
+    // Что обрабатывает одно выполнение тела и сколько: "pixels", "bytes", "commands"
+    std::string unit;
+    double items_per_iteration = 0.0;
+
+    long long warmup_iterations = 0;
+    double warmup_ms = 0.0;
+    long long iterations_per_sample = 0;
+    std::vector<double> samples_ns;
+
+    double median_ns = 0.0;
+    double p99_ns = 0.0;
+    double mean_ns = 0.0;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+    // Единиц unit в секунду по медиане
+    double throughput = 0.0;
+
+    // Имя с параметрами: "name/key=value/...", по нему сравниваются прогоны
+    [[nodiscard]] std::string Id() const;
+};
+
+// Набор микробенчмарков. Каждый бенчмарк прогревается, подбирает число повторов на замер
+// и делает options.samples замеров; статистика считается по времени одного выполнения.
+// Тело должно само возвращать данные в исходное состояние, если меняет их
+class BenchmarkSuite
+{
+public:
+    explicit BenchmarkSuite(std::string name, BenchmarkOptions options = {});
+
+    // Бенчмарки, в Id которых нет filter, пропускаются. Пустой filter — выполняются все
+    void SetFilter(std::string filter) { filter_ = std::move(filter); }
+    // Печатает строку о каждом бенчмарке по мере выполнения
+    void SetProgress(std::ostream* progress) noexcept { progress_ = progress; }
+
+    // Возвращает false, если бенчмарк пропущен фильтром
+    bool Run(const std::string& name, const Params& params, const std::string& unit, double items_per_iteration,
+        const std::function<void()>& body);
+
+    [[nodiscard]] const std::vector<BenchmarkResult>& Results() const noexcept { return results_; }
+
+    // Отчет JSON: {"suite", "options", "benchmarks": [...]} с полями BenchmarkResult и всеми замерами
+    void WriteJson(std::ostream& os) const;
+
+private:
+    std::string name_;
+    BenchmarkOptions options_;
+    std::string filter_;
+    std::ostream* progress_ = nullptr;
+    std::vector<BenchmarkResult> results_;
+};
+
+// Перцентиль percent (0..100) отсортированных значений по ближайшему рангу
+double Percentile(const std::vector<double>& sorted, double percent);
+
+} // namespace bench
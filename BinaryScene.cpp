@@ -0,0 +1,316 @@
+#include "BinaryScene.hpp"
+#include "PlotterFactory.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::array<char, 8> MAGIC = { 'P', 'L', 'T', 'S', 'C', 'E', 'N', 'E' };
+
+    // Смещения полей заголовка
+    constexpr size_t VERSION_OFFSET = 8;
+    constexpr size_t RECORD_SIZE_OFFSET = 12;
+    constexpr size_t WIDTH_OFFSET = 16;
+    constexpr size_t HEIGHT_OFFSET = 20;
+    constexpr size_t THREADS_OFFSET = 24;
+    constexpr size_t BACKGROUND_OFFSET = 28;
+    constexpr size_t PLOTTER_TYPE_OFFSET = 29;
+    constexpr size_t PALETTE_SIZE_OFFSET = 30;
+    constexpr size_t COMMAND_COUNT_OFFSET = 32;
+    constexpr size_t COMMANDS_OFFSET = 40;
+    constexpr size_t INDEX_COUNT_OFFSET = 48;
+    constexpr size_t INDEX_OFFSET = 56;
+    constexpr size_t PALETTE_OFFSET = 64;
+
+    // Смещения полей записи команды
+    constexpr size_t OP_OFFSET = 0;
+    constexpr size_t FILTER_OFFSET = 1;
+    constexpr size_t FLAGS_OFFSET = 2;
+    constexpr size_t BRUSH_OFFSET = 3;
+    constexpr size_t DITHER_OFFSET = 4;
+    constexpr size_t ARGS_OFFSET = 8;
+    constexpr size_t VALUES_OFFSET = 32;
+
+    constexpr std::uint8_t USES_BRIGHTNESS_FLAG = 1;
+    constexpr std::uint8_t FILL_FLAG = 2;
+
+    constexpr std::uint8_t OP_COUNT = static_cast<std::uint8_t>(plotter::SceneOp::Filter) + 1;
+    constexpr std::uint8_t FILTER_COUNT = static_cast<std::uint8_t>(plotter::SceneFilter::AutoContrast) + 1;
+    constexpr std::uint8_t DITHER_COUNT = static_cast<std::uint8_t>(plotter::Dither::Atkinson) + 1;
+
+    static_assert(PALETTE_OFFSET + plotter::BinaryScene::MAX_PALETTE_SIZE == plotter::BinaryScene::HEADER_SIZE);
+    static_assert(VALUES_OFFSET + 2 * sizeof(double) == plotter::BinaryScene::RECORD_SIZE);
+
+    // Сдвиги вместо memcpy в структуру: формат не зависит от порядка байт машины,
+    // а на little-endian компилятор сводит их к одной загрузке
+    template <typename T>
+    T LoadLe(const unsigned char* data) noexcept
+    {
+        std::uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+        }
+        return static_cast<T>(value);
+    }
+
+    template <typename T>
+    void StoreLe(unsigned char* data, const T value) noexcept
+    {
+        const auto bits = static_cast<std::uint64_t>(value);
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            data[i] = static_cast<unsigned char>(bits >> (8 * i));
+        }
+    }
+
+    void EncodeCommand(const plotter::SceneCommand& command, unsigned char* record)
+    {
+        std::fill_n(record, plotter::BinaryScene::RECORD_SIZE, 0);
+        record[OP_OFFSET] = static_cast<std::uint8_t>(command.op);
+        record[FILTER_OFFSET] = static_cast<std::uint8_t>(command.filter);
+        record[FLAGS_OFFSET] = (command.uses_brightness ? USES_BRIGHTNESS_FLAG : 0) | (command.fill ? FILL_FLAG : 0);
+        record[BRUSH_OFFSET] = static_cast<unsigned char>(command.brush);
+        record[DITHER_OFFSET] = static_cast<std::uint8_t>(command.dither);
+        for (size_t i = 0; i < command.args.size(); ++i)
+        {
+            StoreLe(record + ARGS_OFFSET + 4 * i, static_cast<std::uint32_t>(command.args[i]));
+        }
+        for (size_t i = 0; i < command.values.size(); ++i)
+        {
+            StoreLe(record + VALUES_OFFSET + 8 * i, std::bit_cast<std::uint64_t>(command.values[i]));
+        }
+    }
+
+    plotter::SceneCommand DecodeCommand(const unsigned char* record, const size_t index)
+    {
+        const std::uint8_t flags = record[FLAGS_OFFSET];
+        if (record[OP_OFFSET] >= OP_COUNT || record[FILTER_OFFSET] >= FILTER_COUNT
+            || record[DITHER_OFFSET] >= DITHER_COUNT || (flags & ~(USES_BRIGHTNESS_FLAG | FILL_FLAG)) != 0)
+        {
+            throw plotter::BinarySceneError("Corrupted scene command " + std::to_string(index));
+        }
+
+        plotter::SceneCommand command;
+        command.op = static_cast<plotter::SceneOp>(record[OP_OFFSET]);
+        command.filter = static_cast<plotter::SceneFilter>(record[FILTER_OFFSET]);
+        command.uses_brightness = (flags & USES_BRIGHTNESS_FLAG) != 0;
+        command.fill = (flags & FILL_FLAG) != 0;
+        command.brush = static_cast<char>(record[BRUSH_OFFSET]);
+        command.dither = static_cast<plotter::Dither>(record[DITHER_OFFSET]);
+        for (size_t i = 0; i < command.args.size(); ++i)
+        {
+            command.args[i] = static_cast<int>(LoadLe<std::uint32_t>(record + ARGS_OFFSET + 4 * i));
+        }
+        for (size_t i = 0; i < command.values.size(); ++i)
+        {
+            command.values[i] = std::bit_cast<double>(LoadLe<std::uint64_t>(record + VALUES_OFFSET + 8 * i));
+        }
+        return command;
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+void BinaryScene::Compile(const std::string_view scene_text, std::ostream& out)
+{
+    const std::streampos start = out.tellp();
+    std::array<unsigned char, HEADER_SIZE> header{};
+    out.write(reinterpret_cast<const char*>(header.data()), HEADER_SIZE);
+
+    PlotterConfig config;
+    std::vector<std::uint64_t> clears;
+    std::array<unsigned char, RECORD_SIZE> record{};
+    std::uint64_t count = 0;
+    Scene::Read(scene_text,
+        [&config](const PlotterConfig& scene_config)
+        {
+            if (!Config::ValidateConfig(scene_config))
+            {
+                throw SceneError("Scene config is invalid");
+            }
+            if (scene_config.palette.size() > MAX_PALETTE_SIZE)
+            {
+                throw BinarySceneError("Palette is too long for a binary scene");
+            }
+            config = scene_config;
+        },
+        [&](const SceneCommand& command)
+        {
+            if (command.op == SceneOp::Clear)
+            {
+                clears.push_back(count);
+            }
+            EncodeCommand(command, record.data());
+            out.write(reinterpret_cast<const char*>(record.data()), RECORD_SIZE);
+            ++count;
+        });
+
+    std::array<unsigned char, INDEX_ENTRY_SIZE> entry{};
+    for (const std::uint64_t clear : clears)
+    {
+        StoreLe(entry.data(), clear);
+        out.write(reinterpret_cast<const char*>(entry.data()), INDEX_ENTRY_SIZE);
+    }
+
+    std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+    StoreLe(header.data() + VERSION_OFFSET, VERSION);
+    StoreLe(header.data() + RECORD_SIZE_OFFSET, static_cast<std::uint32_t>(RECORD_SIZE));
+    StoreLe(header.data() + WIDTH_OFFSET, static_cast<std::uint32_t>(config.width));
+    StoreLe(header.data() + HEIGHT_OFFSET, static_cast<std::uint32_t>(config.height));
+    StoreLe(header.data() + THREADS_OFFSET, static_cast<std::uint32_t>(config.threads));
+    header[BACKGROUND_OFFSET] = static_cast<unsigned char>(config.background_char);
+    header[PLOTTER_TYPE_OFFSET] = config.plotter_type == "grayscale" ? 1 : 0;
+    StoreLe(header.data() + PALETTE_SIZE_OFFSET, static_cast<std::uint16_t>(config.palette.size()));
+    StoreLe(header.data() + COMMAND_COUNT_OFFSET, count);
+    StoreLe(header.data() + COMMANDS_OFFSET, static_cast<std::uint64_t>(HEADER_SIZE));
+    StoreLe(header.data() + INDEX_COUNT_OFFSET, static_cast<std::uint64_t>(clears.size()));
+    StoreLe(header.data() + INDEX_OFFSET, static_cast<std::uint64_t>(HEADER_SIZE + count * RECORD_SIZE));
+    std::copy(config.palette.begin(), config.palette.end(), header.begin() + PALETTE_OFFSET);
+
+    const std::streampos end = out.tellp();
+    out.seekp(start);
+    out.write(reinterpret_cast<const char*>(header.data()), HEADER_SIZE);
+    out.seekp(end);
+    if (!out)
+    {
+        throw std::runtime_error("Failed to write binary scene");
+    }
+}
+
+void BinaryScene::CompileFile(const std::filesystem::path& scene_path, const std::filesystem::path& binary_path)
+{
+    const MappedFile scene(scene_path);
+    scene.AdviseSequential();
+    std::ofstream out(binary_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Failed to open file '" + binary_path.string() + "'");
+    }
+    Compile(scene.View(), out);
+}
+
+BinaryScene::BinaryScene(const std::filesystem::path& path)
+    : file_(path)
+{
+    const unsigned char* const data = file_.Data();
+    const size_t size = file_.Size();
+    if (size < HEADER_SIZE || !std::equal(MAGIC.begin(), MAGIC.end(), reinterpret_cast<const char*>(data)))
+    {
+        throw BinarySceneError("'" + path.string() + "' is not a binary scene");
+    }
+    if (LoadLe<std::uint32_t>(data + VERSION_OFFSET) != VERSION
+        || LoadLe<std::uint32_t>(data + RECORD_SIZE_OFFSET) != RECORD_SIZE)
+    {
+        throw BinarySceneError("Unsupported binary scene version");
+    }
+
+    // Разделы проверяются делением, чтобы большие счетчики не переполняли произведение
+    const auto section = [&](const size_t offset_field, const size_t count_field, const size_t entry_size,
+                             size_t& count)
+    {
+        const auto offset = LoadLe<std::uint64_t>(data + offset_field);
+        const auto entries = LoadLe<std::uint64_t>(data + count_field);
+        if (offset < HEADER_SIZE || offset > size || entries > (size - offset) / entry_size)
+        {
+            throw BinarySceneError("Binary scene is truncated");
+        }
+        count = static_cast<size_t>(entries);
+        return data + offset;
+    };
+    commands_ = section(COMMANDS_OFFSET, COMMAND_COUNT_OFFSET, RECORD_SIZE, command_count_);
+    index_ = section(INDEX_OFFSET, INDEX_COUNT_OFFSET, INDEX_ENTRY_SIZE, index_count_);
+    for (size_t i = 0; i < index_count_; ++i)
+    {
+        const auto clear = LoadLe<std::uint64_t>(index_ + i * INDEX_ENTRY_SIZE);
+        if (clear >= command_count_ || (i > 0 && clear <= LoadLe<std::uint64_t>(index_ + (i - 1) * INDEX_ENTRY_SIZE)))
+        {
+            throw BinarySceneError("Corrupted binary scene index");
+        }
+    }
+
+    const auto palette_size = LoadLe<std::uint16_t>(data + PALETTE_SIZE_OFFSET);
+    if (palette_size > MAX_PALETTE_SIZE || data[PLOTTER_TYPE_OFFSET] > 1)
+    {
+        throw BinarySceneError("Corrupted binary scene header");
+    }
+    config_.width = static_cast<int>(LoadLe<std::uint32_t>(data + WIDTH_OFFSET));
+    config_.height = static_cast<int>(LoadLe<std::uint32_t>(data + HEIGHT_OFFSET));
+    config_.threads = static_cast<int>(LoadLe<std::uint32_t>(data + THREADS_OFFSET));
+    config_.background_char = static_cast<char>(data[BACKGROUND_OFFSET]);
+    config_.plotter_type = data[PLOTTER_TYPE_OFFSET] == 1 ? "grayscale" : "basic";
+    config_.palette.assign(data + PALETTE_OFFSET, data + PALETTE_OFFSET + palette_size);
+    if (!Config::ValidateConfig(config_))
+    {
+        throw BinarySceneError("Binary scene config is invalid");
+    }
+}
+
+SceneCommand BinaryScene::Command(const size_t index) const
+{
+    if (index >= command_count_)
+    {
+        throw std::out_of_range("Scene command index out of range");
+    }
+    return DecodeCommand(commands_ + index * RECORD_SIZE, index);
+}
+
+std::unique_ptr<Plotter> BinaryScene::CreatePlotter() const
+{
+    return PlotterFactory::CreatePlotter(config_);
+}
+
+void BinaryScene::Execute(Plotter& plotter) const
+{
+    ExecuteRange(plotter, 0, command_count_);
+}
+
+void BinaryScene::ExecuteUntil(Plotter& plotter, const size_t end) const
+{
+    if (end > command_count_)
+    {
+        throw std::out_of_range("Scene command index out of range");
+    }
+
+    // Последняя команда "clear" среди первых end команд
+    size_t low = 0;
+    size_t high = index_count_;
+    while (low < high)
+    {
+        const size_t middle = low + (high - low) / 2;
+        if (LoadLe<std::uint64_t>(index_ + middle * INDEX_ENTRY_SIZE) < end)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    const size_t begin = low == 0 ? 0 : static_cast<size_t>(LoadLe<std::uint64_t>(index_ + (low - 1) * INDEX_ENTRY_SIZE));
+    ExecuteRange(plotter, begin, end);
+}
+
+void BinaryScene::ExecuteRange(Plotter& plotter, const size_t begin, const size_t end) const
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const SceneCommand command = DecodeCommand(commands_ + i * RECORD_SIZE, i);
+        try
+        {
+            Scene::ExecuteCommand(command, plotter);
+        }
+        catch (const SceneError& e)
+        {
+            throw SceneError("Scene command " + std::to_string(i) + ": " + e.what());
+        }
+    }
+}
+
+} // namespace plotter
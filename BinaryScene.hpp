@@ -0,0 +1,74 @@
+#pragma once
+#include "Config.hpp"
+#include "MappedFile.hpp"
+#include "Scene.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace plotter
+{
+
+// Файл двоичной сцены поврежден или несовместим
+class BinarySceneError : public std::runtime_error
+{
+public:
+    using runtime_error::runtime_error;
+};
+
+// Двоичная сцена: те же команды, что у Scene, записанные записями фиксированного размера
+// в little-endian. Файл отображается в память и исполняется прямо из отображения без разбора текста.
+//
+// Раскладка файла:
+//   заголовок HEADER_SIZE байт — сигнатура, версия, размер записи, параметры PlotterConfig,
+//     число и смещения команд и индекса, палитра;
+//   команды — command_count записей по RECORD_SIZE байт;
+//   индекс — номера команд "clear" по возрастанию, по 8 байт. После "clear" канвас не зависит
+//     от предыдущих команд, поэтому ExecuteUntil начинает с последней такой команды
+class BinaryScene
+{
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 320;
+    static constexpr size_t RECORD_SIZE = 48;
+    static constexpr size_t INDEX_ENTRY_SIZE = 8;
+    static constexpr size_t MAX_PALETTE_SIZE = 256;
+
+    // Переводит текстовую сцену в двоичную потоком, команды не накапливаются в памяти.
+    // out должен поддерживать seekp: заголовок дописывается в конце. Бросает SceneError
+    // и json::ParsingError, как Scene, и BinarySceneError, если палитра длиннее MAX_PALETTE_SIZE
+    static void Compile(std::string_view scene_text, std::ostream& out);
+    static void CompileFile(const std::filesystem::path& scene_path, const std::filesystem::path& binary_path);
+
+    // Отображает файл и проверяет заголовок и размеры разделов. Бросает BinarySceneError
+    explicit BinaryScene(const std::filesystem::path& path);
+
+    [[nodiscard]] const PlotterConfig& GetConfig() const noexcept { return config_; }
+    [[nodiscard]] size_t CommandCount() const noexcept { return command_count_; }
+    [[nodiscard]] SceneCommand Command(size_t index) const;
+
+    // Plotter по конфигу сцены через PlotterFactory, команды не исполняются
+    [[nodiscard]] std::unique_ptr<Plotter> CreatePlotter() const;
+    // Исполняет все команды
+    void Execute(Plotter& plotter) const;
+    // Приводит канвас к состоянию после первых end команд: если среди них есть "clear",
+    // исполнение начинается с последнего из них по индексу. Иначе plotter должен быть
+    // в начальном состоянии, как после CreatePlotter
+    void ExecuteUntil(Plotter& plotter, size_t end) const;
+
+private:
+    MappedFile file_;
+    PlotterConfig config_;
+    const unsigned char* commands_ = nullptr;
+    size_t command_count_ = 0;
+    const unsigned char* index_ = nullptr;
+    size_t index_count_ = 0;
+
+    void ExecuteRange(Plotter& plotter, size_t begin, size_t end) const;
+};
+
+} // namespace plotter
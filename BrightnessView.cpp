@@ -0,0 +1,124 @@
+#include "BrightnessView.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    constexpr double MAX_LEVEL = 255.0;
+} // anonymous namespace
+
+namespace plotter
+{
+
+BrightnessView::BrightnessView(const char* symbols, const int width, const int height, const size_t stride,
+    const std::array<double, 256>* char_to_brightness) noexcept
+    : symbols_(symbols)
+    , char_to_brightness_(char_to_brightness)
+    , width_(width)
+    , height_(height)
+    , stride_(stride)
+{
+}
+
+BrightnessView::BrightnessView(const std::uint8_t* levels, const int width, const int height, const size_t stride) noexcept
+    : levels_(levels)
+    , width_(width)
+    , height_(height)
+    , stride_(stride)
+{
+}
+
+double BrightnessView::operator()(const int x, const int y) const noexcept
+{
+    if (levels_)
+    {
+        return levels_[Offset(x, y)] / MAX_LEVEL;
+    }
+    return (*char_to_brightness_)[static_cast<unsigned char>(symbols_[Offset(x, y)])];
+}
+
+double BrightnessView::at(const int x, const int y) const
+{
+    if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    {
+        throw std::out_of_range("Brightness view index is out of range");
+    }
+    return (*this)(x, y);
+}
+
+BrightnessView BrightnessView::Subview(const int x, const int y, const int width, const int height) const
+{
+    if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > width_ || y + height > height_)
+    {
+        throw std::out_of_range("Subview is out of range");
+    }
+
+    if (levels_)
+    {
+        return { levels_ + Offset(x, y), width, height, stride_ };
+    }
+    return { symbols_ + Offset(x, y), width, height, stride_, char_to_brightness_ };
+}
+
+void BrightnessView::ExportTo(float* const dst, const size_t dst_stride) const
+{
+    // Таблица на стеке, чтобы во внутреннем цикле не было преобразования double -> float
+    std::array<float, 256> table{};
+    for (size_t code = 0; code < table.size(); ++code)
+    {
+        table[code] = levels_ ? static_cast<float>(code / MAX_LEVEL) : static_cast<float>((*char_to_brightness_)[code]);
+    }
+
+    for (int y = 0; y < height_; ++y)
+    {
+        float* const dst_row = dst + static_cast<size_t>(y) * dst_stride;
+        if (levels_)
+        {
+            const std::uint8_t* const row = levels_ + Offset(0, y);
+            for (int x = 0; x < width_; ++x)
+            {
+                dst_row[x] = table[row[x]];
+            }
+        }
+        else
+        {
+            const char* const row = symbols_ + Offset(0, y);
+            for (int x = 0; x < width_; ++x)
+            {
+                dst_row[x] = table[static_cast<unsigned char>(row[x])];
+            }
+        }
+    }
+}
+
+void BrightnessView::ExportTo(std::uint8_t* const dst, const size_t dst_stride) const
+{
+    std::array<std::uint8_t, 256> table{};
+    for (size_t code = 0; code < table.size(); ++code)
+    {
+        table[code] = levels_
+            ? static_cast<std::uint8_t>(code)
+            : static_cast<std::uint8_t>(std::lround((*char_to_brightness_)[code] * MAX_LEVEL));
+    }
+
+    for (int y = 0; y < height_; ++y)
+    {
+        std::uint8_t* const dst_row = dst + static_cast<size_t>(y) * dst_stride;
+        if (levels_)
+        {
+            const std::uint8_t* const row = levels_ + Offset(0, y);
+            std::copy(row, row + width_, dst_row);
+        }
+        else
+        {
+            const char* const row = symbols_ + Offset(0, y);
+            for (int x = 0; x < width_; ++x)
+            {
+                dst_row[x] = table[static_cast<unsigned char>(row[x])];
+            }
+        }
+    }
+}
+
+} // namespace plotter
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace plotter
+{
+
+// Невладеющее двумерное представление яркости канваса без копирования.
+// Пиксель (x, y) лежит по смещению y * Stride() + x. Яркость вычисляется при обращении:
+// либо по коду символа через таблицу плоттера, либо из 8-битного слоя яркости.
+// Представление действительно, пока канвас, палитра и слой яркости плоттера не меняются.
+class BrightnessView
+{
+public:
+    // Символы канваса и таблица яркости по коду символа
+    BrightnessView(const char* symbols, int width, int height, size_t stride,
+        const std::array<double, 256>* char_to_brightness) noexcept;
+    // 8-битный слой яркости, яркость = уровень / 255
+    BrightnessView(const std::uint8_t* levels, int width, int height, size_t stride) noexcept;
+
+    [[nodiscard]] int Width() const noexcept { return width_; }
+    [[nodiscard]] int Height() const noexcept { return height_; }
+    [[nodiscard]] size_t Stride() const noexcept { return stride_; }
+    [[nodiscard]] bool IsLevelView() const noexcept { return levels_ != nullptr; }
+
+    // Без проверки границ
+    [[nodiscard]] double operator()(int x, int y) const noexcept;
+    // С проверкой границ
+    [[nodiscard]] double at(int x, int y) const;
+
+    // Прямоугольная часть [x, x + width) x [y, y + height) того же буфера
+    [[nodiscard]] BrightnessView Subview(int x, int y, int width, int height) const;
+
+    // Копирует яркость в буфер вызывающего, dst_stride — шаг строки в элементах.
+    // uint8 получает округленную яркость * 255
+    void ExportTo(float* dst, size_t dst_stride) const;
+    void ExportTo(std::uint8_t* dst, size_t dst_stride) const;
+
+private:
+    const char* symbols_ = nullptr;
+    const std::array<double, 256>* char_to_brightness_ = nullptr;
+    const std::uint8_t* levels_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    size_t stride_ = 0;
+
+    [[nodiscard]] size_t Offset(int x, int y) const noexcept { return static_cast<size_t>(y) * stride_ + x; }
+};
+
+} // namespace plotter
@@ -1,17 +1,116 @@
 #include "Canvas.hpp"
 #include "CanvasIterators.hpp"
+#include "Profiling.hpp"
 #include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <fstream>
 #include <limits>
 #include <stdexcept>
+#include <string_view>
 #include <utility>
 
+namespace
+{
+    using plotter::CellColors;
+    using plotter::Color;
+
+    constexpr std::string_view ANSI_RESET = "\x1b[0m";
+
+    void AppendNumber(std::string& out, const unsigned value)
+    {
+        char digits[4];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // Параметры SGR цвета: base 30 для символа, 40 для фона.
+    // Первые 16 цветов палитры имеют короткие коды
+    void AppendColor(std::string& out, const Color color, const unsigned base)
+    {
+        switch (color.GetKind())
+        {
+        case Color::Kind::Default:
+            AppendNumber(out, base + 9);
+            break;
+        case Color::Kind::Indexed:
+            if (color.Index() < 8)
+            {
+                AppendNumber(out, base + color.Index());
+            }
+            else if (color.Index() < 16)
+            {
+                AppendNumber(out, base + 60 + color.Index() - 8);
+            }
+            else
+            {
+                AppendNumber(out, base + 8);
+                out += ";5;";
+                AppendNumber(out, color.Index());
+            }
+            break;
+        case Color::Kind::Rgb:
+            AppendNumber(out, base + 8);
+            out += ";2;";
+            AppendNumber(out, color.Red());
+            out += ';';
+            AppendNumber(out, color.Green());
+            out += ';';
+            AppendNumber(out, color.Blue());
+            break;
+        }
+    }
+
+    // Одна последовательность перехода от цветов from к to с изменившимися частями
+    void AppendTransition(std::string& out, const CellColors& from, const CellColors& to)
+    {
+        if (to == CellColors{})
+        {
+            out += ANSI_RESET;
+            return;
+        }
+
+        out += "\x1b[";
+        const bool foreground = from.foreground != to.foreground;
+        if (foreground)
+        {
+            AppendColor(out, to.foreground, 30);
+        }
+        if (from.background != to.background)
+        {
+            if (foreground)
+            {
+                out += ';';
+            }
+            AppendColor(out, to.background, 40);
+        }
+        out += 'm';
+    }
+} // anonymous namespace
+
 namespace plotter
 {
 
 namespace fs = std::filesystem;
 
+CharMap IdentityCharMap() noexcept
+{
+    CharMap table{};
+    for (size_t code = 0; code < table.size(); ++code)
+    {
+        table[code] = static_cast<char>(code);
+    }
+    return table;
+}
+
+void CountChars(const char* first, const char* const last, CharCounts& counts, const int sign) noexcept
+{
+    for (; first != last; ++first)
+    {
+        counts[CharCode(*first)] += sign;
+    }
+}
+
 // Реализуйте методы класса Canvas в этом файле
 Canvas::Canvas(int width, int height, char background /*= DEFAULT_BACKGROUND */)
     : width_(width)
@@ -38,6 +137,19 @@ Canvas::Canvas(int width, int height, char background /*= DEFAULT_BACKGROUND */)
     symbols_.assign(width_ * height_, background_);
 }
 
+Canvas::Canvas(const Canvas& other)
+    : width_(other.width_)
+    , height_(other.height_)
+    , background_(other.background_)
+    , symbols_(other.symbols_)
+    , colors_(other.colors_)
+{
+    // Статистику other может в этот момент пересчитывать константный Statistics
+    const std::lock_guard lock(other.counts_mutex_);
+    counts_ = other.counts_;
+    counts_stale_ = other.counts_stale_.load();
+}
+
 Canvas::Canvas(Canvas&& other) noexcept
 {
     if (other.symbols_.empty())
@@ -59,14 +171,19 @@ Canvas& Canvas::operator=(const Canvas& other)
         return *this;
     }
 
+    // Статистика — свойство канваса-приемника, содержимое приходит из other
+    const bool statistics = HasStatistics();
+
     if (other.symbols_.empty())
     {
         // Проверка консистентности
         assert(other.width_ == 0 && other.height_ == 0);
         symbols_.clear();
+        colors_.clear();
         width_ = other.width_;
         height_ = other.height_;
         background_ = other.background_;
+        TouchStatistics();
     }
     else
     {
@@ -74,6 +191,7 @@ Canvas& Canvas::operator=(const Canvas& other)
         Swap(copy);
     }
 
+    RestoreStatistics(statistics);
     return *this;
 }
 
@@ -81,7 +199,9 @@ Canvas& Canvas::operator=(Canvas&& other) noexcept
 {
     if (this != &other)
     {
+        const bool statistics = HasStatistics();
         Exchange(other);
+        RestoreStatistics(statistics);
     }
 
     return *this;
@@ -104,6 +224,7 @@ int Canvas::Size() const noexcept
 
 char& Canvas::at(int x, int y)
 {
+    TouchStatistics();
     const size_t idx = GetPixelIndex(x, y);
     return symbols_.at(idx);
 }
@@ -116,6 +237,7 @@ const char& Canvas::at(int x, int y) const
 
 char& Canvas::operator()(int x, int y) noexcept
 {
+    TouchStatistics();
     const size_t idx = GetPixelIndex(x, y);
     assert(IsPixelInBounds(idx));
     return symbols_[idx];
@@ -128,9 +250,35 @@ const char& Canvas::operator()(int x, int y) const noexcept
     return symbols_[idx];
 }
 
+void Canvas::SetPixel(const int x, const int y, const char symbol) noexcept
+{
+    const size_t idx = GetPixelIndex(x, y);
+    assert(IsPixelInBounds(idx));
+    if (counts_ && !counts_stale_)
+    {
+        --(*counts_)[CharCode(symbols_[idx])];
+        ++(*counts_)[CharCode(symbol)];
+    }
+    symbols_[idx] = symbol;
+}
+
 void Canvas::Clear(char fill_char)
 {
+    // Нулевой символ зарезервирован плоттерами для разметки пикселей, как и в фоне
+    if (fill_char == '\0')
+    {
+        throw std::invalid_argument("Fill char can't be null");
+    }
+
+    PLOTTER_PROFILE_COUNT("pixels_written", Size());
     symbols_.assign(width_ * height_, fill_char);
+    std::fill(colors_.begin(), colors_.end(), CellColors{});
+    if (counts_)
+    {
+        counts_->fill(0);
+        (*counts_)[CharCode(fill_char)] = Size();
+        counts_stale_ = false;
+    }
 }
 
 void Canvas::FillRegion(int x1, int y1, int x2, int y2, char fill_char) {
@@ -148,10 +296,171 @@ void Canvas::FillRegion(int x1, int y1, int x2, int y2, char fill_char) {
         return;
     }
 
+    PLOTTER_PROFILE_COUNT("pixels_written", (right - left + 1) * (bottom - top + 1));
+    const bool track = counts_ && !counts_stale_;
     for (int y = top; y <= bottom; ++y) {
-        auto it_row_start = RowBegin(y) + left;
-        auto it_row_end = RowBegin(y) + (right + 1);
-        std::fill(it_row_start, it_row_end, fill_char);
+        char* const row_start = symbols_.data() + GetPixelIndex(left, y);
+        char* const row_end = row_start + (right - left + 1);
+        if (track) {
+            for (const char* pixel = row_start; pixel != row_end; ++pixel) {
+                --(*counts_)[CharCode(*pixel)];
+            }
+            (*counts_)[CharCode(fill_char)] += right - left + 1;
+        }
+        std::fill(row_start, row_end, fill_char);
+    }
+}
+
+void Canvas::Remap(const CharMap& table)
+{
+    ReplaceRows(0, height_, table);
+    RemapStatistics(table);
+}
+
+void Canvas::Remap(const CharMap& table, const std::function<void(int rows, const RowRemap& remap)>& for_each_band)
+{
+    for_each_band(height_, [this, &table](const int first_row, const int last_row)
+    {
+        if (first_row < 0 || last_row > height_ || first_row > last_row)
+        {
+            throw std::out_of_range("Incorrect remap rows");
+        }
+        ReplaceRows(first_row, last_row, table);
+    });
+    RemapStatistics(table);
+}
+
+void Canvas::RemapStatistics(const CharMap& table) noexcept
+{
+    if (!counts_ || counts_stale_)
+    {
+        return;
+    }
+
+    CharCounts remapped{};
+    for (size_t code = 0; code < remapped.size(); ++code)
+    {
+        remapped[CharCode(table[code])] += (*counts_)[code];
+    }
+    *counts_ = remapped;
+}
+
+void Canvas::EnableStatistics()
+{
+    if (!counts_)
+    {
+        counts_.emplace();
+        counts_stale_ = true;
+    }
+}
+
+void Canvas::DisableStatistics() noexcept
+{
+    counts_.reset();
+    counts_stale_ = false;
+}
+
+const CharCounts& Canvas::Statistics() const
+{
+    if (!counts_)
+    {
+        throw std::logic_error("Canvas statistics are disabled");
+    }
+
+    if (!counts_stale_.load(std::memory_order_acquire))
+    {
+        return *counts_;
+    }
+
+    // Пересчет меняет mutable состояние, поэтому одновременные константные вызовы его сериализуют
+    const std::lock_guard lock(counts_mutex_);
+    if (counts_stale_.load(std::memory_order_relaxed))
+    {
+        counts_->fill(0);
+        CountChars(symbols_.data(), symbols_.data() + symbols_.size(), *counts_);
+        counts_stale_.store(false, std::memory_order_release);
+    }
+    return *counts_;
+}
+
+void Canvas::MergeStatistics(const CharCounts& delta)
+{
+    const std::lock_guard lock(counts_mutex_);
+    if (!TracksStatistics())
+    {
+        return;
+    }
+
+    for (size_t code = 0; code < delta.size(); ++code)
+    {
+        (*counts_)[code] += delta[code];
+    }
+}
+
+void Canvas::RemapRows(const int first_row, const int last_row, const CharMap& table)
+{
+    if (first_row < 0 || last_row > height_ || first_row > last_row)
+    {
+        throw std::out_of_range("Incorrect remap rows");
+    }
+
+    ReplaceRows(first_row, last_row, table);
+    TouchStatistics();
+}
+
+void Canvas::ReplaceRows(const int first_row, const int last_row, const CharMap& table) noexcept
+{
+    char* const begin = symbols_.data() + GetPixelIndex(0, first_row);
+    char* const end = symbols_.data() + GetPixelIndex(0, last_row);
+    PLOTTER_PROFILE_COUNT("pixels_written", end - begin);
+    for (char* pixel = begin; pixel != end; ++pixel)
+    {
+        *pixel = table[CharCode(*pixel)];
+    }
+}
+
+void Canvas::EnableColors()
+{
+    if (colors_.empty())
+    {
+        colors_.assign(symbols_.size(), CellColors{});
+    }
+}
+
+void Canvas::DisableColors() noexcept
+{
+    colors_ = {};
+}
+
+void Canvas::SetColors(const int x, const int y, const CellColors& colors) noexcept
+{
+    const size_t idx = GetPixelIndex(x, y);
+    assert(idx < colors_.size());
+    colors_[idx] = colors;
+}
+
+const CellColors& Canvas::Colors(const int x, const int y) const noexcept
+{
+    const size_t idx = GetPixelIndex(x, y);
+    assert(idx < colors_.size());
+    return colors_[idx];
+}
+
+void Canvas::FillColors(const int x1, const int y1, const int x2, const int y2, const CellColors& colors)
+{
+    if (colors_.empty())
+    {
+        throw std::logic_error("Canvas colors are disabled");
+    }
+
+    const int left = std::max(0, std::min(x1, x2));
+    const int right = std::min(width_ - 1, std::max(x1, x2));
+    const int top = std::max(0, std::min(y1, y2));
+    const int bottom = std::min(height_ - 1, std::max(y1, y2));
+    for (int y = top; y <= bottom && left <= right; ++y)
+    {
+        const auto row = colors_.begin() + static_cast<ptrdiff_t>(GetPixelIndex(left, y));
+        std::fill(row, row + (right - left + 1), colors);
     }
 }
 
@@ -162,22 +471,79 @@ bool Canvas::InBounds(int x, int y) const noexcept
 
 void Canvas::Render(std::ostream& os /* = std::cout */) const
 {
+    PLOTTER_PROFILE_SCOPE("Canvas::Render");
     if (symbols_.empty())
     {
         return;
     }
 
-    for (int y = 0; y < height_; ++y) {
-        const char* row_start = &symbols_[y * width_];
-        os.write(row_start, width_);
-        os << '\n';
+    std::string frame;
+    if (colors_.empty())
+    {
+        frame.reserve(symbols_.size() + height_);
+        for (int y = 0; y < height_; ++y) {
+            frame.append(&symbols_[y * width_], width_);
+            frame += '\n';
+        }
+    }
+    else
+    {
+        AppendColoredFrame(frame);
     }
 
+    PLOTTER_PROFILE_COUNT("bytes_written", frame.size());
+    os.write(frame.data(), static_cast<std::streamsize>(frame.size()));
     os.flush();
 }
 
+void Canvas::AppendColoredFrame(std::string& frame) const
+{
+    frame.reserve(symbols_.size() + height_ + ANSI_RESET.size());
+
+    // Кадр начинается с цветов терминала по умолчанию и заканчивается сбросом к ним
+    CellColors current{};
+    for (int y = 0; y < height_; ++y)
+    {
+        const char* const row = symbols_.data() + GetPixelIndex(0, y);
+        const CellColors* const row_colors = colors_.data() + GetPixelIndex(0, y);
+        int x = 0;
+        while (x < width_)
+        {
+            // Отрезок ячеек одного цвета выводится целиком
+            const CellColors& cell = row_colors[x];
+            int run_end = x + 1;
+            while (run_end < width_ && row_colors[run_end] == cell)
+            {
+                ++run_end;
+            }
+            if (cell != current)
+            {
+                AppendTransition(frame, current, cell);
+                current = cell;
+            }
+            frame.append(row + x, run_end - x);
+            x = run_end;
+        }
+
+        // Фон не должен растягиваться на остаток строки терминала
+        if (!current.background.IsDefault())
+        {
+            const CellColors next{ current.foreground, Color{} };
+            AppendTransition(frame, current, next);
+            current = next;
+        }
+        frame += '\n';
+    }
+
+    if (current != CellColors{})
+    {
+        frame += ANSI_RESET;
+    }
+}
+
 void Canvas::SaveToFile(const fs::path& filepath) const
 {
+    PLOTTER_PROFILE_SCOPE("Canvas::SaveToFile");
     if (filepath.empty())
     {
         throw std::runtime_error("Filepath is empty");
@@ -237,6 +603,7 @@ Canvas::PixelIterator Canvas::end()
 
 char& Canvas::GetPixel(size_t pos) noexcept
 {
+    TouchStatistics();
     assert(IsPixelInBounds(pos));
     return symbols_[pos];
 }
@@ -247,20 +614,58 @@ const char& Canvas::GetPixel(size_t pos) const noexcept
     return symbols_[pos];
 }
 
+char* Canvas::Data() noexcept
+{
+    TouchStatistics();
+    return symbols_.data();
+}
+
+const char* Canvas::Data() const noexcept
+{
+    return symbols_.data();
+}
+
 void Canvas::Swap(Canvas& other) noexcept
 {
     symbols_.swap(other.symbols_);
+    colors_.swap(other.colors_);
     std::swap(width_, other.width_);
     std::swap(height_, other.height_);
     std::swap(background_, other.background_);
+    std::swap(counts_, other.counts_);
+    counts_stale_ = other.counts_stale_.exchange(counts_stale_);
 }
 
 void Canvas::Exchange(Canvas& other) noexcept
 {
     symbols_ = std::exchange(other.symbols_, {});
+    colors_ = std::exchange(other.colors_, {});
     width_ = std::exchange(other.width_, 0);
     height_ = std::exchange(other.height_, 0);
     background_ = std::exchange(other.background_, DEFAULT_BACKGROUND);
+    counts_ = std::exchange(other.counts_, std::nullopt);
+    counts_stale_ = other.counts_stale_.exchange(false);
+}
+
+void Canvas::TouchStatistics() noexcept
+{
+    if (counts_)
+    {
+        counts_stale_ = true;
+    }
+}
+
+void Canvas::RestoreStatistics(const bool enabled) noexcept
+{
+    if (!enabled)
+    {
+        DisableStatistics();
+    }
+    else if (!counts_)
+    {
+        counts_.emplace();
+        counts_stale_ = true;
+    }
 }
 
 size_t Canvas::GetPixelIndex(int x, int y) const noexcept
@@ -280,4 +685,34 @@ void Canvas::PrintHeader(std::ostream& os) const noexcept
         << "Content:" << '\n';
 }
 
+Canvas::BandCounts::BandCounts(Canvas& canvas) noexcept
+    : canvas_(canvas)
+    , counted_(canvas.TracksStatistics())
+{
+}
+
+void Canvas::BandCounts::Before(const char* const first, const char* const last) noexcept
+{
+    if (counted_)
+    {
+        CountChars(first, last, delta_, -1);
+    }
+}
+
+void Canvas::BandCounts::After(const char* const first, const char* const last) noexcept
+{
+    if (counted_)
+    {
+        CountChars(first, last, delta_);
+    }
+}
+
+void Canvas::BandCounts::Merge()
+{
+    if (counted_)
+    {
+        canvas_.MergeStatistics(delta_);
+    }
+}
+
 } // namespace plotter
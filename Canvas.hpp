@@ -1,11 +1,36 @@
 #pragma once
+#include "CellColors.hpp"
+#include <array>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace plotter
 {
 
+// Таблица замены символов, индекс — код символа как unsigned char
+using CharMap = std::array<char, 256>;
+
+// Код символа для индексации таблиц
+constexpr size_t CharCode(const char symbol) noexcept
+{
+    return static_cast<unsigned char>(symbol);
+}
+
+// Таблица, оставляющая все символы без изменений
+CharMap IdentityCharMap() noexcept;
+
+// Число пикселей каждого символа, индекс — код символа
+using CharCounts = std::array<int, 256>;
+
+// Прибавляет sign к counts[код] для каждого символа из [first, last)
+void CountChars(const char* first, const char* last, CharCounts& counts, int sign = 1) noexcept;
+
 class Canvas
 {
 public:
@@ -14,10 +39,11 @@ public:
     class RowIterator;
     class ColumnIterator;
     class PixelIterator;
+    class BandCounts;
 
     Canvas(int width, int height, char background = DEFAULT_BACKGROUND);
 
-    Canvas(const Canvas& other) = default;
+    Canvas(const Canvas& other);
     Canvas(Canvas&& other) noexcept;
     Canvas& operator=(const Canvas& other);
     Canvas& operator=(Canvas&& other) noexcept;
@@ -25,17 +51,64 @@ public:
     [[nodiscard]] int Width() const noexcept;
     [[nodiscard]] int Height() const noexcept;
     [[nodiscard]] int Size() const noexcept;
+    [[nodiscard]] char Background() const noexcept { return background_; }
 
     char& at(int x, int y);
     [[nodiscard]] const char& at(int x, int y) const;
     char& operator()(int x, int y) noexcept;
     [[nodiscard]] const char& operator()(int x, int y) const noexcept;
 
+    // Запись пикселя без проверки границ, учитывается статистикой
+    void SetPixel(int x, int y, char symbol) noexcept;
+
+    // Цвета включенного слоя цветов становятся цветами по умолчанию.
+    // Бросает std::invalid_argument для нулевого символа, как и конструктор для фона
     void Clear(char fill_char);
     void FillRegion(int x1, int y1, int x2, int y2, char fill_char);
+    // Заменяет каждый пиксель на table[пиксель]
+    void Remap(const CharMap& table);
+    // То же, но строки заменяются полосами: for_each_band(rows, remap) вызывает remap(first_row, last_row)
+    // для полос, покрывающих [0, rows) без пересечений, полосы можно заменять параллельно.
+    // Статистика переносится один раз после всех полос
+    using RowRemap = std::function<void(int first_row, int last_row)>;
+    void Remap(const CharMap& table, const std::function<void(int rows, const RowRemap& remap)>& for_each_band);
+    // То же для строк [first_row, last_row). Статистика становится устаревшей
+    void RemapRows(int first_row, int last_row, const CharMap& table);
+
+    // Статистика символов. Пока она включена, ее поддерживают SetPixel, Clear, FillRegion, Remap
+    // и присваивание, запрос стоит O(256). Неконстантный доступ к пикселям по ссылке или указателю
+    // (at, operator(), GetPixel, Data, итераторы) делает ее устаревшей, и следующий запрос
+    // один раз пересчитывает канвас
+    void EnableStatistics();
+    void DisableStatistics() noexcept;
+    [[nodiscard]] bool HasStatistics() const noexcept { return counts_.has_value(); }
+    // Бросает std::logic_error, если статистика выключена. Константные вызовы из разных потоков
+    // безопасны: пересчет выполняется один раз под counts_mutex_
+    [[nodiscard]] const CharCounts& Statistics() const;
+    // Статистика включена и не устарела, то есть записи в обход SetPixel должны ее поддерживать
+    [[nodiscard]] bool TracksStatistics() const noexcept { return counts_ && !counts_stale_; }
+    // Прибавляет к статистике изменения числа символов, если она ведется. Полосы, записанные
+    // через CountedData, могут сливать свои изменения из разных потоков
+    void MergeStatistics(const CharCounts& delta);
+
+    // Слой цветов ячеек рядом с символами, по умолчанию выключен. Пока он включен, Render выводит
+    // escape-последовательности ANSI: одна последовательность на смену цветов между соседними ячейками,
+    // в конце кадра цвета терминала сбрасываются
+    void EnableColors();
+    void DisableColors() noexcept;
+    [[nodiscard]] bool HasColors() const noexcept { return !colors_.empty(); }
+    // Цвета ячейки без проверки границ, слой цветов должен быть включен
+    void SetColors(int x, int y, const CellColors& colors) noexcept;
+    [[nodiscard]] const CellColors& Colors(int x, int y) const noexcept;
+    // Цвета прямоугольника, обрезанного краями канваса, слой цветов должен быть включен
+    void FillColors(int x1, int y1, int x2, int y2, const CellColors& colors);
+    // Непрерывный буфер цветов как Data, nullptr при выключенном слое
+    CellColors* ColorData() noexcept { return colors_.empty() ? nullptr : colors_.data(); }
+    [[nodiscard]] const CellColors* ColorData() const noexcept { return colors_.empty() ? nullptr : colors_.data(); }
 
     [[nodiscard]] bool InBounds(int x, int y) const noexcept;
 
+    // Кадр собирается в буфер и выводится в os одной записью
     void Render(std::ostream& os = std::cout) const;
     void SaveToFile(const std::filesystem::path& filepath) const;
     void SaveToFile(const std::string& filename) const;
@@ -53,12 +126,26 @@ public:
     // Константный метод. Возвращает «цвет» пикселя в указанной позиции.
     [[nodiscard]] const char& GetPixel(size_t pos) const noexcept;
 
+    // Непрерывный буфер пикселей, строки идут подряд без выравнивания
+    char* Data() noexcept;
+    [[nodiscard]] const char* Data() const noexcept;
+    // Тот же буфер для записи полосами, но статистика не становится устаревшей: каждая полоса
+    // учитывает свои замены в BandCounts, иначе статистика разойдется с пикселями
+    char* CountedData() noexcept { return symbols_.data(); }
+
 private:
     int width_ = 0;
     int height_ = 0;
     char background_ = DEFAULT_BACKGROUND;
     // Добавьте контейнер для хранения данных
     std::vector<char> symbols_;
+    // Слой цветов, пустой — выключен
+    std::vector<CellColors> colors_;
+    // Статистика символов, пустая — выключена
+    mutable std::optional<CharCounts> counts_;
+    // Пиксели могли измениться в обход статистики. Сбрасывается из константного Statistics под counts_mutex_
+    mutable std::atomic<bool> counts_stale_ = false;
+    mutable std::mutex counts_mutex_;
 
     // Обменивает значение с другим канвасом
     void Swap(Canvas& other) noexcept;
@@ -68,8 +155,35 @@ private:
     size_t GetPixelIndex(int x, int y) const noexcept;
     // Проверяет корректность позиции пикселя
     bool IsPixelInBounds(size_t pos) const noexcept;
+    // Отмечает доступ к пикселям в обход статистики
+    void TouchStatistics() noexcept;
+    // Замена строк без проверки границ и без учета статистики
+    void ReplaceRows(int first_row, int last_row, const CharMap& table) noexcept;
+    // Переносит статистику после замены всех пикселей по таблице
+    void RemapStatistics(const CharMap& table) noexcept;
+    // Включает или выключает статистику после присваивания
+    void RestoreStatistics(bool enabled) noexcept;
+    // Дописывает в frame кадр с escape-последовательностями цветов
+    void AppendColoredFrame(std::string& frame) const;
     // Добавляет инфо в файл перед рисунком, как в DemoPrecode
     void PrintHeader(std::ostream& os) const noexcept;
 };
 
+// Изменения статистики одной полосы при записи через CountedData: отрезок считается до записи (Before)
+// и после нее (After), Merge сливает итог в канвас. Если статистика не ведется, ничего не считается
+class Canvas::BandCounts
+{
+public:
+    explicit BandCounts(Canvas& canvas) noexcept;
+
+    void Before(const char* first, const char* last) noexcept;
+    void After(const char* first, const char* last) noexcept;
+    void Merge();
+
+private:
+    Canvas& canvas_;
+    bool counted_;
+    CharCounts delta_{};
+};
+
 } // namespace plotter
@@ -0,0 +1,344 @@
+#include "CanvasPyramid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Запас на ошибку округления float при квантовании среднего индекса палитры
+    constexpr float VALUE_TOLERANCE = 1e-4f;
+
+    int TileCount(const int size)
+    {
+        return (size + plotter::CanvasPyramid::TILE_SIZE - 1) / plotter::CanvasPyramid::TILE_SIZE;
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+CanvasPyramid::CanvasPyramid(const Canvas& source)
+    : source_(&source)
+{
+    BuildLevels();
+}
+
+CanvasPyramid::CanvasPyramid(const Canvas& source, const std::vector<char>& palette)
+    : source_(&source)
+    , palette_(palette)
+{
+    if (palette_.size() < 2)
+    {
+        throw std::invalid_argument("Palette size can't be less than 2");
+    }
+    // При повторе символа в палитре действует последнее вхождение, как в GrayscalePlotter
+    for (size_t i = 0; i < palette_.size(); ++i)
+    {
+        char_to_value_[CharCode(palette_[i])] = static_cast<float>(i);
+    }
+    BuildLevels();
+}
+
+const Canvas& CanvasPyramid::Level(const int level)
+{
+    if (level < 0 || level >= LevelCount())
+    {
+        throw std::out_of_range("Pyramid level out of range");
+    }
+    EnsureTiles(level, 0, 0, levels_[level].tiles_x - 1, levels_[level].tiles_y - 1);
+    return levels_[level].symbols;
+}
+
+int CanvasPyramid::Update()
+{
+    const Canvas& base = levels_.front().symbols;
+    if (source_->Width() != base.Width() || source_->Height() != base.Height())
+    {
+        BuildLevels();
+        return levels_.front().tiles_x * levels_.front().tiles_y;
+    }
+
+    const int width = base.Width();
+    const int height = base.Height();
+    int changed = 0;
+    for (int tile_y = 0; tile_y < levels_.front().tiles_y; ++tile_y)
+    {
+        for (int tile_x = 0; tile_x < levels_.front().tiles_x; ++tile_x)
+        {
+            const int x = tile_x * TILE_SIZE;
+            const auto span = static_cast<size_t>(std::min(TILE_SIZE, width - x));
+            const int y_end = std::min((tile_y + 1) * TILE_SIZE, height);
+            for (int y = tile_y * TILE_SIZE; y < y_end; ++y)
+            {
+                const size_t offset = static_cast<size_t>(y) * width + x;
+                if (std::memcmp(source_->Data() + offset, base.Data() + offset, span) != 0)
+                {
+                    RefreshBaseTile(tile_x, tile_y);
+                    ++changed;
+                    break;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+void CanvasPyramid::Invalidate(const int x1, const int y1, const int x2, const int y2)
+{
+    const Canvas& base = levels_.front().symbols;
+    const int left = std::max(std::min(x1, x2), 0);
+    const int top = std::max(std::min(y1, y2), 0);
+    const int right = std::min(std::max(x1, x2), base.Width() - 1);
+    const int bottom = std::min(std::max(y1, y2), base.Height() - 1);
+    if (left > right || top > bottom)
+    {
+        return;
+    }
+
+    for (int tile_y = top / TILE_SIZE; tile_y <= bottom / TILE_SIZE; ++tile_y)
+    {
+        for (int tile_x = left / TILE_SIZE; tile_x <= right / TILE_SIZE; ++tile_x)
+        {
+            RefreshBaseTile(tile_x, tile_y);
+        }
+    }
+}
+
+void CanvasPyramid::RenderViewport(Canvas& target, const double x, const double y, const double zoom)
+{
+    if (!(zoom > 0.0) || !std::isfinite(zoom))
+    {
+        throw std::invalid_argument("Zoom must be positive");
+    }
+
+    // Самый грубый уровень, пиксель которого не больше пикселя target: 2^level <= 1 / zoom.
+    // При zoom 0.3 это уровень 1, пиксель уровня 2 был бы больше пикселя target
+    const int level = std::clamp(static_cast<int>(std::floor(std::log2(1.0 / zoom) + 1e-9)), 0, LevelCount() - 1);
+    const Canvas& symbols = levels_[level].symbols;
+    const double level_scale = std::ldexp(1.0, level);
+
+    // Пиксель уровня для каждого столбца и строки target, -1 — вне source
+    const auto map_axis = [&](const int size, const double origin, const int level_size)
+    {
+        std::vector<int> indices(size);
+        for (int i = 0; i < size; ++i)
+        {
+            const double position = std::floor((origin + (i + 0.5) / zoom) / level_scale);
+            indices[i] = position >= 0.0 && position < level_size ? static_cast<int>(position) : -1;
+        }
+        return indices;
+    };
+    const std::vector<int> columns = map_axis(target.Width(), x, symbols.Width());
+    const std::vector<int> rows = map_axis(target.Height(), y, symbols.Height());
+
+    const auto visible = [](const std::vector<int>& indices, int& first, int& last)
+    {
+        first = -1;
+        last = -1;
+        for (const int index : indices)
+        {
+            if (index >= 0)
+            {
+                first = first < 0 ? index : std::min(first, index);
+                last = std::max(last, index);
+            }
+        }
+        return first >= 0;
+    };
+    int first_column = 0;
+    int last_column = 0;
+    int first_row = 0;
+    int last_row = 0;
+    const char background = source_->Background();
+    if (!visible(columns, first_column, last_column) || !visible(rows, first_row, last_row))
+    {
+        target.Clear(background);
+        return;
+    }
+    EnsureTiles(level, first_column / TILE_SIZE, first_row / TILE_SIZE, last_column / TILE_SIZE, last_row / TILE_SIZE);
+
+    char* const result = target.Data();
+    for (int ty = 0; ty < target.Height(); ++ty)
+    {
+        char* const row = result + static_cast<size_t>(ty) * target.Width();
+        if (rows[ty] < 0)
+        {
+            std::fill(row, row + target.Width(), background);
+            continue;
+        }
+
+        const char* const level_row = symbols.Data() + static_cast<size_t>(rows[ty]) * symbols.Width();
+        for (int tx = 0; tx < target.Width(); ++tx)
+        {
+            row[tx] = columns[tx] < 0 ? background : level_row[columns[tx]];
+        }
+    }
+}
+
+void CanvasPyramid::BuildLevels()
+{
+    levels_.clear();
+    int width = source_->Width();
+    int height = source_->Height();
+    while (true)
+    {
+        PyramidLevel level{ Canvas(width, height, source_->Background()), {}, TileCount(width), TileCount(height), {} };
+        if (Averages())
+        {
+            level.values.resize(static_cast<size_t>(width) * height);
+        }
+        level.dirty.assign(static_cast<size_t>(level.tiles_x) * level.tiles_y, levels_.empty() ? 0 : 1);
+        levels_.push_back(std::move(level));
+
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    for (int tile_y = 0; tile_y < levels_.front().tiles_y; ++tile_y)
+    {
+        for (int tile_x = 0; tile_x < levels_.front().tiles_x; ++tile_x)
+        {
+            RefreshBaseTile(tile_x, tile_y);
+        }
+    }
+}
+
+void CanvasPyramid::RefreshBaseTile(const int tile_x, const int tile_y)
+{
+    PyramidLevel& base = levels_.front();
+    const int width = base.symbols.Width();
+    const int x = tile_x * TILE_SIZE;
+    const int span = std::min(TILE_SIZE, width - x);
+    const int y_end = std::min((tile_y + 1) * TILE_SIZE, base.symbols.Height());
+    for (int y = tile_y * TILE_SIZE; y < y_end; ++y)
+    {
+        const size_t offset = static_cast<size_t>(y) * width + x;
+        std::copy_n(source_->Data() + offset, span, base.symbols.Data() + offset);
+        if (Averages())
+        {
+            std::transform(source_->Data() + offset, source_->Data() + offset + span, base.values.begin() + offset,
+                [this](const char symbol) { return char_to_value_[CharCode(symbol)]; });
+        }
+    }
+    ++rebuilt_tiles_;
+
+    for (size_t level = 1; level < levels_.size(); ++level)
+    {
+        PyramidLevel& above = levels_[level];
+        above.dirty[static_cast<size_t>(tile_y >> level) * above.tiles_x + (tile_x >> level)] = 1;
+    }
+}
+
+void CanvasPyramid::EnsureTiles(const int level, const int tile_x1, const int tile_y1, const int tile_x2,
+    const int tile_y2)
+{
+    if (level == 0)
+    {
+        return;
+    }
+
+    PyramidLevel& current = levels_[level];
+    const int x_end = std::min(tile_x2, current.tiles_x - 1);
+    const int y_end = std::min(tile_y2, current.tiles_y - 1);
+    bool any_dirty = false;
+    for (int tile_y = tile_y1; tile_y <= y_end && !any_dirty; ++tile_y)
+    {
+        for (int tile_x = tile_x1; tile_x <= x_end && !any_dirty; ++tile_x)
+        {
+            any_dirty = current.dirty[static_cast<size_t>(tile_y) * current.tiles_x + tile_x] != 0;
+        }
+    }
+    if (!any_dirty)
+    {
+        return;
+    }
+
+    // Плитка сворачивает четыре плитки уровня ниже, грязные только под грязными плитками этого уровня
+    EnsureTiles(level - 1, 2 * tile_x1, 2 * tile_y1, 2 * x_end + 1, 2 * y_end + 1);
+    for (int tile_y = tile_y1; tile_y <= y_end; ++tile_y)
+    {
+        for (int tile_x = tile_x1; tile_x <= x_end; ++tile_x)
+        {
+            std::uint8_t& dirty = current.dirty[static_cast<size_t>(tile_y) * current.tiles_x + tile_x];
+            if (dirty)
+            {
+                ReduceTile(level, tile_x, tile_y);
+                dirty = 0;
+            }
+        }
+    }
+}
+
+void CanvasPyramid::ReduceTile(const int level, const int tile_x, const int tile_y)
+{
+    const PyramidLevel& below = levels_[level - 1];
+    PyramidLevel& current = levels_[level];
+    const int below_width = below.symbols.Width();
+    const int below_height = below.symbols.Height();
+    const int width = current.symbols.Width();
+    const int x_end = std::min((tile_x + 1) * TILE_SIZE, width);
+    const int y_end = std::min((tile_y + 1) * TILE_SIZE, current.symbols.Height());
+    const char background = source_->Background();
+
+    for (int y = tile_y * TILE_SIZE; y < y_end; ++y)
+    {
+        // У нечетного размера последний блок неполный
+        const int block_height = std::min(2, below_height - 2 * y);
+        for (int x = tile_x * TILE_SIZE; x < x_end; ++x)
+        {
+            const int block_width = std::min(2, below_width - 2 * x);
+            std::array<size_t, 4> block{};
+            int count = 0;
+            for (int dy = 0; dy < block_height; ++dy)
+            {
+                for (int dx = 0; dx < block_width; ++dx)
+                {
+                    block[count++] = static_cast<size_t>(2 * y + dy) * below_width + 2 * x + dx;
+                }
+            }
+
+            const size_t index = static_cast<size_t>(y) * width + x;
+            if (Averages())
+            {
+                float sum = 0.0f;
+                for (int i = 0; i < count; ++i)
+                {
+                    sum += below.values[block[i]];
+                }
+                current.values[index] = sum / static_cast<float>(count);
+                current.symbols.Data()[index] = ValueToChar(current.values[index]);
+                continue;
+            }
+
+            const char* const symbols = below.symbols.Data();
+            char best = symbols[block[0]];
+            int best_count = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                const char symbol = symbols[block[i]];
+                const auto matches = static_cast<int>(std::count_if(block.begin(), block.begin() + count,
+                    [&](const size_t other) { return symbols[other] == symbol; }));
+                if (matches > best_count || (matches == best_count && best == background && symbol != background))
+                {
+                    best = symbol;
+                    best_count = matches;
+                }
+            }
+            current.symbols.Data()[index] = best;
+        }
+    }
+    ++rebuilt_tiles_;
+}
+
+char CanvasPyramid::ValueToChar(const float value) const noexcept
+{
+    const int max_index = static_cast<int>(palette_.size()) - 1;
+    return palette_[std::clamp(static_cast<int>(value + VALUE_TOLERANCE), 0, max_index)];
+}
+
+} // namespace plotter
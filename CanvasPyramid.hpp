@@ -0,0 +1,78 @@
+#pragma once
+#include "Canvas.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace plotter
+{
+
+// Пирамида уменьшенных копий канваса для показа с любым масштабом.
+// Уровень 0 — копия source, каждый следующий вдвое меньше по обеим осям (с округлением вверх),
+// последний уровень — 1x1. Пиксель уровня сворачивает блок 2x2 предыдущего уровня.
+// Уровни делятся на плитки TILE_SIZE x TILE_SIZE. Изменения source отмечают плитки грязными,
+// а перестраиваются только грязные плитки, которые нужны запрошенному уровню или окну просмотра.
+// Пирамида хранит указатель на source, source должен жить дольше пирамиды
+class CanvasPyramid
+{
+public:
+    static constexpr int TILE_SIZE = 32;
+
+    // Символьный канвас: пиксель — символ, который чаще всего встречается в блоке.
+    // При равенстве выигрывает символ, отличный от фона source, чтобы тонкие линии не пропадали,
+    // затем первый по порядку строк
+    explicit CanvasPyramid(const Canvas& source);
+    // Канвас в оттенках серого: яркость символов palette усредняется и квантуется в palette,
+    // как GrayscalePlotter::BrightnessToChar. Символы вне палитры — нулевая яркость
+    CanvasPyramid(const Canvas& source, const std::vector<char>& palette);
+
+    [[nodiscard]] int LevelCount() const noexcept { return static_cast<int>(levels_.size()); }
+    // Уровень level, его грязные плитки перестраиваются
+    [[nodiscard]] const Canvas& Level(int level);
+
+    // Сравнивает source с копией уровня 0 по плиткам и отмечает измененные плитки на всех уровнях.
+    // Возвращает число измененных плиток уровня 0
+    int Update();
+    // Отмечает измененным прямоугольник source без сравнения, когда вызывающий знает, что рисовал
+    void Invalidate(int x1, int y1, int x2, int y2);
+
+    // Заполняет target видом source с левым верхним углом (x, y) в пикселях source и масштабом zoom:
+    // zoom пикселей target на пиксель source. Пиксели берутся ближайшими из самого грубого уровня,
+    // пиксель которого не больше пикселя target, перестраиваются только видимые грязные плитки.
+    // Пиксели вне source — фон source. Бросает std::invalid_argument, если zoom не положителен
+    void RenderViewport(Canvas& target, double x, double y, double zoom);
+
+    // Число перестроенных плиток с создания пирамиды, включая первое построение
+    [[nodiscard]] long long RebuiltTiles() const noexcept { return rebuilt_tiles_; }
+
+private:
+    struct PyramidLevel
+    {
+        Canvas symbols;
+        // Средний индекс палитры пикселя для усреднения, пустой для символьного канваса
+        std::vector<float> values;
+        int tiles_x;
+        int tiles_y;
+        // Плитка требует перестройки, уровень 0 всегда актуален
+        std::vector<std::uint8_t> dirty;
+    };
+
+    const Canvas* source_;
+    // Пустая палитра — свертка частым символом
+    std::vector<char> palette_;
+    // Индекс символа в палитре
+    std::array<float, 256> char_to_value_{};
+    std::vector<PyramidLevel> levels_;
+    long long rebuilt_tiles_ = 0;
+
+    [[nodiscard]] bool Averages() const noexcept { return !palette_.empty(); }
+    void BuildLevels();
+    // Копирует плитку уровня 0 из source и отмечает плитки над ней грязными
+    void RefreshBaseTile(int tile_x, int tile_y);
+    // Перестраивает грязные плитки [tile_x1, tile_x2] x [tile_y1, tile_y2] уровня и нужные им плитки ниже
+    void EnsureTiles(int level, int tile_x1, int tile_y1, int tile_x2, int tile_y2);
+    void ReduceTile(int level, int tile_x, int tile_y);
+    [[nodiscard]] char ValueToChar(float value) const noexcept;
+};
+
+} // namespace plotter
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+namespace plotter
+{
+
+// Цвет символа или фона ячейки терминала: цвет терминала по умолчанию, один из 256 цветов
+// палитры терминала или 24-битный RGB. Упакован в 32 бита: вид в старшем байте, значение в младших
+class Color
+{
+public:
+    enum class Kind : std::uint8_t
+    {
+        Default,
+        Indexed,
+        Rgb,
+    };
+
+    // Цвет терминала по умолчанию
+    constexpr Color() noexcept = default;
+
+    static constexpr Color Indexed(const std::uint8_t index) noexcept { return { Kind::Indexed, index }; }
+    static constexpr Color Rgb(const std::uint8_t red, const std::uint8_t green, const std::uint8_t blue) noexcept
+    {
+        return { Kind::Rgb, static_cast<std::uint32_t>(red) << 16 | static_cast<std::uint32_t>(green) << 8 | blue };
+    }
+
+    [[nodiscard]] constexpr Kind GetKind() const noexcept { return static_cast<Kind>(packed_ >> 24); }
+    [[nodiscard]] constexpr bool IsDefault() const noexcept { return packed_ == 0; }
+    [[nodiscard]] constexpr std::uint8_t Index() const noexcept { return packed_ & 0xFF; }
+    [[nodiscard]] constexpr std::uint8_t Red() const noexcept { return packed_ >> 16 & 0xFF; }
+    [[nodiscard]] constexpr std::uint8_t Green() const noexcept { return packed_ >> 8 & 0xFF; }
+    [[nodiscard]] constexpr std::uint8_t Blue() const noexcept { return packed_ & 0xFF; }
+
+    friend constexpr bool operator==(Color lhs, Color rhs) noexcept = default;
+
+private:
+    std::uint32_t packed_ = 0;
+
+    constexpr Color(const Kind kind, const std::uint32_t value) noexcept
+        : packed_(static_cast<std::uint32_t>(kind) << 24 | value)
+    {
+    }
+};
+
+// Цвета ячейки канваса
+struct CellColors
+{
+    Color foreground;
+    Color background;
+
+    friend constexpr bool operator==(const CellColors& lhs, const CellColors& rhs) noexcept = default;
+};
+
+} // namespace plotter
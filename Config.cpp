@@ -1,7 +1,8 @@
 #include "Config.hpp"
-#include "json.h"
+#include "JsonView.hpp"
 
-#include <fstream>
+#include <iostream>
+#include <iterator>
 
 namespace
 {
@@ -11,6 +12,7 @@ constexpr const char height[] = "height";
 constexpr const char background_char[] = "background_char";
 constexpr const char plotter_type[] = "plotter_type";
 constexpr const char PALETTE[] = "palette";
+constexpr const char THREADS[] = "threads";
 
 constexpr const char string_type[] = "string";
 constexpr const char int_type[] = "int";
@@ -23,28 +25,32 @@ constexpr int default_height = 24;
 constexpr char default_background_char = ' ';
 constexpr const char default_plotter_type[] = "basic";
 
-void CheckStringItem(const json::Dict& data, const std::string& item)
+const json::ValueView& CheckStringItem(const json::ValueView& data, const std::string& item)
 {
-    if (data.count(item) == 0)
+    const json::ValueView* const value = data.Find(item);
+    if (value == nullptr)
     {
         throw plotter::NotFoundError(item);
     }
-    if (!data.at(item).IsString())
+    if (!value->IsString())
     {
         throw plotter::WrongTypeError(item, string_type);
     }
+    return *value;
 }
 
-void CheckIntItem(const json::Dict& data, const std::string& item)
+const json::ValueView& CheckIntItem(const json::ValueView& data, const std::string& item)
 {
-    if (data.count(item) == 0)
+    const json::ValueView* const value = data.Find(item);
+    if (value == nullptr)
     {
         throw plotter::NotFoundError(item);
     }
-    if (!data.at(item).IsInt())
+    if (!value->IsInt())
     {
         throw plotter::WrongTypeError(item, int_type);
     }
+    return *value;
 }
 
 } // anonymous namespace
@@ -57,16 +63,13 @@ using namespace std::literals;
 // Реализуйте методы класса Config
 PlotterConfig Config::LoadFromFile(const std::string& filename)
 {
-    std::ifstream in(filename);
-    if (!in)
-    {
-        throw std::runtime_error("Failed to open file '" + filename + "'");
-    }
+    // Бросает std::runtime_error, если файл не открывается
+    const json::DocumentView doc = json::DocumentView::Load(filename);
 
     PlotterConfig config;
     try
     {
-        config = Config::LoadFromString(in);
+        config = Config::FromJson(doc.GetRoot());
     }
     catch (const ConfigParserError& e)
     {
@@ -84,41 +87,49 @@ PlotterConfig Config::LoadFromFile(const std::string& filename)
 
 PlotterConfig Config::LoadFromString(std::istream& json_str)
 {
-    json::Document doc = json::Load(json_str);
-    const auto& root = doc.GetRoot();
+    const std::string text(std::istreambuf_iterator<char>(json_str), {});
+    return LoadFromString(std::string_view(text));
+}
+
+PlotterConfig Config::LoadFromString(const std::string_view json_str)
+{
+    const json::DocumentView doc = json::DocumentView::Parse(json_str);
+    return FromJson(doc.GetRoot());
+}
+
+PlotterConfig Config::FromJson(const json::ValueView& root)
+{
     PlotterConfig config;
 
     if (!root.IsDict())
     {
         throw ConfigParserError("json root is not dict");
     }
-    const auto& data = root.AsDict();
-
-    CheckIntItem(data, width);
-    config.width = data.at(width).AsInt();
 
-    CheckIntItem(data, height);
-    config.height = data.at(height).AsInt();
-
-    CheckStringItem(data, background_char);
-    const auto& background_char_str = data.at(background_char).AsString();
+    config.width = CheckIntItem(root, width).AsInt();
+    config.height = CheckIntItem(root, height).AsInt();
 
+    const std::string_view background_char_str = CheckStringItem(root, background_char).AsString();
     if (background_char_str.size() != 1)
     {
         throw ConfigParserError(background_char + " is expected to have a single char."s);
     }
     config.background_char = background_char_str[0];
 
-    CheckStringItem(data, plotter_type);
-    config.plotter_type = data.at(plotter_type).AsString();
+    config.plotter_type = CheckStringItem(root, plotter_type).AsString();
 
-    if (data.count(PALETTE) == 1) {
-        if (!data.at(PALETTE).IsString())
+    if (const json::ValueView* const palette = root.Find(PALETTE))
+    {
+        if (!palette->IsString())
         {
             throw plotter::WrongTypeError(PALETTE, string_type);
         }
-        const auto& palette_str = data.at(PALETTE).AsString();
-        config.palette = ParsePalette(palette_str);
+        config.palette = ParsePalette(std::string(palette->AsString()));
+    }
+
+    if (root.Find(THREADS) != nullptr)
+    {
+        config.threads = CheckIntItem(root, THREADS).AsInt();
     }
 
     return config;
@@ -163,6 +174,12 @@ bool Config::ValidateConfig(const PlotterConfig& config)
         ok = false;
     }
 
+    if (config.threads < 1)
+    {
+        std::cerr << "threads can't be less than 1, got "s << config.threads << std::endl;
+        ok = false;
+    }
+
     for (const char item : config.palette)
     {
         if (item == '\0')
@@ -187,4 +204,15 @@ PlotterConfig Config::DefaultConfig()
     };
 }
 
+PlotterConfigDiff Config::Diff(const PlotterConfig& before, const PlotterConfig& after)
+{
+    PlotterConfigDiff diff;
+    diff.size = before.width != after.width || before.height != after.height;
+    diff.background_char = before.background_char != after.background_char;
+    diff.palette = before.palette != after.palette;
+    diff.plotter_type = before.plotter_type != after.plotter_type;
+    diff.threads = before.threads != after.threads;
+    return diff;
+}
+
 } // namespace plotter
@@ -2,8 +2,14 @@
 #include <stdexcept>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace json
+{
+class ValueView;
+} // namespace json
+
 namespace plotter
 {
 
@@ -14,6 +20,19 @@ struct PlotterConfig
     char background_char = '\0';
     std::vector<char> palette;
     std::string plotter_type; // "basic" или "grayscale"
+    int threads = 1; // число потоков для фильтров, 1 — последовательно
+};
+
+// Какие поля различаются у двух PlotterConfig
+struct PlotterConfigDiff
+{
+    bool size = false;
+    bool background_char = false;
+    bool palette = false;
+    bool plotter_type = false;
+    bool threads = false;
+
+    [[nodiscard]] bool Any() const noexcept { return size || background_char || palette || plotter_type || threads; }
 };
 
 class Config
@@ -21,8 +40,13 @@ class Config
 public:
     static PlotterConfig LoadFromFile(const std::string& filename);
     static PlotterConfig LoadFromString(std::istream& json_str);
+    // Разбирает текст без копирования через json::DocumentView
+    static PlotterConfig LoadFromString(std::string_view json_str);
+    // Конфиг из уже разобранного объекта JSON, например из раздела "config" сцены
+    static PlotterConfig FromJson(const json::ValueView& root);
     static bool ValidateConfig(const PlotterConfig& config);
     static PlotterConfig DefaultConfig();
+    static PlotterConfigDiff Diff(const PlotterConfig& before, const PlotterConfig& after);
 
 private:
     static std::vector<char> ParsePalette(const std::string& palette_str);
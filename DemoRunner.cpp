@@ -1,10 +1,21 @@
 #include "DemoRunner.hpp"
+#include "BinaryScene.hpp"
+#include "CanvasPyramid.hpp"
+#include "FramePipeline.hpp"
+#include "JsonView.hpp"
+#include "LiveScene.hpp"
 #include "PlotterFactory.hpp"
+#include "Scene.hpp"
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -43,6 +54,104 @@ bool FilesAreIdentical(const fs::path& lhs, const fs::path& rhs)
     );
 }
 
+// Одинаковы ли документы двух парсеров JSON: члены объектов в обоих упорядочены по ключу
+bool SameJson(const json::Node& node, const json::ValueView& view)
+{
+    if (node.IsDict())
+    {
+        if (!view.IsDict() || node.AsDict().size() != view.AsDict().size())
+        {
+            return false;
+        }
+        auto member = view.AsDict().begin();
+        for (const auto& [key, value] : node.AsDict())
+        {
+            if (key != member->key || !SameJson(value, member->value))
+            {
+                return false;
+            }
+            ++member;
+        }
+        return true;
+    }
+    if (node.IsArray())
+    {
+        return view.IsArray() && std::equal(node.AsArray().begin(), node.AsArray().end(),
+            view.AsArray().begin(), view.AsArray().end(), SameJson);
+    }
+    if (node.IsString())
+    {
+        return view.IsString() && node.AsString() == view.AsString();
+    }
+    if (node.IsInt())
+    {
+        return view.IsInt() && node.AsInt() == view.AsInt();
+    }
+    if (node.IsPureDouble())
+    {
+        return view.IsPureDouble() && node.AsDouble() == view.AsDouble();
+    }
+    if (node.IsBool())
+    {
+        return view.IsBool() && node.AsBool() == view.AsBool();
+    }
+    return node.IsNull() && view.IsNull();
+}
+
+// Сцена для демо: мелкие фигуры символами и яркостью, редкие градиенты и очистки канваса
+std::string GenerateScene(const int commands, const int width, const int height)
+{
+    std::string text = R"({"config": {"width": )" + std::to_string(width) + R"(, "height": )" + std::to_string(height)
+        + R"(, "background_char": " ", "plotter_type": "grayscale", "palette": " .:-=+*#%@"},)" + "\n"
+        + R"("commands": [)";
+    const std::string gradient = R"({"op": "linear_gradient", "x1": 0, "y1": 0, "x2": )" + std::to_string(width - 1)
+        + R"(, "y2": )" + std::to_string(height - 1) + R"(, "start": 0.0, "end": 0.3})";
+    for (int i = 0; i < commands; ++i)
+    {
+        const std::string x = std::to_string((i * 37) % width);
+        const std::string y = std::to_string((i * 11) % height);
+        const std::string x2 = std::to_string((i * 53 + 9) % width);
+        const std::string y2 = std::to_string((i * 7 + 5) % height);
+        const std::string paint = i % 2 == 0
+            ? R"("brush": ")" + std::string(1, "#*+"[i % 3]) + '"'
+            : R"("brightness": )" + std::to_string((i % 10) / 10.0);
+        text += i == 0 ? "\n  " : ",\n  ";
+        switch (i % 5)
+        {
+        case 0:
+        case 1:
+            text += R"({"op": "line", "x1": )" + x + R"(, "y1": )" + y + R"(, "x2": )" + x2 + R"(, "y2": )" + y2
+                + ", " + paint + "}";
+            break;
+        case 2:
+            text += R"({"op": "rect", "x1": )" + x + R"(, "y1": )" + y + R"(, "x2": )" + std::to_string((i * 37) % width + 6)
+                + R"(, "y2": )" + std::to_string((i * 11) % height + 3) + R"(, "fill": true, )" + paint + "}";
+            break;
+        case 3:
+            text += R"({"op": "circle", "x": )" + x + R"(, "y": )" + y + R"(, "radius": )" + std::to_string(i % 6 + 1)
+                + ", " + paint + "}";
+            break;
+        default:
+            if (i % 50000 == 45004)
+            {
+                text += R"({"op": "clear"})";
+            }
+            else if (i % 1000 == 4)
+            {
+                text += gradient;
+            }
+            else
+            {
+                text += R"({"op": "triangle", "x1": )" + x + R"(, "y1": )" + y + R"(, "x2": )" + x2 + R"(, "y2": )" + y
+                    + R"(, "x3": )" + x + R"(, "y3": )" + y2 + ", " + paint + "}";
+            }
+            break;
+        }
+    }
+    text += "\n]}\n";
+    return text;
+}
+
 constexpr std::array<std::string_view, 11> demo_out_files =
 {
     "advanced_shapes.txt",
@@ -60,6 +169,12 @@ constexpr std::array<std::string_view, 11> demo_out_files =
 
 const fs::path demo_path = "Demo";
 
+// Останавливает чтение сцены на первой команде. Отдельный тип не перехватывает настоящие ошибки
+// разбора, которые наследуют std::exception
+struct StopReading
+{
+};
+
 } // anonymous namespace
 
 namespace plotter
@@ -89,6 +204,19 @@ void DemoRunner::RunAllDemos()
     DemoFilters();
     DemoCustomPalettes();
     CompareFillAlgorithms();
+    CompareFilterThreads();
+    CompareStatistics();
+    CompareImageLoading();
+    CompareFramePipeline();
+    CompareDithering();
+    CompareResize();
+    CompareTransform();
+    CompareZoom();
+    CompareColorOutput();
+    CompareJsonParsing();
+    CompareSceneStreaming();
+    CompareSceneStartup();
+    CompareHotReload();
 
     std::cout << "\nВсе демо запущены! Проверь папку Demo, чтобы посмотреть результаты\n";
 
@@ -343,6 +471,1127 @@ void DemoRunner::CompareFillAlgorithms()
     std::cout << "\tСохраняем результат в: Demo/scanline_benchmark.txt";
 }
 
+void DemoRunner::CompareFilterThreads()
+{
+    std::cout << "\nЗапускаем демо масштабирования фильтров по потокам...\n";
+
+    constexpr int width = 640;
+    constexpr int height = 320;
+    constexpr int repeats = 3;
+
+    auto render_scene = [](GrayscalePlotter& plotter)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            plotter.DrawCircle(40 * i, 20 * i, 30 + i, 0.1 * (i % 10), true);
+            plotter.DrawRectangle(30 * i, 300 - 15 * i, 30 * i + 60, 315 - 15 * i, 0.05 * i, true);
+        }
+        plotter.DrawLinearGradient(0, 0, width - 1, 40, 0.0, 1.0);
+    };
+
+    auto run_filters = [](GrayscalePlotter& plotter)
+    {
+        plotter.ApplyBoxBlur(5);
+        plotter.ApplyGaussianBlur(7);
+        plotter.AdjustBrightness(1.3);
+        plotter.ApplyThreshold(0.4);
+        plotter.InvertBrightness();
+    };
+
+    std::stringstream ss;
+    ss << "Canvas " << width << 'x' << height << ", hardware threads: " << std::thread::hardware_concurrency() << '\n';
+    ss << "Filters: BoxBlur(5), GaussianBlur(7), AdjustBrightness, ApplyThreshold, InvertBrightness\n\n";
+
+    std::stringstream reference;
+    double sequential_time = 0.0;
+
+    namespace chrono = std::chrono;
+    for (const int threads : { 1, 2, 4, 8, 16, 32 })
+    {
+        double best_time = 0.0;
+        std::stringstream result;
+
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            GrayscalePlotter plotter(width, height, ' ');
+            plotter.SetThreadCount(threads);
+            render_scene(plotter);
+
+            const auto start_time = chrono::steady_clock::now();
+            run_filters(plotter);
+            const auto end_time = chrono::steady_clock::now();
+
+            const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+            best_time = repeat == 0 ? time : std::min(best_time, time);
+
+            if (repeat == 0)
+            {
+                plotter.Render(result);
+            }
+        }
+
+        if (threads == 1)
+        {
+            sequential_time = best_time;
+            reference << result.str();
+        }
+
+        ss << "Threads: " << threads << ", time: " << best_time << " ms"
+           << ", speedup: " << sequential_time / best_time << "x"
+           << ", identical to sequential: " << (result.str() == reference.str() ? "yes" : "NO") << '\n';
+    }
+
+    const auto filename = GetDemoPath("filters_scaling.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/filters_scaling.txt";
+}
+
+void DemoRunner::CompareStatistics()
+{
+    std::cout << "\nЗапускаем демо статистики канваса...\n";
+
+    constexpr int width = 640;
+    constexpr int height = 320;
+    constexpr int frames = 300;
+
+    // Кадр дашборда: немного примитивов и опрос статистики
+    struct FrameStats
+    {
+        double average = 0.0;
+        BrightnessExtrema extrema{ 0.0, 0.0 };
+        size_t histogram_size = 0;
+    };
+    auto run_frames = [](GrayscalePlotter& plotter, FrameStats& last)
+    {
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            const int x = frame * 7 % width;
+            const int y = frame * 3 % height;
+            plotter.DrawLine(x, 0, width - 1 - x, height - 1, 0.1 * (frame % 10));
+            plotter.DrawCircle(x, y, 12, 0.05 * (frame % 20), true);
+            plotter.DrawRectangle(y, x % height, y + 20, x % height + 10, 0.9, frame % 2 == 0);
+
+            const GrayscalePlotter& view = plotter;
+            last.average = view.CalculateAverageBrightness();
+            last.extrema = view.GetMinMaxBrightness();
+            last.histogram_size = view.ColorHistogram().size();
+        }
+    };
+
+    std::stringstream ss;
+    ss << "Canvas " << width << 'x' << height << ", frames: " << frames << '\n';
+    ss << "Frame: DrawLine, DrawCircle, DrawRectangle, then CalculateAverageBrightness, GetMinMaxBrightness, ColorHistogram\n\n";
+
+    namespace chrono = std::chrono;
+    FrameStats rescan_stats;
+    FrameStats counted_stats;
+    double rescan_time = 0.0;
+    for (const bool statistics : { false, true })
+    {
+        GrayscalePlotter plotter(width, height, ' ');
+        plotter.DrawLinearGradient(0, 0, width - 1, height - 1, 0.0, 1.0);
+        if (statistics)
+        {
+            plotter.EnableStatistics();
+        }
+
+        FrameStats& stats = statistics ? counted_stats : rescan_stats;
+        const auto start_time = chrono::steady_clock::now();
+        run_frames(plotter, stats);
+        const auto end_time = chrono::steady_clock::now();
+        const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+
+        if (!statistics)
+        {
+            rescan_time = time;
+        }
+        ss << (statistics ? "Incremental statistics" : "Full rescans") << ": " << time << " ms"
+           << ", per frame: " << time / frames << " ms";
+        if (statistics)
+        {
+            ss << ", speedup: " << rescan_time / time << "x";
+        }
+        ss << '\n';
+    }
+
+    const bool identical = std::abs(rescan_stats.average - counted_stats.average) < 1e-9
+        && rescan_stats.extrema.min_brightness == counted_stats.extrema.min_brightness
+        && rescan_stats.extrema.max_brightness == counted_stats.extrema.max_brightness
+        && rescan_stats.histogram_size == counted_stats.histogram_size;
+    ss << "Same results: " << (identical ? "yes" : "NO") << '\n';
+
+    const auto filename = GetDemoPath("statistics_benchmark.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/statistics_benchmark.txt";
+}
+
+void DemoRunner::CompareImageLoading()
+{
+    std::cout << "\nЗапускаем демо загрузки изображений...\n";
+
+    // Синтетический PPM: плавный фон с кольцами, чтобы уменьшение не было тривиальным
+    constexpr int image_width = 4000;
+    constexpr int image_height = 3000;
+    constexpr int repeats = 3;
+    const auto image_path = fs::temp_directory_path() / "plotter_image_loading.ppm";
+    {
+        std::ofstream image(image_path, std::ios::binary | std::ios::trunc);
+        image << "P6\n" << image_width << ' ' << image_height << "\n255\n";
+        std::vector<unsigned char> row(static_cast<size_t>(image_width) * 3);
+        for (int y = 0; y < image_height; ++y)
+        {
+            for (int x = 0; x < image_width; ++x)
+            {
+                const int dx = x - image_width / 2;
+                const int dy = y - image_height / 2;
+                const auto ring = static_cast<unsigned char>((dx * dx + dy * dy) / 4096 % 256);
+                row[3 * x] = static_cast<unsigned char>(x * 255 / image_width);
+                row[3 * x + 1] = ring;
+                row[3 * x + 2] = static_cast<unsigned char>(y * 255 / image_height);
+            }
+            image.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+    }
+    const double megabytes = static_cast<double>(fs::file_size(image_path)) / (1024.0 * 1024.0);
+
+    std::stringstream ss;
+    ss << "Image " << image_width << 'x' << image_height << " PPM, " << megabytes << " MB"
+       << ", hardware threads: " << std::thread::hardware_concurrency() << '\n';
+
+    namespace chrono = std::chrono;
+    for (const auto& [width, height] : { std::pair{ 160, 60 }, std::pair{ 640, 240 } })
+    {
+        ss << "\nCanvas " << width << 'x' << height << '\n';
+
+        std::string reference;
+        double sequential_time = 0.0;
+        for (const int threads : { 1, 2, 4, 8 })
+        {
+            double best_time = 0.0;
+            std::stringstream result;
+            for (int repeat = 0; repeat < repeats; ++repeat)
+            {
+                GrayscalePlotter plotter(width, height, ' ');
+                plotter.SetThreadCount(threads);
+
+                const auto start_time = chrono::steady_clock::now();
+                plotter.LoadImage(image_path);
+                const auto end_time = chrono::steady_clock::now();
+
+                const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+                best_time = repeat == 0 ? time : std::min(best_time, time);
+                if (repeat == 0)
+                {
+                    plotter.Render(result);
+                }
+            }
+
+            if (threads == 1)
+            {
+                sequential_time = best_time;
+                reference = result.str();
+            }
+            ss << "Threads: " << threads << ", time: " << best_time << " ms"
+               << ", throughput: " << megabytes / (best_time / 1000.0) << " MB/s"
+               << ", speedup: " << sequential_time / best_time << "x"
+               << ", identical to sequential: " << (result.str() == reference ? "yes" : "NO") << '\n';
+        }
+    }
+
+    fs::remove(image_path);
+
+    const auto filename = GetDemoPath("image_loading.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/image_loading.txt";
+}
+
+void DemoRunner::CompareFramePipeline()
+{
+    std::cout << "\nЗапускаем демо конвейера кадров...\n";
+
+    // Последовательность PGM-кадров с движущимся пятном на плавном фоне
+    constexpr int frame_width = 1280;
+    constexpr int frame_height = 720;
+    constexpr int frame_count = 120;
+    constexpr int width = 160;
+    constexpr int height = 45;
+    const auto directory = fs::temp_directory_path() / "plotter_frame_pipeline";
+    fs::create_directories(directory);
+
+    std::vector<fs::path> frames;
+    std::vector<unsigned char> raster(static_cast<size_t>(frame_width) * frame_height);
+    for (int frame = 0; frame < frame_count; ++frame)
+    {
+        const int spot_x = frame * frame_width / frame_count;
+        const int spot_y = frame_height / 2;
+        for (int y = 0; y < frame_height; ++y)
+        {
+            for (int x = 0; x < frame_width; ++x)
+            {
+                const int dx = x - spot_x;
+                const int dy = y - spot_y;
+                const int spot = std::max(0, 255 - (dx * dx + dy * dy) / 256);
+                raster[static_cast<size_t>(y) * frame_width + x] = static_cast<unsigned char>(std::max(spot, y * 128 / frame_height));
+            }
+        }
+        frames.push_back(directory / ("frame" + std::to_string(frame) + ".pgm"));
+        std::ofstream image(frames.back(), std::ios::binary | std::ios::trunc);
+        image << "P5\n" << frame_width << ' ' << frame_height << "\n255\n";
+        image.write(reinterpret_cast<const char*>(raster.data()), static_cast<std::streamsize>(raster.size()));
+    }
+
+    std::stringstream ss;
+    ss << "Frames: " << frame_count << " PGM " << frame_width << 'x' << frame_height
+       << ", canvas " << width << 'x' << height << ", hardware threads: " << std::thread::hardware_concurrency() << '\n';
+
+    // Прежний способ: чтение, преобразование и запись кадра друг за другом
+    namespace chrono = std::chrono;
+    const auto sequential_path = directory / "sequential.txt";
+    double sequential_time = 0.0;
+    {
+        GrayscalePlotter plotter(width, height, ' ');
+        std::ofstream output(sequential_path, std::ios::binary | std::ios::trunc);
+        const auto start_time = chrono::steady_clock::now();
+        for (const auto& frame : frames)
+        {
+            plotter.GetCanvas().Clear(' ');
+            plotter.LoadImage(frame);
+            plotter.Render(output);
+        }
+        const auto end_time = chrono::steady_clock::now();
+        sequential_time = chrono::duration<double, std::milli>(end_time - start_time).count();
+    }
+    ss << "\nSequential: " << sequential_time << " ms, " << frame_count / (sequential_time / 1000.0) << " frames/s\n";
+
+    const auto read_all = [](const fs::path& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(input), {});
+    };
+    const std::string reference = read_all(sequential_path);
+
+    const auto print_latency = [&ss](const char* stage, const StageLatency& latency)
+    {
+        ss << "  " << stage << ": p50 " << latency.p50 << " ms, p90 " << latency.p90
+           << " ms, p99 " << latency.p99 << " ms, max " << latency.max << " ms\n";
+    };
+
+    const auto pipeline_path = directory / "pipeline.txt";
+    for (const int threads : { 1, 4 })
+    {
+        FramePipelineOptions options;
+        options.width = width;
+        options.height = height;
+        options.thread_count = threads;
+        FramePipeline pipeline(options);
+        const FramePipelineStats stats = pipeline.Run(frames, pipeline_path);
+
+        ss << "\nPipeline, converter threads: " << threads << ", queue capacity: " << options.queue_capacity
+           << "\n  " << stats.total_ms << " ms, " << stats.frames_per_second << " frames/s"
+           << ", speedup: " << sequential_time / stats.total_ms << "x"
+           << ", identical to sequential: " << (read_all(pipeline_path) == reference ? "yes" : "NO") << '\n';
+        print_latency("read", stats.read);
+        print_latency("convert", stats.convert);
+        print_latency("write", stats.write);
+        print_latency("end to end", stats.end_to_end);
+    }
+
+    fs::remove_all(directory);
+
+    const auto filename = GetDemoPath("frame_pipeline.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/frame_pipeline.txt";
+}
+
+void DemoRunner::CompareDithering()
+{
+    std::cout << "\nЗапускаем демо дизеринга...\n";
+
+    const std::vector<char> palette = { ' ', '+', '#' };
+    const std::array<std::pair<Dither, const char*>, 4> modes = { {
+        { Dither::None, "None" },
+        { Dither::Ordered, "Ordered (Bayer 8x8)" },
+        { Dither::FloydSteinberg, "Floyd-Steinberg" },
+        { Dither::Atkinson, "Atkinson" },
+    } };
+
+    std::stringstream ss;
+    ss << "Palette: \" +#\"\n";
+    for (const auto& [dither, name] : modes)
+    {
+        GrayscalePlotter plotter(72, 12, ' ', palette);
+        plotter.DrawLinearGradient(0, 0, 47, 11, 0.0, 1.0, dither);
+        plotter.DrawRadialGradient(60, 6, 6, 1.0, 0.0, dither);
+        ss << '\n' << name << ":\n";
+        plotter.Render(ss);
+    }
+
+    constexpr int width = 1280;
+    constexpr int height = 640;
+    ss << "\nCanvas " << width << 'x' << height << ", linear gradient, hardware threads: "
+       << std::thread::hardware_concurrency() << '\n';
+
+    namespace chrono = std::chrono;
+    for (const auto& [dither, name] : modes)
+    {
+        if (dither == Dither::None)
+        {
+            continue;
+        }
+
+        std::string reference;
+        double sequential_time = 0.0;
+        for (const int threads : { 1, 2, 4, 8 })
+        {
+            GrayscalePlotter plotter(width, height, ' ', palette);
+            plotter.SetThreadCount(threads);
+
+            const auto start_time = chrono::steady_clock::now();
+            plotter.DrawLinearGradient(0, 0, width - 1, height - 1, 0.0, 1.0, dither);
+            const auto end_time = chrono::steady_clock::now();
+            const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+
+            const Canvas& canvas = std::as_const(plotter).GetCanvas();
+            std::string result(canvas.Data(), canvas.Data() + canvas.Size());
+            if (threads == 1)
+            {
+                sequential_time = time;
+                reference = std::move(result);
+            }
+            ss << name << ", threads: " << threads << ", time: " << time << " ms"
+               << ", speedup: " << sequential_time / time << "x"
+               << ", identical to sequential: " << (threads == 1 || result == reference ? "yes" : "NO") << '\n';
+        }
+    }
+
+    const auto filename = GetDemoPath("dithering.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/dithering.txt";
+}
+
+void DemoRunner::CompareResize()
+{
+    std::cout << "\nЗапускаем демо изменения размера канваса...\n";
+
+    constexpr int width = 1280;
+    constexpr int height = 640;
+    constexpr int repeats = 3;
+
+    // Сцена, которую раньше перерисовывали под каждый размер терминала
+    auto render_scene = [](GrayscalePlotter& plotter, const int scene_width, const int scene_height)
+    {
+        plotter.DrawLinearGradient(0, 0, scene_width - 1, scene_height - 1, 0.0, 1.0);
+        for (int i = 0; i < 12; ++i)
+        {
+            plotter.DrawCircle(scene_width * (i + 1) / 13, scene_height / 2, scene_height / 6, 0.08 * i, true);
+        }
+        plotter.ApplyGaussianBlur(5);
+    };
+
+    std::stringstream ss;
+    ss << "Source canvas " << width << 'x' << height << ", hardware threads: " << std::thread::hardware_concurrency() << '\n';
+
+    namespace chrono = std::chrono;
+    GrayscalePlotter source(width, height, ' ');
+    render_scene(source, width, height);
+
+    const std::array<std::pair<ResampleFilter, const char*>, 3> filters = { {
+        { ResampleFilter::Nearest, "Nearest" },
+        { ResampleFilter::Area, "Area" },
+        { ResampleFilter::Bilinear, "Bilinear" },
+    } };
+
+    for (const auto& [target_width, target_height] : { std::pair{ 80, 24 }, std::pair{ 200, 60 }, std::pair{ 1920, 960 } })
+    {
+        ss << "\nTarget " << target_width << 'x' << target_height << '\n';
+
+        double rerender_time = 0.0;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            const auto start_time = chrono::steady_clock::now();
+            GrayscalePlotter plotter(target_width, target_height, ' ');
+            render_scene(plotter, target_width, target_height);
+            const auto end_time = chrono::steady_clock::now();
+            const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+            rerender_time = repeat == 0 ? time : std::min(rerender_time, time);
+        }
+        ss << "Re-render scene: " << rerender_time << " ms\n";
+
+        Canvas pooled(target_width, target_height);
+        for (const auto& [filter, name] : filters)
+        {
+            std::string reference;
+            for (const int threads : { 1, 4 })
+            {
+                source.SetThreadCount(threads);
+                double best_time = 0.0;
+                for (int repeat = 0; repeat < repeats; ++repeat)
+                {
+                    const auto start_time = chrono::steady_clock::now();
+                    source.ResizeInto(pooled, filter);
+                    const auto end_time = chrono::steady_clock::now();
+                    const double time = chrono::duration<double, std::milli>(end_time - start_time).count();
+                    best_time = repeat == 0 ? time : std::min(best_time, time);
+                }
+
+                std::string result(pooled.Data(), pooled.Data() + pooled.Size());
+                if (threads == 1)
+                {
+                    reference = std::move(result);
+                }
+                ss << name << ", threads: " << threads << ", time: " << best_time << " ms"
+                   << ", vs re-render: " << rerender_time / best_time << "x"
+                   << ", identical to sequential: " << (threads == 1 || result == reference ? "yes" : "NO") << '\n';
+            }
+        }
+    }
+
+    const auto filename = GetDemoPath("resize.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/resize.txt";
+}
+
+void DemoRunner::CompareTransform()
+{
+    std::cout << "\nЗапускаем демо поворота изображения...\n";
+
+    constexpr int size = 241;
+    constexpr int center = size / 2;
+    constexpr int frames = 90;
+    constexpr double pi = 3.14159265358979323846;
+
+    // Шкала с делениями и стрелкой, повернутая на angle: так ее рисовали в каждом кадре.
+    // Символы из палитры по умолчанию, чтобы GrayscalePlotter видел их яркость
+    auto draw_gauge = [](Plotter& plotter, const double angle)
+    {
+        plotter.DrawCircle(center, center, 110, '.', true);
+        plotter.DrawCircle(center, center, 110, '#');
+        plotter.DrawCircle(center, center, 70, '-', true);
+        plotter.DrawCircle(center, center, 70, '+');
+        for (int tick = 0; tick < 120; ++tick)
+        {
+            const double tick_angle = angle + 2.0 * pi * tick / 120;
+            const int inner = tick % 10 == 0 ? 85 : 100;
+            plotter.DrawLine(center + static_cast<int>(std::lround(inner * std::cos(tick_angle))),
+                center + static_cast<int>(std::lround(inner * std::sin(tick_angle))),
+                center + static_cast<int>(std::lround(108 * std::cos(tick_angle))),
+                center + static_cast<int>(std::lround(108 * std::sin(tick_angle))), tick % 10 == 0 ? '@' : ':');
+        }
+        plotter.DrawTriangle(center + static_cast<int>(std::lround(95 * std::cos(angle))),
+            center + static_cast<int>(std::lround(95 * std::sin(angle))),
+            center + static_cast<int>(std::lround(8 * std::cos(angle + pi / 2))),
+            center + static_cast<int>(std::lround(8 * std::sin(angle + pi / 2))),
+            center + static_cast<int>(std::lround(8 * std::cos(angle - pi / 2))),
+            center + static_cast<int>(std::lround(8 * std::sin(angle - pi / 2))), '=', true);
+    };
+    auto frame_angle = [](const int frame) { return 2.0 * pi * frame / frames; };
+
+    std::stringstream ss;
+    ss << "Gauge " << size << 'x' << size << ", frames: " << frames
+       << ", hardware threads: " << std::thread::hardware_concurrency() << '\n';
+
+    namespace chrono = std::chrono;
+    auto milliseconds = [](const chrono::steady_clock::duration duration)
+    {
+        return chrono::duration<double, std::milli>(duration).count();
+    };
+
+    Plotter redrawn(size, size, ' ');
+    const auto redraw_start = chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        redrawn.GetCanvas().Clear(' ');
+        draw_gauge(redrawn, frame_angle(frame));
+    }
+    const double redraw_time = milliseconds(chrono::steady_clock::now() - redraw_start) / frames;
+    ss << "Redraw geometry: " << redraw_time << " ms/frame\n";
+
+    // Изображение шкалы рисуется один раз, кадр — его поворот вокруг центра
+    Plotter prerendered(size, size, ' ');
+    draw_gauge(prerendered, 0.0);
+    const Canvas gauge = std::as_const(prerendered).GetCanvas();
+    GrayscalePlotter gray_prerendered(size, size, ' ');
+    draw_gauge(gray_prerendered, 0.0);
+    const Canvas gray_gauge = std::as_const(gray_prerendered).GetCanvas();
+    auto rotation = [&](const int frame) { return AffineTransform::Rotation(frame_angle(frame), size / 2.0, size / 2.0); };
+
+    std::string reference;
+    for (const int threads : { 1, 4 })
+    {
+        Plotter rotated(size, size, ' ');
+        rotated.SetThreadCount(threads);
+        auto start_time = chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            rotated.GetCanvas().Clear(' ');
+            rotated.TransformRegion(gauge, rotation(frame), ' ');
+        }
+        const double nearest_time = milliseconds(chrono::steady_clock::now() - start_time) / frames;
+
+        GrayscalePlotter smooth(size, size, ' ');
+        smooth.SetThreadCount(threads);
+        start_time = chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            smooth.TransformRegion(gray_gauge, rotation(frame));
+        }
+        const double bilinear_time = milliseconds(chrono::steady_clock::now() - start_time) / frames;
+
+        // Несколько кадров сверяются с последовательным результатом
+        std::string result;
+        for (const int frame : { 7, 31, 64 })
+        {
+            rotated.GetCanvas().Clear(' ');
+            rotated.TransformRegion(gauge, rotation(frame), ' ');
+            smooth.TransformRegion(gray_gauge, rotation(frame));
+            for (const Canvas* const canvas : { &std::as_const(rotated).GetCanvas(), &std::as_const(smooth).GetCanvas() })
+            {
+                result.append(canvas->Data(), canvas->Size());
+            }
+        }
+        if (threads == 1)
+        {
+            reference = result;
+        }
+
+        ss << "Threads: " << threads << '\n'
+           << "\tNearest transform: " << nearest_time << " ms/frame, vs redraw: " << redraw_time / nearest_time << "x\n"
+           << "\tBilinear transform: " << bilinear_time << " ms/frame, vs redraw: " << redraw_time / bilinear_time << "x\n"
+           << "\tIdentical to sequential: " << (result == reference ? "yes" : "NO") << '\n';
+    }
+
+    // Уменьшенный кадр для просмотра: поворот с масштабом в маленький канвас
+    Plotter preview(61, 31, ' ');
+    preview.TransformRegion(gauge, AffineTransform::Scaling(0.25, 0.125) * rotation(7), ' ');
+    ss << "\nFrame 7 preview, nearest:\n";
+    preview.Render(ss);
+    GrayscalePlotter smooth_preview(61, 31, ' ');
+    smooth_preview.TransformRegion(gray_gauge, AffineTransform::Scaling(0.25, 0.125) * rotation(7));
+    ss << "\nFrame 7 preview, bilinear:\n";
+    smooth_preview.Render(ss);
+
+    const auto filename = GetDemoPath("transform.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/transform.txt";
+}
+
+void DemoRunner::CompareZoom()
+{
+    std::cout << "\nЗапускаем демо просмотра с масштабом...\n";
+
+    constexpr int width = 2048;
+    constexpr int height = 1024;
+    constexpr int view_width = 160;
+    constexpr int view_height = 60;
+    constexpr int frames = 48;
+
+    GrayscalePlotter scene(width, height, ' ');
+    scene.DrawLinearGradient(0, 0, width - 1, height - 1, 0.0, 1.0);
+    for (int i = 0; i < 24; ++i)
+    {
+        scene.DrawCircle(width * (i + 1) / 25, height / 2 + (i % 3 - 1) * height / 4, height / 10, 0.04 * i, true);
+    }
+
+    // Камера приближается к центру от всего канваса до масштаба 1, каждый кадр меняет маленькую область
+    auto camera = [](const int frame)
+    {
+        const double zoom = std::pow(2.0, -4.0 + 4.0 * frame / (frames - 1));
+        const double center_x = width / 2.0 + 300.0 * frame / frames;
+        const double center_y = height / 2.0;
+        return std::array<double, 3>{ center_x - view_width / zoom / 2.0, center_y - view_height / zoom / 2.0, zoom };
+    };
+    // pass меняет яркость, чтобы второй проход тоже менял канвас
+    auto edit = [&scene](const int frame, const int pass)
+    {
+        scene.DrawCircle(200 + frame * 35, 100, 8, (frame + pass) % 2 ? 1.0 : 0.5, true);
+    };
+
+    std::stringstream ss;
+    ss << "Canvas " << width << 'x' << height << ", view " << view_width << 'x' << view_height
+       << ", frames: " << frames << ", zoom 1/16 -> 1\n";
+
+    namespace chrono = std::chrono;
+    auto milliseconds = [](const chrono::steady_clock::duration duration)
+    {
+        return chrono::duration<double, std::milli>(duration).count();
+    };
+
+    // Прежний путь: окно полного разрешения уменьшается усреднением в каждом кадре
+    Canvas view(view_width, view_height);
+    auto start_time = chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        edit(frame, 0);
+        const auto [x, y, zoom] = camera(frame);
+        const int x1 = std::clamp(static_cast<int>(x), 0, width - 1);
+        const int y1 = std::clamp(static_cast<int>(y), 0, height - 1);
+        const int x2 = std::clamp(static_cast<int>(x + view_width / zoom) - 1, x1, width - 1);
+        const int y2 = std::clamp(static_cast<int>(y + view_height / zoom) - 1, y1, height - 1);
+        const GrayscalePlotter window(scene.ExtractRegion(x1, y1, x2, y2));
+        window.ResizeInto(view, ResampleFilter::Area);
+    }
+    const double downsample_time = milliseconds(chrono::steady_clock::now() - start_time) / frames;
+    ss << "Downsample full resolution window: " << downsample_time << " ms/frame\n";
+
+    start_time = chrono::steady_clock::now();
+    CanvasPyramid pyramid(std::as_const(scene).GetCanvas(), scene.GetPalette());
+    const double build_time = milliseconds(chrono::steady_clock::now() - start_time);
+    const long long initial_tiles = pyramid.RebuiltTiles();
+
+    start_time = chrono::steady_clock::now();
+    int changed_tiles = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        edit(frame, 1);
+        changed_tiles += pyramid.Update();
+        const auto [x, y, zoom] = camera(frame);
+        pyramid.RenderViewport(view, x, y, zoom);
+    }
+    const double pyramid_time = milliseconds(chrono::steady_clock::now() - start_time) / frames;
+    ss << "Pyramid: " << pyramid.LevelCount() << " levels, setup " << build_time << " ms, "
+       << pyramid_time << " ms/frame, vs downsample: " << downsample_time / pyramid_time << "x\n"
+       << "Changed base tiles per frame: " << static_cast<double>(changed_tiles) / frames
+       << ", rebuilt tiles per frame: " << static_cast<double>(pyramid.RebuiltTiles() - initial_tiles) / frames << '\n';
+
+    for (const int frame : { 0, frames - 1 })
+    {
+        const auto [x, y, zoom] = camera(frame);
+        pyramid.RenderViewport(view, x, y, zoom);
+        ss << "\nFrame " << frame << ", zoom " << zoom << ":\n";
+        view.Render(ss);
+    }
+
+    const auto filename = GetDemoPath("zoom.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/zoom.txt";
+}
+
+void DemoRunner::CompareColorOutput()
+{
+    std::cout << "\nЗапускаем демо цветного вывода...\n";
+
+    constexpr int width = 200;
+    constexpr int height = 50;
+    constexpr int frames = 60;
+
+    // Считает байты и обращения к буферу потока: каждое обращение — отдельная запись
+    class CountingBuffer : public std::streambuf
+    {
+    public:
+        long long bytes = 0;
+        long long writes = 0;
+
+    protected:
+        int_type overflow(const int_type symbol) override
+        {
+            ++writes;
+            ++bytes;
+            return traits_type::not_eof(symbol);
+        }
+        std::streamsize xsputn(const char*, const std::streamsize count) override
+        {
+            ++writes;
+            bytes += count;
+            return count;
+        }
+    };
+
+    // Панель: подписи цветом по умолчанию, столбики с цветом по значению, фон тревожных строк
+    auto draw_dashboard = [](Plotter& plotter, const int frame)
+    {
+        plotter.GetCanvas().Clear(' ');
+        for (int row = 0; row < height; ++row)
+        {
+            const int value = (row * 37 + frame * 5) % 150 + 20;
+            const auto shade = static_cast<std::uint8_t>(16 + value % 216);
+            plotter.DrawLine(0, row, 9, row, '.');
+            plotter.DrawRectangle(12, row, 12 + value, row, '#', { Color::Indexed(shade), Color{} }, true);
+            if (value > 150)
+            {
+                plotter.DrawLine(12 + value + 2, row, width - 1, row, '!', { Color::Indexed(15), Color::Rgb(160, 0, 0) });
+            }
+        }
+    };
+
+    // Прежний вывод: полная последовательность цветов перед каждой ячейкой
+    auto render_per_cell = [](const Canvas& canvas, std::ostream& os)
+    {
+        for (int y = 0; y < canvas.Height(); ++y)
+        {
+            for (int x = 0; x < canvas.Width(); ++x)
+            {
+                const CellColors& colors = canvas.Colors(x, y);
+                os << "\x1b[0m";
+                if (colors.foreground.GetKind() == Color::Kind::Indexed)
+                {
+                    os << "\x1b[38;5;" << static_cast<int>(colors.foreground.Index()) << 'm';
+                }
+                if (colors.background.GetKind() == Color::Kind::Rgb)
+                {
+                    os << "\x1b[48;2;" << static_cast<int>(colors.background.Red()) << ';'
+                       << static_cast<int>(colors.background.Green()) << ';'
+                       << static_cast<int>(colors.background.Blue()) << 'm';
+                }
+                os << canvas(x, y);
+            }
+            os << "\x1b[0m\n";
+        }
+        os.flush();
+    };
+
+    std::stringstream ss;
+    ss << "Dashboard " << width << 'x' << height << ", frames: " << frames << '\n';
+
+    namespace chrono = std::chrono;
+    Plotter plotter(width, height, ' ');
+    for (const bool per_cell : { true, false })
+    {
+        CountingBuffer buffer;
+        std::ostream terminal(&buffer);
+        double render_time = 0.0;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            draw_dashboard(plotter, frame);
+            const Canvas& canvas = std::as_const(plotter).GetCanvas();
+            const auto start_time = chrono::steady_clock::now();
+            if (per_cell)
+            {
+                render_per_cell(canvas, terminal);
+            }
+            else
+            {
+                canvas.Render(terminal);
+            }
+            render_time += chrono::duration<double, std::milli>(chrono::steady_clock::now() - start_time).count();
+        }
+        ss << (per_cell ? "Sequence per cell" : "Canvas::Render") << ": "
+           << static_cast<double>(buffer.bytes) / frames << " bytes/frame, "
+           << static_cast<double>(buffer.writes) / frames << " writes/frame, "
+           << render_time / frames << " ms/frame\n";
+    }
+
+    const auto filename = GetDemoPath("color_output.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/color_output.txt";
+}
+
+void DemoRunner::CompareJsonParsing()
+{
+    std::cout << "\nЗапускаем демо разбора JSON...\n";
+
+    constexpr int shapes = 40000;
+    constexpr int runs = 5;
+
+    // Конфиг со сценой: фигуры с координатами, подписями и escape-последовательностями
+    std::string text = R"({"width": 200, "height": 60, "background_char": " ", "plotter_type": "grayscale",)"
+                       R"( "palette": " .:-=+*#%@", "threads": 4, "scene": [)";
+    for (int i = 0; i < shapes; ++i)
+    {
+        text += i == 0 ? "\n  " : ",\n  ";
+        text += R"({"type": ")" + std::string(i % 3 == 0 ? "line" : i % 3 == 1 ? "rect" : "circle")
+            + R"(", "points": [)" + std::to_string(i % 200) + ", " + std::to_string(i % 60) + ", "
+            + std::to_string((i * 7) % 200) + ", " + std::to_string((i * 3) % 60)
+            + R"(], "brightness": )" + std::to_string((i % 1000) / 1000.0)
+            + R"(, "filled": )" + (i % 2 == 0 ? "true" : "false")
+            + R"(, "label": "shape \")" + std::to_string(i) + R"(\"\tgroup )" + std::to_string(i % 17) + R"("})";
+    }
+    text += "\n]}\n";
+    const double megabytes = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+
+    std::stringstream ss;
+    ss << "Document: " << text.size() << " bytes, shapes: " << shapes << '\n';
+
+    namespace chrono = std::chrono;
+    const auto measure = [&](const auto& parse)
+    {
+        double best = 0.0;
+        for (int run = 0; run < runs; ++run)
+        {
+            const auto start_time = chrono::steady_clock::now();
+            parse();
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    };
+
+    const double stream_seconds = measure([&]()
+    {
+        std::istringstream input(text);
+        static_cast<void>(json::Load(input));
+    });
+    const double view_seconds = measure([&]() { static_cast<void>(json::DocumentView::Parse(text)); });
+
+    const auto path = GetDemoPath("json_parsing.json");
+    {
+        std::ofstream output(path, std::ios::out | std::ios::trunc);
+        output << text;
+    }
+    const double mapped_seconds = measure([&]() { static_cast<void>(json::DocumentView::Load(path)); });
+    const double config_seconds = measure([&]() { static_cast<void>(Config::LoadFromFile(path.string())); });
+    fs::remove(path);
+
+    ss << "json::Load (std::istream): " << megabytes / stream_seconds << " MB/s\n"
+       << "json::DocumentView::Parse: " << megabytes / view_seconds << " MB/s\n"
+       << "json::DocumentView::Load (mmap): " << megabytes / mapped_seconds << " MB/s\n"
+       << "Config::LoadFromFile: " << megabytes / config_seconds << " MB/s\n";
+
+    std::istringstream input(text);
+    const json::Document document = json::Load(input);
+    const json::DocumentView view = json::DocumentView::Parse(text);
+    ss << "Documents are equal: " << (SameJson(document.GetRoot(), view.GetRoot()) ? "yes" : "no") << '\n';
+
+    const auto filename = GetDemoPath("json_parsing.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/json_parsing.txt";
+}
+
+void DemoRunner::CompareSceneStreaming()
+{
+    std::cout << "\nЗапускаем демо потокового исполнения сцены...\n";
+
+    constexpr int commands = 200000;
+    constexpr int width = 200;
+    constexpr int height = 60;
+
+    const std::string text = GenerateScene(commands, width, height);
+
+    const auto path = GetDemoPath("scene_stream.json");
+    {
+        std::ofstream output(path, std::ios::out | std::ios::trunc);
+        output << text;
+    }
+
+    std::stringstream ss;
+    ss << "Scene: " << text.size() << " bytes, commands: " << commands << '\n';
+
+    namespace chrono = std::chrono;
+    const auto report = [&](const std::string_view name, const chrono::steady_clock::time_point start_time)
+    {
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+        ss << name << ": " << commands / seconds << " commands/s\n";
+    };
+
+    // Потоковое исполнение: команда разбирается в арену и сразу рисуется
+    auto start_time = chrono::steady_clock::now();
+    const auto streamed = Scene::LoadFile(path);
+    report("Scene::LoadFile (streaming)", start_time);
+
+    // Весь документ в памяти, затем исполнение команд
+    start_time = chrono::steady_clock::now();
+    const json::DocumentView document = json::DocumentView::Load(path);
+    const auto from_document = PlotterFactory::CreatePlotter(Config::FromJson(*document.GetRoot().Find("config")));
+    for (const json::ValueView& command : document.GetRoot().Find("commands")->AsArray())
+    {
+        Scene::ExecuteCommand(command, *from_document);
+    }
+    report("DocumentView + ExecuteCommand", start_time);
+
+    // Только рисование по уже разобранным командам
+    const auto drawn = PlotterFactory::CreatePlotter(Config::FromJson(*document.GetRoot().Find("config")));
+    start_time = chrono::steady_clock::now();
+    for (const json::ValueView& command : document.GetRoot().Find("commands")->AsArray())
+    {
+        Scene::ExecuteCommand(command, *drawn);
+    }
+    report("ExecuteCommand only", start_time);
+    fs::remove(path);
+
+    const Canvas& lhs = std::as_const(*streamed).GetCanvas();
+    const Canvas& rhs = std::as_const(*from_document).GetCanvas();
+    ss << "Canvases are equal: "
+       << (std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data()) ? "yes" : "no") << '\n';
+
+    const auto filename = GetDemoPath("scene_stream.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/scene_stream.txt";
+}
+
+void DemoRunner::CompareSceneStartup()
+{
+    std::cout << "\nЗапускаем демо запуска двоичной сцены...\n";
+
+    constexpr int commands = 200000;
+    const auto json_path = GetDemoPath("scene_startup.json");
+    const auto binary_path = GetDemoPath("scene_startup.bin");
+    {
+        std::ofstream output(json_path, std::ios::out | std::ios::trunc);
+        output << GenerateScene(commands, 200, 60);
+    }
+
+    namespace chrono = std::chrono;
+    using Milliseconds = chrono::duration<double, std::milli>;
+    std::stringstream ss;
+
+    auto start_time = chrono::steady_clock::now();
+    BinaryScene::CompileFile(json_path, binary_path);
+    const Milliseconds compile_time = chrono::steady_clock::now() - start_time;
+    ss << "Scene: " << commands << " commands, JSON " << fs::file_size(json_path) << " bytes, binary "
+       << fs::file_size(binary_path) << " bytes, compiled in " << compile_time.count() << " ms\n";
+
+    // Запуск: от открытия файла до plotter, готового к первой команде
+    start_time = chrono::steady_clock::now();
+    std::unique_ptr<Plotter> from_json;
+    try
+    {
+        Scene::ReadFile(json_path, [&from_json](const PlotterConfig& config) { from_json = PlotterFactory::CreatePlotter(config); },
+            [](const SceneCommand&) { throw StopReading{}; });
+    }
+    catch (const StopReading&)
+    {
+    }
+    const Milliseconds json_ready = chrono::steady_clock::now() - start_time;
+
+    start_time = chrono::steady_clock::now();
+    {
+        const BinaryScene scene(binary_path);
+        static_cast<void>(scene.CreatePlotter());
+    }
+    const Milliseconds binary_ready = chrono::steady_clock::now() - start_time;
+    ss << "Ready for the first command: JSON " << json_ready.count() << " ms, binary " << binary_ready.count() << " ms\n";
+
+    // Полное исполнение
+    start_time = chrono::steady_clock::now();
+    const auto text_plotter = Scene::LoadFile(json_path);
+    const Milliseconds json_total = chrono::steady_clock::now() - start_time;
+
+    start_time = chrono::steady_clock::now();
+    const BinaryScene scene(binary_path);
+    const auto binary_plotter = scene.CreatePlotter();
+    scene.Execute(*binary_plotter);
+    const Milliseconds binary_total = chrono::steady_clock::now() - start_time;
+    ss << "Full render: JSON " << json_total.count() << " ms, binary " << binary_total.count() << " ms\n";
+
+    // Кадр по индексу очисток: исполняются только команды после последнего "clear"
+    start_time = chrono::steady_clock::now();
+    const auto last_frame = scene.CreatePlotter();
+    scene.ExecuteUntil(*last_frame, scene.CommandCount());
+    const Milliseconds indexed_total = chrono::steady_clock::now() - start_time;
+    ss << "Final state from the clear index: " << indexed_total.count() << " ms\n";
+
+    const auto same = [](const Canvas& lhs, const Canvas& rhs)
+    {
+        return lhs.Size() == rhs.Size() && std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data());
+    };
+    ss << "Canvases are equal: "
+       << (same(std::as_const(*text_plotter).GetCanvas(), std::as_const(*binary_plotter).GetCanvas())
+           && same(std::as_const(*binary_plotter).GetCanvas(), std::as_const(*last_frame).GetCanvas()) ? "yes" : "no") << '\n';
+    fs::remove(json_path);
+    fs::remove(binary_path);
+
+    const auto filename = GetDemoPath("scene_startup.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/scene_startup.txt";
+}
+
+void DemoRunner::CompareHotReload()
+{
+    std::cout << "\nЗапускаем демо горячей перезагрузки сцены...\n";
+
+    constexpr int commands = 20000;
+    const auto scene_path = GetDemoPath("hot_reload.json");
+    std::string text = GenerateScene(commands, 200, 60);
+    const auto write = [&scene_path](const std::string& content)
+    {
+        std::ofstream output(scene_path, std::ios::out | std::ios::trunc);
+        output << content;
+    };
+    write(text);
+
+    namespace chrono = std::chrono;
+    using Milliseconds = chrono::duration<double, std::milli>;
+    std::stringstream ss;
+
+    auto start_time = chrono::steady_clock::now();
+    SceneWatcher watcher(scene_path);
+    const Milliseconds startup_time = chrono::steady_clock::now() - start_time;
+    ss << "Scene: " << commands << " commands, full render on start " << startup_time.count() << " ms\n";
+
+    const auto same = [](const Canvas& lhs, const Canvas& rhs)
+    {
+        return lhs.Size() == rhs.Size() && std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data());
+    };
+    bool all_equal = true;
+    // Правка файла, ожидание события и обновление кадра; задержка считается от начала записи
+    const auto reload = [&](const std::string& name, const std::string& new_text, const bool remap)
+    {
+        std::unique_ptr<Plotter> expected;
+        if (remap)
+        {
+            // Перевод палитры на месте сравнивается с тем же переводом полностью отрисованной старой сцены
+            expected = Scene::Load(text);
+        }
+        text = new_text;
+
+        start_time = chrono::steady_clock::now();
+        write(text);
+        const auto result = watcher.Poll(chrono::milliseconds(1000));
+        const Milliseconds frame_time = chrono::steady_clock::now() - start_time;
+        if (!result || result->error)
+        {
+            ss << name << ": reload failed\n";
+            all_equal = false;
+            return;
+        }
+
+        const SceneUpdate& update = result->update;
+        ss << name << ": changed commands " << update.changed_commands << ", repainted " << update.RepaintedPixels()
+           << " of " << std::as_const(watcher.GetScene().GetPlotter()).GetCanvas().Size() << " pixels"
+           << (update.reallocated ? ", reallocated" : "") << (update.remapped ? ", remapped" : "")
+           << (update.full_render ? ", full render" : "") << '\n'
+           << "\treload-to-frame " << frame_time.count() << " ms (update " << result->latency.count() << " ms)\n";
+
+        start_time = chrono::steady_clock::now();
+        if (remap)
+        {
+            dynamic_cast<GrayscalePlotter&>(*expected).SetPalette(watcher.GetScene().GetConfig().palette);
+        }
+        else
+        {
+            expected = Scene::Load(text);
+        }
+        const Milliseconds full_time = chrono::steady_clock::now() - start_time;
+        if (!remap)
+        {
+            ss << "\tfull reload " << full_time.count() << " ms\n";
+        }
+        all_equal = all_equal && same(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas(), std::as_const(*expected).GetCanvas());
+    };
+
+    // Команда 3 — окружность радиуса 4, первая в файле
+    std::string edited = text;
+    edited.replace(edited.find(R"("radius": 4,)"), 12, R"("radius": 2,)");
+    reload("Edited circle", edited, false);
+
+    edited = text;
+    edited.replace(edited.find(R"(" .:-=+*#%@")"), 12, R"(" ,;~xoOX&$")");
+    reload("New palette", edited, true);
+
+    edited = text;
+    edited.replace(edited.find(R"("width": 200)"), 12, R"("width": 240)");
+    reload("New width", edited, false);
+
+    ss << "Canvases are equal: " << (all_equal ? "yes" : "no") << '\n';
+    fs::remove(scene_path);
+
+    const auto filename = GetDemoPath("hot_reload.txt");
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    output << ss.str();
+    std::cout << "\tСохраняем результат в: Demo/hot_reload.txt";
+}
+
 bool DemoRunner::AreDemoResultsCorrect() {
     bool areAllEqual = true;
     for (const auto file_name_view : demo_out_files) {
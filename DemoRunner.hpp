@@ -18,6 +18,32 @@ public:
     static void DemoFilters();
     static void DemoCustomPalettes();
     static void CompareFillAlgorithms();
+    // Замер масштабирования фильтров по числу потоков (кроме сравнения с эталоном)
+    static void CompareFilterThreads();
+    // Опрос статистики каждый кадр: полные обходы против счетчиков канваса
+    static void CompareStatistics();
+    // Загрузка большого PPM в канвас: время и пропускная способность по числу потоков
+    static void CompareImageLoading();
+    // Последовательность кадров: поочередная обработка против FramePipeline
+    static void CompareFramePipeline();
+    // Способы дизеринга на маленькой палитре и масштабирование диффузии ошибки по потокам
+    static void CompareDithering();
+    // Изменение размера готового канваса против перерисовки сцены под каждый размер
+    static void CompareResize();
+    // Вращающаяся шкала: перерисовка геометрии каждый кадр против поворота готового изображения
+    static void CompareTransform();
+    // Просмотр большого канваса с масштабом: уменьшение окна каждый кадр против пирамиды уровней
+    static void CompareZoom();
+    // Цветной вывод в терминал: последовательность на каждую ячейку против смены цветов отрезками
+    static void CompareColorOutput();
+    // Разбор большого JSON: посимвольно через std::istream против разбора отображенного файла без копирования
+    static void CompareJsonParsing();
+    // Исполнение большой сцены: потоковое чтение команд против разбора всего документа
+    static void CompareSceneStreaming();
+    // Запуск сцены: разбор JSON против отображенной двоичной сцены
+    static void CompareSceneStartup();
+    // Горячая перезагрузка: правка команды, палитры и размера без полной перерисовки сцены
+    static void CompareHotReload();
 
 private:
     static void EnsureDemoDirectory();
@@ -0,0 +1,182 @@
+#include "Dithering.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace
+{
+    // Ширина блока столбцов волны: достаточно велика, чтобы синхронизация была редкой
+    constexpr int WAVEFRONT_CHUNK = 64;
+} // anonymous namespace
+
+namespace plotter
+{
+
+const std::array<double, BAYER_SIZE * BAYER_SIZE>& BayerThresholds()
+{
+    static const auto thresholds = []()
+    {
+        // Матрица порядка 2n из матрицы порядка n: [[4M, 4M + 2], [4M + 3, 4M + 1]]
+        std::array<int, BAYER_SIZE * BAYER_SIZE> matrix{};
+        for (int size = 1; size < BAYER_SIZE; size *= 2)
+        {
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    const int value = 4 * matrix[y * BAYER_SIZE + x];
+                    matrix[y * BAYER_SIZE + x] = value;
+                    matrix[y * BAYER_SIZE + x + size] = value + 2;
+                    matrix[(y + size) * BAYER_SIZE + x] = value + 3;
+                    matrix[(y + size) * BAYER_SIZE + x + size] = value + 1;
+                }
+            }
+        }
+
+        std::array<double, BAYER_SIZE * BAYER_SIZE> result{};
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            result[i] = (matrix[i] + 0.5) / static_cast<double>(result.size());
+        }
+        return result;
+    }();
+    return thresholds;
+}
+
+ErrorDiffuser::ErrorDiffuser(const Dither kernel, const int width, const int height, const int max_index)
+    : width_(width)
+    , height_(height)
+    , max_index_(max_index)
+    , progress_(height)
+{
+    switch (kernel)
+    {
+    case Dither::FloydSteinberg:
+        weights_ = { 7.0f / 16, 0.0f, 3.0f / 16, 5.0f / 16, 1.0f / 16, 0.0f };
+        break;
+    case Dither::Atkinson:
+        weights_ = { 1.0f / 8, 1.0f / 8, 1.0f / 8, 1.0f / 8, 1.0f / 8, 1.0f / 8 };
+        break;
+    default:
+        throw std::invalid_argument("Error diffusion needs Floyd-Steinberg or Atkinson kernel");
+    }
+
+    const size_t size = static_cast<size_t>(width) * height;
+    from_above_.assign(size, 0.0f);
+    if (weights_.down2 != 0.0f)
+    {
+        from_above2_.assign(size, 0.0f);
+    }
+}
+
+void ErrorDiffuser::ProcessRows(const int row_begin, const int row_end,
+    const std::function<void(int, float*)>& load,
+    const std::function<void(int, const int*)>& store)
+{
+    const int rows = row_end - row_begin;
+    if (rows <= 0)
+    {
+        return;
+    }
+
+    const auto row_size = static_cast<size_t>(width_);
+    std::vector<float> values(row_size * rows);
+    std::vector<int> indices(row_size * rows);
+    std::vector<Carry> carries(rows);
+    for (int row = 0; row < rows; ++row)
+    {
+        load(row_begin + row, values.data() + row_size * row);
+    }
+
+    // На шаге step строка row обрабатывает блок step - row
+    const int chunks = (width_ + WAVEFRONT_CHUNK - 1) / WAVEFRONT_CHUNK;
+    for (int step = 0; step < chunks + rows - 1; ++step)
+    {
+        for (int row = std::max(0, step - chunks + 1); row <= std::min(rows - 1, step); ++row)
+        {
+            const int chunk = step - row;
+            const int y = row_begin + row;
+
+            // Пикселю нужна строка выше до следующего столбца включительно
+            if (row == 0 && y > 0)
+            {
+                const int needed = std::min(chunk + 2, chunks);
+                std::atomic<int>& above = progress_[y - 1];
+                for (int done = above.load(std::memory_order_acquire); done < needed;
+                     done = above.load(std::memory_order_acquire))
+                {
+                    above.wait(done, std::memory_order_acquire);
+                }
+            }
+
+            const int x_begin = chunk * WAVEFRONT_CHUNK;
+            const int x_end = std::min(x_begin + WAVEFRONT_CHUNK, width_);
+            DiffuseSpan(y, x_begin, x_end, values.data() + row_size * row, indices.data() + row_size * row,
+                carries[row]);
+
+            if (row == rows - 1)
+            {
+                progress_[y].store(chunk + 1, std::memory_order_release);
+                progress_[y].notify_all();
+            }
+        }
+    }
+
+    for (int row = 0; row < rows; ++row)
+    {
+        store(row_begin + row, indices.data() + row_size * row);
+    }
+}
+
+void ErrorDiffuser::DiffuseSpan(const int y, const int x_begin, const int x_end,
+    const float* const values, int* const indices, Carry& carry)
+{
+    const size_t offset = static_cast<size_t>(y) * width_;
+    const float* const above = from_above_.data() + offset;
+    const float* const above2 = from_above2_.empty() ? nullptr : from_above2_.data() + offset;
+    float* const below = y + 1 < height_ ? from_above_.data() + offset + width_ : nullptr;
+    float* const below2 = above2 && y + 2 < height_ ? from_above2_.data() + offset + 2 * width_ : nullptr;
+    const auto max_value = static_cast<float>(max_index_);
+
+    for (int x = x_begin; x < x_end; ++x)
+    {
+        if (std::isnan(values[x]))
+        {
+            // Ошибка не переходит через пропущенные пиксели
+            indices[x] = -1;
+            carry = {};
+            continue;
+        }
+
+        float value = std::clamp(values[x], 0.0f, 1.0f) * max_value + above[x] + carry.next;
+        if (above2)
+        {
+            value += above2[x];
+        }
+        const int index = std::clamp(static_cast<int>(std::lround(value)), 0, max_index_);
+        indices[x] = index;
+
+        const float error = value - static_cast<float>(index);
+        carry.next = carry.after_next + error * weights_.right;
+        carry.after_next = error * weights_.right2;
+        if (below)
+        {
+            if (x > 0)
+            {
+                below[x - 1] += error * weights_.down_left;
+            }
+            below[x] += error * weights_.down;
+            if (x + 1 < width_)
+            {
+                below[x + 1] += error * weights_.down_right;
+            }
+        }
+        if (below2)
+        {
+            below2[x] += error * weights_.down2;
+        }
+    }
+}
+
+} // namespace plotter
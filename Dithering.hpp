@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace plotter
+{
+
+// Способ квантования яркости в палитру
+enum class Dither
+{
+    // Ближайший снизу символ палитры, как BrightnessToChar
+    None,
+    // Упорядоченный дизеринг матрицей Байера 8x8
+    Ordered,
+    // Диффузия ошибки Флойда — Стейнберга
+    FloydSteinberg,
+    // Диффузия ошибки Аткинсона: расходится 3/4 ошибки, контраст выше, светлые и темные области чище
+    Atkinson,
+};
+
+constexpr int BAYER_SIZE = 8;
+
+// Пороги упорядоченного дизеринга (значение матрицы Байера + 0.5) / 64, индекс — y % 8 * 8 + x % 8
+const std::array<double, BAYER_SIZE * BAYER_SIZE>& BayerThresholds();
+
+// Диффузия ошибки квантования по прямоугольнику width x height.
+// Строки можно обрабатывать полосами в разных потоках диагональной волной: полоса разбивается
+// на блоки столбцов, каждая строка отстает от строки выше на блок, а первая строка полосы ждет,
+// пока последняя строка полосы выше пройдет на два блока дальше. Ошибка, пришедшая сверху,
+// хранится отдельно от ошибки из той же строки и складывается в фиксированном порядке,
+// поэтому результат не зависит от разбиения на полосы и совпадает с последовательным
+class ErrorDiffuser
+{
+public:
+    // kernel — Dither::FloydSteinberg или Dither::Atkinson. Результат — индексы [0, max_index]
+    ErrorDiffuser(Dither kernel, int width, int height, int max_index);
+
+    // Обрабатывает строки [row_begin, row_end). Полоса выше должна обрабатываться одновременно
+    // или раньше, иначе вызов будет ждать ее бесконечно.
+    // load(y, values) заполняет яркость строки в [0, 1], NaN — пиксель не меняется и не получает ошибку.
+    // store(y, indices) получает индексы строки, -1 для пропущенных пикселей
+    void ProcessRows(int row_begin, int row_end,
+        const std::function<void(int, float*)>& load,
+        const std::function<void(int, const int*)>& store);
+
+private:
+    // Доли ошибки соседям: справа, через один справа, снизу слева, снизу, снизу справа, через строку снизу
+    struct Weights
+    {
+        float right;
+        float right2;
+        float down_left;
+        float down;
+        float down_right;
+        float down2;
+    };
+
+    // Ошибка из той же строки для следующих двух пикселей
+    struct Carry
+    {
+        float next = 0.0f;
+        float after_next = 0.0f;
+    };
+
+    Weights weights_;
+    int width_;
+    int height_;
+    int max_index_;
+    // Ошибка для пикселя от строки выше и от строки через одну выше
+    std::vector<float> from_above_;
+    std::vector<float> from_above2_;
+    // Число готовых блоков столбцов строки, публикуется для последних строк полос
+    std::vector<std::atomic<int>> progress_;
+
+    void DiffuseSpan(int y, int x_begin, int x_end, const float* values, int* indices, Carry& carry);
+};
+
+} // namespace plotter
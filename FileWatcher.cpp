@@ -0,0 +1,98 @@
+#include "FileWatcher.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr std::uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO;
+    // Буфер вмещает много событий с длинными именами за одно чтение
+    constexpr size_t EVENT_BUFFER_SIZE = 64 * 1024;
+} // anonymous namespace
+
+namespace plotter
+{
+
+FileWatcher::FileWatcher(const std::vector<std::filesystem::path>& files)
+    : descriptor_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (descriptor_ < 0)
+    {
+        throw std::runtime_error("Failed to initialize inotify: " + std::string(std::strerror(errno)));
+    }
+
+    for (const std::filesystem::path& path : files)
+    {
+        const std::filesystem::path absolute = std::filesystem::absolute(path);
+        // Каталог, за которым уже следим, возвращает тот же дескриптор наблюдения
+        const int watch = ::inotify_add_watch(descriptor_, absolute.parent_path().c_str(), WATCH_MASK);
+        if (watch < 0)
+        {
+            const std::string error = std::strerror(errno);
+            ::close(descriptor_);
+            throw std::runtime_error("Failed to watch '" + absolute.parent_path().string() + "': " + error);
+        }
+        files_.push_back({ watch, absolute.filename().string(), path });
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    ::close(descriptor_);
+}
+
+std::vector<std::filesystem::path> FileWatcher::Wait(const std::chrono::milliseconds timeout)
+{
+    std::vector<std::filesystem::path> changed;
+    pollfd request{ descriptor_, POLLIN, 0 };
+    const int ready = ::poll(&request, 1, static_cast<int>(std::max<std::chrono::milliseconds::rep>(timeout.count(), 0)));
+    if (ready < 0 && errno != EINTR)
+    {
+        throw std::runtime_error("Failed to wait for inotify events: " + std::string(std::strerror(errno)));
+    }
+    if (ready > 0)
+    {
+        ReadEvents(changed);
+    }
+    return changed;
+}
+
+void FileWatcher::ReadEvents(std::vector<std::filesystem::path>& changed)
+{
+    alignas(inotify_event) std::array<char, EVENT_BUFFER_SIZE> buffer;
+    while (true)
+    {
+        const ssize_t size = ::read(descriptor_, buffer.data(), buffer.size());
+        if (size <= 0)
+        {
+            // EAGAIN: события кончились
+            return;
+        }
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            inotify_event event{};
+            std::memcpy(&event, buffer.data() + offset, sizeof(event));
+            const std::string_view name(event.len > 0 ? buffer.data() + offset + sizeof(event) : "");
+            offset += static_cast<ssize_t>(sizeof(event) + event.len);
+
+            for (const WatchedFile& file : files_)
+            {
+                if (file.watch == event.wd && file.name == name
+                    && std::find(changed.begin(), changed.end(), file.path) == changed.end())
+                {
+                    changed.push_back(file.path);
+                }
+            }
+        }
+    }
+}
+
+} // namespace plotter
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace plotter
+{
+
+// Слежение за изменением файлов через inotify (Linux).
+// Следит за каталогами файлов, а не за самими файлами: редакторы часто сохраняют файл
+// через запись во временный файл и переименование, и inode файла меняется.
+// Изменением считается закрытие файла после записи и переименование в отслеживаемое имя
+class FileWatcher
+{
+public:
+    // Бросает std::runtime_error, если inotify недоступен или каталог файла не отслеживается
+    explicit FileWatcher(const std::vector<std::filesystem::path>& files);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Ждет изменений не дольше timeout. Возвращает измененные файлы в том виде, в котором они
+    // переданы в конструктор, без повторов; пустой список — изменений не было
+    std::vector<std::filesystem::path> Wait(std::chrono::milliseconds timeout);
+
+private:
+    struct WatchedFile
+    {
+        int watch;
+        std::string name;
+        std::filesystem::path path;
+    };
+
+    int descriptor_ = -1;
+    std::vector<WatchedFile> files_;
+
+    // Читает все накопившиеся события
+    void ReadEvents(std::vector<std::filesystem::path>& changed);
+};
+
+} // namespace plotter
@@ -0,0 +1,158 @@
+#include "FilterPipeline.hpp"
+#include "GrayscalePlotter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace plotter
+{
+
+FilterPipeline::FilterPipeline(GrayscalePlotter& plotter)
+    : plotter_(plotter)
+{
+}
+
+FilterPipeline& FilterPipeline::Scale(const double factor)
+{
+    return AddPoint([factor](const double brightness)
+    {
+        return std::clamp(brightness * factor, 0.0, 1.0);
+    });
+}
+
+FilterPipeline& FilterPipeline::Offset(const double offset)
+{
+    return AddPoint([offset](const double brightness)
+    {
+        return std::clamp(brightness + offset, 0.0, 1.0);
+    });
+}
+
+FilterPipeline& FilterPipeline::Gamma(const double gamma)
+{
+    if (!(gamma > 0.0))
+    {
+        throw std::invalid_argument("Gamma must be positive");
+    }
+
+    return AddPoint([gamma](const double brightness)
+    {
+        return std::pow(brightness, gamma);
+    });
+}
+
+FilterPipeline& FilterPipeline::Threshold(const double threshold)
+{
+    return AddPoint([threshold](const double brightness)
+    {
+        return brightness >= threshold ? 1.0 : 0.0;
+    });
+}
+
+FilterPipeline& FilterPipeline::Invert()
+{
+    return AddPoint([](const double brightness)
+    {
+        return 1.0 - brightness;
+    });
+}
+
+FilterPipeline& FilterPipeline::Remap(const CharMap& table)
+{
+    stages_.push_back({ nullptr, table, nullptr });
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::BoxBlur(const int kernel_size)
+{
+    stages_.push_back({ nullptr, std::nullopt, [&plotter = plotter_, kernel_size] { plotter.ApplyBoxBlur(kernel_size); } });
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::GaussianBlur(const int kernel_size)
+{
+    stages_.push_back({ nullptr, std::nullopt, [&plotter = plotter_, kernel_size] { plotter.ApplyGaussianBlur(kernel_size); } });
+    return *this;
+}
+
+void FilterPipeline::Apply()
+{
+    const bool use_plane = plotter_.HasBrightnessPlane();
+
+    CharMap composed_chars = IdentityCharMap();
+    GrayscalePlotter::LevelMap composed_levels{};
+    auto reset = [&]
+    {
+        composed_chars = IdentityCharMap();
+        for (size_t level = 0; level < composed_levels.size(); ++level)
+        {
+            composed_levels[level] = static_cast<std::uint8_t>(level);
+        }
+    };
+    reset();
+    bool has_pending = false;
+
+    auto flush = [&]
+    {
+        if (has_pending)
+        {
+            if (use_plane)
+            {
+                plotter_.ApplyLevelMap(composed_levels);
+            }
+            else
+            {
+                plotter_.ApplyCharMap(composed_chars);
+            }
+            reset();
+            has_pending = false;
+        }
+    };
+
+    // Композиция: сначала накопленная таблица, затем таблица стадии
+    auto compose = [](auto& composed, const auto& table)
+    {
+        for (auto& value : composed)
+        {
+            value = table[static_cast<size_t>(static_cast<unsigned char>(value))];
+        }
+    };
+
+    for (const auto& stage : stages_)
+    {
+        if (stage.barrier || (use_plane && stage.remap))
+        {
+            flush();
+            if (stage.barrier)
+            {
+                stage.barrier();
+            }
+            else
+            {
+                plotter_.ApplyCharMap(*stage.remap);
+            }
+            continue;
+        }
+
+        if (use_plane)
+        {
+            compose(composed_levels, plotter_.MakeLevelMap(stage.transform));
+        }
+        else
+        {
+            compose(composed_chars, stage.remap ? *stage.remap : plotter_.MakePointMap(stage.transform));
+        }
+        has_pending = true;
+    }
+
+    flush();
+    stages_.clear();
+}
+
+FilterPipeline& FilterPipeline::AddPoint(std::function<double(double)> transform)
+{
+    stages_.push_back({ std::move(transform), std::nullopt, nullptr });
+    return *this;
+}
+
+} // namespace plotter
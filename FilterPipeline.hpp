@@ -0,0 +1,61 @@
+#pragma once
+#include "Canvas.hpp"
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace plotter
+{
+
+class GrayscalePlotter;
+
+// Отложенная цепочка фильтров для GrayscalePlotter.
+// Поточечные операции только записываются, а в Apply() подряд идущие операции
+// сворачиваются в одну таблицу замены символов и применяются за один проход по канвасу.
+// Размытия не являются поточечными и служат барьерами: перед ними накопленная таблица применяется.
+// Результат совпадает с последовательным вызовом соответствующих методов плоттера.
+// Если у плоттера включен слой яркости, операции сворачиваются в таблицу уровней слоя,
+// а замена символов становится барьером.
+class FilterPipeline
+{
+public:
+    explicit FilterPipeline(GrayscalePlotter& plotter);
+
+    // Как AdjustBrightness: яркость умножается на factor
+    FilterPipeline& Scale(double factor);
+    // К яркости прибавляется offset
+    FilterPipeline& Offset(double offset);
+    // Яркость возводится в степень gamma
+    FilterPipeline& Gamma(double gamma);
+    // Как ApplyThreshold
+    FilterPipeline& Threshold(double threshold);
+    // Как InvertBrightness
+    FilterPipeline& Invert();
+    // Произвольная замена символов, включая символы вне палитры
+    FilterPipeline& Remap(const CharMap& table);
+
+    // Барьеры
+    FilterPipeline& BoxBlur(int kernel_size = 3);
+    FilterPipeline& GaussianBlur(int kernel_size = 3);
+
+    // Выполняет записанные операции и очищает цепочку
+    void Apply();
+
+    [[nodiscard]] bool Empty() const noexcept { return stages_.empty(); }
+
+private:
+    // Заполнено ровно одно поле
+    struct Stage
+    {
+        std::function<double(double)> transform;
+        std::optional<CharMap> remap;
+        std::function<void()> barrier;
+    };
+
+    GrayscalePlotter& plotter_;
+    std::vector<Stage> stages_;
+
+    FilterPipeline& AddPoint(std::function<double(double)> transform);
+};
+
+} // namespace plotter
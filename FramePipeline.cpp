@@ -0,0 +1,227 @@
+#include "FramePipeline.hpp"
+#include "ImageLoader.hpp"
+#include "SpscQueue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double Milliseconds(const Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // Перцентили по ближайшему рангу
+    plotter::StageLatency Percentiles(std::vector<double> times)
+    {
+        plotter::StageLatency latency;
+        if (times.empty())
+        {
+            return latency;
+        }
+
+        std::sort(times.begin(), times.end());
+        const auto rank = [&times](const double percent)
+        {
+            const auto index = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(times.size())));
+            return times[std::max<size_t>(index, 1) - 1];
+        };
+        latency.p50 = rank(50.0);
+        latency.p90 = rank(90.0);
+        latency.p99 = rank(99.0);
+        latency.max = times.back();
+        return latency;
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+FramePipeline::FramePipeline(FramePipelineOptions options)
+    : options_(std::move(options))
+    , plotter_(options_.width, options_.height, options_.background, options_.palette)
+{
+    if (options_.queue_capacity < 1)
+    {
+        throw std::invalid_argument("Queue capacity must be positive");
+    }
+    plotter_.SetThreadCount(options_.thread_count);
+
+    // Кадры в очереди записи и один записываемый
+    canvas_pool_.reserve(options_.queue_capacity + 1);
+    for (int i = 0; i < options_.queue_capacity + 1; ++i)
+    {
+        canvas_pool_.emplace_back(options_.width, options_.height, options_.background);
+    }
+}
+
+FramePipelineStats FramePipeline::Run(const std::vector<std::filesystem::path>& frames, std::ostream& output)
+{
+    struct SourceFrame
+    {
+        PnmImage image;
+        Clock::time_point started;
+    };
+    // Пустой canvas — конец потока
+    struct ReadyFrame
+    {
+        Canvas* canvas = nullptr;
+        Clock::time_point started;
+    };
+
+    const auto capacity = static_cast<size_t>(options_.queue_capacity);
+    // std::nullopt — конец потока
+    SpscQueue<std::optional<SourceFrame>> sources(capacity);
+    SpscQueue<ReadyFrame> ready(capacity);
+    SpscQueue<Canvas*> free_canvases(canvas_pool_.size());
+    for (Canvas& canvas : canvas_pool_)
+    {
+        Canvas* pooled = &canvas;
+        free_canvases.TryPush(pooled);
+    }
+
+    // После ошибки стадии продолжают разбирать очереди, но не обрабатывают кадры,
+    // чтобы ни одна стадия не осталась ждать соседнюю
+    std::atomic<bool> failed{ false };
+    std::exception_ptr read_error;
+    std::exception_ptr convert_error;
+    std::exception_ptr write_error;
+
+    std::vector<double> read_times;
+    std::vector<double> convert_times;
+    std::vector<double> write_times;
+    std::vector<double> total_times;
+    read_times.reserve(frames.size());
+    convert_times.reserve(frames.size());
+    write_times.reserve(frames.size());
+    total_times.reserve(frames.size());
+
+    const auto start_time = Clock::now();
+
+    std::thread reader([&]()
+    {
+        for (const auto& path : frames)
+        {
+            if (failed.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            try
+            {
+                const auto started = Clock::now();
+                PnmImage image(path);
+                image.Prefault();
+                read_times.push_back(Milliseconds(Clock::now() - started));
+                sources.Push(SourceFrame{ std::move(image), started });
+            }
+            catch (...)
+            {
+                read_error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+                break;
+            }
+        }
+        sources.Push(std::nullopt);
+    });
+
+    std::thread writer([&]()
+    {
+        for (ReadyFrame frame = ready.Pop(); frame.canvas; frame = ready.Pop())
+        {
+            if (!failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    const auto started = Clock::now();
+                    frame.canvas->Render(output);
+                    output << options_.frame_separator;
+                    if (!output)
+                    {
+                        throw std::runtime_error("Failed to write frame " + std::to_string(write_times.size()));
+                    }
+                    const auto finished = Clock::now();
+                    write_times.push_back(Milliseconds(finished - started));
+                    total_times.push_back(Milliseconds(finished - frame.started));
+                }
+                catch (...)
+                {
+                    write_error = std::current_exception();
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            free_canvases.Push(frame.canvas);
+        }
+    });
+
+    // Преобразование идет в вызывающем потоке, вместе с пулом потоков плоттера
+    for (std::optional<SourceFrame> source = sources.Pop(); source; source = sources.Pop())
+    {
+        if (failed.load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+        try
+        {
+            const auto started = Clock::now();
+            plotter_.GetCanvas().Clear(options_.background);
+            plotter_.LoadImage(source->image, options_.cell_aspect);
+            convert_times.push_back(Milliseconds(Clock::now() - started));
+
+            // Готовый кадр меняется местами со свободным канвасом пула без копирования
+            Canvas* const target = free_canvases.Pop();
+            std::swap(*target, plotter_.GetCanvas());
+            ready.Push(ReadyFrame{ target, source->started });
+        }
+        catch (...)
+        {
+            convert_error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    ready.Push(ReadyFrame{});
+
+    reader.join();
+    writer.join();
+    const double total_ms = Milliseconds(Clock::now() - start_time);
+
+    for (const auto& error : { read_error, convert_error, write_error })
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    FramePipelineStats stats;
+    stats.frames = static_cast<int>(write_times.size());
+    stats.total_ms = total_ms;
+    stats.frames_per_second = total_ms > 0.0 ? stats.frames / (total_ms / 1000.0) : 0.0;
+    stats.read = Percentiles(std::move(read_times));
+    stats.convert = Percentiles(std::move(convert_times));
+    stats.write = Percentiles(std::move(write_times));
+    stats.end_to_end = Percentiles(std::move(total_times));
+    return stats;
+}
+
+FramePipelineStats FramePipeline::Run(const std::vector<std::filesystem::path>& frames,
+    const std::filesystem::path& output_file)
+{
+    std::ofstream output(output_file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        throw std::runtime_error("Failed to create file '" + output_file.string() + "'");
+    }
+    return Run(frames, output);
+}
+
+} // namespace plotter
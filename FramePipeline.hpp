@@ -0,0 +1,71 @@
+#pragma once
+#include "GrayscalePlotter.hpp"
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace plotter
+{
+
+struct FramePipelineOptions
+{
+    int width = 80;
+    int height = 40;
+    char background = ' ';
+    std::vector<char> palette = GrayscalePlotter::DefaultPalette();
+    // См. GrayscalePlotter::LoadImage
+    double cell_aspect = 2.0;
+    // Потоки преобразования кадра, как GrayscalePlotter::SetThreadCount
+    int thread_count = 1;
+    // Кадров в каждой очереди между стадиями
+    int queue_capacity = 4;
+    // Пишется после каждого кадра, например "\x1b[H" для показа в терминале
+    std::string frame_separator;
+};
+
+// Перцентили времени обработки кадра, мс
+struct StageLatency
+{
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+struct FramePipelineStats
+{
+    int frames = 0;
+    double total_ms = 0.0;
+    double frames_per_second = 0.0;
+    StageLatency read;
+    StageLatency convert;
+    StageLatency write;
+    // От начала чтения кадра до конца его записи, включая ожидание в очередях
+    StageLatency end_to_end;
+};
+
+// Преобразование последовательности кадров PGM/PPM в символы тремя стадиями в своих потоках:
+// чтение (отображение файла и загрузка страниц) -> преобразование (GrayscalePlotter::LoadImage)
+// -> запись. Стадии связаны ограниченными очередями SpscQueue. Канвасы кадров берутся из пула
+// фиксированного размера и возвращаются в него после записи, поэтому при медленной записи
+// преобразование ждет свободный канвас, а чтение — место в очереди, и память не растет.
+// Результат совпадает с последовательными LoadImage и Render для каждого кадра
+class FramePipeline
+{
+public:
+    explicit FramePipeline(FramePipelineOptions options);
+
+    // Кадры пишутся в output по порядку. Первая ошибка любой стадии (нечитаемый кадр,
+    // ошибка записи) останавливает конвейер и пробрасывается после завершения потоков
+    FramePipelineStats Run(const std::vector<std::filesystem::path>& frames, std::ostream& output = std::cout);
+    // Кадры пишутся в файл output_file, файл перезаписывается
+    FramePipelineStats Run(const std::vector<std::filesystem::path>& frames, const std::filesystem::path& output_file);
+
+private:
+    FramePipelineOptions options_;
+    GrayscalePlotter plotter_;
+    std::vector<Canvas> canvas_pool_;
+};
+
+} // namespace plotter
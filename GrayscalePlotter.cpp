@@ -1,8 +1,90 @@
 #include "GrayscalePlotter.hpp"
 #include "CanvasIterators.hpp"
+#include "ImageLoader.hpp"
+#include "Profiling.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <span>
 #include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr int MAX_LEVEL = 255;
+
+    // Фиксированная точка 32.32 для пошагового вычисления градиентов
+    constexpr int FIXED_SHIFT = 32;
+    constexpr std::int64_t FIXED_ONE = std::int64_t{ 1 } << FIXED_SHIFT;
+    // Дробная часть ближе этого к границе уровня перепроверяется исходной формулой
+    constexpr std::int64_t FIXED_GUARD = std::int64_t{ 1 } << 24;
+    // Значения по модулю больше не помещаются в фиксированную точку с запасом
+    constexpr double FIXED_RANGE = static_cast<double>(std::int64_t{ 1 } << 30);
+
+    // Сумма весов пересчета отличается от 1 на ошибку округления, без запаса
+    // ровная область символа палитры уходила бы в соседний более темный символ
+    constexpr double RESAMPLE_TOLERANCE = 1e-9;
+
+    // Модуль градиента Собеля для перепада яркости от 0 до 1
+    constexpr double SOBEL_NORM = 4.0;
+    // tg(22.5°): граница между осевым и диагональным направлением
+    constexpr double TAN_22_5 = 0.41421356237309503;
+
+    // Символ границы, перпендикулярной градиенту (gx, gy). Ось y направлена вниз
+    char EdgeGlyph(const double gx, const double gy)
+    {
+        const double ax = std::abs(gx);
+        const double ay = std::abs(gy);
+        if (ay <= ax * TAN_22_5)
+        {
+            return '|';
+        }
+        if (ax <= ay * TAN_22_5)
+        {
+            return '-';
+        }
+        return (gx > 0.0) == (gy > 0.0) ? '/' : '\\';
+    }
+
+    void CheckRankRadius(const int radius)
+    {
+        if (radius < 0 || radius > plotter::MAX_RANK_RADIUS)
+        {
+            throw std::invalid_argument("Filter radius is out of range");
+        }
+    }
+
+    // Нулевой символ размечает пиксели примитива, поэтому в палитре его быть не может
+    void CheckPalette(const std::vector<char>& palette)
+    {
+        if (palette.size() < 2)
+        {
+            throw std::invalid_argument("Palette size can't be less than 2");
+        }
+        if (std::find(palette.begin(), palette.end(), '\0') != palette.end())
+        {
+            throw std::invalid_argument("Palette char can't be null");
+        }
+    }
+
+    // floor(sqrt(value)) без ошибок округления
+    std::int64_t IntegerSqrt(const std::int64_t value)
+    {
+        auto root = static_cast<std::int64_t>(std::sqrt(static_cast<double>(value)));
+        while (root * root > value)
+        {
+            --root;
+        }
+        while ((root + 1) * (root + 1) <= value)
+        {
+            ++root;
+        }
+        return root;
+    }
+} // anonymous namespace
 
 namespace plotter
 {
@@ -15,11 +97,8 @@ GrayscalePlotter::GrayscalePlotter(std::unique_ptr<Canvas> canvas,
     {
         palette_ = DefaultPalette();
     }
-    if (palette_.size() < 2)
-    {
-        throw std::invalid_argument("Palette size can't be less than 2");
-    }
-    char_to_brightness_ = CreateCharToBrightness();
+    CheckPalette(palette_);
+    BuildLookupTables();
 }
 
 GrayscalePlotter::GrayscalePlotter(int width, int height, char background_char,
@@ -30,19 +109,24 @@ GrayscalePlotter::GrayscalePlotter(int width, int height, char background_char,
     {
         palette_ = DefaultPalette();
     }
-    if (palette_.size() < 2)
-    {
-        throw std::invalid_argument("Palette size can't be less than 2");
-    }
-    char_to_brightness_ = CreateCharToBrightness();
+    CheckPalette(palette_);
+    BuildLookupTables();
 }
 
-char GrayscalePlotter::BrightnessToChar(double brightness) const {
-    brightness = std::clamp(brightness, 0.0, 1.0);
+char GrayscalePlotter::BrightnessToChar(const double brightness) const {
+    // Эквивалентно palette_[floor(clamp(brightness, 0, 1) * (size - 1))]
+    return palette_[PaletteQuantizer()(brightness)];
+}
+
+GrayscalePlotter::Quantizer GrayscalePlotter::PaletteQuantizer() const noexcept
+{
+    const int max_index = static_cast<int>(palette_.size()) - 1;
+    return { static_cast<double>(max_index), 0.0, max_index };
+}
 
-    double scaled_index = brightness * (palette_.size() - 1);
-    const size_t index = static_cast<size_t>(std::floor(scaled_index));
-    return palette_[index];
+GrayscalePlotter::Quantizer GrayscalePlotter::LevelQuantizer() noexcept
+{
+    return { static_cast<double>(MAX_LEVEL), 0.5, MAX_LEVEL };
 }
 
 std::vector<char> GrayscalePlotter::DefaultPalette()
@@ -50,390 +134,1859 @@ std::vector<char> GrayscalePlotter::DefaultPalette()
     return { ' ', '.', ':', '-', '=', '+', '*', '#', '%', '@' };
 }
 
-void GrayscalePlotter::DrawLine(const int x1, const int y1, const int x2, const int y2, const double brightness)
+void GrayscalePlotter::DrawLine(const int x1, const int y1, const int x2, const int y2, const double brightness,
+    const Dither dither)
 {
-    Plotter::DrawLine(x1, y1, x2, y2, BrightnessToChar(brightness));
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawLine");
+    Paint({ std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2) }, brightness,
+        [&](const char brush) { Plotter::DrawLine(x1, y1, x2, y2, brush); }, dither);
 }
 
-void GrayscalePlotter::DrawRectangle(const int x1, const int y1, const int x2, const int y2, const double brightness, const bool fill)
+void GrayscalePlotter::DrawRectangle(const int x1, const int y1, const int x2, const int y2, const double brightness,
+    const bool fill, const Dither dither)
 {
-    Plotter::DrawRectangle(x1, y1, x2, y2, BrightnessToChar(brightness), fill);
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawRectangle");
+    Paint({ std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2) }, brightness,
+        [&](const char brush) { Plotter::DrawRectangle(x1, y1, x2, y2, brush, fill); }, dither);
 }
 
 void GrayscalePlotter::DrawTriangle(const int x1, const int y1, const int x2, const int y2, const int x3, const int y3,
-    const double brightness, const bool fill)
+    const double brightness, const bool fill, const Dither dither)
 {
-    Plotter::DrawTriangle(x1, y1, x2, y2, x3, y3, BrightnessToChar(brightness), fill);
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawTriangle");
+    Paint({ std::min({ x1, x2, x3 }), std::min({ y1, y2, y3 }), std::max({ x1, x2, x3 }), std::max({ y1, y2, y3 }) },
+        brightness, [&](const char brush) { Plotter::DrawTriangle(x1, y1, x2, y2, x3, y3, brush, fill); }, dither);
 }
 
 void GrayscalePlotter::DrawCircle(const int center_x, const int center_y, const int radius,
-    const double brightness, const bool fill)
+    const double brightness, const bool fill, const Dither dither)
 {
-    Plotter::DrawCircle(center_x, center_y, radius, BrightnessToChar(brightness), fill);
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawCircle");
+    // Брезенхем может выйти за радиус на пиксель
+    Paint({ center_x - radius - 1, center_y - radius - 1, center_x + radius + 1, center_y + radius + 1 }, brightness,
+        [&](const char brush) { Plotter::DrawCircle(center_x, center_y, radius, brush, fill); }, dither);
 }
 
-void GrayscalePlotter::FloodFill(const int x, const int y, const double brightness)
+void GrayscalePlotter::FloodFill(const int x, const int y, const double brightness, const Dither dither)
 {
-    Plotter::FloodFill(x, y, BrightnessToChar(brightness));
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::FloodFill");
+    Paint(WholeCanvas(), brightness, [&](const char brush) { Plotter::FloodFill(x, y, brush); }, dither);
 }
 
-void GrayscalePlotter::ScanlineFill(const int x, const int y, const double brightness)
+void GrayscalePlotter::ScanlineFill(const int x, const int y, const double brightness, const Dither dither)
 {
-    Plotter::ScanlineFill(x, y, BrightnessToChar(brightness));
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ScanlineFill");
+    Paint(WholeCanvas(), brightness, [&](const char brush) { Plotter::ScanlineFill(x, y, brush); }, dither);
 }
 
 void GrayscalePlotter::DrawLinearGradient(const int x1, const int y1, const int x2, const int y2,
-    const double start_brightness, const double end_brightness)
+    const double start_brightness, const double end_brightness, const Dither dither)
 {
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawLinearGradient");
     const int width = x2 - x1;
     const int height = y2 - y1;
 
-    for (int y = y1; y <= y2; ++y)
+    Canvas& canvas = RawCanvas();
+    const int left = std::max(x1, 0);
+    const int right = std::min(x2, canvas.Width() - 1);
+    const int top = std::max(y1, 0);
+    const int bottom = std::min(y2, canvas.Height() - 1);
+    if (left > right || top > bottom)
     {
-        for (int x = x1; x <= x2; ++x)
-        {
-            if (!GetCanvas().InBounds(x, y))
-                continue;
+        return;
+    }
 
-            const double x_ratio = static_cast<double>(x - x1) / width;
-            const double y_ratio = static_cast<double>(y - y1) / height;
-            const double ratio = (x_ratio + y_ratio) / 2.0;
+    PrepareBrightnessWrite();
+    const Quantizer quantize = HasBrightnessPlane() ? LevelQuantizer() : PaletteQuantizer();
 
-            const double brightness = start_brightness + ratio * (end_brightness - start_brightness);
-            GetCanvas().at(x, y) = BrightnessToChar(brightness);
-        }
-    }
-}
+    // Исходная попиксельная формула, по ней пересчитываются пиксели у границ уровней
+    const auto brightness_at = [&](const int x, const double y_ratio)
+    {
+        const double x_ratio = static_cast<double>(x - x1) / width;
+        const double ratio = (x_ratio + y_ratio) / 2.0;
+        return start_brightness + ratio * (end_brightness - start_brightness);
+    };
 
-void GrayscalePlotter::DrawRadialGradient(const int center_x, const int center_y, const int radius,
-    const double center_brightness, const double edge_brightness)
-{
-    for (int y = center_y - radius; y <= center_y + radius; ++y)
+    if (dither != Dither::None && !HasBrightnessPlane())
     {
-        for (int x = center_x - radius; x <= center_x + radius; ++x)
+        DitherRegion({ left, top, right, bottom }, dither, [&](const int y, float* const row)
         {
-            if (!GetCanvas().InBounds(x, y))
-                continue;
+            const double y_ratio = static_cast<double>(y - y1) / height;
+            for (int x = left; x <= right; ++x)
+            {
+                // Вырожденный прямоугольник дает NaN, который квантуется как нулевая яркость
+                const double brightness = brightness_at(x, y_ratio);
+                row[x - left] = std::isnan(brightness) ? 0.0f : static_cast<float>(brightness);
+            }
+        });
+        return;
+    }
 
-            const double distance = std::sqrt(std::pow(x - center_x, 2) + std::pow(y - center_y, 2));
-            if (distance > radius)
-                continue;
+    PLOTTER_PROFILE_COUNT("pixels_written", (right - left + 1) * (bottom - top + 1));
+    // Приращение brightness * scale + bias на пиксель по x в фиксированной точке
+    const std::int64_t step = width != 0
+        ? std::llround((end_brightness - start_brightness) / (2.0 * width) * quantize.scale * FIXED_ONE)
+        : 0;
+
+    const auto fill_row = [&](auto* const row, const auto& output, const int y)
+    {
+        const double y_ratio = static_cast<double>(y - y1) / height;
+        const double first = brightness_at(left, y_ratio) * quantize.scale + quantize.bias;
+        const double last = brightness_at(right, y_ratio) * quantize.scale + quantize.bias;
 
-            const double ratio = distance / radius;
-            const double brightness = center_brightness + ratio * (edge_brightness - center_brightness);
-            GetCanvas().at(x, y) = BrightnessToChar(brightness);
+        // Вырожденный прямоугольник, NaN или слишком большие значения: только исходная формула
+        if (width == 0 || !(std::abs(first) < FIXED_RANGE) || !(std::abs(last) < FIXED_RANGE))
+        {
+            for (int x = left; x <= right; ++x)
+            {
+                row[x] = output(quantize(brightness_at(x, y_ratio)));
+            }
+            return;
         }
-    }
-}
 
-double GrayscalePlotter::CalculateAverageBrightness()
-{
-    double total = 0.0;
-    int count = 0;
+        // Накопленная ошибка шага много меньше FIXED_GUARD, поэтому вдали от границы уровня
+        // целая часть совпадает с исходным округлением
+        std::int64_t value = std::llround(first * FIXED_ONE);
+        for (int x = left; x <= right; ++x, value += step)
+        {
+            const std::int64_t fraction = value & (FIXED_ONE - 1);
+            const int index = fraction < FIXED_GUARD || fraction > FIXED_ONE - FIXED_GUARD
+                ? quantize(brightness_at(x, y_ratio))
+                : static_cast<int>(std::clamp<std::int64_t>(value >> FIXED_SHIFT, 0, quantize.max_index));
+            row[x] = output(index);
+        }
+    };
 
-    for (auto& pixel : GetCanvas())
+    // Полосы пишут символы мимо SetPixel и сами переносят свои замены в статистику канваса
+    char* const symbols = HasBrightnessPlane() ? nullptr : canvas.CountedData();
+    ForEachRowBand(bottom - top + 1, [&](const RowBand band)
     {
-        if (const auto it = char_to_brightness_.find(pixel); it != char_to_brightness_.end())
+        Canvas::BandCounts counts(canvas);
+        for (int y = top + band.begin; y < top + band.end; ++y)
         {
-            total += it->second;
-            count++;
+            const size_t offset = static_cast<size_t>(y) * canvas.Width();
+            if (HasBrightnessPlane())
+            {
+                fill_row(plane_.data() + offset, [](const int level) { return static_cast<std::uint8_t>(level); }, y);
+            }
+            else
+            {
+                char* const row = symbols + offset;
+                counts.Before(row + left, row + right + 1);
+                fill_row(row, [this](const int index) { return palette_[index]; }, y);
+                counts.After(row + left, row + right + 1);
+            }
         }
-    }
-
-    return count > 0 ? total / count : 0.0;
+        counts.Merge();
+    });
 }
 
-BrightnessExtrema GrayscalePlotter::GetMinMaxBrightness()
+void GrayscalePlotter::DrawRadialGradient(const int center_x, const int center_y, const int radius,
+    const double center_brightness, const double edge_brightness, const Dither dither)
 {
-    if (GetCanvas().Size() == 0)
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DrawRadialGradient");
+    Canvas& canvas = RawCanvas();
+    const int top = std::max(center_y - radius, 0);
+    const int bottom = std::min(center_y + radius, canvas.Height() - 1);
+    if (radius < 0 || top > bottom || center_x + radius < 0 || center_x - radius >= canvas.Width())
     {
-        return { 0.0, 0.0 };
+        return;
     }
 
-    double min_brightness = 1.0;
-    double max_brightness = 0.0;
+    PrepareBrightnessWrite();
+    const Quantizer quantize = HasBrightnessPlane() ? LevelQuantizer() : PaletteQuantizer();
+
+    // Исходная формула от квадрата расстояния до центра
+    const auto index_at = [&](const std::int64_t squared_distance)
+    {
+        const double distance = std::sqrt(static_cast<double>(squared_distance));
+        const double ratio = distance / radius;
+        return quantize(center_brightness + ratio * (edge_brightness - center_brightness));
+    };
 
-    for (const auto& pixel : GetCanvas())
+    if (dither != Dither::None && !HasBrightnessPlane())
     {
-        if (const auto it = char_to_brightness_.find(pixel); it != char_to_brightness_.end())
+        const int left = std::max(center_x - radius, 0);
+        const int right = std::min(center_x + radius, canvas.Width() - 1);
+        const std::int64_t radius_squared = static_cast<std::int64_t>(radius) * radius;
+        DitherRegion({ left, top, right, bottom }, dither, [&](const int y, float* const row)
         {
-            double brightness = it->second;
-            min_brightness = std::min(min_brightness, brightness);
-            max_brightness = std::max(max_brightness, brightness);
-        }
+            const std::int64_t dy = y - center_y;
+            for (int x = left; x <= right; ++x)
+            {
+                const std::int64_t dx = x - center_x;
+                const std::int64_t squared_distance = dx * dx + dy * dy;
+                if (squared_distance > radius_squared)
+                {
+                    row[x - left] = std::numeric_limits<float>::quiet_NaN();
+                    continue;
+                }
+                const double ratio = std::sqrt(static_cast<double>(squared_distance)) / radius;
+                const double brightness = center_brightness + ratio * (edge_brightness - center_brightness);
+                row[x - left] = std::isnan(brightness) ? 0.0f : static_cast<float>(brightness);
+            }
+        });
+        return;
     }
 
-    return { min_brightness, max_brightness };
-}
-
-std::vector<std::vector<double>> GrayscalePlotter::GetBrightnessMatrix() const
-{
-    std::vector<std::vector<double>> matrix(GetCanvas().Height(),
-        std::vector<double>(GetCanvas().Width()));
-
-    for (int y = 0; y < GetCanvas().Height(); ++y)
+    // Уровень монотонно зависит от квадрата расстояния, поэтому круг распадается
+    // на кольца одного уровня. Границы колец ищутся двоичным поиском по исходной формуле
+    struct Ring
     {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
+        std::int64_t first;
+        std::int64_t last;
+        int index;
+    };
+    std::vector<Ring> rings;
+    const std::int64_t radius_squared = static_cast<std::int64_t>(radius) * radius;
+    for (std::int64_t first = 0; first <= radius_squared;)
+    {
+        const int index = index_at(first);
+        std::int64_t low = first;
+        std::int64_t high = radius_squared + 1;
+        while (high - low > 1)
         {
-            char pixel_char = GetCanvas().at(x, y);
-            auto it = char_to_brightness_.find(pixel_char);
-            matrix[y][x] = it != char_to_brightness_.end() ? it->second : 0.0;
+            const std::int64_t middle = low + (high - low) / 2;
+            (index_at(middle) == index ? low : high) = middle;
         }
+        rings.push_back({ first, low, index });
+        first = low + 1;
     }
 
-    return matrix;
-}
-
-void GrayscalePlotter::AdjustBrightness(const double factor)
-{
-    for (int y = 0; y < GetCanvas().Height(); ++y)
+    const int canvas_width = canvas.Width();
+    const auto fill_row = [&](auto* const row, const auto& output, const int y)
     {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
+        const std::int64_t dy = y - center_y;
+        const std::int64_t dy_squared = dy * dy;
+
+        // Заполняет пиксели от center_x + from до center_x + to в пределах канваса
+        const auto fill_span = [&](const std::int64_t from, const std::int64_t to, const int index)
         {
-            char old_char = GetCanvas().at(x, y);
-            if (auto it = char_to_brightness_.find(old_char); it != char_to_brightness_.end())
+            const std::int64_t span_left = std::max<std::int64_t>(center_x + from, 0);
+            const std::int64_t span_right = std::min<std::int64_t>(center_x + to, canvas_width - 1);
+            if (span_left <= span_right)
             {
-                const double new_brightness = std::clamp(it->second * factor, 0.0, 1.0);
-                GetCanvas().at(x, y) = BrightnessToChar(new_brightness);
+                PLOTTER_PROFILE_COUNT("spans_emitted", 1);
+                PLOTTER_PROFILE_COUNT("pixels_written", span_right - span_left + 1);
+                std::fill(row + span_left, row + span_right + 1, output(index));
             }
-        }
-    }
-}
+        };
 
-void GrayscalePlotter::ApplyThreshold(const double threshold)
-{
-    for (int y = 0; y < GetCanvas().Height(); ++y)
-    {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
+        for (const Ring& ring : rings)
         {
-            char old_char = GetCanvas().at(x, y);
-            if (const auto it = char_to_brightness_.find(old_char); it != char_to_brightness_.end())
+            if (ring.last < dy_squared)
+            {
+                continue;
+            }
+            // Смещения dx, для которых first <= dy^2 + dx^2 <= last
+            const std::int64_t dx_max = IntegerSqrt(ring.last - dy_squared);
+            const std::int64_t dx_min = ring.first <= dy_squared ? 0 : IntegerSqrt(ring.first - dy_squared - 1) + 1;
+            if (dx_min > dx_max)
             {
-                const double new_brightness = it->second >= threshold ? 1.0 : 0.0;
-                GetCanvas().at(x, y) = BrightnessToChar(new_brightness);
+                continue;
             }
+            fill_span(dx_min, dx_max, ring.index);
+            fill_span(-dx_max, -std::max<std::int64_t>(dx_min, 1), ring.index);
         }
-    }
-}
+    };
 
-void GrayscalePlotter::InvertBrightness()
-{
-    for (int y = 0; y < GetCanvas().Height(); ++y)
+    // Кольца задевают только столбцы описанного квадрата
+    const int left = std::max(center_x - radius, 0);
+    const int right = std::min(center_x + radius, canvas_width - 1);
+    char* const symbols = HasBrightnessPlane() ? nullptr : canvas.CountedData();
+    ForEachRowBand(bottom - top + 1, [&](const RowBand band)
     {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
+        Canvas::BandCounts counts(canvas);
+        for (int y = top + band.begin; y < top + band.end; ++y)
         {
-            char old_char = GetCanvas().at(x, y);
-            if (const auto it = char_to_brightness_.find(old_char); it != char_to_brightness_.end())
+            const size_t offset = static_cast<size_t>(y) * canvas_width;
+            if (HasBrightnessPlane())
+            {
+                fill_row(plane_.data() + offset, [](const int level) { return static_cast<std::uint8_t>(level); }, y);
+            }
+            else
             {
-                const double new_brightness = 1.0 - it->second;
-                GetCanvas().at(x, y) = BrightnessToChar(new_brightness);
+                char* const row = symbols + offset;
+                counts.Before(row + left, row + right + 1);
+                fill_row(row, [this](const int index) { return palette_[index]; }, y);
+                counts.After(row + left, row + right + 1);
             }
         }
-    }
+        counts.Merge();
+    });
 }
 
-double GrayscalePlotter::GetPixelBrightness(const int x, const int y) const
+void GrayscalePlotter::LoadImage(const std::filesystem::path& path, const double cell_aspect, const Dither dither)
 {
-    if (!GetCanvas().InBounds(x, y))
-        return 0.0;
-
-    const char pixel_char = GetCanvas().at(x, y);
-    const auto it = char_to_brightness_.find(pixel_char);
-    return it != char_to_brightness_.end() ? it->second : 0.0;
+    LoadImage(PnmImage(path), cell_aspect, dither);
 }
 
-void GrayscalePlotter::SetPixelBrightness(const int x, const int y, const double brightness)
+void GrayscalePlotter::LoadImage(const PnmImage& image, const double cell_aspect, const Dither dither)
 {
-    if (GetCanvas().InBounds(x, y))
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::LoadImage");
+    if (!(cell_aspect > 0.0))
     {
-        GetCanvas().at(x, y) = BrightnessToChar(brightness);
+        throw std::invalid_argument("Cell aspect must be positive");
     }
-}
 
-std::vector<std::vector<double>> GrayscalePlotter::CreateGaussianKernel(const int size, const double sigma)
-{
-    if (size % 2 == 0)
+    // Ширина изображения в символах на одну строку символов
+    const int canvas_width = RawCanvas().Width();
+    const int canvas_height = RawCanvas().Height();
+    const double columns_per_row = static_cast<double>(image.Width()) / image.Height() * cell_aspect;
+    int width = canvas_width;
+    int height = canvas_height;
+    if (static_cast<double>(canvas_width) / canvas_height > columns_per_row)
     {
-        throw std::invalid_argument("Kernel size must be odd");
+        width = std::clamp(static_cast<int>(std::lround(canvas_height * columns_per_row)), 1, canvas_width);
     }
+    else
+    {
+        height = std::clamp(static_cast<int>(std::lround(canvas_width / columns_per_row)), 1, canvas_height);
+    }
+    const int left = (canvas_width - width) / 2;
+    const int top = (canvas_height - height) / 2;
 
-    std::vector<std::vector<double>> kernel(size, std::vector<double>(size));
-    double sum = 0.0;
-    const int center = size / 2;
+    const AreaDownscaler downscaler(image, width, height);
+    PrepareBrightnessWrite();
 
-    for (int i = 0; i < size; ++i)
+    if (dither != Dither::None && !HasBrightnessPlane())
     {
-        for (int j = 0; j < size; ++j)
+        // Диффузии нужны строки полосы целиком, поэтому изображение сначала уменьшается в буфер
+        std::vector<float> brightness(static_cast<size_t>(width) * height);
+        ForEachRowBand(height, [&](const RowBand band)
         {
-            const int x = i - center;
-            const int y = j - center;
-            kernel[i][j] = std::exp(-(x * x + y * y) / (2 * sigma * sigma));
-            sum += kernel[i][j];
-        }
+            downscaler.ProcessRows(band.begin, band.end, [&](const int y, const double* const row)
+            {
+                std::copy(row, row + width, brightness.begin() + static_cast<ptrdiff_t>(y) * width);
+            });
+        });
+        DitherRegion({ left, top, left + width - 1, top + height - 1 }, dither, [&](const int y, float* const row)
+        {
+            const auto source = brightness.begin() + static_cast<ptrdiff_t>(y - top) * width;
+            std::copy(source, source + width, row);
+        });
+        return;
     }
 
-    for (int i = 0; i < size; ++i)
+    Canvas& canvas = RawCanvas();
+    char* const symbols = HasBrightnessPlane() ? nullptr : canvas.CountedData();
+    PLOTTER_PROFILE_COUNT("pixels_written", width * height);
+
+    ForEachRowBand(height, [&](const RowBand band)
     {
-        for (int j = 0; j < size; ++j)
+        Canvas::BandCounts counts(canvas);
+        downscaler.ProcessRows(band.begin, band.end, [&](const int y, const double* const row)
         {
-            kernel[i][j] /= sum;
-        }
-    }
+            const size_t offset = static_cast<size_t>(top + y) * canvas_width + left;
+            if (HasBrightnessPlane())
+            {
+                std::transform(row, row + width, plane_.begin() + static_cast<ptrdiff_t>(offset), BrightnessToLevel);
+            }
+            else
+            {
+                counts.Before(symbols + offset, symbols + offset + width);
+                std::transform(row, row + width, symbols + offset,
+                    [this](const double brightness) { return BrightnessToChar(brightness); });
+                counts.After(symbols + offset, symbols + offset + width);
+            }
+        });
+        counts.Merge();
+    });
+}
 
-    return kernel;
+std::unique_ptr<Canvas> GrayscalePlotter::Resize(const int width, const int height, const ResampleFilter filter) const
+{
+    auto result = std::make_unique<Canvas>(width, height, RawCanvas().Background());
+    ResizeInto(*result, filter);
+    return result;
 }
 
-std::vector<std::vector<double>> GrayscalePlotter::CreateBoxKernel(const int size)
+void GrayscalePlotter::ResizeInto(Canvas& target, const ResampleFilter filter) const
 {
-    std::vector<std::vector<double>> kernel(size, std::vector<double>(size));
-    const double value = 1.0 / (size * size);
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ResizeInto");
+    if (filter == ResampleFilter::Nearest)
+    {
+        Plotter::ResizeInto(target);
+        return;
+    }
+    if (&target == &RawCanvas())
+    {
+        throw std::invalid_argument("Can't resize canvas into itself");
+    }
 
-    for (int i = 0; i < size; ++i)
+    const int source_width = RawCanvas().Width();
+    const int source_height = RawCanvas().Height();
+    const int width = target.Width();
+    const auto make_weights = filter == ResampleFilter::Area ? AreaWeights : BilinearWeights;
+    const ResampleWeights columns = make_weights(source_width, width);
+    const ResampleWeights rows = make_weights(source_height, target.Height());
+
+    // Сначала каждая исходная строка пересчитывается по горизонтали
+    BeforeCanvasRead();
+    std::vector<double> reduced(static_cast<size_t>(source_height) * width);
+    ForEachRowBand(source_height, [&](const RowBand band)
     {
-        for (int j = 0; j < size; ++j)
+        std::vector<double> brightness(source_width);
+        for (int y = band.begin; y < band.end; ++y)
         {
-            kernel[i][j] = value;
+            LoadBrightnessRow(y, brightness.data());
+            double* const row = reduced.data() + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x)
+            {
+                double sum = 0.0;
+                for (int entry = columns.first[x]; entry < columns.first[x + 1]; ++entry)
+                {
+                    sum += columns.weights[entry] * brightness[columns.sources[entry]];
+                }
+                row[x] = sum;
+            }
         }
-    }
+    });
 
-    return kernel;
+    // Затем строки результата складываются из строк с весами: сплошные проходы по строке
+    char* const symbols = target.CountedData();
+    PLOTTER_PROFILE_COUNT("pixels_written", target.Size());
+    ForEachRowBand(target.Height(), [&](const RowBand band)
+    {
+        Canvas::BandCounts counts(target);
+        counts.Before(symbols + static_cast<size_t>(band.begin) * width, symbols + static_cast<size_t>(band.end) * width);
+        std::vector<double> sums(width);
+        for (int y = band.begin; y < band.end; ++y)
+        {
+            std::fill(sums.begin(), sums.end(), 0.0);
+            for (int entry = rows.first[y]; entry < rows.first[y + 1]; ++entry)
+            {
+                const double weight = rows.weights[entry];
+                const double* const row = reduced.data() + static_cast<size_t>(rows.sources[entry]) * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    sums[x] += weight * row[x];
+                }
+            }
+            std::transform(sums.begin(), sums.end(), symbols + static_cast<size_t>(y) * width,
+                [this](const double brightness) { return BrightnessToChar(brightness + RESAMPLE_TOLERANCE); });
+        }
+        counts.After(symbols + static_cast<size_t>(band.begin) * width, symbols + static_cast<size_t>(band.end) * width);
+        counts.Merge();
+    });
 }
 
-std::vector<std::vector<double>> GrayscalePlotter::Convolve(const std::vector<std::vector<double>>& kernel) const
+void GrayscalePlotter::TransformRegion(const Canvas& source, const AffineTransform& transform,
+    const ResampleFilter filter)
 {
-    const int kernel_size = kernel.size();
-    if (kernel_size % 2 == 0)
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::TransformRegion");
+    if (filter == ResampleFilter::Nearest)
     {
-        throw std::invalid_argument("Kernel size must be odd");
+        Plotter::TransformRegion(source, transform);
+        return;
+    }
+    if (filter != ResampleFilter::Bilinear)
+    {
+        throw std::invalid_argument("Transform supports nearest and bilinear filters only");
     }
 
-    const int offset = kernel_size / 2;
-    const int width = GetCanvas().Width();
-    const int height = GetCanvas().Height();
+    // Яркость source считается до записи: source может быть канвасом плоттера
+    const int source_width = source.Width();
+    const int source_height = source.Height();
+    std::vector<float> brightness(static_cast<size_t>(source_width) * source_height);
+    const bool from_plane = &source == &RawCanvas() && PlaneIsCurrent();
+    const char* const source_symbols = source.Data();
+    ForEachRowBand(source_height, [&](const RowBand band)
+    {
+        const size_t begin = static_cast<size_t>(band.begin) * source_width;
+        const size_t end = static_cast<size_t>(band.end) * source_width;
+        for (size_t i = begin; i < end; ++i)
+        {
+            brightness[i] = from_plane ? static_cast<float>(plane_[i]) / MAX_LEVEL
+                                       : static_cast<float>(char_to_brightness_[CharCode(source_symbols[i])]);
+        }
+    });
 
-    std::vector<std::vector<double>> result(height, std::vector<double>(width, 0.0));
+    PrepareBrightnessWrite();
+    Canvas& canvas = RawCanvas();
+    char* const symbols = HasBrightnessPlane() ? nullptr : canvas.CountedData();
+    const int width = canvas.Width();
+    constexpr int FRACTION_BITS = TransformSpan::FRACTION_BITS;
+    constexpr std::int64_t HALF = std::int64_t{ 1 } << (FRACTION_BITS - 1);
+    constexpr std::int64_t FRACTION_MASK = (std::int64_t{ 1 } << FRACTION_BITS) - 1;
+    constexpr double FRACTION_SCALE = 1.0 / static_cast<double>(std::int64_t{ 1 } << FRACTION_BITS);
 
-    for (int y = 0; y < height; ++y)
+    ForEachTransformSpan(source_width, source_height, transform, [&](const TransformSpan& span)
     {
-        for (int x = 0; x < width; ++x)
+        const size_t row = static_cast<size_t>(span.y) * width;
+        // Участок — наименьшая единица обхода, поэтому замены в статистике переносятся по участкам
+        Canvas::BandCounts counts(canvas);
+        if (symbols)
+        {
+            counts.Before(symbols + row + span.x_begin, symbols + row + span.x_end);
+        }
+        // Отсчет от центров пикселей source
+        std::int64_t u = span.u - HALF;
+        std::int64_t v = span.v - HALF;
+        for (int x = span.x_begin; x < span.x_end; ++x, u += span.du, v += span.dv)
         {
-            double sum = 0.0;
+            const auto left = static_cast<int>(u >> FRACTION_BITS);
+            const auto top = static_cast<int>(v >> FRACTION_BITS);
+            const double fraction_x = static_cast<double>(u & FRACTION_MASK) * FRACTION_SCALE;
+            const double fraction_y = static_cast<double>(v & FRACTION_MASK) * FRACTION_SCALE;
+            const int x0 = std::clamp(left, 0, source_width - 1);
+            const int x1 = std::clamp(left + 1, 0, source_width - 1);
+            const float* const row0 = brightness.data() + static_cast<size_t>(std::clamp(top, 0, source_height - 1)) * source_width;
+            const float* const row1 = brightness.data() + static_cast<size_t>(std::clamp(top + 1, 0, source_height - 1)) * source_width;
 
-            for (int ky = 0; ky < kernel_size; ++ky)
+            const double upper = row0[x0] + (row0[x1] - row0[x0]) * fraction_x;
+            const double lower = row1[x0] + (row1[x1] - row1[x0]) * fraction_x;
+            const double value = upper + (lower - upper) * fraction_y + RESAMPLE_TOLERANCE;
+            if (symbols)
             {
-                for (int kx = 0; kx < kernel_size; ++kx)
-                {
-                    int src_x = x + kx - offset;
-                    int src_y = y + ky - offset;
-
-                    // Обработка границ: отражаем
-                    if (src_x < 0)
-                    {
-                        src_x = -src_x;
-                    }
-                    if (src_x >= width)
-                    {
-                        src_x = 2 * width - src_x - 1;
-                    }
-                    if (src_y < 0)
-                    {
-                        src_y = -src_y;
-                    }
-                    if (src_y >= height)
-                    {
-                        src_y = 2 * height - src_y - 1;
-                    }
-
-                    if (GetCanvas().InBounds(src_x, src_y))
-                    {
-                        const double pixel_brightness = GetPixelBrightness(src_x, src_y);
-                        sum += pixel_brightness * kernel[ky][kx];
-                    }
-                }
+                symbols[row + x] = BrightnessToChar(value);
+            }
+            else
+            {
+                plane_[row + x] = BrightnessToLevel(value);
             }
-
-            result[y][x] = std::clamp(sum, 0.0, 1.0);
         }
-    }
-
-    return result;
+        if (symbols)
+        {
+            counts.After(symbols + row + span.x_begin, symbols + row + span.x_end);
+            counts.Merge();
+        }
+    });
 }
 
-void GrayscalePlotter::ApplyBoxBlur(int kernel_size)
+double GrayscalePlotter::CalculateAverageBrightness() const
 {
-    if (kernel_size % 2 == 0)
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::CalculateAverageBrightness");
+    if (PlaneIsCurrent())
     {
-        kernel_size++; // Делаем нечетным
+        double total = 0.0;
+        for (const std::uint8_t level : plane_)
+        {
+            total += static_cast<double>(level) / MAX_LEVEL;
+        }
+        return plane_.empty() ? 0.0 : total / plane_.size();
     }
 
-    const auto kernel = CreateBoxKernel(kernel_size);
-    const auto convolved = Convolve(kernel);
+    double total = 0.0;
+    int count = 0;
+
+    const Canvas& canvas = GetCanvas();
+    if (canvas.HasStatistics())
+    {
+        const CharCounts& counts = canvas.Statistics();
+        for (size_t code = 0; code < counts.size(); ++code)
+        {
+            if (in_palette_[code])
+            {
+                total += char_to_brightness_[code] * counts[code];
+                count += counts[code];
+            }
+        }
+        return count > 0 ? total / count : 0.0;
+    }
 
-    for (int y = 0; y < GetCanvas().Height(); ++y)
+    for (const char pixel : std::span(canvas.Data(), canvas.Size()))
     {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
+        if (in_palette_[CharCode(pixel)])
         {
-            SetPixelBrightness(x, y, convolved[y][x]);
+            total += char_to_brightness_[CharCode(pixel)];
+            count++;
         }
     }
+
+    return count > 0 ? total / count : 0.0;
 }
 
-void GrayscalePlotter::ApplyGaussianBlur(int kernel_size)
+BrightnessExtrema GrayscalePlotter::GetMinMaxBrightness() const
 {
-    if (kernel_size % 2 == 0)
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::GetMinMaxBrightness");
+    if (RawCanvas().Size() == 0)
     {
-        kernel_size++; // Делаем нечетным
+        return { 0.0, 0.0 };
     }
 
-    // Из исходного кода
-    // const действительно необязателен здесь.
-    // Однако, он может быть полезен, чтобы ненамеренно не изменить значение, особенно, если много строк кода в функции.
-    // Кроме того, для другим разработчикам будет сразу видно, что переменная не изменяется.
-    double sigma = kernel_size / 3.0;
-    const auto kernel = CreateGaussianKernel(kernel_size, sigma);
-    const auto convolved = Convolve(kernel);
-
-    // Применяем результат к canvas
-    for (int y = 0; y < GetCanvas().Height(); ++y)
+    if (PlaneIsCurrent())
     {
-        for (int x = 0; x < GetCanvas().Width(); ++x)
-        {
-            SetPixelBrightness(x, y, convolved[y][x]);
-        }
+        const auto [min_level, max_level] = std::minmax_element(plane_.begin(), plane_.end());
+        return { static_cast<double>(*min_level) / MAX_LEVEL, static_cast<double>(*max_level) / MAX_LEVEL };
     }
-}
 
-void GrayscalePlotter::SetPalette(const std::vector<char>& new_palette)
-{
-    if (!new_palette.empty())
+    double min_brightness = 1.0;
+    double max_brightness = 0.0;
+    auto account = [&](const size_t code)
     {
-        if (new_palette.size() < 2)
+        if (in_palette_[code])
         {
-            throw std::invalid_argument("Palette size can't be less than 2");
+            const double brightness = char_to_brightness_[code];
+            min_brightness = std::min(min_brightness, brightness);
+            max_brightness = std::max(max_brightness, brightness);
         }
-        palette_ = new_palette;
-        char_to_brightness_ = CreateCharToBrightness();
+    };
 
-        const auto brightness_matrix = GetBrightnessMatrix();
-        for (int y = 0; y < GetCanvas().Height(); ++y)
+    const Canvas& canvas = GetCanvas();
+    if (canvas.HasStatistics())
+    {
+        const CharCounts& counts = canvas.Statistics();
+        for (size_t code = 0; code < counts.size(); ++code)
         {
-            for (int x = 0; x < GetCanvas().Width(); ++x)
+            if (counts[code] > 0)
             {
-                GetCanvas().at(x, y) = BrightnessToChar(brightness_matrix[y][x]);
+                account(code);
             }
         }
     }
-}
-
-std::unordered_map<char, double> GrayscalePlotter::CreateCharToBrightness()
+    else
+    {
+        for (const char pixel : std::span(canvas.Data(), canvas.Size()))
+        {
+            account(CharCode(pixel));
+        }
+    }
+
+    return { min_brightness, max_brightness };
+}
+
+std::vector<std::vector<double>> GrayscalePlotter::GetBrightnessMatrix() const
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::GetBrightnessMatrix");
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+    std::vector<std::vector<double>> matrix(height, std::vector<double>(width));
+
+    for (int y = 0; y < height; ++y)
+    {
+        LoadBrightnessRow(y, matrix[y].data());
+    }
+
+    return matrix;
+}
+
+BrightnessView GrayscalePlotter::GetBrightnessView() const
+{
+    const Canvas& canvas = RawCanvas();
+    if (PlaneIsCurrent())
+    {
+        return { plane_.data(), canvas.Width(), canvas.Height(), static_cast<size_t>(canvas.Width()) };
+    }
+
+    BeforeCanvasRead();
+    return { canvas.Data(), canvas.Width(), canvas.Height(), static_cast<size_t>(canvas.Width()), &char_to_brightness_ };
+}
+
+void GrayscalePlotter::ExportBrightness(float* const dst, const size_t dst_stride) const
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ExportBrightness");
+    const BrightnessView view = GetBrightnessView();
+    ForEachRowBand(view.Height(), [&](const RowBand band)
+    {
+        view.Subview(0, band.begin, view.Width(), band.end - band.begin)
+            .ExportTo(dst + static_cast<size_t>(band.begin) * dst_stride, dst_stride);
+    });
+}
+
+void GrayscalePlotter::ExportBrightness(std::uint8_t* const dst, const size_t dst_stride) const
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ExportBrightness");
+    const BrightnessView view = GetBrightnessView();
+    ForEachRowBand(view.Height(), [&](const RowBand band)
+    {
+        view.Subview(0, band.begin, view.Width(), band.end - band.begin)
+            .ExportTo(dst + static_cast<size_t>(band.begin) * dst_stride, dst_stride);
+    });
+}
+
+void GrayscalePlotter::AdjustBrightness(const double factor)
+{
+    ApplyPointTransform([factor](const double brightness)
+    {
+        return std::clamp(brightness * factor, 0.0, 1.0);
+    });
+}
+
+void GrayscalePlotter::ApplyThreshold(const double threshold)
+{
+    ApplyPointTransform([threshold](const double brightness)
+    {
+        return brightness >= threshold ? 1.0 : 0.0;
+    });
+}
+
+void GrayscalePlotter::InvertBrightness()
+{
+    ApplyPointTransform([](const double brightness)
+    {
+        return 1.0 - brightness;
+    });
+}
+
+CharMap GrayscalePlotter::MakePointMap(const std::function<double(double)>& transform) const
+{
+    CharMap table = IdentityCharMap();
+    for (size_t code = 0; code < table.size(); ++code)
+    {
+        if (in_palette_[code])
+        {
+            table[code] = BrightnessToChar(transform(char_to_brightness_[code]));
+        }
+    }
+    return table;
+}
+
+void GrayscalePlotter::ApplyCharMap(const CharMap& table)
+{
+    // В режиме слоя яркости символы становятся источником, слой будет пересобран
+    BeforeCanvasWrite();
+
+    RawCanvas().Remap(table, [this](const int rows, const Canvas::RowRemap& remap)
+    {
+        ForEachRowBand(rows, [&remap](const RowBand band) { remap(band.begin, band.end); });
+    });
+}
+
+void GrayscalePlotter::RewriteSymbols(Canvas& canvas, const std::function<void(size_t, size_t, char*)>& write) const
+{
+    const auto width = static_cast<size_t>(canvas.Width());
+    char* const symbols = canvas.CountedData();
+    ForEachRowBand(canvas.Height(), [&](const RowBand band)
+    {
+        const size_t begin = static_cast<size_t>(band.begin) * width;
+        const size_t end = static_cast<size_t>(band.end) * width;
+        Canvas::BandCounts counts(canvas);
+        counts.Before(symbols + begin, symbols + end);
+        write(begin, end, symbols);
+        counts.After(symbols + begin, symbols + end);
+        counts.Merge();
+    });
+}
+
+GrayscalePlotter::LevelMap GrayscalePlotter::MakeLevelMap(const std::function<double(double)>& transform) const
+{
+    LevelMap table{};
+    for (size_t level = 0; level < table.size(); ++level)
+    {
+        table[level] = BrightnessToLevel(transform(static_cast<double>(level) / MAX_LEVEL));
+    }
+    return table;
+}
+
+void GrayscalePlotter::ApplyLevelMap(const LevelMap& table)
+{
+    SyncPlane();
+    PLOTTER_PROFILE_COUNT("pixels_written", plane_.size());
+
+    const int width = RawCanvas().Width();
+    ForEachRowBand(RawCanvas().Height(), [&](const RowBand band)
+    {
+        const auto begin = plane_.begin() + static_cast<ptrdiff_t>(band.begin) * width;
+        const auto end = plane_.begin() + static_cast<ptrdiff_t>(band.end) * width;
+        std::transform(begin, end, begin, [&table](const std::uint8_t level) { return table[level]; });
+    });
+
+    chars_stale_ = true;
+}
+
+void GrayscalePlotter::ApplyPointTransform(const std::function<double(double)>& transform)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ApplyPointTransform");
+    if (HasBrightnessPlane())
+    {
+        ApplyLevelMap(MakeLevelMap(transform));
+    }
+    else
+    {
+        ApplyCharMap(MakePointMap(transform));
+    }
+}
+
+void GrayscalePlotter::EnableBrightnessPlane()
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::EnableBrightnessPlane");
+    if (HasBrightnessPlane())
+    {
+        return;
+    }
+
+    const Canvas& canvas = RawCanvas();
+    plane_.resize(canvas.Size());
+    std::transform(canvas.Data(), canvas.Data() + canvas.Size(), plane_.begin(),
+        [this](const char symbol) { return char_to_level_[CharCode(symbol)]; });
+    chars_stale_ = false;
+    plane_stale_ = false;
+}
+
+void GrayscalePlotter::DisableBrightnessPlane()
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DisableBrightnessPlane");
+    BeforeCanvasRead();
+    plane_.clear();
+    plane_.shrink_to_fit();
+    chars_stale_ = false;
+    plane_stale_ = false;
+}
+
+bool GrayscalePlotter::CanvasIsStale() const noexcept
+{
+    return chars_stale_.load(std::memory_order_acquire);
+}
+
+void GrayscalePlotter::SyncCanvas(Canvas& canvas) const
+{
+    RewriteSymbols(canvas, [this](const size_t begin, const size_t end, char* const symbols)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            symbols[i] = level_to_char_[plane_[i]];
+        }
+    });
+
+    chars_stale_.store(false, std::memory_order_release);
+}
+
+void GrayscalePlotter::BeforeCanvasWrite()
+{
+    BeforeCanvasRead();
+    if (HasBrightnessPlane() && !drawing_to_plane_)
+    {
+        plane_stale_ = true;
+    }
+}
+
+void GrayscalePlotter::SyncPlane()
+{
+    if (!plane_stale_)
+    {
+        return;
+    }
+
+    // Символы актуальны относительно слоя с последнего BeforeCanvasWrite, поэтому пиксель с символом
+    // своего уровня не менялся или получил тот же символ, и его точный уровень сохраняется
+    const Canvas& canvas = RawCanvas();
+    const char* const symbols = canvas.Data();
+    for (size_t i = 0; i < plane_.size(); ++i)
+    {
+        if (level_to_char_[plane_[i]] != symbols[i])
+        {
+            plane_[i] = char_to_level_[CharCode(symbols[i])];
+        }
+    }
+
+    plane_stale_ = false;
+}
+
+void GrayscalePlotter::PrepareBrightnessWrite()
+{
+    if (HasBrightnessPlane())
+    {
+        SyncPlane();
+        chars_stale_ = true;
+    }
+}
+
+bool GrayscalePlotter::PlaneIsCurrent() const noexcept
+{
+    return HasBrightnessPlane() && !plane_stale_;
+}
+
+GrayscalePlotter::PaintBounds GrayscalePlotter::WholeCanvas() const noexcept
+{
+    return { 0, 0, RawCanvas().Width() - 1, RawCanvas().Height() - 1 };
+}
+
+void GrayscalePlotter::Paint(const PaintBounds& bounds, const double brightness, const std::function<void(char)>& draw,
+    const Dither dither)
+{
+    if (!HasBrightnessPlane() && dither == Dither::None)
+    {
+        draw(BrightnessToChar(brightness));
+        return;
+    }
+
+    if (!HasBrightnessPlane())
+    {
+        // Примитив рисуется маркером, затем пиксели маркера получают символы с дизерингом
+        DrawMarker(draw);
+        const PaintBounds region = ClipToCanvas(bounds.x1, bounds.y1, bounds.x2, bounds.y2);
+        if (region.x1 > region.x2 || region.y1 > region.y2)
+        {
+            return;
+        }
+        const Canvas& canvas = RawCanvas();
+        const auto value = static_cast<float>(std::isnan(brightness) ? 0.0 : brightness);
+        DitherRegion(region, dither, [&](const int y, float* const row)
+        {
+            for (int x = region.x1; x <= region.x2; ++x)
+            {
+                row[x - region.x1] = canvas(x, y) == MARKER ? value : std::numeric_limits<float>::quiet_NaN();
+            }
+        });
+        return;
+    }
+
+    // Примитив рисуется маркером по актуальным символам, затем маркер заменяется уровнем яркости
+    SyncPlane();
+    BeforeCanvasRead();
+
+    drawing_to_plane_ = true;
+    try
+    {
+        DrawMarker(draw);
+    }
+    catch (...)
+    {
+        drawing_to_plane_ = false;
+        throw;
+    }
+    drawing_to_plane_ = false;
+
+    Canvas& canvas = RawCanvas();
+    const std::uint8_t level = BrightnessToLevel(brightness);
+    const char symbol = LevelToChar(level);
+
+    const int left = std::max(0, bounds.x1);
+    const int right = std::min(canvas.Width() - 1, bounds.x2);
+    const int top = std::max(0, bounds.y1);
+    const int bottom = std::min(canvas.Height() - 1, bounds.y2);
+
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+        {
+            if (std::as_const(canvas)(x, y) == MARKER)
+            {
+                canvas.SetPixel(x, y, symbol);
+                plane_[static_cast<size_t>(y) * canvas.Width() + x] = level;
+            }
+        }
+    }
+}
+
+void GrayscalePlotter::DitherRegion(const PaintBounds& region, const Dither dither,
+    const std::function<void(int, float*)>& load_row)
+{
+    const int region_width = region.x2 - region.x1 + 1;
+    const int rows = region.y2 - region.y1 + 1;
+    Canvas& canvas = RawCanvas();
+    const int canvas_width = canvas.Width();
+    char* const symbols = canvas.CountedData();
+    const auto row_start = [&](const int y) { return symbols + static_cast<size_t>(y) * canvas_width + region.x1; };
+    // Учитывается вся область, включая пропущенные пиксели вне примитива
+    PLOTTER_PROFILE_COUNT("pixels_written", region_width * rows);
+
+    if (dither == Dither::Ordered)
+    {
+        // Индекс — floor(яркость * scale + порог клетки матрицы Байера), пороги и символы берутся из таблиц
+        const Quantizer quantize = PaletteQuantizer();
+        const auto& thresholds = BayerThresholds();
+        ForEachRowBand(rows, [&](const RowBand band)
+        {
+            Canvas::BandCounts counts(canvas);
+            std::vector<float> row(region_width);
+            for (int y = region.y1 + band.begin; y < region.y1 + band.end; ++y)
+            {
+                load_row(y, row.data());
+                const double* const cells = thresholds.data() + static_cast<size_t>(y % BAYER_SIZE) * BAYER_SIZE;
+                char* const out = row_start(y);
+                counts.Before(out, out + region_width);
+                for (int i = 0; i < region_width; ++i)
+                {
+                    if (!std::isnan(row[i]))
+                    {
+                        const double value = std::clamp(static_cast<double>(row[i]), 0.0, 1.0) * quantize.scale;
+                        const int index = static_cast<int>(value + cells[(region.x1 + i) % BAYER_SIZE]);
+                        out[i] = palette_[std::min(index, quantize.max_index)];
+                    }
+                }
+                counts.After(out, out + region_width);
+            }
+            counts.Merge();
+        });
+        return;
+    }
+
+    ErrorDiffuser diffuser(dither, region_width, rows, static_cast<int>(palette_.size()) - 1);
+    ForEachRowBand(rows, [&](const RowBand band)
+    {
+        Canvas::BandCounts counts(canvas);
+        diffuser.ProcessRows(band.begin, band.end,
+            [&](const int row, float* const values) { load_row(region.y1 + row, values); },
+            [&](const int row, const int* const indices)
+            {
+                char* const out = row_start(region.y1 + row);
+                counts.Before(out, out + region_width);
+                for (int i = 0; i < region_width; ++i)
+                {
+                    if (indices[i] >= 0)
+                    {
+                        out[i] = palette_[indices[i]];
+                    }
+                }
+                counts.After(out, out + region_width);
+            });
+        counts.Merge();
+    });
+}
+
+void GrayscalePlotter::Requantize(const Dither dither)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::Requantize");
+    if (!HasBrightnessPlane())
+    {
+        // Символы палитры квантуются сами в себя без ошибки
+        return;
+    }
+
+    SyncPlane();
+    if (dither == Dither::None)
+    {
+        chars_stale_ = true;
+        BeforeCanvasRead();
+        return;
+    }
+
+    const int width = RawCanvas().Width();
+    DitherRegion(WholeCanvas(), dither, [&](const int y, float* const row)
+    {
+        const std::uint8_t* const levels = plane_.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x)
+        {
+            row[x] = static_cast<float>(levels[x]) / MAX_LEVEL;
+        }
+    });
+    chars_stale_ = false;
+}
+
+std::uint8_t GrayscalePlotter::BrightnessToLevel(const double brightness) noexcept
+{
+    return static_cast<std::uint8_t>(LevelQuantizer()(brightness));
+}
+
+double GrayscalePlotter::GetPixelBrightness(const int x, const int y) const
+{
+    if (!RawCanvas().InBounds(x, y))
+        return 0.0;
+
+    if (PlaneIsCurrent())
+    {
+        return static_cast<double>(plane_[static_cast<size_t>(y) * RawCanvas().Width() + x]) / MAX_LEVEL;
+    }
+    return char_to_brightness_[CharCode(GetCanvas()(x, y))];
+}
+
+void GrayscalePlotter::LoadBrightnessRow(const int y, double* const row) const
+{
+    const int width = RawCanvas().Width();
+    const size_t offset = static_cast<size_t>(y) * width;
+
+    if (PlaneIsCurrent())
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            row[x] = static_cast<double>(plane_[offset + x]) / MAX_LEVEL;
+        }
+        return;
+    }
+
+    const char* const symbols = GetCanvas().Data() + offset;
+    for (int x = 0; x < width; ++x)
+    {
+        row[x] = char_to_brightness_[CharCode(symbols[x])];
+    }
+}
+
+std::vector<std::vector<double>> GrayscalePlotter::CreateGaussianKernel(const int size, const double sigma)
+{
+    if (size % 2 == 0)
+    {
+        throw std::invalid_argument("Kernel size must be odd");
+    }
+
+    std::vector<std::vector<double>> kernel(size, std::vector<double>(size));
+    double sum = 0.0;
+    const int center = size / 2;
+
+    for (int i = 0; i < size; ++i)
+    {
+        for (int j = 0; j < size; ++j)
+        {
+            const int x = i - center;
+            const int y = j - center;
+            kernel[i][j] = std::exp(-(x * x + y * y) / (2 * sigma * sigma));
+            sum += kernel[i][j];
+        }
+    }
+
+    for (int i = 0; i < size; ++i)
+    {
+        for (int j = 0; j < size; ++j)
+        {
+            kernel[i][j] /= sum;
+        }
+    }
+
+    return kernel;
+}
+
+std::vector<std::vector<double>> GrayscalePlotter::CreateBoxKernel(const int size)
+{
+    std::vector<std::vector<double>> kernel(size, std::vector<double>(size));
+    const double value = 1.0 / (size * size);
+
+    for (int i = 0; i < size; ++i)
+    {
+        for (int j = 0; j < size; ++j)
+        {
+            kernel[i][j] = value;
+        }
+    }
+
+    return kernel;
+}
+
+void GrayscalePlotter::Convolve(const std::vector<std::vector<double>>& kernel,
+    const std::function<void(int, const double*)>& store_row) const
+{
+    const int kernel_size = kernel.size();
+    if (kernel_size % 2 == 0)
+    {
+        throw std::invalid_argument("Kernel size must be odd");
+    }
+
+    const int offset = kernel_size / 2;
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+
+    // Обработка границ: отражаем. -1 — координата и после отражения вне канваса
+    auto reflect = [](int pos, const int size)
+    {
+        if (pos < 0)
+        {
+            pos = -pos;
+        }
+        if (pos >= size)
+        {
+            pos = 2 * size - pos - 1;
+        }
+        return (pos >= 0 && pos < size) ? pos : -1;
+    };
+
+    // Столбец источника для x + kx - offset, индекс сдвинут на offset
+    std::vector<int> source_columns(width + 2 * offset);
+    for (int i = 0; i < static_cast<int>(source_columns.size()); ++i)
+    {
+        source_columns[i] = reflect(i - offset, width);
+    }
+
+    // Каждая полоса читает свои строки и offset строк-ореолов сверху и снизу.
+    // Порядок суммирования тот же, что и при последовательной обработке,
+    // поэтому результат не зависит от числа потоков.
+    ForEachRowBand(height, [&](const RowBand band)
+    {
+        const int halo_rows = band.end - band.begin + 2 * offset;
+        std::vector<double> halo(static_cast<size_t>(halo_rows) * width);
+        std::vector<bool> halo_valid(halo_rows);
+
+        for (int row = 0; row < halo_rows; ++row)
+        {
+            const int src_y = reflect(band.begin - offset + row, height);
+            halo_valid[row] = src_y >= 0;
+            if (src_y < 0)
+            {
+                continue;
+            }
+            LoadBrightnessRow(src_y, &halo[static_cast<size_t>(row) * width]);
+        }
+
+        std::vector<double> sums(width);
+        for (int y = band.begin; y < band.end; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                double sum = 0.0;
+
+                for (int ky = 0; ky < kernel_size; ++ky)
+                {
+                    const int row = y - band.begin + ky;
+                    if (!halo_valid[row])
+                    {
+                        continue;
+                    }
+
+                    const double* halo_row = &halo[static_cast<size_t>(row) * width];
+                    for (int kx = 0; kx < kernel_size; ++kx)
+                    {
+                        const int src_x = source_columns[x + kx];
+                        if (src_x >= 0)
+                        {
+                            sum += halo_row[src_x] * kernel[ky][kx];
+                        }
+                    }
+                }
+
+                sums[x] = std::clamp(sum, 0.0, 1.0);
+            }
+
+            store_row(y, sums.data());
+        }
+    });
+}
+
+void GrayscalePlotter::ApplyKernel(const std::vector<std::vector<double>>& kernel)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ApplyKernel");
+    // Свертка читает соседние строки, поэтому результат пишется в канвас только после всех полос
+    const int width = RawCanvas().Width();
+    PLOTTER_PROFILE_COUNT("pixels_written", RawCanvas().Size());
+
+    if (HasBrightnessPlane())
+    {
+        SyncPlane();
+        std::vector<std::uint8_t> convolved(plane_.size());
+        Convolve(kernel, [&](const int y, const double* sums)
+        {
+            std::transform(sums, sums + width, convolved.begin() + static_cast<ptrdiff_t>(y) * width, BrightnessToLevel);
+        });
+        plane_ = std::move(convolved);
+        chars_stale_ = true;
+        return;
+    }
+
+    std::vector<char> convolved(RawCanvas().Size());
+    Convolve(kernel, [&](const int y, const double* sums)
+    {
+        std::transform(sums, sums + width, convolved.begin() + static_cast<ptrdiff_t>(y) * width,
+            [this](const double brightness) { return BrightnessToChar(brightness); });
+    });
+    RewriteSymbols(RawCanvas(), [&convolved](const size_t begin, const size_t end, char* const symbols)
+    {
+        std::copy(convolved.begin() + static_cast<ptrdiff_t>(begin), convolved.begin() + static_cast<ptrdiff_t>(end), symbols + begin);
+    });
+}
+
+void GrayscalePlotter::ApplyBoxBlur(int kernel_size)
+{
+    if (kernel_size % 2 == 0)
+    {
+        kernel_size++; // Делаем нечетным
+    }
+
+    ApplyKernel(CreateBoxKernel(kernel_size));
+}
+
+void GrayscalePlotter::ApplyGaussianBlur(int kernel_size)
+{
+    if (kernel_size % 2 == 0)
+    {
+        kernel_size++; // Делаем нечетным
+    }
+
+    // Из исходного кода
+    // const действительно необязателен здесь.
+    // Однако, он может быть полезен, чтобы ненамеренно не изменить значение, особенно, если много строк кода в функции.
+    // Кроме того, для другим разработчикам будет сразу видно, что переменная не изменяется.
+    double sigma = kernel_size / 3.0;
+    ApplyKernel(CreateGaussianKernel(kernel_size, sigma));
+}
+
+void GrayscalePlotter::DetectEdges(const double threshold)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::DetectEdges");
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+    // Сравнение квадратов: |G| / 4 > threshold
+    const double limit = std::max(threshold, 0.0) * SOBEL_NORM;
+    const double limit_squared = limit * limit;
+
+    std::vector<char> edges(RawCanvas().Size());
+    ForEachRowBand(height, [&](const RowBand band)
+    {
+        // Три строки яркости с повтором крайних пикселей по бокам, индекс x + 1
+        const size_t padded = static_cast<size_t>(width) + 2;
+        std::vector<double> rows(3 * padded);
+        auto load = [&](const int slot, const int y)
+        {
+            double* const row = &rows[slot * padded];
+            LoadBrightnessRow(std::clamp(y, 0, height - 1), row + 1);
+            row[0] = row[1];
+            row[width + 1] = row[width];
+        };
+        load(0, band.begin - 1);
+        load(1, band.begin);
+
+        std::vector<double> gx(width);
+        std::vector<double> gy(width);
+        for (int y = band.begin; y < band.end; ++y)
+        {
+            const int slot = y - band.begin;
+            load((slot + 2) % 3, y + 1);
+            const double* const above = &rows[(slot % 3) * padded];
+            const double* const middle = &rows[((slot + 1) % 3) * padded];
+            const double* const below = &rows[((slot + 2) % 3) * padded];
+
+            // Оба ядра Собеля за один проход без ветвлений
+            for (int x = 0; x < width; ++x)
+            {
+                gx[x] = (above[x + 2] - above[x]) + 2.0 * (middle[x + 2] - middle[x]) + (below[x + 2] - below[x]);
+                gy[x] = (below[x] + 2.0 * below[x + 1] + below[x + 2]) - (above[x] + 2.0 * above[x + 1] + above[x + 2]);
+            }
+
+            char* const out = &edges[static_cast<size_t>(y) * width];
+            for (int x = 0; x < width; ++x)
+            {
+                out[x] = gx[x] * gx[x] + gy[x] * gy[x] > limit_squared
+                    ? EdgeGlyph(gx[x], gy[x])
+                    : palette_.front();
+            }
+        }
+    });
+
+    BeforeCanvasWrite();
+    PLOTTER_PROFILE_COUNT("pixels_written", edges.size());
+    RewriteSymbols(RawCanvas(), [&edges](const size_t begin, const size_t end, char* const symbols)
+    {
+        std::copy(edges.begin() + static_cast<ptrdiff_t>(begin), edges.begin() + static_cast<ptrdiff_t>(end), symbols + begin);
+    });
+}
+
+void GrayscalePlotter::EqualizeHistogram()
+{
+    const PaintBounds canvas = WholeCanvas();
+    EqualizeHistogram(canvas.x1, canvas.y1, canvas.x2, canvas.y2);
+}
+
+void GrayscalePlotter::EqualizeHistogram(const int x1, const int y1, const int x2, const int y2)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::EqualizeHistogram");
+    const PaintBounds region = ClipToCanvas(x1, y1, x2, y2);
+    const std::vector<size_t> histogram = ValueHistogram(region);
+    const int max_value = static_cast<int>(histogram.size()) - 1;
+
+    std::vector<size_t> cumulative(histogram.size());
+    std::partial_sum(histogram.begin(), histogram.end(), cumulative.begin());
+    const size_t total = cumulative.back();
+    const auto first_used = std::find_if(histogram.begin(), histogram.end(), [](const size_t count) { return count > 0; });
+    if (first_used == histogram.end())
+    {
+        return;
+    }
+    // Самое темное из встречающихся значений уходит в начало палитры
+    const size_t darkest = *first_used;
+    if (total == darkest)
+    {
+        return;
+    }
+
+    std::vector<int> table(histogram.size());
+    for (size_t value = 0; value < table.size(); ++value)
+    {
+        const double share = static_cast<double>(cumulative[value]) - static_cast<double>(darkest);
+        const auto mapped = std::lround(share * max_value / static_cast<double>(total - darkest));
+        table[value] = static_cast<int>(std::clamp<long>(mapped, 0, max_value));
+    }
+    ApplyValueMap(table, region);
+}
+
+void GrayscalePlotter::AutoContrast(const double clip_percent)
+{
+    const PaintBounds canvas = WholeCanvas();
+    AutoContrast(clip_percent, canvas.x1, canvas.y1, canvas.x2, canvas.y2);
+}
+
+void GrayscalePlotter::AutoContrast(const double clip_percent, const int x1, const int y1, const int x2, const int y2)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::AutoContrast");
+    if (!(clip_percent >= 0.0 && clip_percent < 50.0))
+    {
+        throw std::invalid_argument("Clip percent must be in [0, 50)");
+    }
+
+    const PaintBounds region = ClipToCanvas(x1, y1, x2, y2);
+    const std::vector<size_t> histogram = ValueHistogram(region);
+    const int max_value = static_cast<int>(histogram.size()) - 1;
+    const size_t total = std::accumulate(histogram.begin(), histogram.end(), size_t{ 0 });
+    const double clipped = clip_percent / 100.0 * static_cast<double>(total);
+
+    // Первое значение, до которого включительно набралось больше clipped пикселей, и так же с конца
+    int low = 0;
+    for (size_t seen = 0; low < max_value; ++low)
+    {
+        seen += histogram[low];
+        if (static_cast<double>(seen) > clipped)
+        {
+            break;
+        }
+    }
+    int high = max_value;
+    for (size_t seen = 0; high > 0; --high)
+    {
+        seen += histogram[high];
+        if (static_cast<double>(seen) > clipped)
+        {
+            break;
+        }
+    }
+    if (high <= low)
+    {
+        return;
+    }
+
+    std::vector<int> table(histogram.size());
+    for (int value = 0; value <= max_value; ++value)
+    {
+        const auto mapped = std::lround(static_cast<double>(value - low) * max_value / (high - low));
+        table[value] = static_cast<int>(std::clamp<long>(mapped, 0, max_value));
+    }
+    ApplyValueMap(table, region);
+}
+
+void GrayscalePlotter::EqualizeHistogramLocal(const int tile_size, const double clip_limit)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::EqualizeHistogramLocal");
+    if (tile_size < 1)
+    {
+        throw std::invalid_argument("Tile size can't be less than 1");
+    }
+
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+    const int tiles_x = (width + tile_size - 1) / tile_size;
+    const int tiles_y = (height + tile_size - 1) / tile_size;
+
+    // Пиксели символов вне палитры не входят в гистограммы плиток
+    std::vector<bool> in_palette;
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, const int bins)
+    {
+        // Таблица каждой плитки: значение -> новое значение в дробном виде для интерполяции
+        std::vector<double> maps(static_cast<size_t>(tiles_x) * tiles_y * bins);
+        const auto map_of = [&](const int tx, const int ty)
+        {
+            return &maps[(static_cast<size_t>(ty) * tiles_x + tx) * bins];
+        };
+
+        ForEachRowBand(tiles_y, [&](const RowBand band)
+        {
+            std::vector<double> histogram(bins);
+            for (int ty = band.begin; ty < band.end; ++ty)
+            {
+                for (int tx = 0; tx < tiles_x; ++tx)
+                {
+                    const int left = tx * tile_size;
+                    const int right = std::min(left + tile_size, width);
+                    const int top = ty * tile_size;
+                    const int bottom = std::min(top + tile_size, height);
+
+                    std::fill(histogram.begin(), histogram.end(), 0.0);
+                    double pixels = 0.0;
+                    for (int y = top; y < bottom; ++y)
+                    {
+                        const size_t offset = static_cast<size_t>(y) * width;
+                        for (int x = left; x < right; ++x)
+                        {
+                            if (in_palette.empty() || in_palette[offset + x])
+                            {
+                                histogram[values[offset + x]] += 1.0;
+                                pixels += 1.0;
+                            }
+                        }
+                    }
+
+                    double* const map = map_of(tx, ty);
+                    if (pixels == 0.0)
+                    {
+                        // В плитке нет символов палитры: соседям достается таблица без изменений
+                        for (int value = 0; value < bins; ++value)
+                        {
+                            map[value] = value;
+                        }
+                        continue;
+                    }
+
+                    // Частоты выше предела срезаются, излишек делится поровну между всеми значениями
+                    if (clip_limit > 0.0)
+                    {
+                        const double limit = std::max(1.0, clip_limit * pixels / bins);
+                        double excess = 0.0;
+                        for (double& count : histogram)
+                        {
+                            excess += std::max(count - limit, 0.0);
+                            count = std::min(count, limit);
+                        }
+                        for (double& count : histogram)
+                        {
+                            count += excess / bins;
+                        }
+                    }
+
+                    double cumulative = 0.0;
+                    for (int value = 0; value < bins; ++value)
+                    {
+                        cumulative += histogram[value];
+                        map[value] = cumulative * (bins - 1) / pixels;
+                    }
+                }
+            }
+        });
+
+        // Центры плиток — узлы билинейной интерполяции, у краев берется ближайшая плитка
+        const auto locate = [tile_size](const int position, const int tiles, int& first, int& second, double& weight)
+        {
+            const double offset = (position + 0.5) / tile_size - 0.5;
+            first = std::clamp(static_cast<int>(std::floor(offset)), 0, tiles - 1);
+            second = std::min(first + 1, tiles - 1);
+            weight = std::clamp(offset - first, 0.0, 1.0);
+        };
+
+        ForEachRowBand(height, [&](const RowBand band)
+        {
+            for (int y = band.begin; y < band.end; ++y)
+            {
+                int ty0 = 0;
+                int ty1 = 0;
+                double wy = 0.0;
+                locate(y, tiles_y, ty0, ty1, wy);
+
+                std::uint8_t* const row = &values[static_cast<size_t>(y) * width];
+                for (int x = 0; x < width; ++x)
+                {
+                    int tx0 = 0;
+                    int tx1 = 0;
+                    double wx = 0.0;
+                    locate(x, tiles_x, tx0, tx1, wx);
+
+                    const int value = row[x];
+                    const double top = map_of(tx0, ty0)[value] * (1.0 - wx) + map_of(tx1, ty0)[value] * wx;
+                    const double bottom = map_of(tx0, ty1)[value] * (1.0 - wx) + map_of(tx1, ty1)[value] * wx;
+                    const double mapped = top * (1.0 - wy) + bottom * wy;
+                    row[x] = static_cast<std::uint8_t>(std::clamp(std::lround(mapped), 0L, static_cast<long>(bins - 1)));
+                }
+            }
+        });
+    }, &in_palette);
+}
+
+std::vector<size_t> GrayscalePlotter::ValueHistogram(const PaintBounds& region)
 {
-    std::unordered_map<char, double> char_to_brightness;
+    const bool by_level = HasBrightnessPlane();
+    std::vector<size_t> histogram(by_level ? MAX_LEVEL + 1 : palette_.size());
+    if (region.x1 > region.x2 || region.y1 > region.y2)
+    {
+        return histogram;
+    }
+    if (by_level)
+    {
+        SyncPlane();
+    }
+
+    const int width = RawCanvas().Width();
+    const Canvas& canvas = RawCanvas();
+    std::mutex merge;
+    ForEachRowBand(region.y2 - region.y1 + 1, [&](const RowBand band)
+    {
+        // Полоса считает коды символов или уровни, в индексы палитры они переводятся при слиянии
+        std::array<size_t, 256> counts{};
+        for (int y = region.y1 + band.begin; y < region.y1 + band.end; ++y)
+        {
+            const size_t offset = static_cast<size_t>(y) * width;
+            if (by_level)
+            {
+                for (int x = region.x1; x <= region.x2; ++x)
+                {
+                    ++counts[plane_[offset + x]];
+                }
+            }
+            else
+            {
+                const char* const symbols = canvas.Data() + offset;
+                for (int x = region.x1; x <= region.x2; ++x)
+                {
+                    ++counts[CharCode(symbols[x])];
+                }
+            }
+        }
+
+        std::lock_guard lock(merge);
+        for (size_t code = 0; code < counts.size(); ++code)
+        {
+            const int value = by_level ? static_cast<int>(code) : char_to_index_[code];
+            if (value >= 0)
+            {
+                histogram[value] += counts[code];
+            }
+        }
+    });
+    return histogram;
+}
+
+void GrayscalePlotter::ApplyValueMap(const std::vector<int>& table, const PaintBounds& region)
+{
+    if (region.x1 > region.x2 || region.y1 > region.y2)
+    {
+        return;
+    }
+
+    const int width = RawCanvas().Width();
+    if (HasBrightnessPlane())
+    {
+        SyncPlane();
+        LevelMap levels{};
+        std::copy(table.begin(), table.end(), levels.begin());
+        PLOTTER_PROFILE_COUNT("pixels_written", (region.x2 - region.x1 + 1) * (region.y2 - region.y1 + 1));
+        ForEachRowBand(region.y2 - region.y1 + 1, [&](const RowBand band)
+        {
+            for (int y = region.y1 + band.begin; y < region.y1 + band.end; ++y)
+            {
+                std::uint8_t* const row = &plane_[static_cast<size_t>(y) * width];
+                std::transform(row + region.x1, row + region.x2 + 1, row + region.x1,
+                    [&levels](const std::uint8_t level) { return levels[level]; });
+            }
+        });
+        chars_stale_ = true;
+        return;
+    }
+
+    CharMap symbols = IdentityCharMap();
+    for (size_t code = 0; code < symbols.size(); ++code)
+    {
+        if (char_to_index_[code] >= 0)
+        {
+            symbols[code] = palette_[table[char_to_index_[code]]];
+        }
+    }
+    const PaintBounds canvas = WholeCanvas();
+    if (region.x1 == canvas.x1 && region.y1 == canvas.y1 && region.x2 == canvas.x2 && region.y2 == canvas.y2)
+    {
+        ApplyCharMap(symbols);
+        return;
+    }
+
+    BeforeCanvasWrite();
+    PLOTTER_PROFILE_COUNT("pixels_written", (region.x2 - region.x1 + 1) * (region.y2 - region.y1 + 1));
+    Canvas& target = RawCanvas();
+    char* const data = target.CountedData();
+    ForEachRowBand(region.y2 - region.y1 + 1, [&](const RowBand band)
+    {
+        Canvas::BandCounts counts(target);
+        for (int y = region.y1 + band.begin; y < region.y1 + band.end; ++y)
+        {
+            char* const row = data + static_cast<size_t>(y) * width;
+            counts.Before(row + region.x1, row + region.x2 + 1);
+            std::transform(row + region.x1, row + region.x2 + 1, row + region.x1,
+                [&symbols](const char symbol) { return symbols[CharCode(symbol)]; });
+            counts.After(row + region.x1, row + region.x2 + 1);
+        }
+        counts.Merge();
+    });
+}
+
+GrayscalePlotter::PaintBounds GrayscalePlotter::ClipToCanvas(const int x1, const int y1, const int x2, const int y2) const noexcept
+{
+    return { std::max(x1, 0), std::max(y1, 0), std::min(x2, RawCanvas().Width() - 1), std::min(y2, RawCanvas().Height() - 1) };
+}
+
+void GrayscalePlotter::ApplyMedianFilter(const int radius)
+{
+    CheckRankRadius(radius);
+
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, const int bins)
+    {
+        std::vector<std::uint8_t> result(values.size());
+        ForEachRowBand(height, [&](const RowBand band)
+        {
+            MedianRows(values.data(), result.data(), width, height, bins, radius, band.begin, band.end);
+        });
+        values.swap(result);
+    });
+}
+
+void GrayscalePlotter::ApplyErosion(const int radius)
+{
+    CheckRankRadius(radius);
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, int)
+    {
+        ApplyExtremumFilter(values, radius, Extremum::Min);
+    });
+}
+
+void GrayscalePlotter::ApplyDilation(const int radius)
+{
+    CheckRankRadius(radius);
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, int)
+    {
+        ApplyExtremumFilter(values, radius, Extremum::Max);
+    });
+}
+
+void GrayscalePlotter::ApplyOpening(const int radius)
+{
+    CheckRankRadius(radius);
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, int)
+    {
+        ApplyExtremumFilter(values, radius, Extremum::Min);
+        ApplyExtremumFilter(values, radius, Extremum::Max);
+    });
+}
+
+void GrayscalePlotter::ApplyClosing(const int radius)
+{
+    CheckRankRadius(radius);
+    ApplyRankFilter([&](std::vector<std::uint8_t>& values, int)
+    {
+        ApplyExtremumFilter(values, radius, Extremum::Max);
+        ApplyExtremumFilter(values, radius, Extremum::Min);
+    });
+}
+
+void GrayscalePlotter::ApplyRankFilter(const std::function<void(std::vector<std::uint8_t>&, int)>& filter,
+    std::vector<bool>* const palette_mask)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::ApplyRankFilter");
+    if (HasBrightnessPlane())
+    {
+        SyncPlane();
+        PLOTTER_PROFILE_COUNT("pixels_written", plane_.size());
+        filter(plane_, MAX_LEVEL + 1);
+        chars_stale_ = true;
+        return;
+    }
+
+    // Индекс символа в палитре монотонен по яркости, поэтому медиана, минимум и максимум
+    // по индексам совпадают с ними же по яркости. Для палитры длиннее 256 берутся уровни
+    const bool by_index = palette_.size() <= static_cast<size_t>(MAX_LEVEL) + 1;
+    std::array<std::uint8_t, 256> char_to_value{};
+    if (by_index)
+    {
+        for (size_t code = 0; code < char_to_value.size(); ++code)
+        {
+            char_to_value[code] = static_cast<std::uint8_t>(std::max(char_to_index_[code], 0));
+        }
+    }
+    else
+    {
+        char_to_value = char_to_level_;
+    }
+
+    Canvas& canvas = RawCanvas();
+    std::vector<std::uint8_t> values(canvas.Size());
+    const char* const symbols = std::as_const(canvas).Data();
+    std::transform(symbols, symbols + canvas.Size(), values.begin(),
+        [&](const char symbol) { return char_to_value[CharCode(symbol)]; });
+
+    if (palette_mask)
+    {
+        palette_mask->resize(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            (*palette_mask)[i] = in_palette_[CharCode(symbols[i])];
+        }
+    }
+
+    filter(values, by_index ? static_cast<int>(palette_.size()) : MAX_LEVEL + 1);
+    PLOTTER_PROFILE_COUNT("pixels_written", values.size());
+
+    RewriteSymbols(canvas, [&](const size_t begin, const size_t end, char* const out)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!palette_mask || (*palette_mask)[i])
+            {
+                out[i] = by_index ? palette_[values[i]] : level_to_char_[values[i]];
+            }
+        }
+    });
+}
+
+void GrayscalePlotter::ApplyExtremumFilter(std::vector<std::uint8_t>& values, const int radius,
+    const Extremum extremum) const
+{
+    // Квадратный элемент раскладывается на проходы по строкам и по столбцам
+    const int width = RawCanvas().Width();
+    const int height = RawCanvas().Height();
+    std::vector<std::uint8_t> rows(values.size());
+    ForEachRowBand(height, [&](const RowBand band)
+    {
+        HorizontalExtremumRows(values.data(), rows.data(), width, radius, extremum, band.begin, band.end);
+    });
+    ForEachRowBand(height, [&](const RowBand band)
+    {
+        VerticalExtremumRows(rows.data(), values.data(), width, height, radius, extremum, band.begin, band.end);
+    });
+}
+
+void GrayscalePlotter::SetPalette(const std::vector<char>& new_palette, const Dither dither)
+{
+    PLOTTER_PROFILE_SCOPE("GrayscalePlotter::SetPalette");
+    if (!new_palette.empty())
+    {
+        CheckPalette(new_palette);
+        if (HasBrightnessPlane())
+        {
+            // Слой хранит яркость, поэтому смена палитры только перестраивает таблицы
+            SyncPlane();
+            palette_ = new_palette;
+            BuildLookupTables();
+            chars_stale_ = true;
+            Requantize(dither);
+            return;
+        }
+
+        // Таблица перевода: символ старой палитры -> символ новой палитры той же яркости.
+        // Символы вне старой палитры считаются нулевой яркостью
+        const auto old_brightness = char_to_brightness_;
+        palette_ = new_palette;
+        BuildLookupTables();
+
+        if (dither != Dither::None)
+        {
+            const Canvas& canvas = RawCanvas();
+            DitherRegion(WholeCanvas(), dither, [&](const int y, float* const row)
+            {
+                for (int x = 0; x < canvas.Width(); ++x)
+                {
+                    row[x] = static_cast<float>(old_brightness[CharCode(canvas(x, y))]);
+                }
+            });
+            return;
+        }
+
+        CharMap table{};
+        for (size_t code = 0; code < table.size(); ++code)
+        {
+            table[code] = BrightnessToChar(old_brightness[code]);
+        }
+        ApplyCharMap(table);
+    }
+}
+
+void GrayscalePlotter::BuildLookupTables()
+{
+    char_to_brightness_.fill(0.0);
+    in_palette_.fill(false);
+    char_to_index_.fill(-1);
+    // При повторе символа в палитре действует последнее вхождение
     for (size_t i = 0; i < palette_.size(); ++i)
     {
         const double brightness = static_cast<double>(i) / (palette_.size() - 1);
-        char_to_brightness[palette_[i]] = brightness;
+        char_to_brightness_[CharCode(palette_[i])] = brightness;
+        in_palette_[CharCode(palette_[i])] = true;
+        char_to_index_[CharCode(palette_[i])] = static_cast<int>(i);
+    }
+
+    for (size_t level = 0; level < level_to_char_.size(); ++level)
+    {
+        level_to_char_[level] = BrightnessToChar(static_cast<double>(level) / MAX_LEVEL);
+    }
+
+    // Уровень символа — наименьший уровень, который снова дает этот символ,
+    // чтобы символы без изменений переживали переход в слой яркости и обратно
+    for (size_t code = 0; code < char_to_level_.size(); ++code)
+    {
+        char_to_level_[code] = BrightnessToLevel(char_to_brightness_[code]);
+    }
+    for (int level = MAX_LEVEL; level >= 0; --level)
+    {
+        char_to_level_[CharCode(level_to_char_[level])] = static_cast<std::uint8_t>(level);
     }
-    return char_to_brightness;
 }
 
 } // namespace plotter
\ No newline at end of file
@@ -1,14 +1,27 @@
 #pragma once
+#include "BrightnessView.hpp"
+#include "Dithering.hpp"
+#include "FilterPipeline.hpp"
 #include "Plotter.hpp"
+#include "RankFilters.hpp"
+#include "Resampling.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 // Для тестирования BrightnessToChar
 void TestGrayscalePlotter();
+// Для тестирования LevelToChar
+void TestPointLookupTables();
+// Для сверки градиентов с попиксельной формулой
+void TestGradientRasterizers();
 
 namespace plotter
 {
+class PnmImage;
+
 struct BrightnessExtrema
 {
     double min_brightness;
@@ -17,6 +30,7 @@ struct BrightnessExtrema
 class GrayscalePlotter : public Plotter
 {
 public:
+    // Палитра не короче двух символов и без нулевого символа, иначе std::invalid_argument
     explicit GrayscalePlotter(std::unique_ptr<Canvas> canvas,
         const std::vector<char>& palette = DefaultPalette());
 
@@ -25,22 +39,47 @@ public:
 
     static std::vector<char> DefaultPalette();
 
-    void DrawLine(int x1, int y1, int x2, int y2, double brightness);
-    void DrawRectangle(int x1, int y1, int x2, int y2, double brightness, bool fill = false);
-    void DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, double brightness, bool fill = false);
-    void DrawCircle(int center_x, int center_y, int radius, double brightness, bool fill = false);
+    // dither задает квантование яркости в палитру для этого вызова, см. Dither. В режиме слоя яркости
+    // слой хранит точную яркость и dither не действует, символы с дизерингом дает Requantize
+    void DrawLine(int x1, int y1, int x2, int y2, double brightness, Dither dither = Dither::None);
+    void DrawRectangle(int x1, int y1, int x2, int y2, double brightness, bool fill = false,
+        Dither dither = Dither::None);
+    void DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, double brightness, bool fill = false,
+        Dither dither = Dither::None);
+    void DrawCircle(int center_x, int center_y, int radius, double brightness, bool fill = false,
+        Dither dither = Dither::None);
 
-    void FloodFill(int x, int y, double brightness);
-    void ScanlineFill(int x, int y, double brightness);
+    void FloodFill(int x, int y, double brightness, Dither dither = Dither::None);
+    void ScanlineFill(int x, int y, double brightness, Dither dither = Dither::None);
 
     void DrawLinearGradient(int x1, int y1, int x2, int y2,
-        double start_brightness, double end_brightness);
+        double start_brightness, double end_brightness, Dither dither = Dither::None);
     void DrawRadialGradient(int center_x, int center_y, int radius,
-        double center_brightness, double edge_brightness);
+        double center_brightness, double edge_brightness, Dither dither = Dither::None);
+
+    // Загружает PGM (P5) или PPM (P6) в канвас: изображение вписывается в канвас по центру
+    // с сохранением пропорций, где символ в cell_aspect раз выше своей ширины, и уменьшается
+    // усреднением по площади. Пиксели канваса вне изображения не меняются.
+    // Бросает std::runtime_error для нечитаемого файла, std::invalid_argument для cell_aspect <= 0
+    void LoadImage(const std::filesystem::path& path, double cell_aspect = 2.0, Dither dither = Dither::None);
+    // То же для уже открытого изображения
+    void LoadImage(const PnmImage& image, double cell_aspect = 2.0, Dither dither = Dither::None);
+
+    // Заново квантует яркость всего канваса в палитру с дизерингом. Нужен в режиме слоя яркости:
+    // символы с дизерингом действуют до следующего изменения слоя, Dither::None возвращает обычные.
+    // Символы канваса без слоя уже совпадают с палитрой и не меняются, символы вне палитры не трогаются
+    void Requantize(Dither dither);
 
-    [[nodiscard]] double CalculateAverageBrightness();
-    [[nodiscard]] BrightnessExtrema GetMinMaxBrightness();
+    // Со статистикой канваса (см. Plotter::EnableStatistics) считаются за O(256) по счетчикам символов,
+    // в режиме слоя яркости — по слою
+    [[nodiscard]] double CalculateAverageBrightness() const;
+    [[nodiscard]] BrightnessExtrema GetMinMaxBrightness() const;
     [[nodiscard]] std::vector<std::vector<double>> GetBrightnessMatrix() const;
+    // Яркость канваса без копирования, см. BrightnessView
+    [[nodiscard]] BrightnessView GetBrightnessView() const;
+    // Копирует яркость в буфер вызывающего полосами строк, dst_stride — шаг строки в элементах
+    void ExportBrightness(float* dst, size_t dst_stride) const;
+    void ExportBrightness(std::uint8_t* dst, size_t dst_stride) const;
 
     void AdjustBrightness(double factor);
     void ApplyThreshold(double threshold);
@@ -49,25 +88,197 @@ public:
     void ApplyBoxBlur(int kernel_size = 3);
     void ApplyGaussianBlur(int kernel_size = 3);
 
-    void SetPalette(const std::vector<char>& new_palette);
+    // Контуры по оператору Собеля: пиксели, где модуль градиента / 4 больше threshold,
+    // получают символ направления границы '-', '|', '/' или '\', остальные — первый символ палитры.
+    // Перепад яркости от 0 до 1 дает модуль 1
+    void DetectEdges(double threshold = 0.25);
+
+    // Выравнивание гистограммы: индексы палитры (уровни слоя) перераспределяются по накопленной частоте.
+    // Символы вне палитры не учитываются и не меняются. Прямоугольник обрезается краями канваса
+    void EqualizeHistogram();
+    void EqualizeHistogram(int x1, int y1, int x2, int y2);
+    // Растяжение контраста: по clip_percent процентов самых темных и самых светлых пикселей
+    // уходят в края палитры, остальные растягиваются линейно. clip_percent из [0, 50)
+    void AutoContrast(double clip_percent = 0.0);
+    void AutoContrast(double clip_percent, int x1, int y1, int x2, int y2);
+    // Адаптивное выравнивание по плиткам tile_size x tile_size (CLAHE): частота значения в плитке
+    // ограничена clip_limit средних частот (0 — без ограничения), таблицы соседних плиток
+    // интерполируются билинейно. Символы вне палитры, как и в EqualizeHistogram, не учитываются и не меняются
+    void EqualizeHistogramLocal(int tile_size = 16, double clip_limit = 2.0);
+
+    // Медианный фильтр окном (2 * radius + 1)^2 над индексами палитры (в режиме слоя — над уровнями).
+    // Убирает одиночные выбросы и сохраняет границы. Символы вне палитры считаются нулевой яркостью
+    void ApplyMedianFilter(int radius = 1);
+    // Морфология квадратом (2 * radius + 1)^2: эрозия берет минимум яркости окна, дилатация — максимум,
+    // размыкание — эрозия и затем дилатация, замыкание — наоборот
+    void ApplyErosion(int radius = 1);
+    void ApplyDilation(int radius = 1);
+    void ApplyOpening(int radius = 1);
+    void ApplyClosing(int radius = 1);
+
+    // Канвас другого размера: Nearest копирует символы как Plotter::Resize, Area и Bilinear пересчитывают
+    // яркость (из слоя, если он включен) и квантуют ее в палитру. Проходы по строкам и по столбцам
+    // идут по таблицам весов полосами строк. Цвета ячеек переносит только Nearest, у Area и Bilinear
+    // слой цветов target остается как был
+    [[nodiscard]] std::unique_ptr<Canvas> Resize(int width, int height, ResampleFilter filter = ResampleFilter::Area) const;
+    // То же в готовый канвас target, например из пула: размер результата — размер target
+    void ResizeInto(Canvas& target, ResampleFilter filter = ResampleFilter::Area) const;
+
+    // Перенос source преобразованием transform, как Plotter::TransformRegion. Bilinear интерполирует
+    // яркость четырех ближайших пикселей source (символы переводятся в яркость палитрой плоттера,
+    // символы вне палитры — нулевая яркость, у краев повторяется крайний пиксель) и квантует ее в палитру
+    // или пишет в слой яркости, цвета ячеек при этом не переносятся. Nearest переносит символы и цвета
+    // как Plotter::TransformRegion, Area не поддерживается
+    void TransformRegion(const Canvas& source, const AffineTransform& transform,
+        ResampleFilter filter = ResampleFilter::Bilinear);
+
+    // Отложенная цепочка фильтров, см. FilterPipeline
+    [[nodiscard]] FilterPipeline Pipeline() { return FilterPipeline(*this); }
+
+    // Числовой слой яркости (8 бит на пиксель) рядом с символами канваса.
+    // Пока слой включен, фильтры, градиенты и SetPalette работают с ним без квантования в палитру,
+    // а символы канваса пересчитываются лениво: при чтении канваса, Render и SaveToFile. Пересчет
+    // из константных методов идет под своей блокировкой, поэтому их можно вызывать из нескольких потоков
+    // (кроме пересчета устаревшей статистики канваса, см. Canvas::Statistics).
+    // Неконстантный GetCanvas считается записью: после него слой сверяется с символами, и пиксели,
+    // символ которых не изменился, сохраняют свою яркость. Для чтения — std::as_const(plotter).GetCanvas().
+    // Символы вне палитры при включении слоя считаются нулевой яркостью
+    void EnableBrightnessPlane();
+    void DisableBrightnessPlane();
+    [[nodiscard]] bool HasBrightnessPlane() const noexcept { return !plane_.empty(); }
+
+    // Без слоя яркости символы старой палитры переводятся в новую по своей яркости с дизерингом dither
+    void SetPalette(const std::vector<char>& new_palette, Dither dither = Dither::None);
     [[nodiscard]] const std::vector<char>& GetPalette() const noexcept { return palette_; }
     [[nodiscard]] size_t GetPaletteSize() const noexcept { return palette_.size(); }
 
+protected:
+    void BeforeCanvasWrite() override;
+    [[nodiscard]] bool CanvasIsStale() const noexcept override;
+    void SyncCanvas(Canvas& canvas) const override;
+
 private:
     // Для тестирования BrightnessToChar
     friend void ::TestGrayscalePlotter();
+    friend void ::TestPointLookupTables();
+    friend void ::TestGradientRasterizers();
+    friend class FilterPipeline;
     std::vector<char> palette_;
-    // Этот словарь часто используется, поэтому решил добавить поле и заполнить его в конструкторе и методе SetPalette
-    std::unordered_map<char, double> char_to_brightness_;
+    // Таблицы часто используются, поэтому заполняются в конструкторе и методе SetPalette.
+    // Яркость символа по его коду, для символов вне палитры 0.0
+    std::array<double, 256> char_to_brightness_{};
+    // Принадлежит ли символ палитре
+    std::array<bool, 256> in_palette_{};
+    // Символ для 8-битной яркости level / 255
+    std::array<char, 256> level_to_char_{};
+
+    // Индекс символа в палитре, при повторе символа — последнее вхождение. -1 для символов вне палитры
+    std::array<int, 256> char_to_index_{};
+
+    // Уровень, который при обратном переходе снова дает символ
+    std::array<std::uint8_t, 256> char_to_level_{};
+
+    // Слой яркости, пустой — слой выключен
+    std::vector<std::uint8_t> plane_;
+    // Символы канваса отстают от слоя. Сбрасывается из константного SyncCanvas
+    mutable std::atomic<bool> chars_stale_ = false;
+    // Слой отстает от символов: их изменили в обход слоя
+    bool plane_stale_ = false;
+    // Идет рисование примитива маркером, см. Paint
+    bool drawing_to_plane_ = false;
+
+    using LevelMap = std::array<std::uint8_t, 256>;
+
+    // Прямоугольник, в котором примитив может изменить пиксели
+    struct PaintBounds
+    {
+        int x1;
+        int y1;
+        int x2;
+        int y2;
+    };
+
+    // Квантование яркости: индекс floor(brightness * scale + bias), яркость вне (0, 1) и NaN дают крайние индексы
+    struct Quantizer
+    {
+        double scale;
+        double bias;
+        int max_index;
+
+        int operator()(const double brightness) const noexcept
+        {
+            if (!(brightness > 0.0))
+            {
+                return 0;
+            }
+            if (brightness >= 1.0)
+            {
+                return max_index;
+            }
+            return static_cast<int>(brightness * scale + bias);
+        }
+    };
+    // Индекс в palette_
+    [[nodiscard]] Quantizer PaletteQuantizer() const noexcept;
+    // Уровень слоя яркости
+    [[nodiscard]] static Quantizer LevelQuantizer() noexcept;
+
     char BrightnessToChar(double brightness) const;
+    char LevelToChar(std::uint8_t level) const noexcept { return level_to_char_[level]; }
+    static std::uint8_t BrightnessToLevel(double brightness) noexcept;
 
     double GetPixelBrightness(int x, int y) const;
-    void SetPixelBrightness(int x, int y, double brightness);
-    std::vector<std::vector<double>> Convolve(const std::vector<std::vector<double>>& kernel) const;
+    // Записывает яркости строки y в row, из слоя или из символов
+    void LoadBrightnessRow(int y, double* row) const;
+    // Сворачивает канвас с ядром, store_row(y, sums) получает готовую строку результата
+    void Convolve(const std::vector<std::vector<double>>& kernel,
+        const std::function<void(int, const double*)>& store_row) const;
+    void ApplyKernel(const std::vector<std::vector<double>>& kernel);
     static std::vector<std::vector<double>> CreateGaussianKernel(int size, double sigma = 1.0);
     static std::vector<std::vector<double>> CreateBoxKernel(int size);
-    // Создает словарь char_to_brightness, используя символы из palette_
-    std::unordered_map<char, double> CreateCharToBrightness();
+    // Применяет filter(values, bins) к значениям канваса: индексам палитры или уровням слоя.
+    // Если palette_mask не nullptr, до вызова filter в нем отмечаются пиксели символов палитры,
+    // а символы вне палитры не меняются. В слое яркости значения есть у всех пикселей, и маска пуста
+    void ApplyRankFilter(const std::function<void(std::vector<std::uint8_t>&, int)>& filter,
+        std::vector<bool>* palette_mask = nullptr);
+    // Эрозия или дилатация values: проход по строкам, затем по столбцам
+    void ApplyExtremumFilter(std::vector<std::uint8_t>& values, int radius, Extremum extremum) const;
+    // Гистограмма индексов палитры или уровней слоя в прямоугольнике, символы вне палитры не считаются
+    std::vector<size_t> ValueHistogram(const PaintBounds& region);
+    // Заменяет индекс палитры или уровень слоя value на table[value] в прямоугольнике
+    void ApplyValueMap(const std::vector<int>& table, const PaintBounds& region);
+    // Прямоугольник, обрезанный краями канваса. Может оказаться пустым: x1 > x2 или y1 > y2
+    [[nodiscard]] PaintBounds ClipToCanvas(int x1, int y1, int x2, int y2) const noexcept;
+    // Заполняет таблицы char_to_brightness_, in_palette_, char_to_index_, level_to_char_ и char_to_level_ по palette_
+    void BuildLookupTables();
+    // Таблица замены символов палитры на BrightnessToChar(transform(яркость)).
+    // Символы вне палитры остаются без изменений
+    CharMap MakePointMap(const std::function<double(double)>& transform) const;
+    // Применяет таблицу замены ко всему канвасу, полосами строк
+    void ApplyCharMap(const CharMap& table);
+    // Переписывает все символы canvas полосами строк: write(begin, end, symbols) задает symbols[i]
+    // для i из [begin, end). Замены полос переносятся в статистику канваса
+    void RewriteSymbols(Canvas& canvas, const std::function<void(size_t, size_t, char*)>& write) const;
+    // Аналоги для слоя яркости
+    LevelMap MakeLevelMap(const std::function<double(double)>& transform) const;
+    void ApplyLevelMap(const LevelMap& table);
+    // Поточечное преобразование яркости в слое или в символах
+    void ApplyPointTransform(const std::function<double(double)>& transform);
+
+    // Пересобирает слой из символов, если они менялись в обход слоя. Пиксель, символ которого
+    // совпадает с символом его уровня, сохраняет уровень
+    void SyncPlane();
+    // Вызывается перед прямой записью в слой яркости или в символы канваса
+    void PrepareBrightnessWrite();
+    [[nodiscard]] bool PlaneIsCurrent() const noexcept;
+    [[nodiscard]] PaintBounds WholeCanvas() const noexcept;
+    // Рисует примитив draw(brush) яркостью brightness: символом палитры или в слой яркости
+    void Paint(const PaintBounds& bounds, double brightness, const std::function<void(char)>& draw,
+        Dither dither = Dither::None);
+    // Квантует яркость прямоугольника в символы палитры с дизерингом полосами строк.
+    // load_row(y, row) заполняет яркость пикселей [region.x1, region.x2] строки y, NaN — пиксель не меняется.
+    // Прямоугольник должен лежать в канвасе, слой яркости не меняется
+    void DitherRegion(const PaintBounds& region, Dither dither, const std::function<void(int, float*)>& load_row);
 };
 
 } // namespace plotter
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "ImageLoader.hpp"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace
+{
+    // Веса Rec. 601 для яркости по RGB
+    constexpr std::array<float, 3> LUMA_WEIGHTS = { 0.299f, 0.587f, 0.114f };
+    constexpr int MAX_SAMPLE = 65535;
+} // anonymous namespace
+
+namespace plotter
+{
+
+PnmImage::PnmImage(const std::filesystem::path& path) : file_(path)
+{
+    ParseHeader(path);
+    file_.AdviseSequential();
+
+    const std::array<float, 3> gray = { 1.0f, 0.0f, 0.0f };
+    const auto& weights = channels_ == 1 ? gray : LUMA_WEIGHTS;
+    for (int channel = 0; channel < channels_; ++channel)
+    {
+        for (int value = 0; value < 256; ++value)
+        {
+            luminance_[channel][value] = weights[channel] * static_cast<float>(value) / static_cast<float>(max_value_);
+        }
+    }
+}
+
+void PnmImage::ParseHeader(const std::filesystem::path& path)
+{
+    const std::string_view text = file_.View();
+    size_t pos = 0;
+
+    const auto fail = [&path](const std::string& reason)
+    {
+        throw std::runtime_error("Failed to read image '" + path.string() + "': " + reason);
+    };
+
+    if (text.size() < 2 || text[0] != 'P' || (text[1] != '5' && text[1] != '6'))
+    {
+        fail("expected binary PGM (P5) or PPM (P6)");
+    }
+    channels_ = text[1] == '5' ? 1 : 3;
+    pos = 2;
+
+    // Числа заголовка разделены пробельными символами, от '#' до конца строки — комментарий
+    const auto read_number = [&]()
+    {
+        while (pos < text.size())
+        {
+            if (text[pos] == '#')
+            {
+                while (pos < text.size() && text[pos] != '\n')
+                {
+                    ++pos;
+                }
+            }
+            else if (std::isspace(static_cast<unsigned char>(text[pos])))
+            {
+                ++pos;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        long value = 0;
+        const size_t start = pos;
+        while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) && value <= MAX_SAMPLE * 1024L)
+        {
+            value = value * 10 + (text[pos] - '0');
+            ++pos;
+        }
+        if (pos == start)
+        {
+            fail("malformed header");
+        }
+        return value;
+    };
+
+    const long width = read_number();
+    const long height = read_number();
+    const long max_value = read_number();
+    if (width < 1 || height < 1 || width > MAX_SAMPLE * 1024L || height > MAX_SAMPLE * 1024L)
+    {
+        fail("invalid size");
+    }
+    if (max_value < 1 || max_value > MAX_SAMPLE)
+    {
+        fail("invalid maximum value");
+    }
+    // Растр начинается после ровно одного пробельного символа
+    if (pos >= text.size() || !std::isspace(static_cast<unsigned char>(text[pos])))
+    {
+        fail("malformed header");
+    }
+    ++pos;
+
+    width_ = static_cast<int>(width);
+    height_ = static_cast<int>(height);
+    max_value_ = static_cast<int>(max_value);
+    row_size_ = static_cast<size_t>(width_) * channels_ * (max_value_ > 255 ? 2 : 1);
+    if (file_.Size() - pos < RasterSize())
+    {
+        fail("image data is truncated");
+    }
+    raster_ = file_.Data() + pos;
+}
+
+void PnmImage::LoadLuminanceRow(const int y, float* const row) const
+{
+    const unsigned char* const samples = raster_ + row_size_ * y;
+
+    if (max_value_ > 255)
+    {
+        const auto sample = [samples](const size_t index)
+        {
+            return static_cast<float>(samples[2 * index] << 8 | samples[2 * index + 1]);
+        };
+        const float scale = 1.0f / static_cast<float>(max_value_);
+        for (int x = 0; x < width_; ++x)
+        {
+            float value = 0.0f;
+            for (int channel = 0; channel < channels_; ++channel)
+            {
+                const float weight = channels_ == 1 ? 1.0f : LUMA_WEIGHTS[channel];
+                value += weight * sample(static_cast<size_t>(x) * channels_ + channel);
+            }
+            row[x] = value * scale;
+        }
+        return;
+    }
+
+    if (channels_ == 1)
+    {
+        const auto& table = luminance_[0];
+        for (int x = 0; x < width_; ++x)
+        {
+            row[x] = table[samples[x]];
+        }
+        return;
+    }
+
+    const auto& red = luminance_[0];
+    const auto& green = luminance_[1];
+    const auto& blue = luminance_[2];
+    for (int x = 0; x < width_; ++x)
+    {
+        const unsigned char* const pixel = samples + 3 * static_cast<size_t>(x);
+        row[x] = red[pixel[0]] + green[pixel[1]] + blue[pixel[2]];
+    }
+}
+
+void PnmImage::ReleaseRows(const int first_row, const int last_row) const noexcept
+{
+    if (first_row < last_row)
+    {
+        const size_t offset = static_cast<size_t>(raster_ - file_.Data()) + row_size_ * first_row;
+        file_.Release(offset, row_size_ * (last_row - first_row));
+    }
+}
+
+AreaDownscaler::AreaDownscaler(const PnmImage& image, const int width, const int height)
+    : image_(image)
+    , width_(width)
+    , height_(height)
+{
+    if (width < 1 || height < 1)
+    {
+        throw std::invalid_argument("Width and height can't be less than 1");
+    }
+
+    columns_ = AreaWeights(image.Width(), width);
+    rows_ = AreaWeights(image.Height(), height);
+}
+
+void AreaDownscaler::ProcessRows(const int row_begin, const int row_end,
+    const std::function<void(int, const double*)>& store) const
+{
+    if (row_begin >= row_end)
+    {
+        return;
+    }
+
+    std::vector<float> luminance(image_.Width());
+    std::vector<double> reduced(width_);
+    std::vector<double> accumulated(width_);
+
+    // Первая строка изображения полосы может понадобиться и полосе выше, ее не отдаем
+    int released_until = rows_.sources[rows_.first[row_begin]] + 1;
+
+    for (int y = row_begin; y < row_end; ++y)
+    {
+        std::fill(accumulated.begin(), accumulated.end(), 0.0);
+
+        for (int entry = rows_.first[y]; entry < rows_.first[y + 1]; ++entry)
+        {
+            image_.LoadLuminanceRow(rows_.sources[entry], luminance.data());
+
+            // Сначала строка сжимается по горизонтали, затем добавляется со своим весом
+            for (int x = 0; x < width_; ++x)
+            {
+                double sum = 0.0;
+                for (int column = columns_.first[x]; column < columns_.first[x + 1]; ++column)
+                {
+                    sum += columns_.weights[column] * luminance[columns_.sources[column]];
+                }
+                reduced[x] = sum;
+            }
+
+            const double weight = rows_.weights[entry];
+            for (int x = 0; x < width_; ++x)
+            {
+                accumulated[x] += weight * reduced[x];
+            }
+        }
+
+        store(y, accumulated.data());
+
+        if (y + 1 < row_end)
+        {
+            const int next_first = rows_.sources[rows_.first[y + 1]];
+            image_.ReleaseRows(released_until, next_first);
+            released_until = std::max(released_until, next_first);
+        }
+    }
+}
+
+} // namespace plotter
@@ -0,0 +1,71 @@
+#pragma once
+#include "MappedFile.hpp"
+#include "Resampling.hpp"
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace plotter
+{
+
+// Двоичное изображение PGM (P5) или PPM (P6), отображенное в память.
+// Поддерживаются 8- и 16-битные отсчеты (maxval до 65535, 16 бит — старший байт первым)
+class PnmImage
+{
+public:
+    // Бросает std::runtime_error для нечитаемого файла, неизвестного формата или обрезанных данных
+    explicit PnmImage(const std::filesystem::path& path);
+
+    [[nodiscard]] int Width() const noexcept { return width_; }
+    [[nodiscard]] int Height() const noexcept { return height_; }
+    // 1 для PGM, 3 для PPM
+    [[nodiscard]] int Channels() const noexcept { return channels_; }
+    [[nodiscard]] int MaxValue() const noexcept { return max_value_; }
+    // Размер растра в байтах, без заголовка
+    [[nodiscard]] size_t RasterSize() const noexcept { return row_size_ * height_; }
+
+    // Яркость строки y в [0, 1]: для PPM — яркость по весам Rec. 601
+    void LoadLuminanceRow(int y, float* row) const;
+    // Загружает страницы файла в память заранее, например в отдельном потоке чтения
+    void Prefault() const noexcept { file_.Prefault(); }
+    // Страницы строк [first_row, last_row) больше не нужны
+    void ReleaseRows(int first_row, int last_row) const noexcept;
+
+private:
+    MappedFile file_;
+    const unsigned char* raster_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    int channels_ = 1;
+    int max_value_ = 0;
+    size_t row_size_ = 0;
+    // Вклад 8-битного отсчета канала в яркость, для 16 бит считается на месте
+    std::array<std::array<float, 256>, 3> luminance_{};
+
+    void ParseHeader(const std::filesystem::path& path);
+};
+
+// Уменьшение (или увеличение) изображения в сетку width x height усреднением по площади:
+// каждая клетка получает среднюю яркость покрытого ей прямоугольника изображения с учетом
+// частично покрытых пикселей, см. AreaWeights. Таблицы весов строятся один раз, строки результата
+// независимы и могут обрабатываться параллельно
+class AreaDownscaler
+{
+public:
+    AreaDownscaler(const PnmImage& image, int width, int height);
+
+    // Вычисляет строки результата [row_begin, row_end) по порядку и передает каждую в store(y, row).
+    // Память — несколько строк изображения и результата. Прочитанные строки изображения,
+    // которые больше не понадобятся, отдаются системе, поэтому и огромные файлы не занимают память целиком
+    void ProcessRows(int row_begin, int row_end, const std::function<void(int, const double*)>& store) const;
+
+private:
+    const PnmImage& image_;
+    int width_;
+    int height_;
+    ResampleWeights columns_;
+    ResampleWeights rows_;
+};
+
+} // namespace plotter
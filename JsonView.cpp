@@ -0,0 +1,709 @@
+#include "JsonView.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Глубже рекурсивный разбор рискует переполнить стек
+    constexpr int MAX_DEPTH = 512;
+    // Встроенный буфер арены ValueReader: его хватает на типичное значение потока без выделений
+    constexpr size_t READER_ARENA_BYTES = 16 * 1024;
+    // Начальный блок арены на байт текста, дальше арена растет сама
+    constexpr size_t ARENA_BYTES_PER_CHAR = 1;
+    constexpr size_t MIN_ARENA_BYTES = 1024;
+
+    bool IsDigit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    int HexValue(const char c)
+    {
+        if (IsDigit(c))
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    char* AppendUtf8(char* out, const std::uint32_t code_point)
+    {
+        if (code_point < 0x80)
+        {
+            *out++ = static_cast<char>(code_point);
+        }
+        else if (code_point < 0x800)
+        {
+            *out++ = static_cast<char>(0xC0 | code_point >> 6);
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else if (code_point < 0x10000)
+        {
+            *out++ = static_cast<char>(0xE0 | code_point >> 12);
+            *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xF0 | code_point >> 18);
+            *out++ = static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        return out;
+    }
+} // anonymous namespace
+
+namespace json
+{
+
+bool ValueView::AsBool() const
+{
+    if (!IsBool())
+    {
+        throw std::logic_error("Not a bool");
+    }
+    return boolean_;
+}
+
+int ValueView::AsInt() const
+{
+    if (!IsInt())
+    {
+        throw std::logic_error("Not an int");
+    }
+    return integer_;
+}
+
+double ValueView::AsDouble() const
+{
+    if (!IsDouble())
+    {
+        throw std::logic_error("Not a double");
+    }
+    return IsInt() ? integer_ : number_;
+}
+
+std::string_view ValueView::AsString() const
+{
+    if (!IsString())
+    {
+        throw std::logic_error("Not a string");
+    }
+    return { chars_, size_ };
+}
+
+std::span<const ValueView> ValueView::AsArray() const
+{
+    if (!IsArray())
+    {
+        throw std::logic_error("Not an array");
+    }
+    return { items_, size_ };
+}
+
+std::span<const Member> ValueView::AsDict() const
+{
+    if (!IsDict())
+    {
+        throw std::logic_error("Not a dict");
+    }
+    return { members_, size_ };
+}
+
+const ValueView* ValueView::Find(const std::string_view key) const
+{
+    const std::span<const Member> members = AsDict();
+    const auto it = std::lower_bound(members.begin(), members.end(), key,
+        [](const Member& member, const std::string_view value) { return member.key < value; });
+    return it != members.end() && it->key == key ? &it->value : nullptr;
+}
+
+// Рекурсивный спуск по тексту. Дочерние значения собираются в переиспользуемых стеках
+// и копируются в арену одним блоком, когда массив или объект закрыт
+class ViewParser
+{
+public:
+    ViewParser(const std::string_view text, std::pmr::memory_resource& arena)
+        : begin_(text.data())
+        , pos_(text.data())
+        , end_(text.data() + text.size())
+        , arena_(arena)
+    {
+    }
+
+    ValueView ParseDocument()
+    {
+        SkipWhitespace();
+        if (pos_ == end_)
+        {
+            Fail("Unexpected end of input");
+        }
+        const ValueView root = ParseValue(0);
+        SkipWhitespace();
+        if (pos_ != end_)
+        {
+            Fail("Unexpected characters after the document");
+        }
+        return root;
+    }
+
+    // Следующее значение потока, перед ним допустимы пробелы
+    ValueView ParseNext()
+    {
+        SkipWhitespace();
+        if (pos_ == end_)
+        {
+            Fail("Unexpected end of input");
+        }
+        return ParseValue(0);
+    }
+
+    std::string_view ParseKey()
+    {
+        SkipWhitespace();
+        if (pos_ == end_ || *pos_ != '"')
+        {
+            Fail("Expected string key");
+        }
+        const std::string_view key = ParseString();
+        SkipWhitespace();
+        Expect(':');
+        return key;
+    }
+
+    bool TryConsume(const char c)
+    {
+        SkipWhitespace();
+        if (pos_ != end_ && *pos_ == c)
+        {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool AtEnd() noexcept
+    {
+        SkipWhitespace();
+        return pos_ == end_;
+    }
+
+    [[nodiscard]] size_t Offset() const noexcept { return static_cast<size_t>(pos_ - begin_); }
+
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        // Позиция считается только при ошибке, чтобы не замедлять разбор
+        int line = 1;
+        const char* line_begin = begin_;
+        for (const char* it = begin_; it < pos_; ++it)
+        {
+            if (*it == '\n')
+            {
+                ++line;
+                line_begin = it + 1;
+            }
+        }
+        throw ParsingError(message + " at line " + std::to_string(line) + ", column "
+            + std::to_string(pos_ - line_begin + 1));
+    }
+
+    void SkipWhitespace() noexcept
+    {
+        while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t'))
+        {
+            ++pos_;
+        }
+    }
+
+    void Expect(const char c)
+    {
+        if (pos_ == end_ || *pos_ != c)
+        {
+            Fail(pos_ == end_ ? "Unexpected end of input" : std::string("Expected '") + c + "'");
+        }
+        ++pos_;
+    }
+
+private:
+    const char* const begin_;
+    const char* pos_;
+    const char* const end_;
+    std::pmr::memory_resource& arena_;
+    std::vector<ValueView> items_;
+    std::vector<Member> members_;
+
+    template <typename T>
+    T* Allocate(const size_t count)
+    {
+        return static_cast<T*>(arena_.allocate(count * sizeof(T), alignof(T)));
+    }
+
+    std::uint32_t CheckedSize(const size_t size) const
+    {
+        if (size > std::numeric_limits<std::uint32_t>::max())
+        {
+            Fail("Value is too large");
+        }
+        return static_cast<std::uint32_t>(size);
+    }
+
+    ValueView ParseValue(const int depth)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            Fail("Nesting is too deep");
+        }
+
+        ValueView result;
+        switch (*pos_)
+        {
+        case '{':
+            return ParseDict(depth);
+        case '[':
+            return ParseArray(depth);
+        case '"':
+        {
+            const std::string_view text = ParseString();
+            result.type_ = ValueView::Type::String;
+            result.chars_ = text.data();
+            result.size_ = CheckedSize(text.size());
+            return result;
+        }
+        case 't':
+            ParseLiteral("true");
+            result.type_ = ValueView::Type::Bool;
+            result.boolean_ = true;
+            return result;
+        case 'f':
+            ParseLiteral("false");
+            result.type_ = ValueView::Type::Bool;
+            result.boolean_ = false;
+            return result;
+        case 'n':
+            ParseLiteral("null");
+            return result;
+        default:
+            if (*pos_ == '-' || IsDigit(*pos_))
+            {
+                return ParseNumber();
+            }
+            Fail(std::string("Unexpected character '") + *pos_ + "'");
+        }
+    }
+
+    void ParseLiteral(const std::string_view literal)
+    {
+        if (static_cast<size_t>(end_ - pos_) < literal.size() || std::string_view(pos_, literal.size()) != literal)
+        {
+            Fail("Invalid literal");
+        }
+        pos_ += literal.size();
+    }
+
+    ValueView ParseNumber()
+    {
+        const char* const start = pos_;
+        bool is_int = true;
+        if (*pos_ == '-')
+        {
+            ++pos_;
+        }
+        if (pos_ == end_ || !IsDigit(*pos_))
+        {
+            Fail("Invalid number");
+        }
+        // Ведущий ноль не может быть продолжен цифрами
+        if (*pos_ == '0')
+        {
+            ++pos_;
+        }
+        else
+        {
+            while (pos_ != end_ && IsDigit(*pos_))
+            {
+                ++pos_;
+            }
+        }
+        if (pos_ != end_ && *pos_ == '.')
+        {
+            is_int = false;
+            ++pos_;
+            if (pos_ == end_ || !IsDigit(*pos_))
+            {
+                Fail("Invalid number");
+            }
+            while (pos_ != end_ && IsDigit(*pos_))
+            {
+                ++pos_;
+            }
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E'))
+        {
+            is_int = false;
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-'))
+            {
+                ++pos_;
+            }
+            if (pos_ == end_ || !IsDigit(*pos_))
+            {
+                Fail("Invalid number");
+            }
+            while (pos_ != end_ && IsDigit(*pos_))
+            {
+                ++pos_;
+            }
+        }
+
+        ValueView result;
+        if (is_int)
+        {
+            int value = 0;
+            if (std::from_chars(start, pos_, value).ec == std::errc{})
+            {
+                result.type_ = ValueView::Type::Int;
+                result.integer_ = value;
+                return result;
+            }
+            // Целое вне диапазона int становится double, как в json::Load
+        }
+        double value = 0.0;
+        const auto [end, error] = std::from_chars(start, pos_, value);
+        if (error == std::errc::result_out_of_range)
+        {
+            // from_chars не меняет value, и 1e400 стало бы нулем; json::Load тоже отвергает такие числа
+            Fail("Number is out of range");
+        }
+        if (error != std::errc{})
+        {
+            Fail("Invalid number");
+        }
+        result.type_ = ValueView::Type::Double;
+        result.number_ = value;
+        return result;
+    }
+
+    // Строка без escape-последовательностей — вид в текст, иначе раскодированная копия в арене
+    std::string_view ParseString()
+    {
+        ++pos_;
+        const char* const start = pos_;
+        while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\')
+        {
+            if (static_cast<unsigned char>(*pos_) < 0x20)
+            {
+                Fail("Control character in string");
+            }
+            ++pos_;
+        }
+        if (pos_ == end_)
+        {
+            Fail("String parsing error");
+        }
+        if (*pos_ == '"')
+        {
+            return { start, static_cast<size_t>(pos_++ - start) };
+        }
+
+        // Раскодированная строка не длиннее исходной: \uXXXX дает не больше 3 байт, пара — 4 байта из 12
+        const char* const string_end = FindStringEnd();
+        char* const decoded = Allocate<char>(static_cast<size_t>(string_end - start));
+        char* out = std::copy(start, pos_, decoded);
+        while (*pos_ != '"')
+        {
+            if (*pos_ != '\\')
+            {
+                if (static_cast<unsigned char>(*pos_) < 0x20)
+                {
+                    Fail("Control character in string");
+                }
+                *out++ = *pos_++;
+                continue;
+            }
+
+            ++pos_;
+            switch (*pos_++)
+            {
+            case '"':
+                *out++ = '"';
+                break;
+            case '\\':
+                *out++ = '\\';
+                break;
+            case '/':
+                *out++ = '/';
+                break;
+            case 'b':
+                *out++ = '\b';
+                break;
+            case 'f':
+                *out++ = '\f';
+                break;
+            case 'n':
+                *out++ = '\n';
+                break;
+            case 'r':
+                *out++ = '\r';
+                break;
+            case 't':
+                *out++ = '\t';
+                break;
+            case 'u':
+                out = AppendUtf8(out, ParseCodePoint());
+                break;
+            default:
+                --pos_;
+                Fail("Unrecognized escape sequence");
+            }
+        }
+        ++pos_;
+        return { decoded, static_cast<size_t>(out - decoded) };
+    }
+
+    // Закрывающая кавычка строки, начиная с текущего escape. Позиция не сдвигается
+    const char* FindStringEnd() const
+    {
+        const char* it = pos_;
+        while (it != end_ && *it != '"')
+        {
+            it += *it == '\\' && it + 1 != end_ ? 2 : 1;
+        }
+        if (it == end_)
+        {
+            Fail("String parsing error");
+        }
+        return it;
+    }
+
+    std::uint32_t ParseHex4()
+    {
+        if (end_ - pos_ < 4)
+        {
+            Fail("Invalid unicode escape");
+        }
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const int digit = HexValue(*pos_);
+            if (digit < 0)
+            {
+                Fail("Invalid unicode escape");
+            }
+            value = value << 4 | static_cast<std::uint32_t>(digit);
+            ++pos_;
+        }
+        return value;
+    }
+
+    std::uint32_t ParseCodePoint()
+    {
+        const std::uint32_t high = ParseHex4();
+        if (high >= 0xDC00 && high <= 0xDFFF)
+        {
+            Fail("Unpaired surrogate");
+        }
+        if (high < 0xD800 || high > 0xDBFF)
+        {
+            return high;
+        }
+        if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u')
+        {
+            Fail("Unpaired surrogate");
+        }
+        pos_ += 2;
+        const std::uint32_t low = ParseHex4();
+        if (low < 0xDC00 || low > 0xDFFF)
+        {
+            Fail("Unpaired surrogate");
+        }
+        return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    ValueView ParseArray(const int depth)
+    {
+        ++pos_;
+        const size_t base = items_.size();
+        SkipWhitespace();
+        if (pos_ != end_ && *pos_ == ']')
+        {
+            ++pos_;
+        }
+        else
+        {
+            while (true)
+            {
+                SkipWhitespace();
+                if (pos_ == end_)
+                {
+                    Fail("Array parsing error");
+                }
+                // Ссылка в items_ может стать недействительной во время разбора вложенных значений
+                const ValueView item = ParseValue(depth + 1);
+                items_.push_back(item);
+                SkipWhitespace();
+                if (pos_ != end_ && *pos_ == ',')
+                {
+                    ++pos_;
+                    continue;
+                }
+                Expect(']');
+                break;
+            }
+        }
+
+        ValueView result;
+        result.type_ = ValueView::Type::Array;
+        result.size_ = CheckedSize(items_.size() - base);
+        ValueView* const items = Allocate<ValueView>(result.size_);
+        std::copy(items_.begin() + static_cast<std::ptrdiff_t>(base), items_.end(), items);
+        items_.resize(base);
+        result.items_ = items;
+        return result;
+    }
+
+    ValueView ParseDict(const int depth)
+    {
+        ++pos_;
+        const size_t base = members_.size();
+        SkipWhitespace();
+        if (pos_ != end_ && *pos_ == '}')
+        {
+            ++pos_;
+        }
+        else
+        {
+            while (true)
+            {
+                SkipWhitespace();
+                if (pos_ == end_ || *pos_ != '"')
+                {
+                    Fail("Expected string key");
+                }
+                const std::string_view key = ParseString();
+                SkipWhitespace();
+                Expect(':');
+                SkipWhitespace();
+                if (pos_ == end_)
+                {
+                    Fail("Dict parsing error");
+                }
+                const ValueView value = ParseValue(depth + 1);
+                members_.push_back({ key, value });
+                SkipWhitespace();
+                if (pos_ != end_ && *pos_ == ',')
+                {
+                    ++pos_;
+                    continue;
+                }
+                Expect('}');
+                break;
+            }
+        }
+
+        ValueView result;
+        result.type_ = ValueView::Type::Dict;
+        result.size_ = CheckedSize(members_.size() - base);
+        Member* const members = Allocate<Member>(result.size_);
+        std::copy(members_.begin() + static_cast<std::ptrdiff_t>(base), members_.end(), members);
+        members_.resize(base);
+
+        // Отсортированные ключи дают двоичный поиск в Find, а повторы оказываются рядом
+        std::sort(members, members + result.size_,
+            [](const Member& lhs, const Member& rhs) { return lhs.key < rhs.key; });
+        const Member* const duplicate = std::adjacent_find(members, members + result.size_,
+            [](const Member& lhs, const Member& rhs) { return lhs.key == rhs.key; });
+        if (duplicate != members + result.size_)
+        {
+            --pos_;
+            Fail("Duplicate key '" + std::string(duplicate->key) + "'");
+        }
+        result.members_ = members;
+        return result;
+    }
+};
+
+DocumentView DocumentView::Parse(const std::string_view text)
+{
+    DocumentView document;
+    document.ParseText(text);
+    return document;
+}
+
+DocumentView DocumentView::Load(const std::filesystem::path& path)
+{
+    DocumentView document;
+    document.file_ = std::make_unique<plotter::MappedFile>(path);
+    document.file_->AdviseSequential();
+    document.ParseText(document.file_->View());
+    return document;
+}
+
+void DocumentView::ParseText(const std::string_view text)
+{
+    arena_ = std::make_unique<std::pmr::monotonic_buffer_resource>(
+        std::max(MIN_ARENA_BYTES, text.size() * ARENA_BYTES_PER_CHAR));
+    root_ = ViewParser(text, *arena_).ParseDocument();
+}
+
+ValueReader::ValueReader(const std::string_view text)
+    : buffer_(std::make_unique<std::byte[]>(READER_ARENA_BYTES))
+    , arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(buffer_.get(), READER_ARENA_BYTES))
+    , parser_(std::make_unique<ViewParser>(text, *arena_))
+{
+}
+
+ValueReader::~ValueReader() = default;
+
+bool ValueReader::TryConsume(const char c)
+{
+    return parser_->TryConsume(c);
+}
+
+void ValueReader::Expect(const char c)
+{
+    parser_->SkipWhitespace();
+    parser_->Expect(c);
+}
+
+std::string_view ValueReader::ReadKey()
+{
+    arena_->release();
+    return parser_->ParseKey();
+}
+
+const ValueView& ValueReader::ReadValue()
+{
+    arena_->release();
+    current_ = parser_->ParseNext();
+    return current_;
+}
+
+bool ValueReader::AtEnd()
+{
+    return parser_->AtEnd();
+}
+
+size_t ValueReader::Offset() const noexcept
+{
+    return parser_->Offset();
+}
+
+void ValueReader::Fail(const std::string& message) const
+{
+    parser_->Fail(message);
+}
+
+} // namespace json
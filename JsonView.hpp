@@ -0,0 +1,139 @@
+#pragma once
+#include "json.h"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace json
+{
+
+struct Member;
+class ViewParser;
+
+// Значение документа DocumentView. Строки и ключи — string_view прямо в исходный текст,
+// строки с escape-последовательностями раскодируются в арену документа. Элементы массивов
+// и члены объектов лежат в арене подряд. Значение действительно, пока жив документ
+class ValueView
+{
+public:
+    enum class Type : std::uint8_t
+    {
+        Null,
+        Bool,
+        Int,
+        Double,
+        String,
+        Array,
+        Dict,
+    };
+
+    ValueView() noexcept : integer_(0) {}
+
+    [[nodiscard]] Type GetType() const noexcept { return type_; }
+    [[nodiscard]] bool IsNull() const noexcept { return type_ == Type::Null; }
+    [[nodiscard]] bool IsBool() const noexcept { return type_ == Type::Bool; }
+    [[nodiscard]] bool IsInt() const noexcept { return type_ == Type::Int; }
+    [[nodiscard]] bool IsPureDouble() const noexcept { return type_ == Type::Double; }
+    [[nodiscard]] bool IsDouble() const noexcept { return IsInt() || IsPureDouble(); }
+    [[nodiscard]] bool IsString() const noexcept { return type_ == Type::String; }
+    [[nodiscard]] bool IsArray() const noexcept { return type_ == Type::Array; }
+    [[nodiscard]] bool IsDict() const noexcept { return type_ == Type::Dict; }
+
+    // Бросают std::logic_error при другом типе, как json::Node
+    [[nodiscard]] bool AsBool() const;
+    [[nodiscard]] int AsInt() const;
+    [[nodiscard]] double AsDouble() const;
+    [[nodiscard]] std::string_view AsString() const;
+    [[nodiscard]] std::span<const ValueView> AsArray() const;
+    // Члены отсортированы по ключу, ключи не повторяются
+    [[nodiscard]] std::span<const Member> AsDict() const;
+
+    // Значение по ключу объекта или nullptr, если ключа нет. Бросает std::logic_error, если это не объект
+    [[nodiscard]] const ValueView* Find(std::string_view key) const;
+
+private:
+    friend class ViewParser;
+
+    Type type_ = Type::Null;
+    // Длина строки или число элементов
+    std::uint32_t size_ = 0;
+    union
+    {
+        bool boolean_;
+        int integer_;
+        double number_;
+        const char* chars_;
+        const ValueView* items_;
+        const Member* members_;
+    };
+};
+
+struct Member
+{
+    std::string_view key;
+    ValueView value;
+};
+
+// Документ JSON, разобранный за один проход без копирования текста: синтаксис проверяется
+// по ходу разбора, узлы размещаются в арене документа, строки указывают в текст.
+// Ошибки — ParsingError с номером строки и столбца
+class DocumentView
+{
+public:
+    // text должен жить дольше документа
+    static DocumentView Parse(std::string_view text);
+    // Отображает файл в память, документ владеет отображением
+    static DocumentView Load(const std::filesystem::path& path);
+
+    [[nodiscard]] const ValueView& GetRoot() const noexcept { return root_; }
+
+private:
+    std::unique_ptr<plotter::MappedFile> file_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    ValueView root_;
+
+    DocumentView() = default;
+    void ParseText(std::string_view text);
+};
+
+// Потоковое чтение текста JSON: структуру верхних уровней вызывающий разбирает сам по символам
+// и ключам, а значения читаются по одному в арену, которая очищается перед каждым чтением.
+// Так документ любого размера обрабатывается без дерева в памяти. Ключ и значение действительны
+// до следующего ReadKey или ReadValue. Ошибки — ParsingError с номером строки и столбца
+class ValueReader
+{
+public:
+    // text должен жить дольше читателя
+    explicit ValueReader(std::string_view text);
+    ~ValueReader();
+
+    ValueReader(const ValueReader&) = delete;
+    ValueReader& operator=(const ValueReader&) = delete;
+
+    // Пропускает пробелы и съедает c, если он следующий
+    bool TryConsume(char c);
+    // Как TryConsume, но бросает ParsingError, если следующий символ не c
+    void Expect(char c);
+    // Ключ объекта вместе с двоеточием после него
+    std::string_view ReadKey();
+    const ValueView& ReadValue();
+    // Пропускает пробелы, true в конце текста
+    bool AtEnd();
+    // Число прочитанных байт текста
+    [[nodiscard]] size_t Offset() const noexcept;
+    // Бросает ParsingError с текущей позицией
+    [[noreturn]] void Fail(const std::string& message) const;
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    std::unique_ptr<ViewParser> parser_;
+    ValueView current_;
+};
+
+} // namespace json
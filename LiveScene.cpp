@@ -0,0 +1,314 @@
+#include "LiveScene.hpp"
+#include "Dithering.hpp"
+#include "GrayscalePlotter.hpp"
+#include "PlotterFactory.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    struct Bounds
+    {
+        int x1;
+        int y1;
+        int x2;
+        int y2;
+
+        [[nodiscard]] bool Empty() const noexcept { return x1 > x2 || y1 > y2; }
+    };
+
+    constexpr Bounds EMPTY_BOUNDS{ 0, 0, -1, -1 };
+
+    Bounds Union(const Bounds& lhs, const Bounds& rhs)
+    {
+        if (lhs.Empty())
+        {
+            return rhs;
+        }
+        if (rhs.Empty())
+        {
+            return lhs;
+        }
+        return { std::min(lhs.x1, rhs.x1), std::min(lhs.y1, rhs.y1), std::max(lhs.x2, rhs.x2), std::max(lhs.y2, rhs.y2) };
+    }
+
+    Bounds Intersection(const Bounds& lhs, const Bounds& rhs)
+    {
+        return { std::max(lhs.x1, rhs.x1), std::max(lhs.y1, rhs.y1), std::min(lhs.x2, rhs.x2), std::min(lhs.y2, rhs.y2) };
+    }
+
+    // Меняет ли команда пиксель только по его собственному значению и координатам
+    bool IsLocal(const plotter::SceneCommand& command)
+    {
+        using plotter::SceneFilter;
+        using plotter::SceneOp;
+        if (command.dither == plotter::Dither::FloydSteinberg || command.dither == plotter::Dither::Atkinson)
+        {
+            return false;
+        }
+        switch (command.op)
+        {
+        case SceneOp::FloodFill:
+        case SceneOp::ScanlineFill:
+            return false;
+        case SceneOp::Filter:
+            return command.filter == SceneFilter::Threshold || command.filter == SceneFilter::Invert
+                || command.filter == SceneFilter::Brightness;
+        default:
+            return true;
+        }
+    }
+
+    // Прямоугольник, вне которого локальная команда пиксели не меняет
+    Bounds BoundsOf(const plotter::SceneCommand& command, const Bounds& canvas)
+    {
+        using plotter::SceneOp;
+        const auto& a = command.args;
+        switch (command.op)
+        {
+        case SceneOp::Line:
+        case SceneOp::Rect:
+        case SceneOp::LinearGradient:
+            return { std::min(a[0], a[2]), std::min(a[1], a[3]), std::max(a[0], a[2]), std::max(a[1], a[3]) };
+        case SceneOp::Triangle:
+            return { std::min({ a[0], a[2], a[4] }), std::min({ a[1], a[3], a[5] }),
+                std::max({ a[0], a[2], a[4] }), std::max({ a[1], a[3], a[5] }) };
+        case SceneOp::Circle:
+            // Брезенхем может выйти за радиус на пиксель, окружность радиуса 0 рисуется в (x ± 1, y ± 1)
+            return { a[0] - a[2] - 1, a[1] - a[2] - 1, a[0] + a[2] + 1, a[1] + a[2] + 1 };
+        case SceneOp::RadialGradient:
+            return { a[0] - a[2], a[1] - a[2], a[0] + a[2], a[1] + a[2] };
+        default:
+            return canvas;
+        }
+    }
+
+    plotter::SceneCommand Translated(plotter::SceneCommand command, const int dx, const int dy)
+    {
+        using plotter::SceneOp;
+        int points = 0;
+        switch (command.op)
+        {
+        case SceneOp::Line:
+        case SceneOp::Rect:
+        case SceneOp::LinearGradient:
+            points = 2;
+            break;
+        case SceneOp::Triangle:
+            points = 3;
+            break;
+        case SceneOp::Circle:
+        case SceneOp::RadialGradient:
+        case SceneOp::FloodFill:
+        case SceneOp::ScanlineFill:
+            points = 1;
+            break;
+        case SceneOp::Clear:
+        case SceneOp::Filter:
+            break;
+        }
+        for (int i = 0; i < points; ++i)
+        {
+            command.args[2 * i] += dx;
+            command.args[2 * i + 1] += dy;
+        }
+        return command;
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+LiveScene::LiveScene(const PlotterConfig& config, std::vector<SceneCommand> commands)
+    : config_(config)
+    , commands_(std::move(commands))
+    , plotter_(PlotterFactory::CreatePlotter(config_))
+    , has_nonlocal_(!std::all_of(commands_.begin(), commands_.end(), IsLocal))
+{
+    RenderAll();
+}
+
+SceneUpdate LiveScene::Update(const PlotterConfig& config, std::vector<SceneCommand> commands)
+{
+    SceneUpdate update;
+    update.config = Config::Diff(config_, config);
+
+    // Измененные команды — между общим началом и общим концом старого и нового списков
+    const size_t common = std::min(commands_.size(), commands.size());
+    size_t prefix = 0;
+    while (prefix < common && commands_[prefix] == commands[prefix])
+    {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < common - prefix && commands_[commands_.size() - 1 - suffix] == commands[commands.size() - 1 - suffix])
+    {
+        ++suffix;
+    }
+    update.changed_commands = commands.size() - prefix - suffix;
+
+    const Bounds canvas{ 0, 0, config_.width - 1, config_.height - 1 };
+    Bounds dirty = EMPTY_BOUNDS;
+    bool nonlocal = has_nonlocal_;
+    for (size_t i = prefix; i < commands_.size() - suffix; ++i)
+    {
+        dirty = Union(dirty, BoundsOf(commands_[i], canvas));
+    }
+    for (size_t i = prefix; i < commands.size() - suffix; ++i)
+    {
+        dirty = Union(dirty, BoundsOf(commands[i], canvas));
+    }
+
+    config_ = config;
+    commands_ = std::move(commands);
+    has_nonlocal_ = !std::all_of(commands_.begin(), commands_.end(), IsLocal);
+    nonlocal = nonlocal || has_nonlocal_;
+
+    if (update.config.size || update.config.background_char || update.config.plotter_type)
+    {
+        plotter_ = PlotterFactory::CreatePlotter(config_);
+        RenderAll();
+        update.reallocated = true;
+        update.full_render = true;
+        update.x1 = 0;
+        update.y1 = 0;
+        update.x2 = config_.width - 1;
+        update.y2 = config_.height - 1;
+        return update;
+    }
+
+    if (update.config.threads)
+    {
+        plotter_->SetThreadCount(config_.threads);
+    }
+    if (update.config.palette)
+    {
+        if (auto* const grayscale = dynamic_cast<GrayscalePlotter*>(plotter_.get()))
+        {
+            grayscale->SetPalette(config_.palette.empty() ? GrayscalePlotter::DefaultPalette() : config_.palette);
+            update.remapped = true;
+        }
+    }
+
+    dirty = Intersection(dirty, canvas);
+    if (dirty.Empty())
+    {
+        return update;
+    }
+
+    // Большую область дешевле перерисовать сразу целиком
+    const auto area = [](const Bounds& bounds)
+    {
+        return static_cast<long long>(bounds.x2 - bounds.x1 + 1) * (bounds.y2 - bounds.y1 + 1);
+    };
+    if (nonlocal || 2 * area(dirty) > area(canvas))
+    {
+        RenderAll();
+        update.full_render = true;
+        dirty = canvas;
+    }
+    else
+    {
+        RepaintRegion(dirty.x1, dirty.y1, dirty.x2, dirty.y2);
+    }
+    update.x1 = dirty.x1;
+    update.y1 = dirty.y1;
+    update.x2 = dirty.x2;
+    update.y2 = dirty.y2;
+    return update;
+}
+
+void LiveScene::RenderAll()
+{
+    plotter_->GetCanvas().Clear(config_.background_char);
+    for (const SceneCommand& command : commands_)
+    {
+        Scene::ExecuteCommand(command, *plotter_);
+    }
+}
+
+void LiveScene::RepaintRegion(const int x1, const int y1, const int x2, const int y2)
+{
+    // Угол выравнивается на матрицу Байера, чтобы упорядоченный дизеринг во временном канвасе совпал
+    const int left = x1 - x1 % BAYER_SIZE;
+    const int top = y1 - y1 % BAYER_SIZE;
+    PlotterConfig region_config = config_;
+    region_config.width = x2 - left + 1;
+    region_config.height = y2 - top + 1;
+    region_config.threads = 1;
+    const std::unique_ptr<Plotter> region = PlotterFactory::CreatePlotter(region_config);
+
+    const Bounds canvas{ 0, 0, config_.width - 1, config_.height - 1 };
+    const Bounds area{ left, top, x2, y2 };
+    for (const SceneCommand& command : commands_)
+    {
+        if (!Intersection(BoundsOf(command, canvas), area).Empty())
+        {
+            Scene::ExecuteCommand(Translated(command, -left, -top), *region);
+        }
+    }
+    plotter_->PasteRegion(std::as_const(*region).GetCanvas(), left, top);
+}
+
+SceneWatcher::SceneWatcher(const std::filesystem::path& scene_path, const std::filesystem::path& config_path)
+    : scene_path_(scene_path)
+    , config_path_(config_path)
+    , watcher_(WatchedFiles(scene_path, config_path))
+{
+    auto [config, commands] = Load();
+    scene_ = std::make_unique<LiveScene>(config, std::move(commands));
+}
+
+std::optional<SceneReload> SceneWatcher::Poll(const std::chrono::milliseconds timeout)
+{
+    if (watcher_.Wait(timeout).empty())
+    {
+        return std::nullopt;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    SceneReload reload;
+    try
+    {
+        auto [config, commands] = Load();
+        reload.update = scene_->Update(config, std::move(commands));
+    }
+    catch (const std::exception& e)
+    {
+        // Файл мог быть сохранен с ошибкой или не до конца: показываем прежний кадр до следующего сохранения
+        reload.error = e.what();
+    }
+    reload.latency = std::chrono::steady_clock::now() - start_time;
+    return reload;
+}
+
+std::pair<PlotterConfig, std::vector<SceneCommand>> SceneWatcher::Load() const
+{
+    PlotterConfig config;
+    std::vector<SceneCommand> commands;
+    Scene::ReadFile(scene_path_, [&config](const PlotterConfig& scene_config) { config = scene_config; },
+        [&commands](const SceneCommand& command) { commands.push_back(command); });
+
+    if (!config_path_.empty())
+    {
+        config = Config::LoadFromFile(config_path_.string());
+    }
+    else if (!Config::ValidateConfig(config))
+    {
+        throw SceneError("Scene config is invalid");
+    }
+    return { config, std::move(commands) };
+}
+
+std::vector<std::filesystem::path> SceneWatcher::WatchedFiles(const std::filesystem::path& scene_path,
+    const std::filesystem::path& config_path)
+{
+    std::vector<std::filesystem::path> files{ scene_path };
+    if (!config_path.empty())
+    {
+        files.push_back(config_path);
+    }
+    return files;
+}
+
+} // namespace plotter
@@ -0,0 +1,104 @@
+#pragma once
+#include "Config.hpp"
+#include "FileWatcher.hpp"
+#include "Plotter.hpp"
+#include "Scene.hpp"
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plotter
+{
+
+// Что сделал LiveScene::Update
+struct SceneUpdate
+{
+    PlotterConfigDiff config;
+    // Plotter создан заново: сменились размер, фон или тип
+    bool reallocated = false;
+    // Символы переведены в новую палитру на месте через SetPalette
+    bool remapped = false;
+    // Сцена перерисована целиком
+    bool full_render = false;
+    // Число команд новой сцены, которых не было на их месте в старой
+    size_t changed_commands = 0;
+    // Перерисованная область, x1 > x2 — команды не перерисовывались
+    int x1 = 0;
+    int y1 = 0;
+    int x2 = -1;
+    int y2 = -1;
+
+    [[nodiscard]] long long RepaintedPixels() const noexcept
+    {
+        return x1 > x2 || y1 > y2 ? 0 : static_cast<long long>(x2 - x1 + 1) * (y2 - y1 + 1);
+    }
+};
+
+// Сцена, которая держит свой канвас в актуальном состоянии при смене конфига и команд.
+// Update сравнивает новый PlotterConfig и список команд со старыми и делает минимум работы:
+// смена палитры переводит символы на месте, смена размера, фона или типа plotter создает его заново,
+// а измененные команды перерисовывают только прямоугольник, который занимали старая и новая версии.
+// Прямоугольник перерисовывается во временном канвасе командами, которые его задевают, со сдвигом
+// координат и вклеивается обратно. Так можно, пока каждая команда сцены меняет пиксель только по его
+// координатам: заливки, фильтры по соседям и диффузия ошибки дают полную перерисовку
+class LiveScene
+{
+public:
+    LiveScene(const PlotterConfig& config, std::vector<SceneCommand> commands);
+
+    SceneUpdate Update(const PlotterConfig& config, std::vector<SceneCommand> commands);
+
+    [[nodiscard]] const PlotterConfig& GetConfig() const noexcept { return config_; }
+    [[nodiscard]] const std::vector<SceneCommand>& Commands() const noexcept { return commands_; }
+    [[nodiscard]] Plotter& GetPlotter() noexcept { return *plotter_; }
+
+private:
+    PlotterConfig config_;
+    std::vector<SceneCommand> commands_;
+    std::unique_ptr<Plotter> plotter_;
+    // Сцена содержит команду, зависящую от соседних пикселей
+    bool has_nonlocal_ = false;
+
+    void RenderAll();
+    void RepaintRegion(int x1, int y1, int x2, int y2);
+};
+
+// Отчет SceneWatcher::Poll о перезагрузке
+struct SceneReload
+{
+    SceneUpdate update;
+    // От события inotify до готового кадра
+    std::chrono::duration<double, std::milli> latency{};
+    // Конфиг или сцену не удалось прочитать, кадр остался прежним
+    std::optional<std::string> error;
+};
+
+// Режим наблюдения: сцена и, если задан, отдельный конфиг перечитываются при изменении файлов,
+// кадр обновляется через LiveScene::Update. Без config_path используется раздел "config" сцены
+class SceneWatcher
+{
+public:
+    // Бросает исключения Config и Scene, если файлы не читаются при старте
+    explicit SceneWatcher(const std::filesystem::path& scene_path, const std::filesystem::path& config_path = {});
+
+    // Ждет изменений не дольше timeout и обновляет кадр. nullopt — изменений не было
+    std::optional<SceneReload> Poll(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] LiveScene& GetScene() noexcept { return *scene_; }
+
+private:
+    std::filesystem::path scene_path_;
+    std::filesystem::path config_path_;
+    FileWatcher watcher_;
+    std::unique_ptr<LiveScene> scene_;
+
+    [[nodiscard]] std::pair<PlotterConfig, std::vector<SceneCommand>> Load() const;
+    static std::vector<std::filesystem::path> WatchedFiles(const std::filesystem::path& scene_path,
+        const std::filesystem::path& config_path);
+};
+
+} // namespace plotter
@@ -0,0 +1,118 @@
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace plotter
+{
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Failed to open file '" + path.string() + "'");
+    }
+
+    struct stat info{};
+    if (::fstat(descriptor, &info) != 0)
+    {
+        ::close(descriptor);
+        throw std::runtime_error("Failed to read size of file '" + path.string() + "'");
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0)
+    {
+        void* const mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(descriptor);
+            throw std::runtime_error("Failed to map file '" + path.string() + "'");
+        }
+        data_ = static_cast<const unsigned char*>(mapping);
+    }
+
+    // Отображение остается действительным и после закрытия дескриптора
+    ::close(descriptor);
+}
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+std::string_view MappedFile::View() const noexcept
+{
+    return { reinterpret_cast<const char*>(data_), size_ };
+}
+
+void MappedFile::AdviseSequential() const noexcept
+{
+    if (data_)
+    {
+        ::madvise(const_cast<unsigned char*>(data_), size_, MADV_SEQUENTIAL);
+    }
+}
+
+void MappedFile::Prefault() const noexcept
+{
+    const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    unsigned char sum = 0;
+    for (size_t offset = 0; offset < size_; offset += page)
+    {
+        sum += static_cast<const volatile unsigned char*>(data_)[offset];
+    }
+    static_cast<void>(sum);
+}
+
+void MappedFile::Release(const size_t offset, const size_t length) const noexcept
+{
+    if (!data_ || offset >= size_)
+    {
+        return;
+    }
+
+    // madvise работает с целыми страницами, поэтому диапазон сужается до страниц внутри него
+    const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t end = std::min(offset + length, size_);
+    const size_t first_page = (offset + page - 1) / page * page;
+    const size_t last_page = end / page * page;
+    if (first_page < last_page)
+    {
+        ::madvise(const_cast<unsigned char*>(data_) + first_page, last_page - first_page, MADV_DONTNEED);
+    }
+}
+
+void MappedFile::Unmap() noexcept
+{
+    if (data_)
+    {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+} // namespace plotter
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace plotter
+{
+
+// Файл, отображенный в память только для чтения (POSIX mmap).
+// Пустой файл дает пустое отображение без ошибки
+class MappedFile
+{
+public:
+    // Бросает std::runtime_error, если файл не открывается или не отображается
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    [[nodiscard]] const unsigned char* Data() const noexcept { return data_; }
+    [[nodiscard]] size_t Size() const noexcept { return size_; }
+    [[nodiscard]] std::string_view View() const noexcept;
+
+    // Подсказка ядру: файл читается подряд
+    void AdviseSequential() const noexcept;
+    // Читает по байту с каждой страницы, чтобы последующий доступ не ждал диска
+    void Prefault() const noexcept;
+    // Подсказка ядру: страницы внутри [offset, offset + length) больше не нужны
+    // и могут быть вытеснены. Повторное чтение снова загрузит их из файла
+    void Release(size_t offset, size_t length) const noexcept;
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+
+    void Unmap() noexcept;
+};
+
+} // namespace plotter
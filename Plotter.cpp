@@ -1,10 +1,14 @@
 #include "Plotter.hpp"
 #include "CanvasIterators.hpp"
+#include "Profiling.hpp"
+#include "Resampling.hpp"
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
 #include <queue>
 #include <stack>
+#include <utility>
 
 namespace
 {
@@ -13,6 +17,27 @@ namespace
     constexpr int STEP_SCALE = 4;
     constexpr int EAST_INCREMENT = 6;
     constexpr int SOUTH_EAST_INCREMENT = 10;
+    // Меньшие полосы не окупают синхронизацию потоков
+    constexpr int MIN_ROWS_PER_BAND = 8;
+
+    // Сужает [first, last] до x, при которых 0 <= start + step * x < limit
+    void ClipLinear(const double start, const double step, const double limit, double& first, double& last)
+    {
+        if (step == 0.0)
+        {
+            if (!(start >= 0.0 && start < limit))
+            {
+                first = 1.0;
+                last = 0.0;
+            }
+            return;
+        }
+
+        const double at_zero = -start / step;
+        const double at_limit = (limit - start) / step;
+        first = std::max(first, std::min(at_zero, at_limit));
+        last = std::min(last, std::max(at_zero, at_limit));
+    }
 } // anonymous namespace
 
 namespace plotter
@@ -33,6 +58,49 @@ Plotter::Plotter(int width, int height, char background_char)
     // При невалидных данных конструктор Canvas бросит исключение 
 }
 
+void Plotter::SetThreadCount(const int thread_count)
+{
+    if (thread_count < 1)
+    {
+        throw std::invalid_argument("Thread count can't be less than 1");
+    }
+
+    if (thread_count == GetThreadCount())
+    {
+        return;
+    }
+
+    thread_pool_ = thread_count > 1 ? std::make_unique<ThreadPool>(thread_count) : nullptr;
+}
+
+int Plotter::GetThreadCount() const noexcept
+{
+    return thread_pool_ ? thread_pool_->ThreadCount() : 1;
+}
+
+void Plotter::ForEachRowBand(const int rows, const std::function<void(RowBand)>& body) const
+{
+    if (rows <= 0)
+    {
+        return;
+    }
+
+    const int band_count = std::clamp(rows / MIN_ROWS_PER_BAND, 1, GetThreadCount());
+    if (band_count == 1)
+    {
+        body({ 0, rows });
+        return;
+    }
+
+    // Полосы не зависят от планирования потоков, поэтому результат детерминирован
+    thread_pool_->ParallelFor(band_count, [&](const int band)
+    {
+        const int begin = static_cast<int>(static_cast<long long>(rows) * band / band_count);
+        const int end = static_cast<int>(static_cast<long long>(rows) * (band + 1) / band_count);
+        body({ begin, end });
+    });
+}
+
 // Перешел на C++ 20
 // Plotter::ScanlineSegment::ScanlineSegment(int y, int x_start, int x_end)
 //     : y(y)
@@ -43,14 +111,25 @@ Plotter::Plotter(int width, int height, char background_char)
 
 void Plotter::DrawLine(const int x1, const int y1, const int x2, const int y2, const char brush)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::DrawLine");
+    CheckBrush(brush);
+    BeforeCanvasWrite();
+
     DrawLineBresenham(x1, y1, x2, y2, brush);
 }
 
 void Plotter::DrawRectangle(const int x1, const int y1, const int x2, const int y2, const char brush, const bool fill)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::DrawRectangle");
+    CheckBrush(brush);
     if (fill)
     {
+        BeforeCanvasWrite();
         canvas_->FillRegion(x1, y1, x2, y2, brush);
+        if (pen_)
+        {
+            canvas_->FillColors(x1, y1, x2, y2, *pen_);
+        }
     }
     else
     {
@@ -64,6 +143,10 @@ void Plotter::DrawRectangle(const int x1, const int y1, const int x2, const int
 void Plotter::DrawTriangle(const int x1, const int y1, const int x2, const int y2, const int x3, const int y3,
     const char brush, const bool fill)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::DrawTriangle");
+    CheckBrush(brush);
+    BeforeCanvasWrite();
+
     if (fill)
     {
         FillTriangle(x1, y1, x2, y2, x3, y3, brush);
@@ -78,6 +161,10 @@ void Plotter::DrawTriangle(const int x1, const int y1, const int x2, const int y
 
 void Plotter::DrawCircle(const int center_x, const int center_y, const int radius, const char brush, const bool fill)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::DrawCircle");
+    CheckBrush(brush);
+    BeforeCanvasWrite();
+
     if (fill)
     {
         for (int y = -radius; y <= radius; ++y)
@@ -90,7 +177,7 @@ void Plotter::DrawCircle(const int center_x, const int center_y, const int radiu
                     const int py = center_y + y;
                     if (canvas_->InBounds(px, py))
                     {
-                        canvas_->at(px, py) = brush;
+                        PutPixel(px, py, brush);
                     }
                 }
             }
@@ -104,10 +191,16 @@ void Plotter::DrawCircle(const int center_x, const int center_y, const int radiu
 
 void Plotter::FloodFill(int x, int y, const char fill_brush)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::FloodFill");
+    CheckBrush(fill_brush);
+    BeforeCanvasWrite();
+    // Чтение через константную ссылку не сбрасывает статистику канваса
+    const Canvas& source = *canvas_;
+
     if (!canvas_->InBounds(x, y))
         return;
 
-    const char target_brush = canvas_->at(x, y);
+    const char target_brush = source.at(x, y);
     if (target_brush == fill_brush)
     {
         return;
@@ -121,18 +214,133 @@ void Plotter::FloodFill(int x, int y, const char fill_brush)
         auto [cx, cy] = pixels.front();
         pixels.pop();
 
-        if (!canvas_->InBounds(cx, cy) || canvas_->at(cx, cy) != target_brush)
+        if (!canvas_->InBounds(cx, cy) || source.at(cx, cy) != target_brush)
         {
             continue;
         }
 
-        canvas_->at(cx, cy) = fill_brush;
+        PutPixel(cx, cy, fill_brush);
 
         pixels.emplace(cx + 1, cy);
         pixels.emplace(cx - 1, cy);
         pixels.emplace(cx, cy + 1);
         pixels.emplace(cx, cy - 1);
+        PLOTTER_PROFILE_MAX("flood_fill.queue_high_water", pixels.size());
+    }
+}
+
+void Plotter::DrawLine(const int x1, const int y1, const int x2, const int y2, const char brush,
+    const CellColors& colors)
+{
+    DrawWithColors(colors, [&]() { DrawLine(x1, y1, x2, y2, brush); });
+}
+
+void Plotter::DrawRectangle(const int x1, const int y1, const int x2, const int y2, const char brush,
+    const CellColors& colors, const bool fill)
+{
+    DrawWithColors(colors, [&]() { DrawRectangle(x1, y1, x2, y2, brush, fill); });
+}
+
+void Plotter::DrawTriangle(const int x1, const int y1, const int x2, const int y2, const int x3, const int y3,
+    const char brush, const CellColors& colors, const bool fill)
+{
+    DrawWithColors(colors, [&]() { DrawTriangle(x1, y1, x2, y2, x3, y3, brush, fill); });
+}
+
+void Plotter::DrawCircle(const int center_x, const int center_y, const int radius, const char brush,
+    const CellColors& colors, const bool fill)
+{
+    DrawWithColors(colors, [&]() { DrawCircle(center_x, center_y, radius, brush, fill); });
+}
+
+void Plotter::FloodFill(const int x, const int y, const char fill_brush, const CellColors& colors)
+{
+    BeforeCanvasWrite();
+    // Заливка тем же символом сразу остановилась бы, поэтому область сначала помечается
+    if (canvas_->InBounds(x, y) && std::as_const(*canvas_)(x, y) == fill_brush)
+    {
+        DrawMarker([&](const char marker) { FloodFill(x, y, marker); });
+    }
+    DrawWithColors(colors, [&]() { FloodFill(x, y, fill_brush); });
+}
+
+void Plotter::ScanlineFill(const int x, const int y, const char fill_brush, const CellColors& colors)
+{
+    BeforeCanvasWrite();
+    if (canvas_->InBounds(x, y) && std::as_const(*canvas_)(x, y) == fill_brush)
+    {
+        DrawMarker([&](const char marker) { ScanlineFill(x, y, marker); });
+    }
+    DrawWithColors(colors, [&]() { ScanlineFill(x, y, fill_brush); });
+}
+
+void Plotter::BeforeCanvasRead() const
+{
+    if (!CanvasIsStale())
+    {
+        return;
+    }
+
+    const std::lock_guard lock(sync_mutex_);
+    if (CanvasIsStale())
+    {
+        SyncCanvas(*canvas_);
+    }
+}
+
+void Plotter::SyncCanvas(Canvas&) const
+{
+}
+
+void Plotter::DrawMarker(const std::function<void(char)>& draw)
+{
+    // Вложенный вызов: заливка маркером внутри примитива, нарисованного маркером
+    const bool outer = drawing_marker_;
+    drawing_marker_ = true;
+    try
+    {
+        draw(MARKER);
+    }
+    catch (...)
+    {
+        drawing_marker_ = outer;
+        throw;
+    }
+    drawing_marker_ = outer;
+}
+
+void Plotter::CheckBrush(const char brush) const
+{
+    if (brush == MARKER && !drawing_marker_)
+    {
+        throw std::invalid_argument("Brush can't be null");
+    }
+}
+
+void Plotter::PutPixel(const int x, const int y, const char brush)
+{
+    PLOTTER_PROFILE_COUNT("pixels_written", 1);
+    canvas_->SetPixel(x, y, brush);
+    if (pen_)
+    {
+        canvas_->SetColors(x, y, *pen_);
+    }
+}
+
+void Plotter::DrawWithColors(const CellColors& colors, const std::function<void()>& draw)
+{
+    canvas_->EnableColors();
+    pen_ = colors;
+    try
+    {
+        draw();
+    }
+    catch (...)
+    {
+        pen_.reset();
+        throw;
     }
+    pen_.reset();
 }
 
 std::unordered_map<char, int> Plotter::ColorHistogram() const
@@ -142,15 +350,33 @@ std::unordered_map<char, int> Plotter::ColorHistogram() const
 
 std::unordered_map<char, int> Plotter::ColorHistogram(const int x1, const int y1, const int x2, const int y2) const
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::ColorHistogram");
+    BeforeCanvasRead();
+
+    const Canvas& source = *canvas_;
     std::unordered_map<char, int> histogram;
 
+    // Весь канвас со статистикой: таблица счетчиков вместо обхода пикселей
+    if (source.HasStatistics() && x1 <= 0 && y1 <= 0 && x2 >= source.Width() - 1 && y2 >= source.Height() - 1)
+    {
+        const CharCounts& counts = source.Statistics();
+        for (size_t code = 0; code < counts.size(); ++code)
+        {
+            if (counts[code] > 0)
+            {
+                histogram[static_cast<char>(code)] = counts[code];
+            }
+        }
+        return histogram;
+    }
+
     for (int y = y1; y <= y2; ++y)
     {
         for (int x = x1; x <= x2; ++x)
         {
-            if (canvas_->InBounds(x, y))
+            if (source.InBounds(x, y))
             {
-                char color = canvas_->at(x, y);
+                char color = source.at(x, y);
                 histogram[color]++;
             }
         }
@@ -188,12 +414,79 @@ ColorExtrema Plotter::GetMinMaxColors(const std::unordered_map<char, int>& color
     return { min_color, max_color };
 }
 
+std::unique_ptr<Canvas> Plotter::Resize(const int width, const int height) const
+{
+    auto result = std::make_unique<Canvas>(width, height, canvas_->Background());
+    ResizeInto(*result);
+    return result;
+}
+
+void Plotter::ResizeInto(Canvas& target) const
+{
+    PLOTTER_PROFILE_SCOPE("Plotter::ResizeInto");
+    if (&target == canvas_.get())
+    {
+        throw std::invalid_argument("Can't resize canvas into itself");
+    }
+
+    BeforeCanvasRead();
+    const Canvas& source = *canvas_;
+    const std::vector<int> columns = NearestIndices(source.Width(), target.Width());
+    const std::vector<int> rows = NearestIndices(source.Height(), target.Height());
+
+    if (source.HasColors())
+    {
+        target.EnableColors();
+    }
+    else
+    {
+        target.DisableColors();
+    }
+
+    const char* const symbols = source.Data();
+    char* const result = target.CountedData();
+    const CellColors* const colors = source.ColorData();
+    CellColors* const result_colors = target.ColorData();
+    PLOTTER_PROFILE_COUNT("pixels_written", target.Size());
+    ForEachRowBand(target.Height(), [&](const RowBand band)
+    {
+        Canvas::BandCounts counts(target);
+        for (int y = band.begin; y < band.end; ++y)
+        {
+            const size_t source_offset = static_cast<size_t>(rows[y]) * source.Width();
+            const size_t offset = static_cast<size_t>(y) * target.Width();
+            counts.Before(result + offset, result + offset + target.Width());
+            for (int x = 0; x < target.Width(); ++x)
+            {
+                result[offset + x] = symbols[source_offset + columns[x]];
+            }
+            counts.After(result + offset, result + offset + target.Width());
+            if (colors)
+            {
+                for (int x = 0; x < target.Width(); ++x)
+                {
+                    result_colors[offset + x] = colors[source_offset + columns[x]];
+                }
+            }
+        }
+        counts.Merge();
+    });
+}
+
 std::unique_ptr<Canvas> Plotter::ExtractRegion(const int x1, const int y1, const int x2, const int y2) const
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::ExtractRegion");
+    BeforeCanvasRead();
+
     int width = x2 - x1 + 1;
     int height = y2 - y1 + 1;
 
     auto region = std::make_unique<Canvas>(width, height, ' ');
+    const Canvas& source = *canvas_;
+    if (source.HasColors())
+    {
+        region->EnableColors();
+    }
 
     for (int y = 0; y < height; ++y)
     {
@@ -203,7 +496,11 @@ std::unique_ptr<Canvas> Plotter::ExtractRegion(const int x1, const int y1, const
             const int src_y = y1 + y;
             if (canvas_->InBounds(src_x, src_y))
             {
-                region->at(x, y) = canvas_->at(src_x, src_y);
+                region->SetPixel(x, y, source.at(src_x, src_y));
+                if (source.HasColors())
+                {
+                    region->SetColors(x, y, source.Colors(src_x, src_y));
+                }
             }
         }
     }
@@ -213,6 +510,16 @@ std::unique_ptr<Canvas> Plotter::ExtractRegion(const int x1, const int y1, const
 
 void Plotter::PasteRegion(const Canvas& region, const int x, const int y)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::PasteRegion");
+    BeforeCanvasWrite();
+    PLOTTER_PROFILE_COUNT("pixels_written",
+        static_cast<long long>(std::max(0, std::min(x + region.Width(), canvas_->Width()) - std::max(x, 0)))
+            * std::max(0, std::min(y + region.Height(), canvas_->Height()) - std::max(y, 0)));
+    if (region.HasColors())
+    {
+        canvas_->EnableColors();
+    }
+
     for (int ry = 0; ry < region.Height(); ++ry)
     {
         for (int rx = 0; rx < region.Width(); ++rx)
@@ -221,12 +528,173 @@ void Plotter::PasteRegion(const Canvas& region, const int x, const int y)
             const int dest_y = y + ry;
             if (canvas_->InBounds(dest_x, dest_y))
             {
-                (*canvas_)(dest_x, dest_y) = region.at(rx, ry);
+                canvas_->SetPixel(dest_x, dest_y, region.at(rx, ry));
+                if (region.HasColors())
+                {
+                    canvas_->SetColors(dest_x, dest_y, region.Colors(rx, ry));
+                }
             }
         }
     }
 }
 
+void Plotter::TransformRegion(const Canvas& source, const AffineTransform& transform,
+    const std::optional<char> transparent)
+{
+    PLOTTER_PROFILE_SCOPE("Plotter::TransformRegion");
+    BeforeCanvasWrite();
+
+    // Преобразование канваса в себя читает его копию
+    std::optional<Canvas> copy;
+    if (&source == canvas_.get())
+    {
+        copy.emplace(source);
+    }
+    const Canvas& from = copy ? *copy : source;
+    if (from.HasColors())
+    {
+        canvas_->EnableColors();
+    }
+
+    const char* const symbols = from.Data();
+    char* const result = canvas_->CountedData();
+    const CellColors* const colors = from.ColorData();
+    CellColors* const result_colors = canvas_->ColorData();
+    const int width = canvas_->Width();
+    const auto source_width = static_cast<size_t>(from.Width());
+    // Без прозрачного символа сравнение с символом вне char никогда не срабатывает
+    const int skipped = transparent ? static_cast<unsigned char>(*transparent) : -1;
+    ForEachTransformSpan(from.Width(), from.Height(), transform, [&](const TransformSpan& span)
+    {
+        const size_t offset = static_cast<size_t>(span.y) * width;
+        // Участок — наименьшая единица обхода, поэтому замены в статистике переносятся по участкам
+        Canvas::BandCounts counts(*canvas_);
+        counts.Before(result + offset + span.x_begin, result + offset + span.x_end);
+        std::int64_t u = span.u;
+        std::int64_t v = span.v;
+        for (int x = span.x_begin; x < span.x_end; ++x, u += span.du, v += span.dv)
+        {
+            const auto source_x = static_cast<size_t>(u >> TransformSpan::FRACTION_BITS);
+            const auto source_y = static_cast<size_t>(v >> TransformSpan::FRACTION_BITS);
+            const size_t source_index = source_y * source_width + source_x;
+            const char symbol = symbols[source_index];
+            if (static_cast<unsigned char>(symbol) != skipped)
+            {
+                result[offset + x] = symbol;
+                if (colors)
+                {
+                    result_colors[offset + x] = colors[source_index];
+                }
+            }
+        }
+        counts.After(result + offset + span.x_begin, result + offset + span.x_end);
+        counts.Merge();
+    });
+}
+
+void Plotter::ForEachTransformSpan(const int source_width, const int source_height, const AffineTransform& transform,
+    const std::function<void(const TransformSpan&)>& body) const
+{
+    const AffineTransform inverse = transform.Inverse();
+    const auto width = static_cast<double>(source_width);
+    const auto height = static_cast<double>(source_height);
+
+    // Строки канваса между крайними углами образа source
+    double top = std::numeric_limits<double>::infinity();
+    double bottom = -std::numeric_limits<double>::infinity();
+    const std::pair<double, double> corners[] = { { 0.0, 0.0 }, { width, 0.0 }, { 0.0, height }, { width, height } };
+    for (const auto& [x, y] : corners)
+    {
+        top = std::min(top, transform.MapY(x, y));
+        bottom = std::max(bottom, transform.MapY(x, y));
+    }
+    const auto canvas_height = static_cast<double>(canvas_->Height());
+    const auto row_begin = static_cast<int>(std::clamp(std::floor(top), 0.0, canvas_height));
+    const auto row_end = static_cast<int>(std::clamp(std::ceil(bottom) + 1.0, 0.0, canvas_height));
+    if (row_begin >= row_end)
+    {
+        return;
+    }
+
+    constexpr double FIXED_ONE = static_cast<double>(std::int64_t{ 1 } << TransformSpan::FRACTION_BITS);
+    const double last_column = canvas_->Width() - 1.0;
+    ForEachRowBand(row_end - row_begin, [&](const RowBand band)
+    {
+        for (int y = row_begin + band.begin; y < row_begin + band.end; ++y)
+        {
+            // Координаты в source центра пикселя (x, y): start + step * x
+            const double u_start = inverse.MapX(0.5, y + 0.5);
+            const double v_start = inverse.MapY(0.5, y + 0.5);
+            const double u_step = inverse.xx;
+            const double v_step = inverse.yx;
+
+            double first = 0.0;
+            double last = last_column;
+            ClipLinear(u_start, u_step, width, first, last);
+            ClipLinear(v_start, v_step, height, first, last);
+            if (first > last)
+            {
+                continue;
+            }
+
+            // Концы уточняются точной проверкой: граница source в пикселе не включается
+            const auto inside = [&](const int x)
+            {
+                const double u = u_start + u_step * x;
+                const double v = v_start + v_step * x;
+                return u >= 0.0 && u < width && v >= 0.0 && v < height;
+            };
+            int x_begin = static_cast<int>(std::ceil(first));
+            int x_end = static_cast<int>(std::floor(last)) + 1;
+            while (x_begin < x_end && !inside(x_begin))
+            {
+                ++x_begin;
+            }
+            while (x_end > x_begin && !inside(x_end - 1))
+            {
+                --x_end;
+            }
+            if (x_begin == x_end)
+            {
+                continue;
+            }
+
+            // Шаг нужен только участку длиннее пикселя, тогда он меньше размера source
+            const bool steps = x_end - x_begin > 1;
+            const std::int64_t u = std::llround((u_start + u_step * x_begin) * FIXED_ONE);
+            const std::int64_t v = std::llround((v_start + v_step * x_begin) * FIXED_ONE);
+            const std::int64_t du = steps ? std::llround(u_step * FIXED_ONE) : 0;
+            const std::int64_t dv = steps ? std::llround(v_step * FIXED_ONE) : 0;
+
+            // Шаг округлен, поэтому крайние пиксели проверяются в фиксированной точке еще раз.
+            // Координаты линейны по x, значит внутри участка они лежат между крайними и не выходят за source
+            const std::int64_t u_limit = static_cast<std::int64_t>(source_width) << TransformSpan::FRACTION_BITS;
+            const std::int64_t v_limit = static_cast<std::int64_t>(source_height) << TransformSpan::FRACTION_BITS;
+            const int first_x = x_begin;
+            const auto fits = [&](const int x)
+            {
+                const std::int64_t pixel_u = u + du * (x - first_x);
+                const std::int64_t pixel_v = v + dv * (x - first_x);
+                return pixel_u >= 0 && pixel_u < u_limit && pixel_v >= 0 && pixel_v < v_limit;
+            };
+            while (x_begin < x_end && !fits(x_begin))
+            {
+                ++x_begin;
+            }
+            while (x_end > x_begin && !fits(x_end - 1))
+            {
+                --x_end;
+            }
+            if (x_begin < x_end)
+            {
+                PLOTTER_PROFILE_COUNT("spans_emitted", 1);
+                PLOTTER_PROFILE_COUNT("pixels_written", x_end - x_begin);
+                body({ y, x_begin, x_end, u + du * (x_begin - first_x), v + dv * (x_begin - first_x), du, dv });
+            }
+        }
+    });
+}
+
 void Plotter::DrawLineBresenham(int x1, int y1, const int x2, const int y2, const char brush)
 {
     int dx = std::abs(x2 - x1);
@@ -239,7 +707,7 @@ void Plotter::DrawLineBresenham(int x1, int y1, const int x2, const int y2, cons
     {
         if (canvas_->InBounds(x1, y1))
         {
-            (*canvas_)(x1, y1) = brush;
+            PutPixel(x1, y1, brush);
         }
 
         if (x1 == x2 && y1 == y2)
@@ -266,35 +734,35 @@ void Plotter::DrawCircleBresenham(const int center_x, const int center_y, const
     {
         if (canvas_->InBounds(cx + x, cy + y))
         {
-            (*canvas_)(cx + x, cy + y) = brush;
+            PutPixel(cx + x, cy + y, brush);
         }
         if (canvas_->InBounds(cx - x, cy + y))
         {
-            (*canvas_)(cx - x, cy + y) = brush;
+            PutPixel(cx - x, cy + y, brush);
         }
         if (canvas_->InBounds(cx + x, cy - y))
         {
-            (*canvas_)(cx + x, cy - y) = brush;
+            PutPixel(cx + x, cy - y, brush);
         }
         if (canvas_->InBounds(cx - x, cy - y))
         {
-            (*canvas_)(cx - x, cy - y) = brush;
+            PutPixel(cx - x, cy - y, brush);
         }
         if (canvas_->InBounds(cx + y, cy + x))
         {
-            (*canvas_)(cx + y, cy + x) = brush;
+            PutPixel(cx + y, cy + x, brush);
         }
         if (canvas_->InBounds(cx - y, cy + x))
         {
-            (*canvas_)(cx - y, cy + x) = brush;
+            PutPixel(cx - y, cy + x, brush);
         }
         if (canvas_->InBounds(cx + y, cy - x))
         {
-            (*canvas_)(cx + y, cy - x) = brush;
+            PutPixel(cx + y, cy - x, brush);
         }
         if (canvas_->InBounds(cx - y, cy - x))
         {
-            (*canvas_)(cx - y, cy - x) = brush;
+            PutPixel(cx - y, cy - x, brush);
         }
     };
 
@@ -320,7 +788,7 @@ void Plotter::DrawCircleBresenham(const int center_x, const int center_y, const
     }
 }
 
-void Plotter::FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const char brush) const
+void Plotter::FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const char brush)
 {
     const int min_x = std::min({ x1, x2, x3 });
     const int max_x = std::max({ x1, x2, x3 });
@@ -348,7 +816,7 @@ void Plotter::FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const
 
             if (inside)
             {
-                (*canvas_)(x, y) = brush;
+                PutPixel(x, y, brush);
             }
         }
     }
@@ -356,12 +824,17 @@ void Plotter::FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const
 
 void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
 {
+    PLOTTER_PROFILE_SCOPE("Plotter::ScanlineFill");
+    CheckBrush(fill_brush);
+    BeforeCanvasWrite();
+    const Canvas& source = *canvas_;
+
     if (!canvas_->InBounds(x, y))
     {
         return;
     }
 
-    const char target_brush = (*canvas_)(x, y);
+    const char target_brush = source(x, y);
     if (target_brush == fill_brush)
     {
         return;
@@ -374,14 +847,14 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
     int x_end = x;
 
     // Идем влево
-    while (x_start >= 0 && canvas_->at(x_start, y) == target_brush)
+    while (x_start >= 0 && source.at(x_start, y) == target_brush)
     {
         x_start--;
     }
     x_start++;
 
     // Идем вправо
-    while (x_end < canvas_->Width() && canvas_->at(x_end, y) == target_brush)
+    while (x_end < canvas_->Width() && source.at(x_end, y) == target_brush)
     {
         x_end++;
     }
@@ -390,8 +863,9 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
     // Закрашиваем начальный отрезок
     for (int i = x_start; i <= x_end; i++)
     {
-        canvas_->at(i, y) = fill_brush;
+        PutPixel(i, y, fill_brush);
     }
+    PLOTTER_PROFILE_COUNT("spans_emitted", 1);
 
     // Добавляем сегменты сверху и снизу
     if (y > 0)
@@ -405,6 +879,7 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
 
     while (!segments.empty())
     {
+        PLOTTER_PROFILE_MAX("scanline_fill.stack_high_water", segments.size());
         const auto [y, x_start, x_end] = segments.top();
         segments.pop();
 
@@ -414,7 +889,7 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
         while (current_x <= x_end)
         {
             // Пропускаем уже закрашенные или неподходящие пиксели
-            if (canvas_->at(current_x, current_y) != target_brush)
+            if (source.at(current_x, current_y) != target_brush)
             {
                 current_x++;
                 continue;
@@ -422,14 +897,14 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
 
             // Находим начало нового отрезка
             int new_x_start = current_x;
-            while (new_x_start > 0 && canvas_->at(new_x_start - 1, current_y) == target_brush)
+            while (new_x_start > 0 && source.at(new_x_start - 1, current_y) == target_brush)
             {
                 new_x_start--;
             }
 
             // Находим конец отрезка
             int new_x_end = current_x;
-            while (new_x_end < canvas_->Width() - 1 && canvas_->at(new_x_end + 1, current_y) == target_brush)
+            while (new_x_end < canvas_->Width() - 1 && source.at(new_x_end + 1, current_y) == target_brush)
             {
                 new_x_end++;
             }
@@ -437,8 +912,9 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
             // Закрашиваем отрезок
             for (int i = new_x_start; i <= new_x_end; i++)
             {
-                canvas_->at(i, current_y) = fill_brush;
+                PutPixel(i, current_y, fill_brush);
             }
+            PLOTTER_PROFILE_COUNT("spans_emitted", 1);
 
             // Проверяем соседние строки на наличие новых сегментов
             if (current_y > 0)
@@ -448,10 +924,10 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
                 int above_x = new_x_start;
                 while (above_x <= new_x_end)
                 {
-                    if (canvas_->at(above_x, above_y) == target_brush)
+                    if (source.at(above_x, above_y) == target_brush)
                     {
                         int above_start = above_x;
-                        while (above_x <= new_x_end && canvas_->at(above_x, above_y) == target_brush)
+                        while (above_x <= new_x_end && source.at(above_x, above_y) == target_brush)
                         {
                             above_x++;
                         }
@@ -471,10 +947,10 @@ void Plotter::ScanlineFill(const int x, const int y, const char fill_brush)
                 int below_x = new_x_start;
                 while (below_x <= new_x_end)
                 {
-                    if (canvas_->at(below_x, below_y) == target_brush)
+                    if (source.at(below_x, below_y) == target_brush)
                     {
                         int below_start = below_x;
-                        while (below_x <= new_x_end && canvas_->at(below_x, below_y) == target_brush)
+                        while (below_x <= new_x_end && source.at(below_x, below_y) == target_brush)
                         {
                             below_x++;
                         }
@@ -1,6 +1,12 @@
 #pragma once
+#include "AffineTransform.hpp"
 #include "Canvas.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
 
 namespace plotter
@@ -21,6 +27,8 @@ public:
     // Нужен виртуальный деструктор для вызова в производном классе
     virtual ~Plotter() = default;
 
+    // Кисть не может быть нулевым символом: он размечает пиксели во время рисования.
+    // Для нулевой кисти методы рисования бросают std::invalid_argument
     void DrawLine(int x1, int y1, int x2, int y2, char brush);
     void DrawRectangle(int x1, int y1, int x2, int y2, char brush, bool fill = false);
     void DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, char brush, bool fill = false);
@@ -29,27 +37,132 @@ public:
     void FloodFill(int x, int y, char fill_brush);
     void ScanlineFill(int x, int y, char fill_brush);
 
+    // Цветные варианты: символы рисуются с цветами colors, слой цветов канваса включается при первом вызове.
+    // Заливка тем же символом меняет цвета области
+    void DrawLine(int x1, int y1, int x2, int y2, char brush, const CellColors& colors);
+    void DrawRectangle(int x1, int y1, int x2, int y2, char brush, const CellColors& colors, bool fill = false);
+    void DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, char brush, const CellColors& colors,
+        bool fill = false);
+    void DrawCircle(int center_x, int center_y, int radius, char brush, const CellColors& colors, bool fill = false);
+    void FloodFill(int x, int y, char fill_brush, const CellColors& colors);
+    void ScanlineFill(int x, int y, char fill_brush, const CellColors& colors);
+
     [[nodiscard]] std::unordered_map<char, int> ColorHistogram() const;
     [[nodiscard]] std::unordered_map<char, int> ColorHistogram(int x1, int y1, int x2, int y2) const;
     // Заменил на структуру также как в GrayscalePlotter
     [[nodiscard]] static ColorExtrema GetMinMaxColors(const std::unordered_map<char, int>& color_weights);
 
+    // Вместе с символами переносятся цвета, если их слой включен в источнике
     [[nodiscard]] std::unique_ptr<Canvas> ExtractRegion(int x1, int y1, int x2, int y2) const;
     void PasteRegion(const Canvas& region, int x, int y);
+    // Переносит source в канвас преобразованием transform из координат source в координаты канваса.
+    // Каждый пиксель канваса берет символ пикселя source, в который обратное преобразование переводит
+    // его центр, и его цвета, если слой цветов source включен.
+    // Пиксели вне образа source не меняются, символ transparent из source не переносится.
+    // Бросает std::invalid_argument для вырожденного transform
+    void TransformRegion(const Canvas& source, const AffineTransform& transform,
+        std::optional<char> transparent = std::nullopt);
+
+    // Канвас другого размера с тем же рисунком: каждый пиксель берет символ и цвета ближайшего пикселя.
+    // Таблицы исходных строк и столбцов строятся один раз, строки результата заполняются полосами
+    [[nodiscard]] std::unique_ptr<Canvas> Resize(int width, int height) const;
+    // То же в готовый канвас target, например из пула: размер результата — размер target.
+    // Слой цветов target включается или выключается как у канваса
+    void ResizeInto(Canvas& target) const;
 
-    [[nodiscard]] const Canvas& GetCanvas() const noexcept { return *canvas_; }
-    Canvas& GetCanvas() noexcept { return *canvas_; }
+    [[nodiscard]] const Canvas& GetCanvas() const { BeforeCanvasRead(); return *canvas_; }
+    Canvas& GetCanvas() { BeforeCanvasWrite(); return *canvas_; }
 
-    void Render(std::ostream& os = std::cout) const { canvas_->Render(os); }
-    void SaveToFile(const std::filesystem::path& filepath) const { canvas_->SaveToFile(filepath); }
+    void Render(std::ostream& os = std::cout) const { GetCanvas().Render(os); }
+    void SaveToFile(const std::filesystem::path& filepath) const { GetCanvas().SaveToFile(filepath); }
     void SaveToFile(const std::string& filename) const { SaveToFile(std::filesystem::path(filename)); }
 
+    // Счетчики символов канваса для ColorHistogram и статистики яркости, см. Canvas::EnableStatistics
+    void EnableStatistics() { canvas_->EnableStatistics(); }
+    void DisableStatistics() noexcept { canvas_->DisableStatistics(); }
+    [[nodiscard]] bool HasStatistics() const noexcept { return canvas_->HasStatistics(); }
+
+    // Число потоков для обработки канваса. 1 — последовательное выполнение
+    void SetThreadCount(int thread_count);
+    [[nodiscard]] int GetThreadCount() const noexcept;
+
+protected:
+    // Производный класс может хранить изображение в своем виде и обновлять символы канваса лениво.
+    // Вызывается перед чтением символов канваса: устаревшие символы обновляет SyncCanvas под sync_mutex_,
+    // поэтому одновременные константные чтения обновляют их один раз
+    void BeforeCanvasRead() const;
+    // Вызывается перед изменением символов канваса в обход производного класса
+    virtual void BeforeCanvasWrite() {}
+    // Символы канваса отстают от изображения производного класса
+    [[nodiscard]] virtual bool CanvasIsStale() const noexcept { return false; }
+    // Обновляет символы canvas. Единственный изменяемый доступ к канвасу из константных методов:
+    // вызывается только из BeforeCanvasRead под sync_mutex_
+    virtual void SyncCanvas(Canvas& canvas) const;
+
+    // Доступ к канвасу без вызова BeforeCanvasRead/BeforeCanvasWrite
+    Canvas& RawCanvas() noexcept { return *canvas_; }
+    [[nodiscard]] const Canvas& RawCanvas() const noexcept { return *canvas_; }
+
+    // Символ разметки пикселей примитива. Кисти, палитры и фон не бывают нулевыми,
+    // поэтому в рисунке он встречается только внутри DrawMarker
+    static constexpr char MARKER = '\0';
+    // Вызывает draw(MARKER), методы рисования на это время принимают нулевую кисть
+    void DrawMarker(const std::function<void(char)>& draw);
+
+    // Полоса строк канваса [begin, end)
+    struct RowBand
+    {
+        int begin;
+        int end;
+    };
+
+    // Делит строки [0, rows) на непрерывные полосы и обрабатывает их в пуле потоков.
+    // Возвращает управление после обработки всех полос.
+    void ForEachRowBand(int rows, const std::function<void(RowBand)>& body) const;
+
+    // Участок [x_begin, x_end) строки y канваса, центры пикселей которого обратное преобразование
+    // переводит внутрь source. u, v — координаты в source центра первого пикселя, du, dv — их шаг
+    // на пиксель, все в фиксированной точке с FRACTION_BITS дробными битами. Координаты всех пикселей
+    // участка лежат внутри source
+    struct TransformSpan
+    {
+        static constexpr int FRACTION_BITS = 32;
+
+        int y;
+        int x_begin;
+        int x_end;
+        std::int64_t u;
+        std::int64_t v;
+        std::int64_t du;
+        std::int64_t dv;
+    };
+
+    // Обходит полосами строки канваса, которые задевает образ source размера source_width x source_height.
+    // Участок строки отсекается по канвасу и по source до обхода, пустые участки пропускаются
+    void ForEachTransformSpan(int source_width, int source_height, const AffineTransform& transform,
+        const std::function<void(const TransformSpan&)>& body) const;
+
 private:
     std::unique_ptr<Canvas> canvas_;
+    // nullptr — последовательное выполнение
+    std::unique_ptr<ThreadPool> thread_pool_;
+    // Цвета, которыми пишутся пиксели в цветных вариантах рисования
+    std::optional<CellColors> pen_;
+    // Идет рисование маркером, см. DrawMarker
+    bool drawing_marker_ = false;
+    // Сериализует SyncCanvas из константных чтений
+    mutable std::mutex sync_mutex_;
+
+    // Пишет символ пикселя и цвета pen_, если они заданы
+    void PutPixel(int x, int y, char brush);
+    // Бросает std::invalid_argument для нулевой кисти вне DrawMarker
+    void CheckBrush(char brush) const;
+    // Рисует draw с цветами colors
+    void DrawWithColors(const CellColors& colors, const std::function<void()>& draw);
 
     void DrawLineBresenham(int x1, int y1, int x2, int y2, char brush);
     void DrawCircleBresenham(int center_x, int center_y, int radius, char brush);
-    void FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, char brush) const;
+    void FillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, char brush);
 
     struct ScanlineSegment
     {
@@ -0,0 +1,397 @@
+#include "Benchmark.hpp"
+#include "Regression.hpp"
+#include "Profiling.hpp"
+#include "GrayscalePlotter.hpp"
+#include "Plotter.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Микробенчмарки примитивов, заливок, гистограмм, фильтров и вывода канваса.
+// Каждый бенчмарк прогоняется на нескольких размерах канваса и параметрах, отчет — JSON в stdout
+// или в файл --output, ход выполнения печатается в stderr.
+//
+//   PlotterBench [--output file.json] [--filter text] [--samples N] [--quick] [--profile]
+//                [--baseline file.json [--threshold percent] [--alpha p]]
+//
+// --filter оставляет бенчмарки, в id которых есть text, --quick сокращает прогрев и число замеров.
+// С --baseline результаты сравниваются с сохраненным отчетом критерием Манна — Уитни, таблица изменений
+// печатается в stdout, а код возврата 1 означает значимое замедление больше threshold процентов.
+// --profile печатает в stderr таймеры и счетчики за весь прогон, нужна сборка с PLOTTER_PROFILE
+
+using namespace plotter;
+
+namespace
+{
+    struct CanvasSize
+    {
+        int width;
+        int height;
+    };
+
+    constexpr std::array<CanvasSize, 3> SIZES{ { { 80, 24 }, { 320, 100 }, { 1280, 400 } } };
+    constexpr std::array<int, 2> THREADS{ 1, 4 };
+
+    bench::Params SizeParams(const CanvasSize& size)
+    {
+        return { { "width", std::to_string(size.width) }, { "height", std::to_string(size.height) } };
+    }
+
+    bench::Params With(bench::Params params, const std::string& key, const std::string& value)
+    {
+        params.emplace_back(key, value);
+        return params;
+    }
+
+    // Бенчмарк рисования на plotter типа PlotterType. Объем работы итерации — число пикселей,
+    // которые draw записывает в канвас: они считаются на канвасе с фоном, которого нет ни в кистях,
+    // ни в палитре. odd чередуется, чтобы каждая итерация меняла пиксели
+    template <typename PlotterType, typename Draw>
+    void RunDraw(bench::BenchmarkSuite& suite, const CanvasSize& size, const std::string& name,
+        const bench::Params& params, Draw draw)
+    {
+        constexpr char unused = '`';
+        PlotterType counter(size.width, size.height, unused);
+        draw(counter, false);
+        const Canvas& canvas = std::as_const(counter).GetCanvas();
+        const auto pixels = static_cast<double>(std::count_if(canvas.Data(), canvas.Data() + canvas.Size(),
+            [](const char symbol) { return symbol != unused; }));
+
+        PlotterType plotter(size.width, size.height, ' ');
+        bool odd = false;
+        suite.Run(name, params, "pixels", pixels,
+            [&]()
+            {
+                odd = !odd;
+                draw(plotter, odd);
+            });
+    }
+
+    // Исходное изображение фильтров: градиент с фигурами разной яркости
+    std::unique_ptr<GrayscalePlotter> MakeImage(const CanvasSize& size)
+    {
+        const int w = size.width;
+        const int h = size.height;
+        auto plotter = std::make_unique<GrayscalePlotter>(w, h, ' ');
+        plotter->DrawLinearGradient(0, 0, w - 1, h - 1, 0.1, 0.8, Dither::Ordered);
+        plotter->DrawRectangle(w / 8, h / 8, w / 2, h / 2, 0.9, true);
+        plotter->DrawCircle(2 * w / 3, h / 2, h / 3, 0.2, true, Dither::Ordered);
+        plotter->DrawTriangle(0, h - 1, w / 3, h / 2, w / 2, h - 1, 0.6, true);
+        return plotter;
+    }
+
+    void BenchPrimitives(bench::BenchmarkSuite& suite)
+    {
+        for (const CanvasSize& size : SIZES)
+        {
+            const int w = size.width;
+            const int h = size.height;
+            const bench::Params params = SizeParams(size);
+            RunDraw<Plotter>(suite, size, "line", With(params, "paint", "brush"),
+                [w, h](Plotter& p, bool odd) { p.DrawLine(0, 0, w - 1, h - 1, odd ? '#' : '*'); });
+            RunDraw<GrayscalePlotter>(suite, size, "line", With(params, "paint", "brightness"),
+                [w, h](GrayscalePlotter& p, bool odd) { p.DrawLine(0, 0, w - 1, h - 1, odd ? 0.9 : 0.5); });
+            RunDraw<Plotter>(suite, size, "rect", With(params, "fill", "false"),
+                [w, h](Plotter& p, bool odd) { p.DrawRectangle(1, 1, w - 2, h - 2, odd ? '#' : '*'); });
+            RunDraw<Plotter>(suite, size, "rect", With(params, "fill", "true"),
+                [w, h](Plotter& p, bool odd) { p.DrawRectangle(1, 1, w - 2, h - 2, odd ? '#' : '*', true); });
+            RunDraw<Plotter>(suite, size, "circle", With(params, "fill", "false"),
+                [w, h](Plotter& p, bool odd) { p.DrawCircle(w / 2, h / 2, h / 2 - 1, odd ? '#' : '*'); });
+            RunDraw<Plotter>(suite, size, "circle", With(params, "fill", "true"),
+                [w, h](Plotter& p, bool odd) { p.DrawCircle(w / 2, h / 2, h / 2 - 1, odd ? '#' : '*', true); });
+            RunDraw<Plotter>(suite, size, "triangle", With(params, "fill", "true"),
+                [w, h](Plotter& p, bool odd)
+                { p.DrawTriangle(0, h - 1, w - 1, h - 1, w / 2, 0, odd ? '#' : '*', true); });
+            for (const auto& [dither, dither_name] : { std::pair{ Dither::None, "none" }, std::pair{ Dither::Ordered, "ordered" },
+                     std::pair{ Dither::FloydSteinberg, "floyd_steinberg" } })
+            {
+                RunDraw<GrayscalePlotter>(suite, size, "rect_brightness", With(params, "dither", dither_name),
+                    [w, h, dither](GrayscalePlotter& p, bool odd)
+                    { p.DrawRectangle(1, 1, w - 2, h - 2, odd ? 0.7 : 0.3, true, dither); });
+                RunDraw<GrayscalePlotter>(suite, size, "linear_gradient", With(params, "dither", dither_name),
+                    [w, h, dither](GrayscalePlotter& p, bool odd)
+                    { p.DrawLinearGradient(0, 0, w - 1, h - 1, odd ? 0.0 : 0.2, 1.0, dither); });
+            }
+            RunDraw<GrayscalePlotter>(suite, size, "radial_gradient", params,
+                [w, h](GrayscalePlotter& p, bool odd) { p.DrawRadialGradient(w / 2, h / 2, w / 2, odd ? 1.0 : 0.8, 0.0); });
+        }
+    }
+
+    void BenchFills(bench::BenchmarkSuite& suite)
+    {
+        for (const CanvasSize& size : SIZES)
+        {
+            const int w = size.width;
+            const int h = size.height;
+            for (const std::string_view layout : { "open", "maze" })
+            {
+                Plotter plotter(w, h, ' ');
+                if (layout == "maze")
+                {
+                    // Вертикальные стенки с проходами поочередно сверху и снизу: заливка идет змейкой
+                    for (int x = 2; x < w - 1; x += 3)
+                    {
+                        const bool gap_on_top = (x / 3) % 2 == 0;
+                        plotter.DrawLine(x, gap_on_top ? 1 : 0, x, gap_on_top ? h - 1 : h - 2, '|');
+                    }
+                }
+                const Canvas& canvas = std::as_const(plotter).GetCanvas();
+                const double pixels = static_cast<double>(std::count(canvas.Data(), canvas.Data() + canvas.Size(), ' '));
+
+                const bench::Params params = With(SizeParams(size), "layout", std::string(layout));
+                int iteration = 0;
+                suite.Run("flood_fill", params, "pixels", pixels,
+                    [&]() { plotter.FloodFill(0, 0, ++iteration & 1 ? '.' : ' '); });
+                iteration = 0;
+                suite.Run("scanline_fill", params, "pixels", pixels,
+                    [&]() { plotter.ScanlineFill(0, 0, ++iteration & 1 ? '.' : ' '); });
+            }
+        }
+    }
+
+    void BenchHistograms(bench::BenchmarkSuite& suite)
+    {
+        for (const CanvasSize& size : SIZES)
+        {
+            const auto image = MakeImage(size);
+            GrayscalePlotter& plotter = *image;
+            const double pixels = static_cast<double>(size.width) * size.height;
+            for (const bool statistics : { false, true })
+            {
+                if (statistics)
+                {
+                    plotter.EnableStatistics();
+                }
+                const bench::Params params = With(SizeParams(size), "statistics", statistics ? "true" : "false");
+                suite.Run("color_histogram", params, "pixels", pixels,
+                    [&plotter]() { bench::DoNotOptimize(plotter.ColorHistogram()); });
+                suite.Run("average_brightness", params, "pixels", pixels,
+                    [&plotter]() { bench::DoNotOptimize(plotter.CalculateAverageBrightness()); });
+            }
+        }
+    }
+
+    void BenchFilters(bench::BenchmarkSuite& suite)
+    {
+        struct Filter
+        {
+            std::string name;
+            std::string param;
+            std::function<void(GrayscalePlotter&)> apply;
+        };
+        const std::vector<Filter> filters{
+            { "box_blur", "size=3", [](GrayscalePlotter& p) { p.ApplyBoxBlur(3); } },
+            { "box_blur", "size=7", [](GrayscalePlotter& p) { p.ApplyBoxBlur(7); } },
+            { "gaussian_blur", "size=3", [](GrayscalePlotter& p) { p.ApplyGaussianBlur(3); } },
+            { "gaussian_blur", "size=7", [](GrayscalePlotter& p) { p.ApplyGaussianBlur(7); } },
+            { "median", "radius=1", [](GrayscalePlotter& p) { p.ApplyMedianFilter(1); } },
+            { "median", "radius=3", [](GrayscalePlotter& p) { p.ApplyMedianFilter(3); } },
+            { "erosion", "radius=2", [](GrayscalePlotter& p) { p.ApplyErosion(2); } },
+            { "opening", "radius=2", [](GrayscalePlotter& p) { p.ApplyOpening(2); } },
+            { "threshold", "", [](GrayscalePlotter& p) { p.ApplyThreshold(0.5); } },
+            { "invert", "", [](GrayscalePlotter& p) { p.InvertBrightness(); } },
+            { "brightness", "", [](GrayscalePlotter& p) { p.AdjustBrightness(1.2); } },
+            { "edges", "", [](GrayscalePlotter& p) { p.DetectEdges(0.25); } },
+            { "equalize", "", [](GrayscalePlotter& p) { p.EqualizeHistogram(); } },
+            { "auto_contrast", "", [](GrayscalePlotter& p) { p.AutoContrast(1.0); } },
+            { "equalize_local", "", [](GrayscalePlotter& p) { p.EqualizeHistogramLocal(); } },
+        };
+
+        for (const CanvasSize& size : SIZES)
+        {
+            const auto image = MakeImage(size);
+            const Canvas& source = std::as_const(*image).GetCanvas();
+            const double pixels = static_cast<double>(size.width) * size.height;
+            for (const int threads : THREADS)
+            {
+                const auto target = MakeImage(size);
+                GrayscalePlotter& plotter = *target;
+                plotter.SetThreadCount(threads);
+                for (const Filter& filter : filters)
+                {
+                    bench::Params params = With(SizeParams(size), "threads", std::to_string(threads));
+                    if (!filter.param.empty())
+                    {
+                        const size_t split = filter.param.find('=');
+                        params.emplace_back(filter.param.substr(0, split), filter.param.substr(split + 1));
+                    }
+                    // Фильтр каждый раз применяется к исходному изображению: копирование канваса входит в замер
+                    suite.Run(filter.name, params, "pixels", pixels,
+                        [&]()
+                        {
+                            plotter.GetCanvas() = source;
+                            filter.apply(plotter);
+                        });
+                }
+            }
+        }
+    }
+
+    void BenchOutput(bench::BenchmarkSuite& suite)
+    {
+        const std::filesystem::path frame_path = std::filesystem::temp_directory_path() / "plotter_bench_frame.txt";
+        for (const CanvasSize& size : SIZES)
+        {
+            const auto image = MakeImage(size);
+            const GrayscalePlotter& plotter = *image;
+            std::ostringstream frame;
+            plotter.Render(frame);
+            const auto bytes = static_cast<double>(frame.str().size());
+
+            suite.Run("render", SizeParams(size), "bytes", bytes,
+                [&]()
+                {
+                    frame.str(std::string());
+                    plotter.Render(frame);
+                });
+            suite.Run("save_to_file", SizeParams(size), "bytes", bytes, [&]() { plotter.SaveToFile(frame_path); });
+        }
+        std::filesystem::remove(frame_path);
+    }
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    bench::BenchmarkOptions options;
+    bench::RegressionOptions regression;
+    std::string output_path;
+    std::string baseline_path;
+    std::string filter;
+    bool profile = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--output" && has_value)
+        {
+            output_path = argv[++i];
+        }
+        else if (arg == "--filter" && has_value)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--samples" && has_value)
+        {
+            options.samples = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--baseline" && has_value)
+        {
+            baseline_path = argv[++i];
+        }
+        else if (arg == "--threshold" && has_value)
+        {
+            regression.threshold = std::atof(argv[++i]) / 100.0;
+        }
+        else if (arg == "--alpha" && has_value)
+        {
+            regression.alpha = std::atof(argv[++i]);
+        }
+        else if (arg == "--quick")
+        {
+            options.warmup_time = std::chrono::milliseconds(5);
+            options.samples = 5;
+            options.min_sample_time = std::chrono::milliseconds(1);
+        }
+        else if (arg == "--profile")
+        {
+            profile = true;
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--output file.json] [--filter text] [--samples N] [--quick] [--profile]"
+                      << " [--baseline file.json [--threshold percent] [--alpha p]]\n";
+            return 2;
+        }
+    }
+
+    // Базовый отчет читается до замеров, чтобы ошибка в нем не стоила целого прогона
+    std::vector<bench::BenchmarkResult> baseline;
+    if (!baseline_path.empty())
+    {
+        try
+        {
+            baseline = bench::LoadResults(baseline_path);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to load baseline " << baseline_path << ": " << e.what() << '\n';
+            return 2;
+        }
+        // Бенчмарки, отброшенные фильтром, не считаются пропавшими
+        std::erase_if(baseline, [&filter](const bench::BenchmarkResult& result)
+            { return result.Id().find(filter) == std::string::npos; });
+
+        // С малым числом замеров критерий не достигает alpha, и проверка не нашла бы ни одного замедления
+        for (const bench::BenchmarkResult& result : baseline)
+        {
+            const double minimum = bench::MinimumPValue(static_cast<size_t>(options.samples), result.samples_ns.size());
+            if (minimum >= regression.alpha)
+            {
+                std::cerr << "Can't detect regressions: with " << options.samples << " samples against "
+                          << result.samples_ns.size() << " baseline samples of " << result.Id()
+                          << " the smallest possible p is " << minimum << ", not below --alpha " << regression.alpha
+                          << ". Increase --samples or --alpha\n";
+                return 2;
+            }
+        }
+    }
+
+    profiling::Reset();
+    bench::BenchmarkSuite suite("PlotterBench", options);
+    suite.SetFilter(filter);
+    suite.SetProgress(&std::cerr);
+
+    BenchPrimitives(suite);
+    BenchFills(suite);
+    BenchHistograms(suite);
+    BenchFilters(suite);
+    BenchOutput(suite);
+
+    if (profile)
+    {
+        if constexpr (profiling::ENABLED)
+        {
+            profiling::PrintSnapshot(std::cerr, profiling::TakeSnapshot());
+        }
+        else
+        {
+            std::cerr << "Profiling is disabled, rebuild with -DPLOTTER_PROFILE=ON\n";
+        }
+    }
+
+    if (!output_path.empty())
+    {
+        std::ofstream output(output_path, std::ios::out | std::ios::trunc);
+        suite.WriteJson(output);
+        if (!output)
+        {
+            std::cerr << "Failed to write " << output_path << '\n';
+            return 1;
+        }
+        std::cerr << "Results saved to " << output_path << '\n';
+    }
+    else if (baseline_path.empty())
+    {
+        suite.WriteJson(std::cout);
+    }
+
+    if (!baseline_path.empty())
+    {
+        const auto comparisons = bench::CompareResults(baseline, suite.Results(), regression);
+        bench::PrintDeltaTable(std::cout, comparisons);
+        if (bench::HasRegressions(comparisons))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
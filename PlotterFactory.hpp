@@ -12,14 +12,18 @@ class PlotterFactory
 public:
     static std::unique_ptr<Plotter> CreatePlotter(const PlotterConfig& config)
     {
+        std::unique_ptr<Plotter> plotter;
         if (config.plotter_type == "grayscale")
         {
-            return std::make_unique<GrayscalePlotter>(config.width, config.height, config.background_char, config.palette);
+            plotter = std::make_unique<GrayscalePlotter>(config.width, config.height, config.background_char, config.palette);
         }
         else
         {
-            return std::make_unique<Plotter>(config.width, config.height, config.background_char);
+            plotter = std::make_unique<Plotter>(config.width, config.height, config.background_char);
         }
+
+        plotter->SetThreadCount(config.threads);
+        return plotter;
     }
 };
 
@@ -0,0 +1,264 @@
+#include "Profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace plotter::profiling
+{
+
+namespace
+{
+    // Значения зонда в одном потоке. Пишет только поток-владелец: обычные load и store без
+    // read-modify-write дешевле fetch_add, а atomic нужен, чтобы TakeSnapshot читал без гонки
+    struct Slot
+    {
+        std::atomic<std::uint64_t> count{ 0 };
+        std::atomic<std::uint64_t> total{ 0 };
+        std::atomic<std::uint64_t> max{ 0 };
+    };
+
+    using ThreadSlots = std::array<Slot, MAX_PROBES>;
+
+    void Increase(std::atomic<std::uint64_t>& value, const std::uint64_t delta) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    void Raise(std::atomic<std::uint64_t>& value, const std::uint64_t candidate) noexcept
+    {
+        if (candidate > value.load(std::memory_order_relaxed))
+        {
+            value.store(candidate, std::memory_order_relaxed);
+        }
+    }
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::pair<std::string, ProbeKind>> probes;
+        std::unordered_map<std::string, ProbeId> ids;
+        std::vector<ThreadSlots*> threads;
+        // Значения завершившихся потоков, их пишут под mutex
+        ThreadSlots retired;
+    };
+
+    // Реестр не разрушается: деструкторы thread_local могут выполняться после статических объектов
+    Registry& GetRegistry()
+    {
+        static Registry* const registry = new Registry;
+        return *registry;
+    }
+
+    // Отдает значения потока в retired при его завершении
+    class ThreadHandle
+    {
+    public:
+        ThreadHandle()
+        {
+            Registry& registry = GetRegistry();
+            const std::lock_guard lock(registry.mutex);
+            registry.threads.push_back(&slots_);
+        }
+
+        ~ThreadHandle()
+        {
+            Registry& registry = GetRegistry();
+            const std::lock_guard lock(registry.mutex);
+            for (size_t i = 0; i < MAX_PROBES; ++i)
+            {
+                Increase(registry.retired[i].count, slots_[i].count.load(std::memory_order_relaxed));
+                Increase(registry.retired[i].total, slots_[i].total.load(std::memory_order_relaxed));
+                Raise(registry.retired[i].max, slots_[i].max.load(std::memory_order_relaxed));
+            }
+            std::erase(registry.threads, &slots_);
+        }
+
+        ThreadHandle(const ThreadHandle&) = delete;
+        ThreadHandle& operator=(const ThreadHandle&) = delete;
+
+        ThreadSlots& Slots() noexcept { return slots_; }
+
+    private:
+        ThreadSlots slots_;
+    };
+
+    Slot* LocalSlot(const ProbeId probe) noexcept
+    {
+        if (probe >= MAX_PROBES)
+        {
+            return nullptr;
+        }
+        thread_local ThreadHandle handle;
+        return &handle.Slots()[probe];
+    }
+} // anonymous namespace
+
+ProbeId RegisterProbe(const std::string_view name, const ProbeKind kind)
+{
+    Registry& registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+    // Вид входит в ключ, чтобы одно имя могло быть и таймером, и счетчиком
+    std::string key(name);
+    key += static_cast<char>('0' + static_cast<int>(kind));
+    const auto [it, inserted] = registry.ids.try_emplace(std::move(key), static_cast<ProbeId>(registry.probes.size()));
+    if (inserted)
+    {
+        registry.probes.emplace_back(std::string(name), kind);
+    }
+    return it->second;
+}
+
+void RecordTime(const ProbeId probe, const std::uint64_t nanoseconds) noexcept
+{
+    if (Slot* const slot = LocalSlot(probe))
+    {
+        Increase(slot->count, 1);
+        Increase(slot->total, nanoseconds);
+        Raise(slot->max, nanoseconds);
+    }
+}
+
+void AddCount(const ProbeId probe, const std::uint64_t value) noexcept
+{
+    if (Slot* const slot = LocalSlot(probe))
+    {
+        Increase(slot->count, 1);
+        Increase(slot->total, value);
+    }
+}
+
+void UpdateMaximum(const ProbeId probe, const std::uint64_t value) noexcept
+{
+    if (Slot* const slot = LocalSlot(probe))
+    {
+        Increase(slot->count, 1);
+        Raise(slot->max, value);
+    }
+}
+
+Snapshot TakeSnapshot()
+{
+    Registry& registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+
+    Snapshot snapshot;
+    const size_t probes = std::min(registry.probes.size(), MAX_PROBES);
+    for (size_t i = 0; i < probes; ++i)
+    {
+        TimerStats stats;
+        const auto merge = [&stats, i](const ThreadSlots& slots)
+        {
+            stats.calls += slots[i].count.load(std::memory_order_relaxed);
+            stats.total_ns += slots[i].total.load(std::memory_order_relaxed);
+            stats.max_ns = std::max(stats.max_ns, slots[i].max.load(std::memory_order_relaxed));
+        };
+        merge(registry.retired);
+        for (const ThreadSlots* const slots : registry.threads)
+        {
+            merge(*slots);
+        }
+        // Зонд, который ни разу не сработал после Reset, в снимок не попадает
+        if (stats.calls == 0)
+        {
+            continue;
+        }
+
+        const auto& [name, kind] = registry.probes[i];
+        switch (kind)
+        {
+        case ProbeKind::Timer:
+            snapshot.timers[name] = stats;
+            break;
+        case ProbeKind::Counter:
+            snapshot.counters[name] = stats.total_ns;
+            break;
+        case ProbeKind::Maximum:
+            snapshot.maxima[name] = stats.max_ns;
+            break;
+        }
+    }
+    return snapshot;
+}
+
+void Reset()
+{
+    Registry& registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+    const auto clear = [](ThreadSlots& slots)
+    {
+        for (Slot& slot : slots)
+        {
+            slot.count.store(0, std::memory_order_relaxed);
+            slot.total.store(0, std::memory_order_relaxed);
+            slot.max.store(0, std::memory_order_relaxed);
+        }
+    };
+    clear(registry.retired);
+    for (ThreadSlots* const slots : registry.threads)
+    {
+        clear(*slots);
+    }
+}
+
+void PrintSnapshot(std::ostream& os, const Snapshot& snapshot)
+{
+    std::vector<std::pair<std::string, TimerStats>> timers(snapshot.timers.begin(), snapshot.timers.end());
+    std::stable_sort(timers.begin(), timers.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.second.total_ns > rhs.second.total_ns; });
+
+    size_t name_width = std::string_view("counter").size();
+    for (const auto& [name, stats] : snapshot.timers)
+    {
+        name_width = std::max(name_width, name.size());
+    }
+    for (const auto& [name, value] : snapshot.counters)
+    {
+        name_width = std::max(name_width, name.size());
+    }
+    for (const auto& [name, value] : snapshot.maxima)
+    {
+        name_width = std::max(name_width, name.size());
+    }
+    const auto width = static_cast<int>(name_width);
+
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    if (!timers.empty())
+    {
+        os << std::left << std::setw(width) << "timer" << std::right << std::setw(12) << "calls" << std::setw(14)
+           << "total ms" << std::setw(12) << "mean us" << std::setw(12) << "max us" << '\n';
+        for (const auto& [name, stats] : timers)
+        {
+            os << std::left << std::setw(width) << name << std::right << std::setw(12) << stats.calls << std::setw(14)
+               << static_cast<double>(stats.total_ns) / 1e6 << std::setw(12)
+               << static_cast<double>(stats.total_ns) / 1e3 / static_cast<double>(stats.calls) << std::setw(12)
+               << static_cast<double>(stats.max_ns) / 1e3 << '\n';
+        }
+    }
+    if (!snapshot.counters.empty())
+    {
+        os << std::left << std::setw(width) << "counter" << std::right << std::setw(12) << "total" << '\n';
+        for (const auto& [name, value] : snapshot.counters)
+        {
+            os << std::left << std::setw(width) << name << std::right << std::setw(12) << value << '\n';
+        }
+    }
+    if (!snapshot.maxima.empty())
+    {
+        os << std::left << std::setw(width) << "maximum" << std::right << std::setw(12) << "value" << '\n';
+        for (const auto& [name, value] : snapshot.maxima)
+        {
+            os << std::left << std::setw(width) << name << std::right << std::setw(12) << value << '\n';
+        }
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+} // namespace plotter::profiling
@@ -0,0 +1,133 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Измерение горячих путей: таймеры вызовов методов и счетчики работы.
+// По умолчанию макросы ниже ничего не компилируют, включаются опцией cmake PLOTTER_PROFILE
+// (определяет макрос PLOTTER_PROFILE). Аргументы выключенных макросов не вычисляются.
+//
+//   PLOTTER_PROFILE_SCOPE(name)        — время от точки вызова до конца блока
+//   PLOTTER_PROFILE_COUNT(name, value) — прибавляет value к счетчику
+//   PLOTTER_PROFILE_MAX(name, value)   — наибольшее из переданных значений
+//
+// name — строковый литерал. Зонд регистрируется при первом выполнении макроса, дальше обновление —
+// запись в массив текущего потока без блокировок и атомарных операций чтения-записи.
+// Потоки копят свои значения отдельно, TakeSnapshot сводит их в один снимок
+
+namespace plotter::profiling
+{
+
+#ifdef PLOTTER_PROFILE
+inline constexpr bool ENABLED = true;
+#else
+inline constexpr bool ENABLED = false;
+#endif
+
+enum class ProbeKind : std::uint8_t
+{
+    Timer,
+    Counter,
+    Maximum,
+};
+
+using ProbeId = std::uint32_t;
+
+// Зонды сверх MAX_PROBES не учитываются
+inline constexpr size_t MAX_PROBES = 512;
+
+struct TimerStats
+{
+    std::uint64_t calls = 0;
+    // Время включает вложенные вызовы других измеряемых методов
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+};
+
+// Сумма по всем потокам, включая завершившиеся
+struct Snapshot
+{
+    std::map<std::string, TimerStats> timers;
+    std::map<std::string, std::uint64_t> counters;
+    std::map<std::string, std::uint64_t> maxima;
+};
+
+// Один и тот же id для одинаковых name и kind
+ProbeId RegisterProbe(std::string_view name, ProbeKind kind);
+
+void RecordTime(ProbeId probe, std::uint64_t nanoseconds) noexcept;
+void AddCount(ProbeId probe, std::uint64_t value) noexcept;
+void UpdateMaximum(ProbeId probe, std::uint64_t value) noexcept;
+
+// Можно вызывать во время работы других потоков: их значения читаются без остановки,
+// поэтому снимок может не включать обновления, идущие в этот момент
+Snapshot TakeSnapshot();
+// Обнуляет значения всех потоков. Вызывается, пока измеряемый код не выполняется
+void Reset();
+
+// Таблица таймеров по убыванию общего времени, затем счетчики и максимумы
+void PrintSnapshot(std::ostream& os, const Snapshot& snapshot);
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const ProbeId probe) noexcept
+        : probe_(probe)
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        RecordTime(probe_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ProbeId probe_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace plotter::profiling
+
+#define PLOTTER_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PLOTTER_PROFILE_CONCAT(a, b) PLOTTER_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef PLOTTER_PROFILE
+
+#define PLOTTER_PROFILE_SCOPE(name)                                                                              \
+    static const ::plotter::profiling::ProbeId PLOTTER_PROFILE_CONCAT(plotter_probe_, __LINE__) =               \
+        ::plotter::profiling::RegisterProbe(name, ::plotter::profiling::ProbeKind::Timer);                       \
+    const ::plotter::profiling::ScopedTimer PLOTTER_PROFILE_CONCAT(plotter_timer_, __LINE__)(                    \
+        PLOTTER_PROFILE_CONCAT(plotter_probe_, __LINE__))
+
+#define PLOTTER_PROFILE_COUNT(name, value)                                                                       \
+    do                                                                                                           \
+    {                                                                                                            \
+        static const ::plotter::profiling::ProbeId plotter_probe =                                               \
+            ::plotter::profiling::RegisterProbe(name, ::plotter::profiling::ProbeKind::Counter);                 \
+        ::plotter::profiling::AddCount(plotter_probe, static_cast<std::uint64_t>(value));                       \
+    } while (false)
+
+#define PLOTTER_PROFILE_MAX(name, value)                                                                         \
+    do                                                                                                           \
+    {                                                                                                            \
+        static const ::plotter::profiling::ProbeId plotter_probe =                                               \
+            ::plotter::profiling::RegisterProbe(name, ::plotter::profiling::ProbeKind::Maximum);                 \
+        ::plotter::profiling::UpdateMaximum(plotter_probe, static_cast<std::uint64_t>(value));                  \
+    } while (false)
+
+#else
+
+#define PLOTTER_PROFILE_SCOPE(name) static_cast<void>(0)
+#define PLOTTER_PROFILE_COUNT(name, value) static_cast<void>(0)
+#define PLOTTER_PROFILE_MAX(name, value) static_cast<void>(0)
+
+#endif
@@ -0,0 +1,181 @@
+#include "RankFilters.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+    using plotter::Extremum;
+
+    int Clamp(const int value, const int limit)
+    {
+        return std::clamp(value, 0, limit - 1);
+    }
+
+    // Индекс медианы в гистограмме окна из count значений
+    int MedianBin(const std::uint32_t* histogram, const int bins, const std::uint32_t count)
+    {
+        const std::uint32_t half = count / 2;
+        std::uint32_t seen = 0;
+        for (int bin = 0; bin < bins; ++bin)
+        {
+            seen += histogram[bin];
+            if (seen > half)
+            {
+                return bin;
+            }
+        }
+        return bins - 1;
+    }
+
+    // Экстремум окна для выходов [out_begin, out_end) последовательности src[i * step], i из [0, length).
+    // Вне последовательности стоит нейтральный элемент, поэтому окно фактически обрезается.
+    // Последовательность с запасом radius по краям режется на блоки длины окна, в каждом блоке
+    // накапливаются экстремумы слева (prefix) и справа (suffix), ответ — экстремум двух значений
+    template <typename Op>
+    void SlidingExtremum(const std::uint8_t* src, const ptrdiff_t step, const int length, const int radius,
+        const std::uint8_t identity, Op op, const int out_begin, const int out_end,
+        std::uint8_t* dst, const ptrdiff_t dst_step,
+        std::vector<std::uint8_t>& prefix, std::vector<std::uint8_t>& suffix)
+    {
+        const int window = 2 * radius + 1;
+        const int first = out_begin - radius;
+        const int padded = out_end - out_begin + 2 * radius;
+        prefix.resize(padded);
+        suffix.resize(padded);
+
+        const auto value = [&](const int t)
+        {
+            const int i = first + t;
+            return i >= 0 && i < length ? src[i * step] : identity;
+        };
+
+        for (int t = 0; t < padded; ++t)
+        {
+            prefix[t] = t % window == 0 ? value(t) : op(prefix[t - 1], value(t));
+        }
+        for (int t = padded - 1; t >= 0; --t)
+        {
+            suffix[t] = t == padded - 1 || (t + 1) % window == 0 ? value(t) : op(suffix[t + 1], value(t));
+        }
+
+        for (int i = out_begin; i < out_end; ++i)
+        {
+            const int t = i - out_begin;
+            dst[i * dst_step] = op(suffix[t], prefix[t + window - 1]);
+        }
+    }
+
+    template <typename Body>
+    void WithExtremum(const Extremum extremum, Body body)
+    {
+        if (extremum == Extremum::Min)
+        {
+            body(std::uint8_t{ 255 }, [](const std::uint8_t a, const std::uint8_t b) { return std::min(a, b); });
+        }
+        else
+        {
+            body(std::uint8_t{ 0 }, [](const std::uint8_t a, const std::uint8_t b) { return std::max(a, b); });
+        }
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+void MedianRows(const std::uint8_t* src, std::uint8_t* dst, const int width, const int height,
+    const int bins, const int radius, const int row_begin, const int row_end)
+{
+    if (row_begin >= row_end)
+    {
+        return;
+    }
+
+    // Гистограммы столбцов по строкам [y - radius, y + radius] текущей строки y
+    std::vector<std::uint16_t> columns(static_cast<size_t>(width) * bins);
+    const auto column = [&](const int x) { return columns.data() + static_cast<size_t>(x) * bins; };
+    const auto row = [&](const int y) { return src + static_cast<size_t>(Clamp(y, height)) * width; };
+
+    for (int dy = -radius; dy <= radius; ++dy)
+    {
+        const std::uint8_t* const values = row(row_begin + dy);
+        for (int x = 0; x < width; ++x)
+        {
+            ++column(x)[values[x]];
+        }
+    }
+
+    const auto window_size = static_cast<std::uint32_t>(2 * radius + 1) * static_cast<std::uint32_t>(2 * radius + 1);
+    std::vector<std::uint32_t> kernel(bins);
+
+    for (int y = row_begin; y < row_end; ++y)
+    {
+        if (y > row_begin)
+        {
+            const std::uint8_t* const leaving = row(y - radius - 1);
+            const std::uint8_t* const entering = row(y + radius);
+            for (int x = 0; x < width; ++x)
+            {
+                --column(x)[leaving[x]];
+                ++column(x)[entering[x]];
+            }
+        }
+
+        // Гистограмма окна сдвигается вдоль строки: один столбец входит, один выходит
+        std::fill(kernel.begin(), kernel.end(), 0);
+        for (int dx = -radius; dx <= radius; ++dx)
+        {
+            const std::uint16_t* const counts = column(Clamp(dx, width));
+            for (int bin = 0; bin < bins; ++bin)
+            {
+                kernel[bin] += counts[bin];
+            }
+        }
+
+        std::uint8_t* const out = dst + static_cast<size_t>(y) * width;
+        out[0] = static_cast<std::uint8_t>(MedianBin(kernel.data(), bins, window_size));
+        for (int x = 1; x < width; ++x)
+        {
+            const std::uint16_t* const entering = column(Clamp(x + radius, width));
+            const std::uint16_t* const leaving = column(Clamp(x - radius - 1, width));
+            for (int bin = 0; bin < bins; ++bin)
+            {
+                kernel[bin] += entering[bin];
+                kernel[bin] -= leaving[bin];
+            }
+            out[x] = static_cast<std::uint8_t>(MedianBin(kernel.data(), bins, window_size));
+        }
+    }
+}
+
+void HorizontalExtremumRows(const std::uint8_t* src, std::uint8_t* dst, const int width,
+    const int radius, const Extremum extremum, const int row_begin, const int row_end)
+{
+    WithExtremum(extremum, [&](const std::uint8_t identity, auto op)
+    {
+        std::vector<std::uint8_t> prefix;
+        std::vector<std::uint8_t> suffix;
+        for (int y = row_begin; y < row_end; ++y)
+        {
+            const size_t offset = static_cast<size_t>(y) * width;
+            SlidingExtremum(src + offset, 1, width, radius, identity, op, 0, width, dst + offset, 1, prefix, suffix);
+        }
+    });
+}
+
+void VerticalExtremumRows(const std::uint8_t* src, std::uint8_t* dst, const int width, const int height,
+    const int radius, const Extremum extremum, const int row_begin, const int row_end)
+{
+    WithExtremum(extremum, [&](const std::uint8_t identity, auto op)
+    {
+        std::vector<std::uint8_t> prefix;
+        std::vector<std::uint8_t> suffix;
+        for (int x = 0; x < width; ++x)
+        {
+            SlidingExtremum(src + x, width, height, radius, identity, op, row_begin, row_end, dst + x, width,
+                prefix, suffix);
+        }
+    });
+}
+
+} // namespace plotter
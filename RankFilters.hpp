@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+namespace plotter
+{
+
+// Ранговые фильтры над плоским изображением малых целых значений (индексов палитры или уровней яркости).
+// Изображение хранится построчно, пиксель (x, y) лежит по смещению y * width + x.
+// Каждая функция обрабатывает строки результата [row_begin, row_end) и читает src целиком,
+// поэтому полосы строк можно считать параллельно в общий dst.
+
+// Наибольший радиус окна: счетчики гистограммы столбца 16-битные
+constexpr int MAX_RANK_RADIUS = 32767;
+
+// Медиана окна (2 * radius + 1)^2 по гистограммам столбцов (Perreault, Hébert),
+// время на пиксель не зависит от радиуса. Все значения src меньше bins, bins не больше 256.
+// За краем изображения повторяются крайние пиксели
+void MedianRows(const std::uint8_t* src, std::uint8_t* dst, int width, int height,
+    int bins, int radius, int row_begin, int row_end);
+
+enum class Extremum
+{
+    Min,
+    Max
+};
+
+// Минимум или максимум окна 2 * radius + 1 вдоль строки или столбца (van Herk, Gil-Werman):
+// не больше трех сравнений на пиксель при любом радиусе. Окно обрезается краем изображения
+void HorizontalExtremumRows(const std::uint8_t* src, std::uint8_t* dst, int width,
+    int radius, Extremum extremum, int row_begin, int row_end);
+void VerticalExtremumRows(const std::uint8_t* src, std::uint8_t* dst, int width, int height,
+    int radius, Extremum extremum, int row_begin, int row_end);
+
+} // namespace plotter
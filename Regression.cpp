@@ -0,0 +1,329 @@
+#include "Regression.hpp"
+#include "JsonView.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace bench
+{
+
+namespace
+{
+    const json::ValueView& Require(const json::ValueView& dict, const std::string_view key)
+    {
+        const json::ValueView* const value = dict.Find(key);
+        if (value == nullptr)
+        {
+            throw std::runtime_error("Benchmark report has no '" + std::string(key) + "' field");
+        }
+        return *value;
+    }
+
+    double RequireNumber(const json::ValueView& dict, const std::string_view key)
+    {
+        const json::ValueView& value = Require(dict, key);
+        if (!value.IsDouble())
+        {
+            throw std::runtime_error("Benchmark report field '" + std::string(key) + "' is not a number");
+        }
+        return value.AsDouble();
+    }
+
+    std::string RequireString(const json::ValueView& dict, const std::string_view key)
+    {
+        const json::ValueView& value = Require(dict, key);
+        if (!value.IsString())
+        {
+            throw std::runtime_error("Benchmark report field '" + std::string(key) + "' is not a string");
+        }
+        return std::string(value.AsString());
+    }
+
+    // Имя и параметры по Id: объект "params" в отчете отсортирован по ключам, а Id хранит их порядок
+    void ParseId(const std::string_view id, BenchmarkResult& result)
+    {
+        size_t end = id.find('/');
+        result.name = std::string(id.substr(0, end));
+        while (end != std::string_view::npos)
+        {
+            const size_t begin = end + 1;
+            end = id.find('/', begin);
+            const std::string_view param = id.substr(begin, end == std::string_view::npos ? end : end - begin);
+            const size_t equals = param.find('=');
+            if (equals == std::string_view::npos)
+            {
+                throw std::runtime_error("Benchmark id '" + std::string(id) + "' has a parameter without a value");
+            }
+            result.params.emplace_back(param.substr(0, equals), param.substr(equals + 1));
+        }
+    }
+
+    std::string_view VerdictName(const Verdict verdict)
+    {
+        switch (verdict)
+        {
+        case Verdict::Unchanged:
+            return "ok";
+        case Verdict::Faster:
+            return "faster";
+        case Verdict::Slower:
+            return "SLOWER";
+        case Verdict::New:
+            return "new";
+        case Verdict::Missing:
+            return "missing";
+        }
+        return "";
+    }
+} // anonymous namespace
+
+MannWhitneyResult MannWhitneyU(const std::vector<double>& first, const std::vector<double>& second)
+{
+    MannWhitneyResult result;
+    if (first.empty() || second.empty())
+    {
+        return result;
+    }
+
+    // Ранги объединенной выборки, совпадающим значениям — средний ранг группы
+    struct Value
+    {
+        double value;
+        bool from_first;
+    };
+    std::vector<Value> values;
+    values.reserve(first.size() + second.size());
+    for (const double value : first)
+    {
+        values.push_back({ value, true });
+    }
+    for (const double value : second)
+    {
+        values.push_back({ value, false });
+    }
+    std::sort(values.begin(), values.end(), [](const Value& lhs, const Value& rhs) { return lhs.value < rhs.value; });
+
+    const auto n1 = static_cast<double>(first.size());
+    const auto n2 = static_cast<double>(second.size());
+    const double n = n1 + n2;
+    double first_rank_sum = 0.0;
+    double tie_sum = 0.0;
+    for (size_t begin = 0; begin < values.size();)
+    {
+        size_t end = begin + 1;
+        while (end < values.size() && values[end].value == values[begin].value)
+        {
+            ++end;
+        }
+        // Ранги группы — begin + 1 .. end
+        const double rank = (static_cast<double>(begin + 1) + static_cast<double>(end)) / 2.0;
+        const auto ties = static_cast<double>(end - begin);
+        tie_sum += ties * ties * ties - ties;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (values[i].from_first)
+            {
+                first_rank_sum += rank;
+            }
+        }
+        begin = end;
+    }
+
+    result.u = first_rank_sum - n1 * (n1 + 1.0) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tie_sum / (n * (n - 1.0)));
+    if (variance <= 0.0)
+    {
+        return result;
+    }
+    const double difference = result.u - mean;
+    const double corrected = std::max(0.0, std::abs(difference) - 0.5);
+    result.z = std::copysign(corrected / std::sqrt(variance), difference);
+    result.p_value = std::erfc(std::abs(result.z) / std::sqrt(2.0));
+    return result;
+}
+
+double MinimumPValue(const size_t first_size, const size_t second_size)
+{
+    if (first_size == 0 || second_size == 0)
+    {
+        return 1.0;
+    }
+    const auto n1 = static_cast<double>(first_size);
+    const auto n2 = static_cast<double>(second_size);
+    // U = n1 * n2 при полном разделении, отклонение от среднего — n1 * n2 / 2
+    const double variance = n1 * n2 * (n1 + n2 + 1.0) / 12.0;
+    const double corrected = std::max(0.0, n1 * n2 / 2.0 - 0.5);
+    return std::erfc(corrected / std::sqrt(variance) / std::sqrt(2.0));
+}
+
+std::vector<Comparison> CompareResults(const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& current, const RegressionOptions& options)
+{
+    std::unordered_map<std::string, const BenchmarkResult*> baseline_by_id;
+    for (const BenchmarkResult& result : baseline)
+    {
+        baseline_by_id.emplace(result.Id(), &result);
+    }
+
+    std::vector<Comparison> comparisons;
+    comparisons.reserve(current.size());
+    for (const BenchmarkResult& result : current)
+    {
+        Comparison comparison;
+        comparison.id = result.Id();
+        comparison.current_median_ns = result.median_ns;
+
+        const auto found = baseline_by_id.find(comparison.id);
+        if (found == baseline_by_id.end())
+        {
+            comparison.verdict = Verdict::New;
+            comparisons.push_back(std::move(comparison));
+            continue;
+        }
+        const BenchmarkResult& before = *found->second;
+        baseline_by_id.erase(found);
+
+        comparison.baseline_median_ns = before.median_ns;
+        comparison.delta = before.median_ns > 0.0 ? result.median_ns / before.median_ns - 1.0 : 0.0;
+        comparison.p_value = MannWhitneyU(result.samples_ns, before.samples_ns).p_value;
+        if (comparison.p_value < options.alpha && std::abs(comparison.delta) > options.threshold)
+        {
+            comparison.verdict = comparison.delta > 0.0 ? Verdict::Slower : Verdict::Faster;
+        }
+        comparisons.push_back(std::move(comparison));
+    }
+
+    for (const BenchmarkResult& result : baseline)
+    {
+        if (baseline_by_id.contains(result.Id()))
+        {
+            Comparison comparison;
+            comparison.id = result.Id();
+            comparison.baseline_median_ns = result.median_ns;
+            comparison.verdict = Verdict::Missing;
+            comparisons.push_back(std::move(comparison));
+        }
+    }
+    return comparisons;
+}
+
+bool HasRegressions(const std::vector<Comparison>& comparisons)
+{
+    return std::any_of(comparisons.begin(), comparisons.end(),
+        [](const Comparison& comparison) { return comparison.verdict == Verdict::Slower; });
+}
+
+void PrintDeltaTable(std::ostream& os, const std::vector<Comparison>& comparisons)
+{
+    size_t id_width = std::string_view("benchmark").size();
+    for (const Comparison& comparison : comparisons)
+    {
+        id_width = std::max(id_width, comparison.id.size());
+    }
+
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::left << std::setw(static_cast<int>(id_width)) << "benchmark" << std::right << std::setw(14)
+       << "baseline us" << std::setw(14) << "current us" << std::setw(10) << "delta" << std::setw(10) << "p"
+       << "  verdict\n";
+    os << std::fixed;
+
+    std::unordered_map<Verdict, int> totals;
+    for (const Comparison& comparison : comparisons)
+    {
+        ++totals[comparison.verdict];
+        os << std::left << std::setw(static_cast<int>(id_width)) << comparison.id << std::right;
+        if (comparison.verdict == Verdict::New)
+        {
+            os << std::setw(14) << "-";
+        }
+        else
+        {
+            os << std::setw(14) << std::setprecision(3) << comparison.baseline_median_ns / 1e3;
+        }
+        if (comparison.verdict == Verdict::Missing)
+        {
+            os << std::setw(14) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        else
+        {
+            os << std::setw(14) << std::setprecision(3) << comparison.current_median_ns / 1e3;
+        }
+        if (comparison.verdict != Verdict::New && comparison.verdict != Verdict::Missing)
+        {
+            os << std::setw(9) << std::showpos << std::setprecision(1) << comparison.delta * 100.0 << std::noshowpos
+               << '%' << std::setw(10) << std::setprecision(4) << comparison.p_value;
+        }
+        else if (comparison.verdict == Verdict::New)
+        {
+            os << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        os << "  " << VerdictName(comparison.verdict) << '\n';
+    }
+
+    os << comparisons.size() << " benchmarks: " << totals[Verdict::Slower] << " slower, " << totals[Verdict::Faster]
+       << " faster, " << totals[Verdict::Unchanged] << " unchanged, " << totals[Verdict::New] << " new, "
+       << totals[Verdict::Missing] << " missing\n";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+std::vector<BenchmarkResult> LoadResults(const std::filesystem::path& path)
+{
+    const json::DocumentView document = json::DocumentView::Load(path);
+    const json::ValueView& root = document.GetRoot();
+    if (!root.IsDict())
+    {
+        throw std::runtime_error("Benchmark report '" + path.string() + "' is not a JSON object");
+    }
+    const json::ValueView& benchmarks = Require(root, "benchmarks");
+    if (!benchmarks.IsArray())
+    {
+        throw std::runtime_error("Benchmark report field 'benchmarks' is not an array");
+    }
+
+    std::vector<BenchmarkResult> results;
+    results.reserve(benchmarks.AsArray().size());
+    for (const json::ValueView& entry : benchmarks.AsArray())
+    {
+        if (!entry.IsDict())
+        {
+            throw std::runtime_error("Benchmark report entry is not a JSON object");
+        }
+        BenchmarkResult result;
+        ParseId(RequireString(entry, "id"), result);
+        result.unit = RequireString(entry, "unit");
+        result.items_per_iteration = RequireNumber(entry, "items_per_iteration");
+        result.warmup_iterations = static_cast<long long>(RequireNumber(entry, "warmup_iterations"));
+        result.warmup_ms = RequireNumber(entry, "warmup_ms");
+        result.iterations_per_sample = static_cast<long long>(RequireNumber(entry, "iterations_per_sample"));
+        result.median_ns = RequireNumber(entry, "median_ns");
+        result.p99_ns = RequireNumber(entry, "p99_ns");
+        result.mean_ns = RequireNumber(entry, "mean_ns");
+        result.min_ns = RequireNumber(entry, "min_ns");
+        result.max_ns = RequireNumber(entry, "max_ns");
+        result.throughput = RequireNumber(entry, "throughput");
+
+        const json::ValueView& samples = Require(entry, "samples_ns");
+        if (!samples.IsArray())
+        {
+            throw std::runtime_error("Benchmark report field 'samples_ns' is not an array");
+        }
+        for (const json::ValueView& sample : samples.AsArray())
+        {
+            if (!sample.IsDouble())
+            {
+                throw std::runtime_error("Benchmark report field 'samples_ns' has a non-number sample");
+            }
+            result.samples_ns.push_back(sample.AsDouble());
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,75 @@
+#pragma once
+#include "Benchmark.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// Результат U-критерия Манна — Уитни для двух независимых выборок
+struct MannWhitneyResult
+{
+    // U первой выборки: число пар (a, b), где a > b, пары с равными значениями дают 1/2
+    double u = 0.0;
+    // Нормальное приближение с поправкой на совпадения и непрерывность, знак — в сторону первой выборки
+    double z = 0.0;
+    // Двусторонний уровень значимости, 1 — выборки неразличимы
+    double p_value = 1.0;
+};
+
+// Сравнивает выборки без предположений о распределении: время бенчмарков скошено вправо
+// и содержит выбросы, поэтому t-критерий здесь не годится. Пустая выборка дает p_value = 1
+MannWhitneyResult MannWhitneyU(const std::vector<double>& first, const std::vector<double>& second);
+
+// Наименьшее p_value MannWhitneyU для выборок размеров first_size и second_size: выборки не пересекаются
+// и совпадений нет. Если оно не меньше alpha, различие не может быть значимым. Для 5 и 5 замеров — около 0.012
+[[nodiscard]] double MinimumPValue(size_t first_size, size_t second_size);
+
+enum class Verdict : std::uint8_t
+{
+    Unchanged,
+    Faster,
+    Slower,
+    // Бенчмарка нет в базовом отчете
+    New,
+    // Бенчмарк есть только в базовом отчете
+    Missing,
+};
+
+struct RegressionOptions
+{
+    // Изменение медианы меньше threshold (доля) не считается ни замедлением, ни ускорением
+    double threshold = 0.10;
+    // Изменение значимо, если p_value критерия меньше alpha
+    double alpha = 0.01;
+};
+
+struct Comparison
+{
+    std::string id;
+    double baseline_median_ns = 0.0;
+    double current_median_ns = 0.0;
+    // current / baseline - 1 по медианам
+    double delta = 0.0;
+    double p_value = 1.0;
+    Verdict verdict = Verdict::Unchanged;
+};
+
+// Сравнивает бенчмарки с одинаковым Id по их замерам. Замедление — медиана выросла больше
+// чем на threshold и различие выборок значимо. Порядок — как в current, затем пропавшие из baseline
+std::vector<Comparison> CompareResults(const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& current, const RegressionOptions& options = {});
+
+[[nodiscard]] bool HasRegressions(const std::vector<Comparison>& comparisons);
+
+// Таблица: бенчмарк, медианы, изменение в процентах, p и вердикт, затем итог
+void PrintDeltaTable(std::ostream& os, const std::vector<Comparison>& comparisons);
+
+// Читает отчет BenchmarkSuite::WriteJson. Бросает json::ParsingError при ошибке синтаксиса
+// и std::runtime_error, если в отчете нет нужных полей
+std::vector<BenchmarkResult> LoadResults(const std::filesystem::path& path);
+
+} // namespace bench
@@ -0,0 +1,90 @@
+#include "Resampling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    void CheckSizes(const int source_size, const int target_size)
+    {
+        if (source_size < 1 || target_size < 1)
+        {
+            throw std::invalid_argument("Resample sizes can't be less than 1");
+        }
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+ResampleWeights AreaWeights(const int source_size, const int target_size)
+{
+    CheckSizes(source_size, target_size);
+
+    ResampleWeights table;
+    table.first.reserve(target_size + 1);
+
+    const double scale = static_cast<double>(source_size) / target_size;
+    for (int target = 0; target < target_size; ++target)
+    {
+        table.first.push_back(static_cast<int>(table.sources.size()));
+
+        const double begin = target * scale;
+        const double end = (target + 1) * scale;
+        const int last = std::min(static_cast<int>(std::ceil(end)), source_size);
+        for (int source = static_cast<int>(begin); source < last; ++source)
+        {
+            const double covered = std::min(source + 1.0, end) - std::max(static_cast<double>(source), begin);
+            if (covered > 0.0)
+            {
+                table.sources.push_back(source);
+                table.weights.push_back(covered / scale);
+            }
+        }
+    }
+    table.first.push_back(static_cast<int>(table.sources.size()));
+    return table;
+}
+
+ResampleWeights BilinearWeights(const int source_size, const int target_size)
+{
+    CheckSizes(source_size, target_size);
+
+    ResampleWeights table;
+    table.first.reserve(target_size + 1);
+
+    const double scale = static_cast<double>(source_size) / target_size;
+    for (int target = 0; target < target_size; ++target)
+    {
+        table.first.push_back(static_cast<int>(table.sources.size()));
+
+        // Центры отсчетов совмещены, за краями оси повторяются крайние отсчеты
+        const double position = std::clamp((target + 0.5) * scale - 0.5, 0.0, source_size - 1.0);
+        const int left = static_cast<int>(position);
+        const double fraction = position - left;
+        table.sources.push_back(left);
+        table.weights.push_back(1.0 - fraction);
+        if (fraction > 0.0)
+        {
+            table.sources.push_back(left + 1);
+            table.weights.push_back(fraction);
+        }
+    }
+    table.first.push_back(static_cast<int>(table.sources.size()));
+    return table;
+}
+
+std::vector<int> NearestIndices(const int source_size, const int target_size)
+{
+    CheckSizes(source_size, target_size);
+
+    std::vector<int> indices(target_size);
+    const double scale = static_cast<double>(source_size) / target_size;
+    for (int target = 0; target < target_size; ++target)
+    {
+        indices[target] = std::min(static_cast<int>((target + 0.5) * scale), source_size - 1);
+    }
+    return indices;
+}
+
+} // namespace plotter
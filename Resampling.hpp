@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+
+namespace plotter
+{
+
+// Фильтр изменения размера канваса
+enum class ResampleFilter
+{
+    // Символ ближайшего пикселя, символы не смешиваются
+    Nearest,
+    // Средняя яркость покрытой области, для уменьшения
+    Area,
+    // Билинейная интерполяция яркости, для увеличения
+    Bilinear,
+};
+
+// Веса пересчета одной оси из source_size отсчетов в target_size: отсчет результата i —
+// сумма weights[k] * source[sources[k]] по k из [first[i], first[i + 1]). Веса отсчета в сумме дают 1
+struct ResampleWeights
+{
+    std::vector<int> first;
+    std::vector<int> sources;
+    std::vector<double> weights;
+
+    // Число отсчетов результата
+    [[nodiscard]] int Size() const noexcept { return static_cast<int>(first.size()) - 1; }
+};
+
+// Усреднение по площади: отсчет результата покрывает отрезок source_size / target_size
+// исходной оси, частично покрытые отсчеты входят с долей покрытия
+ResampleWeights AreaWeights(int source_size, int target_size);
+// Линейная интерполяция между двумя ближайшими к центру отсчета результата исходными отсчетами
+ResampleWeights BilinearWeights(int source_size, int target_size);
+// Исходный отсчет, в который попадает центр каждого отсчета результата
+std::vector<int> NearestIndices(int source_size, int target_size);
+
+} // namespace plotter
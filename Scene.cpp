@@ -0,0 +1,600 @@
+#include "Scene.hpp"
+#include "Config.hpp"
+#include "GrayscalePlotter.hpp"
+#include "JsonView.hpp"
+#include "MappedFile.hpp"
+#include "PlotterFactory.hpp"
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace
+{
+    using plotter::SceneError;
+
+    // Прочитанные страницы отображенного файла отпускаются блоками такого размера
+    constexpr size_t RELEASE_CHUNK = 16 * 1024 * 1024;
+
+    // Отсортированы по имени для двоичного поиска
+    constexpr std::array<std::pair<std::string_view, plotter::SceneOp>, 10> OPS =
+    {{
+        { "circle", plotter::SceneOp::Circle },
+        { "clear", plotter::SceneOp::Clear },
+        { "filter", plotter::SceneOp::Filter },
+        { "flood_fill", plotter::SceneOp::FloodFill },
+        { "line", plotter::SceneOp::Line },
+        { "linear_gradient", plotter::SceneOp::LinearGradient },
+        { "radial_gradient", plotter::SceneOp::RadialGradient },
+        { "rect", plotter::SceneOp::Rect },
+        { "scanline_fill", plotter::SceneOp::ScanlineFill },
+        { "triangle", plotter::SceneOp::Triangle },
+    }};
+
+    constexpr std::array<std::pair<std::string_view, plotter::Dither>, 4> DITHERS =
+    {{
+        { "none", plotter::Dither::None },
+        { "ordered", plotter::Dither::Ordered },
+        { "floyd_steinberg", plotter::Dither::FloydSteinberg },
+        { "atkinson", plotter::Dither::Atkinson },
+    }};
+
+    // Доступ к параметрам команды с понятными ошибками
+    class CommandArgs
+    {
+    public:
+        explicit CommandArgs(const json::ValueView& command)
+            : command_(command)
+        {
+            if (!command_.IsDict())
+            {
+                throw SceneError("command is not an object");
+            }
+        }
+
+        [[nodiscard]] int Int(const std::string_view key) const
+        {
+            const json::ValueView& value = Required(key);
+            if (!value.IsInt())
+            {
+                throw SceneError(Quoted(key) + " is not of type 'int'");
+            }
+            return value.AsInt();
+        }
+
+        [[nodiscard]] int Int(const std::string_view key, const int default_value) const
+        {
+            return command_.Find(key) ? Int(key) : default_value;
+        }
+
+        [[nodiscard]] double Number(const std::string_view key) const
+        {
+            const json::ValueView& value = Required(key);
+            if (!value.IsDouble())
+            {
+                throw SceneError(Quoted(key) + " is not of type 'number'");
+            }
+            return value.AsDouble();
+        }
+
+        [[nodiscard]] double Number(const std::string_view key, const double default_value) const
+        {
+            return command_.Find(key) ? Number(key) : default_value;
+        }
+
+        [[nodiscard]] bool Flag(const std::string_view key) const
+        {
+            const json::ValueView* const value = command_.Find(key);
+            if (value == nullptr)
+            {
+                return false;
+            }
+            if (!value->IsBool())
+            {
+                throw SceneError(Quoted(key) + " is not of type 'bool'");
+            }
+            return value->AsBool();
+        }
+
+        [[nodiscard]] std::string_view Text(const std::string_view key) const
+        {
+            const json::ValueView& value = Required(key);
+            if (!value.IsString())
+            {
+                throw SceneError(Quoted(key) + " is not of type 'string'");
+            }
+            return value.AsString();
+        }
+
+        [[nodiscard]] bool Has(const std::string_view key) const { return command_.Find(key) != nullptr; }
+
+        [[nodiscard]] char Brush() const
+        {
+            const std::string_view brush = Text("brush");
+            if (brush.size() != 1)
+            {
+                throw SceneError("'brush' is expected to have a single char");
+            }
+            // Нулевой символ плоттер оставляет для разметки пикселей
+            if (brush[0] == '\0')
+            {
+                throw SceneError("'brush' can't be a null char");
+            }
+            return brush[0];
+        }
+
+        [[nodiscard]] plotter::Dither Dither() const
+        {
+            if (!Has("dither"))
+            {
+                return plotter::Dither::None;
+            }
+            const std::string_view name = Text("dither");
+            const auto it = std::find_if(DITHERS.begin(), DITHERS.end(),
+                [name](const auto& entry) { return entry.first == name; });
+            if (it == DITHERS.end())
+            {
+                throw SceneError("unknown dither '" + std::string(name) + "'");
+            }
+            return it->second;
+        }
+
+    private:
+        const json::ValueView& command_;
+
+        static std::string Quoted(const std::string_view key)
+        {
+            return "'" + std::string(key) + "'";
+        }
+
+        [[nodiscard]] const json::ValueView& Required(const std::string_view key) const
+        {
+            const json::ValueView* const value = command_.Find(key);
+            if (value == nullptr)
+            {
+                throw SceneError(Quoted(key) + " not found");
+            }
+            return *value;
+        }
+    };
+
+    constexpr std::array<std::pair<std::string_view, plotter::SceneFilter>, 13> FILTERS =
+    {{
+        { "box_blur", plotter::SceneFilter::BoxBlur },
+        { "gaussian_blur", plotter::SceneFilter::GaussianBlur },
+        { "median", plotter::SceneFilter::Median },
+        { "erosion", plotter::SceneFilter::Erosion },
+        { "dilation", plotter::SceneFilter::Dilation },
+        { "opening", plotter::SceneFilter::Opening },
+        { "closing", plotter::SceneFilter::Closing },
+        { "threshold", plotter::SceneFilter::Threshold },
+        { "invert", plotter::SceneFilter::Invert },
+        { "brightness", plotter::SceneFilter::Brightness },
+        { "edges", plotter::SceneFilter::Edges },
+        { "equalize", plotter::SceneFilter::Equalize },
+        { "auto_contrast", plotter::SceneFilter::AutoContrast },
+    }};
+
+    plotter::GrayscalePlotter& RequireGrayscale(plotter::Plotter& plotter, const std::string_view what)
+    {
+        auto* const grayscale = dynamic_cast<plotter::GrayscalePlotter*>(&plotter);
+        if (grayscale == nullptr)
+        {
+            throw SceneError(std::string(what) + " needs a grayscale plotter");
+        }
+        return *grayscale;
+    }
+
+    void ReadPaint(const CommandArgs& args, plotter::SceneCommand& command)
+    {
+        command.uses_brightness = args.Has("brightness");
+        if (command.uses_brightness)
+        {
+            command.values[0] = args.Number("brightness");
+            command.dither = args.Dither();
+        }
+        else
+        {
+            command.brush = args.Brush();
+        }
+    }
+
+    void ReadFilter(const CommandArgs& args, plotter::SceneCommand& command)
+    {
+        using plotter::SceneFilter;
+        const std::string_view name = args.Text("name");
+        const auto it = std::find_if(FILTERS.begin(), FILTERS.end(),
+            [name](const auto& entry) { return entry.first == name; });
+        if (it == FILTERS.end())
+        {
+            throw SceneError("unknown filter '" + std::string(name) + "'");
+        }
+
+        command.filter = it->second;
+        switch (command.filter)
+        {
+        case SceneFilter::BoxBlur:
+        case SceneFilter::GaussianBlur:
+            command.args[0] = args.Int("size", 3);
+            break;
+        case SceneFilter::Median:
+        case SceneFilter::Erosion:
+        case SceneFilter::Dilation:
+        case SceneFilter::Opening:
+        case SceneFilter::Closing:
+            command.args[0] = args.Int("radius", 1);
+            break;
+        case SceneFilter::Threshold:
+            command.values[0] = args.Number("value");
+            break;
+        case SceneFilter::Brightness:
+            command.values[0] = args.Number("factor");
+            break;
+        case SceneFilter::Edges:
+            command.values[0] = args.Number("threshold", 0.25);
+            break;
+        case SceneFilter::AutoContrast:
+            command.values[0] = args.Number("clip", 0.0);
+            break;
+        case SceneFilter::Invert:
+        case SceneFilter::Equalize:
+            break;
+        }
+    }
+
+    void ApplyFilter(const plotter::SceneCommand& command, plotter::GrayscalePlotter& plotter)
+    {
+        using plotter::SceneFilter;
+        switch (command.filter)
+        {
+        case SceneFilter::BoxBlur:
+            plotter.ApplyBoxBlur(command.args[0]);
+            break;
+        case SceneFilter::GaussianBlur:
+            plotter.ApplyGaussianBlur(command.args[0]);
+            break;
+        case SceneFilter::Median:
+            plotter.ApplyMedianFilter(command.args[0]);
+            break;
+        case SceneFilter::Erosion:
+            plotter.ApplyErosion(command.args[0]);
+            break;
+        case SceneFilter::Dilation:
+            plotter.ApplyDilation(command.args[0]);
+            break;
+        case SceneFilter::Opening:
+            plotter.ApplyOpening(command.args[0]);
+            break;
+        case SceneFilter::Closing:
+            plotter.ApplyClosing(command.args[0]);
+            break;
+        case SceneFilter::Threshold:
+            plotter.ApplyThreshold(command.values[0]);
+            break;
+        case SceneFilter::Invert:
+            plotter.InvertBrightness();
+            break;
+        case SceneFilter::Brightness:
+            plotter.AdjustBrightness(command.values[0]);
+            break;
+        case SceneFilter::Edges:
+            plotter.DetectEdges(command.values[0]);
+            break;
+        case SceneFilter::Equalize:
+            plotter.EqualizeHistogram();
+            break;
+        case SceneFilter::AutoContrast:
+            plotter.AutoContrast(command.values[0]);
+            break;
+        }
+    }
+    std::unique_ptr<plotter::Plotter> CreateScenePlotter(const plotter::PlotterConfig& config)
+    {
+        if (!plotter::Config::ValidateConfig(config))
+        {
+            throw SceneError("Scene config is invalid");
+        }
+        return plotter::PlotterFactory::CreatePlotter(config);
+    }
+} // anonymous namespace
+
+namespace plotter
+{
+
+size_t Scene::Execute(const std::string_view text, Plotter& plotter)
+{
+    // Plotter уже есть, поэтому раздел "config" не разбирается: в нем допустимы любые ключи
+    return Stream(text, nullptr,
+        [&plotter](const SceneCommand& command) { ExecuteCommand(command, plotter); }, nullptr);
+}
+
+size_t Scene::ExecuteFile(const std::filesystem::path& path, Plotter& plotter)
+{
+    const MappedFile file(path);
+    file.AdviseSequential();
+    return Stream(file.View(), nullptr,
+        [&plotter](const SceneCommand& command) { ExecuteCommand(command, plotter); }, &file);
+}
+
+std::unique_ptr<Plotter> Scene::Load(const std::string_view text)
+{
+    std::unique_ptr<Plotter> plotter;
+    Read(text, [&plotter](const PlotterConfig& config) { plotter = CreateScenePlotter(config); },
+        [&plotter](const SceneCommand& command) { ExecuteCommand(command, *plotter); });
+    return plotter;
+}
+
+std::unique_ptr<Plotter> Scene::LoadFile(const std::filesystem::path& path)
+{
+    std::unique_ptr<Plotter> plotter;
+    ReadFile(path, [&plotter](const PlotterConfig& config) { plotter = CreateScenePlotter(config); },
+        [&plotter](const SceneCommand& command) { ExecuteCommand(command, *plotter); });
+    return plotter;
+}
+
+size_t Scene::Read(const std::string_view text, const std::function<void(const PlotterConfig&)>& on_config,
+    const std::function<void(const SceneCommand&)>& on_command)
+{
+    return Stream(text, on_config, on_command, nullptr);
+}
+
+size_t Scene::ReadFile(const std::filesystem::path& path, const std::function<void(const PlotterConfig&)>& on_config,
+    const std::function<void(const SceneCommand&)>& on_command)
+{
+    const MappedFile file(path);
+    file.AdviseSequential();
+    return Stream(file.View(), on_config, on_command, &file);
+}
+
+SceneCommand Scene::ParseCommand(const json::ValueView& value)
+{
+    const CommandArgs args(value);
+    const std::string_view name = args.Text("op");
+    const auto it = std::lower_bound(OPS.begin(), OPS.end(), name,
+        [](const auto& entry, const std::string_view op) { return entry.first < op; });
+    if (it == OPS.end() || it->first != name)
+    {
+        throw SceneError("unknown op '" + std::string(name) + "'");
+    }
+
+    SceneCommand command;
+    command.op = it->second;
+    // Ключи параметров по порядку args
+    const auto read_ints = [&](const std::initializer_list<std::string_view> keys)
+    {
+        size_t i = 0;
+        for (const std::string_view key : keys)
+        {
+            command.args[i++] = args.Int(key);
+        }
+    };
+
+    switch (command.op)
+    {
+    case SceneOp::Clear:
+        break;
+    case SceneOp::Line:
+        read_ints({ "x1", "y1", "x2", "y2" });
+        ReadPaint(args, command);
+        break;
+    case SceneOp::Rect:
+        read_ints({ "x1", "y1", "x2", "y2" });
+        command.fill = args.Flag("fill");
+        ReadPaint(args, command);
+        break;
+    case SceneOp::Triangle:
+        read_ints({ "x1", "y1", "x2", "y2", "x3", "y3" });
+        command.fill = args.Flag("fill");
+        ReadPaint(args, command);
+        break;
+    case SceneOp::Circle:
+        read_ints({ "x", "y", "radius" });
+        command.fill = args.Flag("fill");
+        ReadPaint(args, command);
+        break;
+    case SceneOp::FloodFill:
+    case SceneOp::ScanlineFill:
+        read_ints({ "x", "y" });
+        ReadPaint(args, command);
+        break;
+    case SceneOp::LinearGradient:
+        read_ints({ "x1", "y1", "x2", "y2" });
+        command.values = { args.Number("start"), args.Number("end") };
+        command.dither = args.Dither();
+        break;
+    case SceneOp::RadialGradient:
+        read_ints({ "x", "y", "radius" });
+        command.values = { args.Number("start"), args.Number("end") };
+        command.dither = args.Dither();
+        break;
+    case SceneOp::Filter:
+        ReadFilter(args, command);
+        break;
+    }
+    return command;
+}
+
+void Scene::ExecuteCommand(const json::ValueView& command, Plotter& plotter)
+{
+    ExecuteCommand(ParseCommand(command), plotter);
+}
+
+void Scene::ExecuteCommand(const SceneCommand& command, Plotter& plotter)
+{
+    const auto& a = command.args;
+    GrayscalePlotter* const grayscale = command.uses_brightness ? &RequireGrayscale(plotter, "'brightness'") : nullptr;
+    const double brightness = command.values[0];
+
+    switch (command.op)
+    {
+    case SceneOp::Clear:
+        plotter.GetCanvas().Clear(plotter.GetCanvas().Background());
+        break;
+    case SceneOp::Line:
+        if (grayscale)
+        {
+            grayscale->DrawLine(a[0], a[1], a[2], a[3], brightness, command.dither);
+        }
+        else
+        {
+            plotter.DrawLine(a[0], a[1], a[2], a[3], command.brush);
+        }
+        break;
+    case SceneOp::Rect:
+        if (grayscale)
+        {
+            grayscale->DrawRectangle(a[0], a[1], a[2], a[3], brightness, command.fill, command.dither);
+        }
+        else
+        {
+            plotter.DrawRectangle(a[0], a[1], a[2], a[3], command.brush, command.fill);
+        }
+        break;
+    case SceneOp::Triangle:
+        if (grayscale)
+        {
+            grayscale->DrawTriangle(a[0], a[1], a[2], a[3], a[4], a[5], brightness, command.fill, command.dither);
+        }
+        else
+        {
+            plotter.DrawTriangle(a[0], a[1], a[2], a[3], a[4], a[5], command.brush, command.fill);
+        }
+        break;
+    case SceneOp::Circle:
+        if (grayscale)
+        {
+            grayscale->DrawCircle(a[0], a[1], a[2], brightness, command.fill, command.dither);
+        }
+        else
+        {
+            plotter.DrawCircle(a[0], a[1], a[2], command.brush, command.fill);
+        }
+        break;
+    case SceneOp::FloodFill:
+        if (grayscale)
+        {
+            grayscale->FloodFill(a[0], a[1], brightness, command.dither);
+        }
+        else
+        {
+            plotter.FloodFill(a[0], a[1], command.brush);
+        }
+        break;
+    case SceneOp::ScanlineFill:
+        if (grayscale)
+        {
+            grayscale->ScanlineFill(a[0], a[1], brightness, command.dither);
+        }
+        else
+        {
+            plotter.ScanlineFill(a[0], a[1], command.brush);
+        }
+        break;
+    case SceneOp::LinearGradient:
+        RequireGrayscale(plotter, "'linear_gradient'").DrawLinearGradient(a[0], a[1], a[2], a[3],
+            command.values[0], command.values[1], command.dither);
+        break;
+    case SceneOp::RadialGradient:
+        RequireGrayscale(plotter, "'radial_gradient'").DrawRadialGradient(a[0], a[1], a[2],
+            command.values[0], command.values[1], command.dither);
+        break;
+    case SceneOp::Filter:
+        ApplyFilter(command, RequireGrayscale(plotter, "'filter'"));
+        break;
+    }
+}
+
+size_t Scene::Stream(const std::string_view text, const std::function<void(const PlotterConfig&)>& on_config,
+    const std::function<void(const SceneCommand&)>& on_command, const MappedFile* const file)
+{
+    json::ValueReader reader(text);
+    size_t count = 0;
+    bool has_config = false;
+    bool has_commands = false;
+
+    reader.Expect('{');
+    if (!reader.TryConsume('}'))
+    {
+        do
+        {
+            const std::string_view key = reader.ReadKey();
+            if (key == "config")
+            {
+                if (has_config || has_commands)
+                {
+                    reader.Fail(has_config ? "Duplicate key 'config'" : "'config' must precede 'commands'");
+                }
+                has_config = true;
+                const json::ValueView& config = reader.ReadValue();
+                if (on_config)
+                {
+                    on_config(Config::FromJson(config));
+                }
+            }
+            else if (key == "commands")
+            {
+                if (has_commands)
+                {
+                    reader.Fail("Duplicate key 'commands'");
+                }
+                has_commands = true;
+                if (!has_config && on_config)
+                {
+                    on_config(Config::DefaultConfig());
+                }
+                has_config = true;
+                ReadCommands(reader, on_command, count, file);
+            }
+            else
+            {
+                static_cast<void>(reader.ReadValue());
+            }
+        } while (reader.TryConsume(','));
+        reader.Expect('}');
+    }
+    if (!reader.AtEnd())
+    {
+        reader.Fail("Unexpected characters after the document");
+    }
+
+    if (!has_config && on_config)
+    {
+        on_config(Config::DefaultConfig());
+    }
+    return count;
+}
+
+void Scene::ReadCommands(json::ValueReader& reader, const std::function<void(const SceneCommand&)>& on_command,
+    size_t& count, const MappedFile* const file)
+{
+    size_t released = 0;
+    reader.Expect('[');
+    if (reader.TryConsume(']'))
+    {
+        return;
+    }
+
+    do
+    {
+        const json::ValueView& value = reader.ReadValue();
+        try
+        {
+            on_command(ParseCommand(value));
+        }
+        catch (const SceneError& e)
+        {
+            throw SceneError("Scene command " + std::to_string(count) + ": " + e.what());
+        }
+        ++count;
+
+        if (file && reader.Offset() - released >= RELEASE_CHUNK)
+        {
+            file->Release(released, reader.Offset() - released);
+            released = reader.Offset();
+        }
+    } while (reader.TryConsume(','));
+    reader.Expect(']');
+}
+
+} // namespace plotter
@@ -0,0 +1,139 @@
+#pragma once
+#include "Config.hpp"
+#include "Dithering.hpp"
+#include "Plotter.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace json
+{
+class ValueReader;
+class ValueView;
+} // namespace json
+
+namespace plotter
+{
+class MappedFile;
+
+// Ошибка в описании сцены: неизвестная команда, нет параметра, параметр не того типа.
+// Синтаксические ошибки JSON — json::ParsingError
+class SceneError : public std::runtime_error
+{
+public:
+    using runtime_error::runtime_error;
+};
+
+enum class SceneOp : std::uint8_t
+{
+    Clear,
+    Line,
+    Rect,
+    Triangle,
+    Circle,
+    FloodFill,
+    ScanlineFill,
+    LinearGradient,
+    RadialGradient,
+    Filter,
+};
+
+enum class SceneFilter : std::uint8_t
+{
+    BoxBlur,
+    GaussianBlur,
+    Median,
+    Erosion,
+    Dilation,
+    Opening,
+    Closing,
+    Threshold,
+    Invert,
+    Brightness,
+    Edges,
+    Equalize,
+    AutoContrast,
+};
+
+// Команда сцены с проверенными параметрами. Координаты и целые параметры лежат в args
+// в порядке описания команды ниже, яркости и вещественные параметры — в values:
+// brightness фигуры, start и end градиента, value / factor / threshold / clip фильтра.
+// Целый параметр фильтра (size или radius) — args[0]
+struct SceneCommand
+{
+    SceneOp op = SceneOp::Clear;
+    SceneFilter filter = SceneFilter::BoxBlur;
+    // Фигура рисуется яркостью values[0], иначе символом brush
+    bool uses_brightness = false;
+    bool fill = false;
+    char brush = '\0';
+    Dither dither = Dither::None;
+    std::array<int, 6> args{};
+    std::array<double, 2> values{};
+
+    friend bool operator==(const SceneCommand& lhs, const SceneCommand& rhs) noexcept = default;
+};
+
+// Сцена — объект JSON с разделами "config" (как у Config) и "commands" (массив команд рисования).
+// Команды читаются по одной через json::ValueReader и сразу исполняются, дерево всего документа
+// не строится, поэтому размер сцены ограничен только размером файла.
+//
+// Команда — объект с полем "op":
+//   "clear"                                    — заливка фоном канваса
+//   "line"            x1 y1 x2 y2              — отрезок
+//   "rect"            x1 y1 x2 y2 [fill]       — прямоугольник
+//   "triangle"        x1 y1 x2 y2 x3 y3 [fill] — треугольник
+//   "circle"          x y radius [fill]        — окружность
+//   "flood_fill"      x y                      — заливка FloodFill
+//   "scanline_fill"   x y                      — заливка ScanlineFill
+//   "linear_gradient" x1 y1 x2 y2 start end    — градиент яркости от (x1, y1) к (x2, y2)
+//   "radial_gradient" x y radius start end     — градиент яркости от центра к краю
+//   "filter"          name [параметры]         — фильтр GrayscalePlotter: box_blur [size], gaussian_blur [size],
+//                     median [radius], erosion / dilation / opening / closing [radius], threshold value,
+//                     invert, brightness factor, edges [threshold], equalize, auto_contrast [clip]
+// Фигуры и заливки рисуются символом "brush" или, в GrayscalePlotter, яркостью "brightness".
+// Яркость и градиенты принимают "dither": "none", "ordered", "floyd_steinberg" или "atkinson".
+// Градиенты, фильтры и яркость требуют GrayscalePlotter
+class Scene
+{
+public:
+    // Исполняет команды сцены в plotter, раздел "config" проверяется только синтаксически,
+    // поэтому может быть неполным.
+    // Возвращает число исполненных команд
+    static size_t Execute(std::string_view text, Plotter& plotter);
+    // Как Execute, но читает отображенный в память файл и отпускает уже прочитанные страницы
+    static size_t ExecuteFile(const std::filesystem::path& path, Plotter& plotter);
+
+    // Создает plotter по разделу "config" через PlotterFactory и исполняет команды.
+    // Без раздела "config" используется Config::DefaultConfig. Раздел должен идти до "commands"
+    static std::unique_ptr<Plotter> Load(std::string_view text);
+    static std::unique_ptr<Plotter> LoadFile(const std::filesystem::path& path);
+
+    // Читает сцену потоком без исполнения: on_config вызывается один раз до первой команды
+    // (с Config::DefaultConfig, если раздела "config" нет), on_command — для каждой команды по порядку.
+    // Возвращает число команд
+    static size_t Read(std::string_view text, const std::function<void(const PlotterConfig&)>& on_config,
+        const std::function<void(const SceneCommand&)>& on_command);
+    static size_t ReadFile(const std::filesystem::path& path, const std::function<void(const PlotterConfig&)>& on_config,
+        const std::function<void(const SceneCommand&)>& on_command);
+
+    // Проверяет параметры команды JSON. Бросает SceneError
+    static SceneCommand ParseCommand(const json::ValueView& command);
+    // Бросает SceneError, если команде нужен GrayscalePlotter, а plotter другой
+    static void ExecuteCommand(const SceneCommand& command, Plotter& plotter);
+    static void ExecuteCommand(const json::ValueView& command, Plotter& plotter);
+
+private:
+    // Пустой on_config: раздел "config" только пропускается без Config::FromJson
+    static size_t Stream(std::string_view text, const std::function<void(const PlotterConfig&)>& on_config,
+        const std::function<void(const SceneCommand&)>& on_command, const MappedFile* file);
+    static void ReadCommands(json::ValueReader& reader, const std::function<void(const SceneCommand&)>& on_command,
+        size_t& count, const MappedFile* file);
+};
+
+} // namespace plotter
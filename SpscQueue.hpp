@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace plotter
+{
+
+// Ограниченная очередь без блокировок для одного потока-производителя и одного потока-потребителя.
+// Индексы чтения и записи только растут, ячейка — индекс по модулю емкости.
+// Каждый индекс меняет только свой поток, поэтому хватает атомарной загрузки и записи.
+// Push ждет свободной ячейки, а Pop — элемента через std::atomic::wait, не занимая процессор
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(const size_t capacity) : slots_(capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Queue capacity must be positive");
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    [[nodiscard]] size_t Capacity() const noexcept { return slots_.size(); }
+
+    // Только для производителя. false, если очередь заполнена
+    bool TryPush(T& value)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+        {
+            return false;
+        }
+        Publish(tail, value);
+        return true;
+    }
+
+    // Только для производителя. Ждет, пока потребитель освободит ячейку
+    void Push(T value)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        while (tail - head == slots_.size())
+        {
+            head_.wait(head, std::memory_order_acquire);
+            head = head_.load(std::memory_order_acquire);
+        }
+        Publish(tail, value);
+    }
+
+    // Только для потребителя. false, если очередь пуста
+    bool TryPop(T& value)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head)
+        {
+            return false;
+        }
+        Consume(head, value);
+        return true;
+    }
+
+    // Только для потребителя. Ждет, пока производитель добавит элемент
+    T Pop()
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        while (tail == head)
+        {
+            tail_.wait(tail, std::memory_order_acquire);
+            tail = tail_.load(std::memory_order_acquire);
+        }
+        T value;
+        Consume(head, value);
+        return value;
+    }
+
+private:
+    std::vector<T> slots_;
+    // Разные линии кэша, чтобы потоки не мешали друг другу
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+
+    void Publish(const size_t tail, T& value)
+    {
+        slots_[tail % slots_.size()] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        tail_.notify_one();
+    }
+
+    void Consume(const size_t head, T& value)
+    {
+        value = std::move(slots_[head % slots_.size()]);
+        head_.store(head + 1, std::memory_order_release);
+        head_.notify_one();
+    }
+};
+
+} // namespace plotter
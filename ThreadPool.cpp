@@ -0,0 +1,127 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace plotter
+{
+
+ThreadPool::ThreadPool(const int thread_count)
+{
+    if (thread_count < 1)
+    {
+        throw std::invalid_argument("Thread count can't be less than 1");
+    }
+
+    workers_.reserve(thread_count - 1);
+    for (int i = 1; i < thread_count; ++i)
+    {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+int ThreadPool::ThreadCount() const noexcept
+{
+    return static_cast<int>(workers_.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(const int task_count, const std::function<void(int)>& task)
+{
+    if (task_count <= 0)
+    {
+        return;
+    }
+
+    // Без рабочих потоков или для одной задачи нет смысла в синхронизации
+    if (workers_.empty() || task_count == 1)
+    {
+        for (int i = 0; i < task_count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    // Пакет принадлежит вызову: одновременные вызовы не перезаписывают задачи и счетчики друг друга
+    const auto batch = std::make_shared<Batch>(Batch{ &task, task_count, 0, task_count, nullptr });
+    std::unique_lock lock(mutex_);
+    batches_.push_back(batch);
+    work_ready_.notify_all();
+
+    RunTasks(lock, *batch);
+    // После последней задачи пакета рабочие потоки к task больше не обращаются
+    work_done_.wait(lock, [&batch] { return batch->pending_tasks == 0; });
+
+    if (batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    std::unique_lock lock(mutex_);
+
+    while (true)
+    {
+        work_ready_.wait(lock, [this] { return stop_ || !batches_.empty(); });
+        if (stop_)
+        {
+            return;
+        }
+
+        // Пакет остается живым, пока поток выполняет его задачу
+        const std::shared_ptr<Batch> batch = batches_.front();
+        RunTasks(lock, *batch);
+    }
+}
+
+void ThreadPool::RunTasks(std::unique_lock<std::mutex>& lock, Batch& batch)
+{
+    while (batch.next_task < batch.task_count)
+    {
+        const int index = batch.next_task++;
+        if (batch.next_task == batch.task_count)
+        {
+            // Все задачи розданы: новым потокам достанется следующий пакет
+            std::erase_if(batches_, [&batch](const std::shared_ptr<Batch>& queued) { return queued.get() == &batch; });
+        }
+        const auto* task = batch.task;
+
+        lock.unlock();
+        std::exception_ptr error;
+        try
+        {
+            (*task)(index);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error && !batch.error)
+        {
+            batch.error = error;
+        }
+        if (--batch.pending_tasks == 0)
+        {
+            work_done_.notify_all();
+        }
+    }
+}
+
+} // namespace plotter
@@ -0,0 +1,59 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plotter
+{
+
+// Пул потоков для параллельной обработки канваса.
+// Потоки создаются один раз и переиспользуются между вызовами ParallelFor.
+class ThreadPool
+{
+public:
+    // thread_count — общее число потоков, включая вызывающий
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] int ThreadCount() const noexcept;
+
+    // Выполняет task(i) для всех i из [0, task_count) и дожидается завершения.
+    // Вызывающий поток тоже берет задачи. Первое исключение из задач пробрасывается наружу.
+    // Можно вызывать из нескольких потоков одновременно: пакеты выполняются по очереди поступления
+    void ParallelFor(int task_count, const std::function<void(int)>& task);
+
+private:
+    // Задачи одного вызова ParallelFor. Поля защищены mutex_
+    struct Batch
+    {
+        const std::function<void(int)>* task;
+        int task_count;
+        int next_task = 0;
+        int pending_tasks;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+
+    // Пакеты, в которых остались невзятые задачи, защищены mutex_
+    std::deque<std::shared_ptr<Batch>> batches_;
+    bool stop_ = false;
+
+    void WorkerLoop();
+    // Забирает и выполняет задачи пакета, пока они не закончатся.
+    // Вызывается с захваченным lock
+    void RunTasks(std::unique_lock<std::mutex>& lock, Batch& batch);
+};
+
+} // namespace plotter
@@ -13,11 +13,30 @@
 // Обычно использую Boost, в данной работе предполагаю не требовалось использовать дополнительные библиотеки.
 
 #include "test_runner.h"
+#include "Benchmark.hpp"
+#include "BinaryScene.hpp"
 #include "Canvas.hpp"
 #include "CanvasIterators.hpp"
+#include "CanvasPyramid.hpp"
 #include "Config.hpp"
+#include "FramePipeline.hpp"
 #include "GrayscalePlotter.hpp"
+#include "JsonView.hpp"
+#include "LiveScene.hpp"
+#include "PlotterFactory.hpp"
+#include "Profiling.hpp"
+#include "Regression.hpp"
+#include "Resampling.hpp"
+#include "Scene.hpp"
+#include "SpscQueue.hpp"
 #include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
 
 using namespace plotter;
 
@@ -113,6 +132,2097 @@ void TestGrayscalePlotter() {
     }
 }
 
+void TestParallelFilters() {
+    auto draw_scene = [](GrayscalePlotter& plotter)
+    {
+        plotter.DrawCircle(18, 20, 12, 0.8, true);
+        plotter.DrawRectangle(2, 30, 30, 50, 0.4, true);
+        plotter.DrawLinearGradient(0, 0, 36, 10, 0.0, 1.0);
+    };
+
+    GrayscalePlotter sequential(37, 53, ' ');
+    GrayscalePlotter parallel(37, 53, ' ');
+    parallel.SetThreadCount(4);
+    ASSERT_EQUAL(parallel.GetThreadCount(), 4);
+    draw_scene(sequential);
+    draw_scene(parallel);
+
+    sequential.ApplyGaussianBlur(5);
+    parallel.ApplyGaussianBlur(5);
+    sequential.ApplyBoxBlur(3);
+    parallel.ApplyBoxBlur(3);
+    sequential.AdjustBrightness(1.5);
+    parallel.AdjustBrightness(1.5);
+    sequential.ApplyThreshold(0.3);
+    parallel.ApplyThreshold(0.3);
+    sequential.InvertBrightness();
+    parallel.InvertBrightness();
+
+    const Canvas& lhs = std::as_const(sequential).GetCanvas();
+    ASSERT(std::equal(lhs.Data(), lhs.Data() + lhs.Size(), std::as_const(parallel).GetCanvas().Data()));
+
+    ASSERT_THROWS(sequential.SetThreadCount(0), std::invalid_argument);
+
+    {
+        // Константные методы одного плоттера разделяют пул потоков
+        GrayscalePlotter shared(200, 100, ' ');
+        shared.SetThreadCount(4);
+        shared.DrawLinearGradient(0, 0, 199, 99, 0.0, 1.0);
+        shared.DrawCircle(100, 50, 30, 0.3, true);
+
+        std::vector<float> expected(200 * 100);
+        shared.ExportBrightness(expected.data(), 200);
+
+        auto export_repeatedly = [&shared, &expected](bool& same)
+        {
+            std::vector<float> levels(200 * 100);
+            for (int i = 0; i < 20; ++i)
+            {
+                std::fill(levels.begin(), levels.end(), -1.0f);
+                shared.ExportBrightness(levels.data(), 200);
+                same = same && levels == expected;
+            }
+        };
+
+        bool first_same = true;
+        bool second_same = true;
+        std::thread first(export_repeatedly, std::ref(first_same));
+        std::thread second(export_repeatedly, std::ref(second_same));
+        first.join();
+        second.join();
+        ASSERT(first_same);
+        ASSERT(second_same);
+    }
+}
+
+void TestPointLookupTables() {
+    {
+        Canvas canvas(4, 2, 'a');
+        CharMap table = IdentityCharMap();
+        table[CharCode('a')] = 'b';
+        canvas(3, 1) = 'c';
+        canvas.RemapRows(1, 2, table);
+        ASSERT_EQUAL(canvas(0, 0), 'a');
+        ASSERT_EQUAL(canvas(0, 1), 'b');
+        ASSERT_EQUAL(canvas(3, 1), 'c');
+        canvas.Remap(table);
+        ASSERT_EQUAL(canvas(0, 0), 'b');
+        ASSERT_THROWS(canvas.RemapRows(1, 3, table), std::out_of_range);
+    }
+
+    {
+        // Замена части строк не проходит мимо статистики
+        Canvas canvas(4, 4, 'a');
+        canvas.EnableStatistics();
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('a')], 16);
+        CharMap table = IdentityCharMap();
+        table[CharCode('a')] = 'b';
+        canvas.RemapRows(0, 2, table);
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('a')], 8);
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('b')], 8);
+
+        // Полосами: статистика переносится после всех полос
+        table[CharCode('b')] = 'c';
+        canvas.Remap(table, [](const int rows, const Canvas::RowRemap& remap)
+        {
+            remap(0, 1);
+            remap(1, rows);
+        });
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('a')], 0);
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('b')], 8);
+        ASSERT_EQUAL(canvas.Statistics()[CharCode('c')], 8);
+        ASSERT_EQUAL(canvas(0, 0), 'c');
+        ASSERT_EQUAL(canvas(0, 3), 'b');
+    }
+
+    {
+        GrayscalePlotter plotter(5, 1, ' ', { ' ', '.', '+', '#' });
+        plotter.GetCanvas()(0, 0) = '.';
+        plotter.GetCanvas()(1, 0) = '+';
+        plotter.GetCanvas()(2, 0) = '#';
+        plotter.GetCanvas()(3, 0) = 'x';
+
+        plotter.AdjustBrightness(2.0);
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '+');
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(1, 0), '#');
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(3, 0), 'x');
+
+        plotter.InvertBrightness();
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '.');
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(4, 0), '#');
+
+        plotter.ApplyThreshold(0.5);
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), ' ');
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(4, 0), '#');
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(3, 0), 'x');
+
+        ASSERT_EQUAL(plotter.LevelToChar(0), ' ');
+        ASSERT_EQUAL(plotter.LevelToChar(255), '#');
+        ASSERT_EQUAL(plotter.LevelToChar(128), '.');
+    }
+}
+
+void TestFilterPipeline() {
+    auto draw_scene = [](GrayscalePlotter& plotter)
+    {
+        plotter.DrawLinearGradient(0, 0, 29, 19, 0.0, 1.0);
+        plotter.DrawCircle(15, 10, 6, 0.3, true);
+    };
+
+    GrayscalePlotter sequential(30, 20, ' ');
+    GrayscalePlotter fused(30, 20, ' ');
+    draw_scene(sequential);
+    draw_scene(fused);
+
+    sequential.AdjustBrightness(1.4);
+    sequential.ApplyThreshold(0.2);
+    sequential.ApplyBoxBlur(3);
+    sequential.InvertBrightness();
+    sequential.AdjustBrightness(0.7);
+
+    auto pipeline = fused.Pipeline();
+    pipeline.Scale(1.4).Threshold(0.2).BoxBlur(3).Invert().Scale(0.7);
+    ASSERT(!pipeline.Empty());
+    pipeline.Apply();
+    ASSERT(pipeline.Empty());
+
+    const Canvas& lhs = std::as_const(sequential).GetCanvas();
+    ASSERT(std::equal(lhs.Data(), lhs.Data() + lhs.Size(), std::as_const(fused).GetCanvas().Data()));
+
+    ASSERT_THROWS(fused.Pipeline().Gamma(0.0), std::invalid_argument);
+}
+
+void TestGradientRasterizers() {
+    // Попиксельные формулы, по которым градиенты рисовались до пошагового вычисления
+    auto linear_reference = [](GrayscalePlotter& plotter, int x1, int y1, int x2, int y2, double from, double to)
+    {
+        std::vector<std::uint8_t> levels;
+        std::string chars;
+        const int width = x2 - x1;
+        const int height = y2 - y1;
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        for (int y = 0; y < canvas.Height(); ++y)
+        {
+            for (int x = 0; x < canvas.Width(); ++x)
+            {
+                const bool inside = x >= x1 && x <= x2 && y >= y1 && y <= y2;
+                const double ratio = (static_cast<double>(x - x1) / width + static_cast<double>(y - y1) / height) / 2.0;
+                const double brightness = from + ratio * (to - from);
+                chars.push_back(inside ? plotter.BrightnessToChar(brightness) : canvas(x, y));
+                levels.push_back(GrayscalePlotter::BrightnessToLevel(brightness));
+            }
+        }
+        return std::make_pair(chars, levels);
+    };
+    auto radial_reference = [](GrayscalePlotter& plotter, int cx, int cy, int radius, double from, double to)
+    {
+        std::vector<std::uint8_t> levels;
+        std::string chars;
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        for (int y = 0; y < canvas.Height(); ++y)
+        {
+            for (int x = 0; x < canvas.Width(); ++x)
+            {
+                const double distance = std::sqrt(std::pow(x - cx, 2) + std::pow(y - cy, 2));
+                const double brightness = from + distance / radius * (to - from);
+                const bool inside = distance <= radius;
+                chars.push_back(inside ? plotter.BrightnessToChar(brightness) : canvas(x, y));
+                levels.push_back(GrayscalePlotter::BrightnessToLevel(brightness));
+            }
+        }
+        return std::make_pair(chars, levels);
+    };
+    auto chars_of = [](const GrayscalePlotter& plotter)
+    {
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+    };
+
+    struct Case
+    {
+        int x1, y1, x2, y2;
+        double from, to;
+    };
+    const std::vector<Case> cases = {
+        { 0, 0, 69, 49, 0.0, 1.0 }, { -20, 5, 90, 30, 1.0, 0.0 }, { 3, 3, 3, 40, 0.2, 0.9 },
+        { 5, 7, 60, 7, 0.0, 1.0 }, { 10, -30, 200, 140, -0.5, 1.7 }, { 0, 0, 69, 49, 0.37, 0.37 },
+        { 1, 2, 1997, 48, 0.0, 1.0 }, { 0, 0, 69, 49, 1e12, -1e12 },
+    };
+    for (const int threads : { 1, 4 })
+    {
+        for (const auto& palette : { GrayscalePlotter::DefaultPalette(), std::vector<char>{ ' ', '#' } })
+        {
+            for (const Case& c : cases)
+            {
+                GrayscalePlotter plotter(70, 50, '?', palette);
+                plotter.SetThreadCount(threads);
+                const auto linear = linear_reference(plotter, c.x1, c.y1, c.x2, c.y2, c.from, c.to);
+                plotter.DrawLinearGradient(c.x1, c.y1, c.x2, c.y2, c.from, c.to);
+                ASSERT(chars_of(plotter) == linear.first);
+
+                const int radius = std::abs(c.x2 - c.x1) / 2;
+                GrayscalePlotter circles(70, 50, '?', palette);
+                circles.SetThreadCount(threads);
+                const auto radial = radial_reference(circles, c.x1, c.y2, radius, c.from, c.to);
+                circles.DrawRadialGradient(c.x1, c.y2, radius, c.from, c.to);
+                ASSERT(chars_of(circles) == radial.first);
+            }
+        }
+    }
+
+    // В слое яркости сравниваются уровни внутри фигуры
+    GrayscalePlotter plotter(70, 50, ' ');
+    plotter.EnableBrightnessPlane();
+    std::vector<std::uint8_t> levels(70 * 50);
+    for (const Case& c : cases)
+    {
+        const auto linear = linear_reference(plotter, c.x1, c.y1, c.x2, c.y2, c.from, c.to);
+        plotter.DrawLinearGradient(c.x1, c.y1, c.x2, c.y2, c.from, c.to);
+        plotter.ExportBrightness(levels.data(), 70);
+        for (int y = std::max(c.y1, 0); y <= std::min(c.y2, 49); ++y)
+        {
+            for (int x = std::max(c.x1, 0); x <= std::min(c.x2, 69); ++x)
+            {
+                ASSERT_EQUAL(static_cast<int>(levels[y * 70 + x]), static_cast<int>(linear.second[y * 70 + x]));
+            }
+        }
+    }
+    const auto radial = radial_reference(plotter, 35, 20, 23, 1.0, 0.1);
+    plotter.DrawRadialGradient(35, 20, 23, 1.0, 0.1);
+    plotter.ExportBrightness(levels.data(), 70);
+    ASSERT_EQUAL(static_cast<int>(levels[20 * 70 + 35]), static_cast<int>(radial.second[20 * 70 + 35]));
+    ASSERT_EQUAL(static_cast<int>(levels[20 * 70 + 57]), static_cast<int>(radial.second[20 * 70 + 57]));
+    ASSERT_EQUAL(static_cast<int>(levels[3 * 70 + 35]), static_cast<int>(radial.second[3 * 70 + 35]));
+
+    // Нулевой радиус закрашивает центр, как и раньше
+    GrayscalePlotter dot(5, 5, '?');
+    dot.DrawRadialGradient(2, 2, 0, 1.0, 1.0);
+    ASSERT_EQUAL(std::as_const(dot).GetCanvas()(2, 2), ' ');
+    ASSERT_EQUAL(std::as_const(dot).GetCanvas()(2, 1), '?');
+}
+
+void TestRankFilters() {
+    const std::vector<char> palette = GrayscalePlotter::DefaultPalette();
+    auto make = [&](GrayscalePlotter& plotter)
+    {
+        Canvas& canvas = plotter.GetCanvas();
+        for (int y = 0; y < canvas.Height(); ++y)
+        {
+            for (int x = 0; x < canvas.Width(); ++x)
+            {
+                canvas(x, y) = palette[(x * 7 + y * 13 + x * y) % palette.size()];
+            }
+        }
+    };
+    auto index_of = [&](const char symbol)
+    {
+        return static_cast<int>(std::find(palette.begin(), palette.end(), symbol) - palette.begin());
+    };
+
+    // Медиана с повтором краев и экстремумы с обрезанным окном, прямым перебором
+    auto reference = [&](const Canvas& canvas, int radius, int mode)
+    {
+        std::string result;
+        for (int y = 0; y < canvas.Height(); ++y)
+        {
+            for (int x = 0; x < canvas.Width(); ++x)
+            {
+                std::vector<int> window;
+                for (int dy = -radius; dy <= radius; ++dy)
+                {
+                    for (int dx = -radius; dx <= radius; ++dx)
+                    {
+                        const int sx = x + dx;
+                        const int sy = y + dy;
+                        if (mode == 0)
+                        {
+                            window.push_back(index_of(canvas(std::clamp(sx, 0, canvas.Width() - 1),
+                                std::clamp(sy, 0, canvas.Height() - 1))));
+                        }
+                        else if (canvas.InBounds(sx, sy))
+                        {
+                            window.push_back(index_of(canvas(sx, sy)));
+                        }
+                    }
+                }
+                std::sort(window.begin(), window.end());
+                const int index = mode == 0 ? window[window.size() / 2] : mode == 1 ? window.front() : window.back();
+                result.push_back(palette[index]);
+            }
+        }
+        return result;
+    };
+    auto chars_of = [](const GrayscalePlotter& plotter)
+    {
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+    };
+
+    for (const int threads : { 1, 3 })
+    {
+        for (const int radius : { 0, 1, 2, 5 })
+        {
+            GrayscalePlotter plotter(37, 29, ' ');
+            plotter.SetThreadCount(threads);
+            make(plotter);
+            const std::string median = reference(std::as_const(plotter).GetCanvas(), radius, 0);
+            const std::string eroded = reference(std::as_const(plotter).GetCanvas(), radius, 1);
+            const std::string dilated = reference(std::as_const(plotter).GetCanvas(), radius, 2);
+
+            plotter.ApplyMedianFilter(radius);
+            ASSERT(chars_of(plotter) == median);
+
+            make(plotter);
+            plotter.ApplyErosion(radius);
+            ASSERT(chars_of(plotter) == eroded);
+
+            make(plotter);
+            plotter.ApplyDilation(radius);
+            ASSERT(chars_of(plotter) == dilated);
+        }
+    }
+
+    // Одиночные выбросы исчезают, стороны прямоугольника остаются на месте
+    GrayscalePlotter noisy(20, 12, ' ');
+    noisy.DrawRectangle(5, 3, 14, 8, 1.0, true);
+    const std::string clean = chars_of(noisy);
+    noisy.GetCanvas()(1, 1) = '@';
+    noisy.GetCanvas()(9, 5) = ' ';
+    noisy.ApplyMedianFilter(1);
+    ASSERT_EQUAL(std::as_const(noisy).GetCanvas()(1, 1), ' ');
+    ASSERT_EQUAL(std::as_const(noisy).GetCanvas()(9, 5), '@');
+    ASSERT_EQUAL(std::as_const(noisy).GetCanvas()(5, 5), '@');
+    ASSERT_EQUAL(std::as_const(noisy).GetCanvas()(4, 5), ' ');
+    ASSERT_EQUAL(std::as_const(noisy).GetCanvas()(10, 8), '@');
+
+    // Размыкание убирает точку, замыкание заделывает дыру
+    noisy.GetCanvas().Clear(' ');
+    noisy.DrawRectangle(5, 3, 14, 8, 1.0, true);
+    noisy.GetCanvas()(1, 1) = '@';
+    noisy.ApplyOpening(1);
+    ASSERT(chars_of(noisy) == clean);
+    noisy.GetCanvas()(9, 5) = ' ';
+    noisy.ApplyClosing(1);
+    ASSERT(chars_of(noisy) == clean);
+
+    // В слое яркости результат тот же, что и по символам
+    GrayscalePlotter layered(37, 29, ' ');
+    make(layered);
+    const std::string median = reference(std::as_const(layered).GetCanvas(), 2, 0);
+    layered.EnableBrightnessPlane();
+    layered.ApplyMedianFilter(2);
+    ASSERT(chars_of(layered) == median);
+
+    ASSERT_THROWS(noisy.ApplyMedianFilter(-1), std::invalid_argument);
+    ASSERT_THROWS(noisy.ApplyErosion(MAX_RANK_RADIUS + 1), std::invalid_argument);
+}
+
+void TestDetectEdges() {
+    // Светлая правая половина: вертикальная граница между столбцами 9 и 10
+    GrayscalePlotter vertical(20, 10, ' ');
+    vertical.DrawRectangle(10, 0, 19, 9, 1.0, true);
+    vertical.DetectEdges();
+    for (int y = 0; y < 10; ++y)
+    {
+        ASSERT_EQUAL(std::as_const(vertical).GetCanvas()(9, y), '|');
+        ASSERT_EQUAL(std::as_const(vertical).GetCanvas()(10, y), '|');
+        ASSERT_EQUAL(std::as_const(vertical).GetCanvas()(5, y), ' ');
+        ASSERT_EQUAL(std::as_const(vertical).GetCanvas()(15, y), ' ');
+    }
+
+    GrayscalePlotter horizontal(20, 10, ' ');
+    horizontal.DrawRectangle(0, 5, 19, 9, 1.0, true);
+    horizontal.DetectEdges(0.5);
+    ASSERT_EQUAL(std::as_const(horizontal).GetCanvas()(7, 4), '-');
+    ASSERT_EQUAL(std::as_const(horizontal).GetCanvas()(7, 5), '-');
+    ASSERT_EQUAL(std::as_const(horizontal).GetCanvas()(7, 2), ' ');
+
+    // Светлый правый нижний угол под диагональю x + y = 20, затем светлый левый нижний под x = y
+    GrayscalePlotter diagonal(20, 20, ' ');
+    for (int y = 0; y < 20; ++y)
+    {
+        for (int x = 0; x < 20; ++x)
+        {
+            diagonal.GetCanvas()(x, y) = x + y > 20 ? '@' : ' ';
+        }
+    }
+    diagonal.DetectEdges();
+    ASSERT_EQUAL(std::as_const(diagonal).GetCanvas()(10, 10), '/');
+    for (int y = 0; y < 20; ++y)
+    {
+        for (int x = 0; x < 20; ++x)
+        {
+            diagonal.GetCanvas()(x, y) = x < y ? '@' : ' ';
+        }
+    }
+    diagonal.DetectEdges();
+    ASSERT_EQUAL(std::as_const(diagonal).GetCanvas()(10, 10), '\\');
+    ASSERT_EQUAL(std::as_const(diagonal).GetCanvas()(2, 15), ' ');
+
+    // Результат не зависит от числа потоков и режима слоя яркости
+    auto edges_of = [](const int threads, const bool plane)
+    {
+        GrayscalePlotter plotter(90, 70, ' ');
+        plotter.SetThreadCount(threads);
+        plotter.DrawRadialGradient(45, 35, 30, 1.0, 0.0);
+        plotter.DrawRectangle(5, 5, 30, 20, 0.7, true);
+        if (plane)
+        {
+            plotter.EnableBrightnessPlane();
+        }
+        plotter.DetectEdges(0.1);
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+    };
+    const std::string single = edges_of(1, false);
+    ASSERT(single == edges_of(4, false));
+    ASSERT(single == edges_of(3, true));
+    ASSERT(single.find('/') != std::string::npos);
+}
+
+void TestContrastStretching() {
+    // Два соседних символа палитры растягиваются на всю палитру
+    GrayscalePlotter plotter(10, 4, ':');
+    plotter.DrawRectangle(0, 2, 9, 3, 0.35, true);
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 3), '-');
+    plotter.GetCanvas()(0, 0) = '?';
+    plotter.EqualizeHistogram();
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(5, 0), ' ');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(5, 3), '@');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '?');
+
+    // Значения 2..5 линейно уходят в 0..9
+    const std::vector<char> palette = GrayscalePlotter::DefaultPalette();
+    GrayscalePlotter stretched(4, 2, ' ');
+    for (int x = 0; x < 4; ++x)
+    {
+        stretched.GetCanvas()(x, 0) = palette[2 + x];
+        stretched.GetCanvas()(x, 1) = palette[2 + x];
+    }
+    stretched.AutoContrast();
+    ASSERT_EQUAL(std::as_const(stretched).GetCanvas()(0, 0), palette[0]);
+    ASSERT_EQUAL(std::as_const(stretched).GetCanvas()(1, 0), palette[3]);
+    ASSERT_EQUAL(std::as_const(stretched).GetCanvas()(2, 1), palette[6]);
+    ASSERT_EQUAL(std::as_const(stretched).GetCanvas()(3, 1), palette[9]);
+
+    // Редкие выбросы отсекаются процентом и не мешают растяжению
+    GrayscalePlotter clipped(100, 1, palette[4]);
+    for (int x = 50; x < 100; ++x)
+    {
+        clipped.GetCanvas()(x, 0) = palette[5];
+    }
+    clipped.GetCanvas()(0, 0) = palette[0];
+    clipped.GetCanvas()(99, 0) = palette[9];
+    GrayscalePlotter unclipped(100, 1, ' ');
+    unclipped.GetCanvas() = clipped.GetCanvas();
+    unclipped.AutoContrast(0.0);
+    ASSERT_EQUAL(std::as_const(unclipped).GetCanvas()(10, 0), palette[4]);
+    clipped.AutoContrast(2.0);
+    ASSERT_EQUAL(std::as_const(clipped).GetCanvas()(10, 0), palette[0]);
+    ASSERT_EQUAL(std::as_const(clipped).GetCanvas()(60, 0), palette[9]);
+    ASSERT_THROWS(clipped.AutoContrast(50.0), std::invalid_argument);
+
+    // Область не трогает пиксели снаружи
+    GrayscalePlotter region(10, 10, ':');
+    region.DrawRectangle(0, 0, 4, 9, 0.35, true);
+    region.AutoContrast(0.0, 2, 0, 7, 9);
+    ASSERT_EQUAL(std::as_const(region).GetCanvas()(1, 5), '-');
+    ASSERT_EQUAL(std::as_const(region).GetCanvas()(8, 5), ':');
+    ASSERT_EQUAL(std::as_const(region).GetCanvas()(3, 5), '@');
+    ASSERT_EQUAL(std::as_const(region).GetCanvas()(6, 5), ' ');
+
+    // В слое яркости растягиваются уровни
+    GrayscalePlotter levels(4, 1, ' ');
+    levels.EnableBrightnessPlane();
+    levels.DrawLine(0, 0, 1, 0, 0.4);
+    levels.DrawLine(2, 0, 3, 0, 0.6);
+    levels.AutoContrast();
+    std::vector<std::uint8_t> exported(4);
+    levels.ExportBrightness(exported.data(), 4);
+    ASSERT_EQUAL(static_cast<int>(exported[0]), 0);
+    ASSERT_EQUAL(static_cast<int>(exported[3]), 255);
+
+    // Локальное выравнивание не зависит от числа потоков, без ограничения растягивает слабый градиент
+    // на всю палитру, с ограничением — слабее
+    auto local = [](const int threads, const double clip_limit)
+    {
+        GrayscalePlotter plotter(80, 60, ' ');
+        plotter.SetThreadCount(threads);
+        plotter.DrawLinearGradient(0, 0, 79, 59, 0.3, 0.6);
+        plotter.EqualizeHistogramLocal(16, clip_limit);
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+    };
+    const std::string unlimited = local(1, 0.0);
+    ASSERT(unlimited == local(4, 0.0));
+    ASSERT(unlimited.find('@') != std::string::npos);
+    ASSERT(std::set<char>(unlimited.begin(), unlimited.end()).size() > 6);
+    const std::string limited = local(1, 2.0);
+    ASSERT(limited == local(3, 2.0));
+    ASSERT(limited != unlimited);
+    ASSERT_THROWS(plotter.EqualizeHistogramLocal(0), std::invalid_argument);
+
+    {
+        // Фигура кистью вне палитры остается на месте и не сдвигает гистограммы плиток
+        GrayscalePlotter branded(80, 60, ' ');
+        branded.DrawLinearGradient(0, 0, 79, 59, 0.3, 0.6);
+        GrayscalePlotter plain(80, 60, ' ');
+        plain.GetCanvas() = std::as_const(branded).GetCanvas();
+        branded.Plotter::DrawCircle(40, 30, 12, 'o', true);
+        const Canvas before = std::as_const(branded).GetCanvas();
+
+        branded.EqualizeHistogramLocal(16, 0.0);
+        plain.EqualizeHistogramLocal(16, 0.0);
+        const Canvas& after = std::as_const(branded).GetCanvas();
+        int kept = 0;
+        int changed = 0;
+        for (int y = 0; y < after.Height(); ++y)
+        {
+            for (int x = 0; x < after.Width(); ++x)
+            {
+                if (before(x, y) == 'o')
+                {
+                    ASSERT_EQUAL(after(x, y), before(x, y));
+                    ++kept;
+                }
+                else
+                {
+                    changed += after(x, y) != before(x, y);
+                }
+            }
+        }
+        ASSERT(kept > 400);
+        ASSERT(changed > 0);
+        // Вдали от фигуры пиксели палитры выравниваются как без нее
+        ASSERT_EQUAL(after(70, 5), std::as_const(plain).GetCanvas()(70, 5));
+    }
+}
+
+void TestCanvasStatistics() {
+    auto recount = [](const Canvas& canvas)
+    {
+        CharCounts counts{};
+        for (int i = 0; i < canvas.Size(); ++i)
+        {
+            ++counts[CharCode(canvas.Data()[i])];
+        }
+        return counts;
+    };
+
+    Canvas canvas(8, 5, '.');
+    ASSERT_THROWS(static_cast<void>(canvas.Statistics()), std::logic_error);
+    canvas.EnableStatistics();
+    ASSERT_EQUAL(canvas.Statistics()[CharCode('.')], 40);
+
+    canvas.SetPixel(1, 1, '#');
+    canvas.FillRegion(2, 0, 4, 3, '*');
+    canvas(7, 4) = '@';
+    ASSERT(canvas.Statistics() == recount(canvas));
+    canvas.Remap([] { CharMap table = IdentityCharMap(); table[CharCode('*')] = '+'; return table; }());
+    ASSERT_EQUAL(canvas.Statistics()[CharCode('+')], 12);
+    ASSERT(canvas.Statistics() == recount(canvas));
+
+    // Присваивание переносит пиксели, но не режим статистики
+    Canvas plain(2, 2, 'x');
+    canvas = plain;
+    ASSERT(canvas.HasStatistics());
+    ASSERT_EQUAL(canvas.Statistics()[CharCode('x')], 4);
+    plain = std::move(canvas);
+    ASSERT(!plain.HasStatistics());
+
+    {
+        // Устаревшую статистику одновременно запрашивают константные читатели
+        Canvas shared(300, 200, '.');
+        shared.EnableStatistics();
+        shared.FillRegion(10, 10, 99, 59, '#');
+        shared(0, 0) = '@';
+        const CharCounts expected = recount(shared);
+
+        bool first_same = false;
+        bool second_same = false;
+        auto read = [&shared, &expected](bool& same)
+        {
+            same = std::as_const(shared).Statistics() == expected;
+        };
+        std::thread first(read, std::ref(first_same));
+        std::thread second(read, std::ref(second_same));
+        first.join();
+        second.join();
+        ASSERT(first_same);
+        ASSERT(second_same);
+        ASSERT(Canvas(shared).Statistics() == expected);
+    }
+
+    // Все примитивы и фильтры плоттера оставляют счетчики точными
+    GrayscalePlotter plotter(60, 40, ' ');
+    plotter.SetThreadCount(3);
+    plotter.EnableStatistics();
+    // Включенная статистика считается при первом запросе
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas().Statistics()[CharCode(' ')], 60 * 40);
+    auto check = [&]()
+    {
+        const GrayscalePlotter& view = plotter;
+        // Массовые записи переносят замены в счетчики, а не заставляют пересчитывать канвас
+        ASSERT(view.GetCanvas().TracksStatistics());
+        ASSERT(std::as_const(view).GetCanvas().Statistics() == recount(std::as_const(view).GetCanvas()));
+        std::unordered_map<char, int> expected;
+        for (int i = 0; i < std::as_const(view).GetCanvas().Size(); ++i)
+        {
+            ++expected[std::as_const(view).GetCanvas().Data()[i]];
+        }
+        ASSERT(view.ColorHistogram() == expected);
+    };
+
+    plotter.DrawLine(0, 0, 59, 39, 0.5);
+    plotter.DrawCircle(30, 20, 10, 0.8, true);
+    plotter.DrawCircle(10, 10, 6, 0.3);
+    plotter.DrawTriangle(40, 5, 55, 30, 35, 30, 0.6, true);
+    plotter.DrawRectangle(2, 30, 20, 38, 0.9, true);
+    check();
+    plotter.FloodFill(1, 38, 0.1);
+    plotter.ScanlineFill(58, 2, 0.2);
+    check();
+    plotter.DrawLinearGradient(0, 0, 25, 15, 0.0, 1.0);
+    plotter.DrawRadialGradient(45, 30, 8, 1.0, 0.0);
+    check();
+    plotter.InvertBrightness();
+    plotter.ApplyThreshold(0.5);
+    check();
+    plotter.ApplyBoxBlur(3);
+    plotter.SetPalette({ ' ', '+', '#' });
+    check();
+    const auto region = plotter.ExtractRegion(0, 0, 9, 9);
+    plotter.PasteRegion(*region, 50, 30);
+    check();
+    plotter.DrawLinearGradient(5, 5, 40, 30, 1.0, 0.0, Dither::Ordered);
+    plotter.DrawRadialGradient(30, 20, 15, 0.0, 1.0, Dither::FloydSteinberg);
+    check();
+    plotter.ApplyGaussianBlur(3);
+    plotter.DetectEdges(0.2);
+    check();
+    plotter.ApplyMedianFilter(1);
+    plotter.ApplyDilation(1);
+    plotter.EqualizeHistogramLocal(8);
+    plotter.AutoContrast(1.0, 10, 10, 40, 30);
+    check();
+    plotter.TransformRegion(*region, AffineTransform::Rotation(0.5, 5.0, 5.0) * AffineTransform::Translation(20.0, 10.0));
+    plotter.TransformRegion(*region, AffineTransform::Scaling(2.0, 1.5), ResampleFilter::Bilinear);
+    check();
+
+    // Слой яркости пишет символы при чтении, тоже со счетчиками
+    plotter.EnableBrightnessPlane();
+    plotter.DrawLinearGradient(0, 0, 59, 39, 0.0, 1.0);
+    plotter.ApplyBoxBlur(3);
+    check();
+    plotter.DisableBrightnessPlane();
+
+    // Счетчики канваса-приемника уменьшения
+    Canvas resized(23, 17, '.');
+    resized.EnableStatistics();
+    ASSERT_EQUAL(resized.Statistics()[CharCode('.')], 23 * 17);
+    for (const ResampleFilter filter : { ResampleFilter::Nearest, ResampleFilter::Area, ResampleFilter::Bilinear })
+    {
+        std::as_const(plotter).ResizeInto(resized, filter);
+        ASSERT(resized.TracksStatistics());
+        ASSERT(resized.Statistics() == recount(resized));
+    }
+
+    const GrayscalePlotter& view = plotter;
+    const double average = view.CalculateAverageBrightness();
+    const BrightnessExtrema extrema = view.GetMinMaxBrightness();
+    plotter.DisableStatistics();
+    ASSERT(std::abs(average - view.CalculateAverageBrightness()) < 1e-12);
+    ASSERT_EQUAL(extrema.min_brightness, view.GetMinMaxBrightness().min_brightness);
+    ASSERT_EQUAL(extrema.max_brightness, view.GetMinMaxBrightness().max_brightness);
+}
+
+void TestLoadImage() {
+    const auto directory = std::filesystem::temp_directory_path() / "plotter_test_images";
+    std::filesystem::create_directories(directory);
+    auto write = [&](const std::string& name, const std::string& header, const std::vector<unsigned char>& raster)
+    {
+        const auto path = directory / name;
+        std::ofstream out(path, std::ios::binary);
+        out << header;
+        out.write(reinterpret_cast<const char*>(raster.data()), static_cast<std::streamsize>(raster.size()));
+        return path;
+    };
+
+    // 4x2 серых пикселя один к одному, с комментарием в заголовке
+    const auto gray = write("gray.pgm", "P5\n# comment\n4 2\n255\n", { 0, 85, 170, 255, 255, 170, 85, 0 });
+    GrayscalePlotter exact(4, 2, '?', { ' ', '-', '+', '#' });
+    exact.LoadImage(gray, 1.0);
+    ASSERT_EQUAL(std::as_const(exact).GetCanvas()(0, 0), ' ');
+    ASSERT_EQUAL(std::as_const(exact).GetCanvas()(1, 0), '-');
+    ASSERT_EQUAL(std::as_const(exact).GetCanvas()(2, 0), '+');
+    ASSERT_EQUAL(std::as_const(exact).GetCanvas()(3, 0), '#');
+    ASSERT_EQUAL(std::as_const(exact).GetCanvas()(0, 1), '#');
+
+    // Усреднение по площади: 4x4 в 2x2, в слое яркости видны точные средние
+    const auto blocks = write("blocks.pgm", "P5 4 4 255\n", {
+        0, 0, 255, 255,
+        0, 0, 255, 255,
+        100, 200, 50, 50,
+        0, 100, 50, 50 });
+    GrayscalePlotter halves(2, 2, ' ');
+    halves.EnableBrightnessPlane();
+    halves.LoadImage(blocks, 1.0);
+    std::vector<std::uint8_t> levels(4);
+    halves.ExportBrightness(levels.data(), 2);
+    ASSERT_EQUAL(static_cast<int>(levels[0]), 0);
+    ASSERT_EQUAL(static_cast<int>(levels[1]), 255);
+    ASSERT_EQUAL(static_cast<int>(levels[2]), 100);
+    ASSERT_EQUAL(static_cast<int>(levels[3]), 50);
+
+    // Дробное покрытие: 3 пикселя в 2 клетки, средний делится пополам
+    const auto thirds = write("thirds.pgm", "P5 3 1 255\n", { 0, 90, 180 });
+    GrayscalePlotter two(2, 1, ' ');
+    two.EnableBrightnessPlane();
+    two.LoadImage(thirds, 2.0 / 3.0);
+    two.ExportBrightness(levels.data(), 2);
+    ASSERT_EQUAL(static_cast<int>(levels[0]), 30);
+    ASSERT_EQUAL(static_cast<int>(levels[1]), 150);
+
+    // PPM: чистые цвета дают яркость по весам Rec. 601, 16-битный PGM читается старшим байтом вперед
+    const auto colors = write("colors.ppm", "P6 3 1 255\n", { 255, 0, 0, 0, 255, 0, 0, 0, 255 });
+    GrayscalePlotter rgb(3, 1, ' ');
+    rgb.EnableBrightnessPlane();
+    rgb.LoadImage(colors, 1.0);
+    rgb.ExportBrightness(levels.data(), 3);
+    ASSERT_EQUAL(static_cast<int>(levels[0]), 76);
+    ASSERT_EQUAL(static_cast<int>(levels[1]), 150);
+    ASSERT_EQUAL(static_cast<int>(levels[2]), 29);
+
+    const auto deep = write("deep.pgm", "P5 2 1 65535\n", { 0xFF, 0xFF, 0x80, 0x00 });
+    GrayscalePlotter wide(2, 1, ' ');
+    wide.EnableBrightnessPlane();
+    wide.LoadImage(deep, 1.0);
+    wide.ExportBrightness(levels.data(), 2);
+    ASSERT_EQUAL(static_cast<int>(levels[0]), 255);
+    ASSERT_EQUAL(static_cast<int>(levels[1]), 128);
+
+    // Широкое изображение вписывается по ширине, строки сверху и снизу не меняются
+    GrayscalePlotter fitted(4, 6, '?', { ' ', '-', '+', '#' });
+    fitted.LoadImage(gray, 1.0);
+    ASSERT_EQUAL(std::as_const(fitted).GetCanvas()(0, 1), '?');
+    ASSERT_EQUAL(std::as_const(fitted).GetCanvas()(3, 2), '#');
+    ASSERT_EQUAL(std::as_const(fitted).GetCanvas()(0, 4), '?');
+
+    // Результат не зависит от числа потоков
+    std::vector<unsigned char> noise(300 * 200 * 3);
+    for (size_t i = 0; i < noise.size(); ++i)
+    {
+        noise[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+    }
+    const auto large = write("large.ppm", "P6\n300 200\n255\n", noise);
+    auto render = [&](const int threads)
+    {
+        GrayscalePlotter plotter(70, 45, ' ');
+        plotter.SetThreadCount(threads);
+        plotter.LoadImage(large);
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+    };
+    ASSERT(render(1) == render(4));
+
+    GrayscalePlotter plotter(4, 4, ' ');
+    ASSERT_THROWS(plotter.LoadImage(write("text.pgm", "P2 2 2 255\n0 0 0 0\n", {})), std::runtime_error);
+    ASSERT_THROWS(plotter.LoadImage(write("short.pgm", "P5 4 4 255\n", { 1, 2, 3 })), std::runtime_error);
+    ASSERT_THROWS(plotter.LoadImage(directory / "missing.pgm"), std::runtime_error);
+    ASSERT_THROWS(plotter.LoadImage(gray, 0.0), std::invalid_argument);
+
+    std::filesystem::remove_all(directory);
+}
+
+void TestFramePipeline() {
+    SpscQueue<int> queue(2);
+    int value = 1;
+    ASSERT(queue.TryPush(value));
+    value = 2;
+    ASSERT(queue.TryPush(value));
+    value = 3;
+    ASSERT(!queue.TryPush(value));
+    ASSERT(queue.TryPop(value) && value == 1);
+    ASSERT(queue.TryPop(value) && value == 2);
+    ASSERT(!queue.TryPop(value));
+
+    // Порядок сохраняется, когда производитель упирается в емкость
+    constexpr int count = 100000;
+    std::thread producer([&queue]()
+    {
+        for (int i = 1; i <= count; ++i)
+        {
+            queue.Push(i);
+        }
+        queue.Push(0);
+    });
+    int expected = 1;
+    bool ordered = true;
+    for (int item = queue.Pop(); item != 0; item = queue.Pop())
+    {
+        ordered = ordered && item == expected++;
+    }
+    producer.join();
+    ASSERT(ordered);
+    ASSERT_EQUAL(expected, count + 1);
+
+    const auto directory = std::filesystem::temp_directory_path() / "plotter_test_frames";
+    std::filesystem::create_directories(directory);
+    std::vector<std::filesystem::path> frames;
+    for (int frame = 0; frame < 9; ++frame)
+    {
+        frames.push_back(directory / ("frame" + std::to_string(frame) + ".pgm"));
+        std::ofstream out(frames.back(), std::ios::binary);
+        out << "P5 40 20 255\n";
+        for (int y = 0; y < 20; ++y)
+        {
+            for (int x = 0; x < 40; ++x)
+            {
+                out.put(static_cast<char>((x * 6 + y * 3 + frame * 25) % 256));
+            }
+        }
+    }
+
+    // Результат совпадает с последовательной загрузкой и выводом кадров
+    std::stringstream expected_output;
+    GrayscalePlotter sequential(20, 10, '.');
+    for (const auto& path : frames)
+    {
+        sequential.GetCanvas().Clear('.');
+        sequential.LoadImage(path);
+        sequential.Render(expected_output);
+        expected_output << "--\n";
+    }
+
+    for (const int capacity : { 1, 3 })
+    {
+        FramePipelineOptions options;
+        options.width = 20;
+        options.height = 10;
+        options.background = '.';
+        options.queue_capacity = capacity;
+        options.thread_count = 2;
+        options.frame_separator = "--\n";
+        FramePipeline pipeline(options);
+
+        std::stringstream output;
+        const FramePipelineStats stats = pipeline.Run(frames, output);
+        ASSERT_EQUAL(stats.frames, 9);
+        ASSERT(output.str() == expected_output.str());
+        ASSERT(stats.end_to_end.p50 <= stats.end_to_end.p99 && stats.end_to_end.p99 <= stats.end_to_end.max);
+        ASSERT(stats.frames_per_second > 0.0);
+
+        // Повторный запуск на тех же канвасах пула, в файл
+        const auto output_file = directory / "frames.txt";
+        ASSERT_EQUAL(pipeline.Run(frames, output_file).frames, 9);
+        std::ifstream written(output_file, std::ios::binary);
+        ASSERT(std::string(std::istreambuf_iterator<char>(written), {}) == expected_output.str());
+    }
+
+    // Ошибка чтения кадра в середине останавливает конвейер и пробрасывается
+    auto broken = frames;
+    broken.insert(broken.begin() + 4, directory / "missing.pgm");
+    FramePipeline pipeline(FramePipelineOptions{});
+    std::stringstream output;
+    ASSERT_THROWS(static_cast<void>(pipeline.Run(broken, output)), std::runtime_error);
+    FramePipelineOptions empty_queue;
+    empty_queue.queue_capacity = 0;
+    ASSERT_THROWS(FramePipeline{ empty_queue }, std::invalid_argument);
+
+    std::filesystem::remove_all(directory);
+}
+
+void TestDithering() {
+    // Пороги матрицы Байера — 64 разных значения (k + 0.5) / 64
+    std::set<double> thresholds(BayerThresholds().begin(), BayerThresholds().end());
+    ASSERT_EQUAL(thresholds.size(), 64u);
+    ASSERT_EQUAL(*thresholds.begin(), 0.5 / 64);
+    ASSERT_EQUAL(BayerThresholds()[1], 32.5 / 64);
+
+    auto count = [](const GrayscalePlotter& plotter, const char symbol)
+    {
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        return std::count(canvas.Data(), canvas.Data() + canvas.Size(), symbol);
+    };
+
+    // Ровная заливка между символами палитры дает долю символов по яркости
+    for (const double brightness : { 0.25, 0.5 })
+    {
+        GrayscalePlotter ordered(16, 16, ' ', { ' ', '#' });
+        ordered.DrawRectangle(0, 0, 15, 15, brightness, true, Dither::Ordered);
+        ASSERT_EQUAL(count(ordered, '#'), static_cast<long>(256 * brightness));
+
+        GrayscalePlotter diffused(32, 32, ' ', { ' ', '#' });
+        diffused.DrawRectangle(0, 0, 31, 31, brightness, true, Dither::FloydSteinberg);
+        ASSERT(std::abs(count(diffused, '#') - 1024 * brightness) < 1024 * 0.02);
+    }
+    // Без дизеринга та же заливка — один символ
+    GrayscalePlotter flat(16, 16, ' ', { ' ', '#' });
+    flat.DrawRectangle(0, 0, 15, 15, 0.5, true);
+    ASSERT_EQUAL(count(flat, '#'), 0);
+
+    // Точная яркость символа палитры не меняется ни одним способом
+    for (const Dither dither : { Dither::Ordered, Dither::FloydSteinberg, Dither::Atkinson })
+    {
+        GrayscalePlotter exact(20, 10, '?', { ' ', '+', '#' });
+        exact.DrawRectangle(2, 2, 17, 7, 0.5, true, dither);
+        ASSERT_EQUAL(count(exact, '+'), 16 * 6);
+        ASSERT_EQUAL(count(exact, '?'), 200 - 16 * 6);
+    }
+
+    // Дизеринг меняет только пиксели примитива
+    GrayscalePlotter circle(30, 30, '.', { ' ', '+', '#' });
+    circle.DrawCircle(15, 15, 10, 0.7, true, Dither::Atkinson);
+    ASSERT_EQUAL(std::as_const(circle).GetCanvas()(0, 0), '.');
+    ASSERT_EQUAL(std::as_const(circle).GetCanvas()(15, 2), '.');
+    ASSERT(std::as_const(circle).GetCanvas()(15, 15) != '.');
+
+    // Диффузия волной по полосам не зависит от числа потоков
+    for (const Dither dither : { Dither::FloydSteinberg, Dither::Atkinson, Dither::Ordered })
+    {
+        auto render = [dither](const int threads)
+        {
+            GrayscalePlotter plotter(301, 97, ' ', { ' ', '+', '#' });
+            plotter.SetThreadCount(threads);
+            plotter.DrawLinearGradient(0, 0, 300, 96, 0.0, 1.0, dither);
+            plotter.DrawRadialGradient(150, 48, 40, 1.0, 0.1, dither);
+            const Canvas& canvas = std::as_const(plotter).GetCanvas();
+            return std::string(canvas.Data(), canvas.Data() + canvas.Size());
+        };
+        const std::string sequential = render(1);
+        ASSERT(sequential == render(2));
+        ASSERT(sequential == render(3));
+        ASSERT(sequential == render(8));
+    }
+
+    // Переход на маленькую палитру с диффузией сохраняет среднюю яркость, обычный — занижает
+    GrayscalePlotter fine(64, 32, ' ');
+    GrayscalePlotter floored(64, 32, ' ');
+    fine.DrawLinearGradient(0, 0, 63, 31, 0.0, 1.0);
+    floored.DrawLinearGradient(0, 0, 63, 31, 0.0, 1.0);
+    const double original = fine.CalculateAverageBrightness();
+    floored.SetPalette({ ' ', '#' });
+    fine.SetPalette({ ' ', '#' }, Dither::FloydSteinberg);
+    ASSERT(std::abs(fine.CalculateAverageBrightness() - original) < 0.02);
+    ASSERT(floored.CalculateAverageBrightness() < original - 0.2);
+
+    // В режиме слоя яркости Requantize дает символы с дизерингом до следующего изменения слоя
+    GrayscalePlotter layered(16, 16, ' ', { ' ', '#' });
+    layered.EnableBrightnessPlane();
+    layered.DrawRectangle(0, 0, 15, 15, 0.5, true, Dither::Ordered);
+    ASSERT_EQUAL(count(layered, '#'), 0);
+    layered.Requantize(Dither::Ordered);
+    ASSERT_EQUAL(count(layered, '#'), 128);
+    layered.Requantize(Dither::None);
+    ASSERT_EQUAL(count(layered, '#'), 0);
+    layered.Requantize(Dither::Atkinson);
+    ASSERT(count(layered, '#') > 64);
+    layered.DrawRectangle(0, 0, 15, 15, 1.0, true);
+    ASSERT_EQUAL(count(layered, '#'), 256);
+
+    // Символы вне палитры при Requantize без слоя не меняются
+    GrayscalePlotter untouched(4, 1, '?', { ' ', '#' });
+    untouched.Requantize(Dither::FloydSteinberg);
+    ASSERT_EQUAL(count(untouched, '?'), 4);
+
+    ASSERT_THROWS(ErrorDiffuser(Dither::Ordered, 4, 4, 1), std::invalid_argument);
+}
+
+void TestResize() {
+    ASSERT_EQUAL(NearestIndices(4, 2), (std::vector<int>{ 1, 3 }));
+    ASSERT_EQUAL(NearestIndices(2, 4), (std::vector<int>{ 0, 0, 1, 1 }));
+    const ResampleWeights area = AreaWeights(3, 2);
+    ASSERT_EQUAL(area.Size(), 2);
+    ASSERT_EQUAL(area.sources, (std::vector<int>{ 0, 1, 1, 2 }));
+    const ResampleWeights bilinear = BilinearWeights(2, 4);
+    ASSERT_EQUAL(bilinear.first, (std::vector<int>{ 0, 1, 3, 5, 6 }));
+    ASSERT_EQUAL(bilinear.weights[1], 0.75);
+    ASSERT_THROWS(AreaWeights(0, 2), std::invalid_argument);
+
+    // Ближайший сосед: увеличение повторяет символы, уменьшение берет их через один по центрам клеток
+    Plotter chars(4, 2, '.');
+    chars.DrawLine(0, 0, 3, 0, '#');
+    chars.GetCanvas()(1, 1) = 'x';
+    const auto doubled = chars.Resize(8, 4);
+    ASSERT_EQUAL(doubled->Background(), '.');
+    ASSERT_EQUAL((*doubled)(7, 1), '#');
+    ASSERT_EQUAL((*doubled)(2, 2), 'x');
+    ASSERT_EQUAL((*doubled)(3, 3), 'x');
+    ASSERT_EQUAL((*doubled)(4, 3), '.');
+    const auto halved = chars.Resize(2, 1);
+    ASSERT_EQUAL((*halved)(0, 0), 'x');
+    ASSERT_EQUAL((*halved)(1, 0), '.');
+    ASSERT_THROWS(chars.ResizeInto(chars.GetCanvas()), std::invalid_argument);
+
+    // Того же размера — без изменений, ровные области сохраняют символ при любом масштабе
+    GrayscalePlotter scene(30, 21, ' ');
+    scene.DrawLinearGradient(0, 0, 29, 20, 0.0, 1.0);
+    scene.DrawRectangle(3, 3, 26, 17, 1.0, true);
+    for (const ResampleFilter filter : { ResampleFilter::Nearest, ResampleFilter::Area, ResampleFilter::Bilinear })
+    {
+        const auto same = scene.Resize(30, 21, filter);
+        ASSERT(std::equal(same->Data(), same->Data() + same->Size(), std::as_const(scene).GetCanvas().Data()));
+
+        const auto smaller = scene.Resize(20, 14, filter);
+        ASSERT_EQUAL((*smaller)(10, 7), '@');
+    }
+
+    // Усреднение по площади: пара символов палитры дает среднюю яркость
+    GrayscalePlotter stripes(4, 1, ' ', { ' ', '+', '#' });
+    stripes.GetCanvas()(1, 0) = '#';
+    stripes.GetCanvas()(3, 0) = '#';
+    const auto merged = stripes.Resize(2, 1, ResampleFilter::Area);
+    ASSERT_EQUAL((*merged)(0, 0), '+');
+    ASSERT_EQUAL((*merged)(1, 0), '+');
+
+    // Билинейное увеличение дает промежуточную яркость между соседями
+    GrayscalePlotter pair(2, 1, ' ', { ' ', '+', '#' });
+    pair.GetCanvas()(1, 0) = '#';
+    const auto stretched = pair.Resize(4, 1, ResampleFilter::Bilinear);
+    ASSERT_EQUAL(std::string(stretched->Data(), 4), "  +#");
+
+    // Слой яркости — источник с полной точностью, результат в готовый канвас пула
+    GrayscalePlotter layered(64, 32, ' ');
+    layered.EnableBrightnessPlane();
+    layered.DrawLinearGradient(0, 0, 63, 31, 0.0, 1.0);
+    layered.ApplyGaussianBlur(5);
+    Canvas pooled(40, 20, '?');
+    layered.ResizeInto(pooled, ResampleFilter::Area);
+    ASSERT(std::none_of(pooled.Data(), pooled.Data() + pooled.Size(), [](const char c) { return c == '?'; }));
+
+    // Результат не зависит от числа потоков
+    for (const ResampleFilter filter : { ResampleFilter::Nearest, ResampleFilter::Area, ResampleFilter::Bilinear })
+    {
+        auto render = [filter](const int threads)
+        {
+            GrayscalePlotter plotter(173, 91, ' ');
+            plotter.SetThreadCount(threads);
+            plotter.DrawRadialGradient(80, 40, 60, 1.0, 0.0);
+            const auto result = plotter.Resize(97, 53, filter);
+            return std::string(result->Data(), result->Data() + result->Size());
+        };
+        ASSERT(render(1) == render(4));
+    }
+}
+
+void TestTransformRegion() {
+    const AffineTransform rotation = AffineTransform::Rotation(0.7, 3.0, 2.0) * AffineTransform::Scaling(2.0, 0.5);
+    const AffineTransform identity = rotation * rotation.Inverse();
+    ASSERT(std::abs(identity.xx - 1.0) < 1e-12 && std::abs(identity.xy) < 1e-12 && std::abs(identity.tx) < 1e-12);
+    ASSERT(std::abs(identity.yx) < 1e-12 && std::abs(identity.yy - 1.0) < 1e-12 && std::abs(identity.ty) < 1e-12);
+    ASSERT_THROWS(static_cast<void>(AffineTransform::Scaling(0.0, 1.0).Inverse()), std::invalid_argument);
+
+    Canvas sprite(3, 2, ' ');
+    std::copy_n("abcdef", 6, sprite.Data());
+
+    // Сдвиг совпадает с PasteRegion, в том числе у края канваса
+    for (const auto& [x, y] : { std::pair{ 4, 2 }, std::pair{ -1, -1 }, std::pair{ 8, 5 } })
+    {
+        Plotter transformed(10, 6, '.');
+        Plotter pasted(10, 6, '.');
+        transformed.TransformRegion(sprite, AffineTransform::Translation(x, y));
+        pasted.PasteRegion(sprite, x, y);
+        ASSERT(std::equal(std::as_const(transformed).GetCanvas().Data(), std::as_const(transformed).GetCanvas().Data() + 60, std::as_const(pasted).GetCanvas().Data()));
+    }
+
+    // Поворот на 90 градусов по часовой стрелке вокруг центра строки "abc" ставит ее в столбец
+    Plotter rotated(4, 5, '.');
+    Canvas line(3, 1, ' ');
+    std::copy_n("abc", 3, line.Data());
+    rotated.TransformRegion(line, AffineTransform::Translation(0.0, 2.0) * AffineTransform::Rotation(std::acos(0.0), 1.5, 0.5));
+    ASSERT_EQUAL(std::string(std::as_const(rotated).GetCanvas().Data(), 20), ".....a...b...c......");
+
+    // Масштаб повторяет пиксели, отражение меняет порядок, прозрачный символ не переносится
+    Plotter scaled(4, 2, '.');
+    scaled.TransformRegion(line, AffineTransform::Scaling(2.0, 2.0), 'b');
+    ASSERT_EQUAL(std::string(std::as_const(scaled).GetCanvas().Data(), 8), "aa..aa..");
+    Plotter mirrored(4, 1, '.');
+    std::copy_n("abcd", 4, mirrored.GetCanvas().Data());
+    mirrored.TransformRegion(std::as_const(mirrored).GetCanvas(), AffineTransform::Scaling(-1.0, 1.0, 2.0, 0.0));
+    ASSERT_EQUAL(std::string(std::as_const(mirrored).GetCanvas().Data(), 4), "dcba");
+    mirrored.TransformRegion(std::as_const(mirrored).GetCanvas(), AffineTransform::Translation(1.0, 0.0));
+    ASSERT_EQUAL(std::string(std::as_const(mirrored).GetCanvas().Data(), 4), "ddcb");
+    mirrored.TransformRegion(sprite, AffineTransform::Translation(100.0, 0.0));
+    ASSERT_EQUAL(std::string(std::as_const(mirrored).GetCanvas().Data(), 4), "ddcb");
+
+    // Билинейная яркость совпадает с билинейным Resize, Nearest переносит символы
+    GrayscalePlotter pair(4, 1, ' ', { ' ', '+', '#' });
+    Canvas gray(2, 1, ' ');
+    gray(1, 0) = '#';
+    pair.TransformRegion(gray, AffineTransform::Scaling(2.0, 1.0));
+    ASSERT_EQUAL(std::string(std::as_const(pair).GetCanvas().Data(), 4), "  +#");
+    pair.TransformRegion(gray, AffineTransform::Scaling(2.0, 1.0), ResampleFilter::Nearest);
+    ASSERT_EQUAL(std::string(std::as_const(pair).GetCanvas().Data(), 4), "  ##");
+    ASSERT_THROWS(pair.TransformRegion(gray, AffineTransform{}, ResampleFilter::Area), std::invalid_argument);
+
+    // Результат не зависит от числа потоков, со слоем яркости и без
+    for (const bool plane : { false, true })
+    {
+        auto render = [plane](const int threads)
+        {
+            GrayscalePlotter plotter(120, 80, ' ');
+            plotter.SetThreadCount(threads);
+            if (plane)
+            {
+                plotter.EnableBrightnessPlane();
+            }
+            plotter.DrawRadialGradient(60, 40, 30, 1.0, 0.0);
+            const auto gauge = plotter.ExtractRegion(30, 10, 89, 69);
+            plotter.TransformRegion(*gauge, AffineTransform::Rotation(0.5, 60.0, 40.0) * AffineTransform::Translation(30.0, 10.0));
+            plotter.TransformRegion(std::as_const(plotter).GetCanvas(), AffineTransform::Shear(0.3, 0.0));
+            return std::string(std::as_const(plotter).GetCanvas().Data(), std::as_const(plotter).GetCanvas().Data() + std::as_const(plotter).GetCanvas().Size());
+        };
+        ASSERT(render(1) == render(4));
+    }
+}
+
+void TestCanvasPyramid() {
+    // Уровни вдвое меньше с округлением вверх, последний 1x1
+    const Canvas small(5, 3, '.');
+    CanvasPyramid sizes(small);
+    ASSERT_EQUAL(sizes.LevelCount(), 4);
+    ASSERT_EQUAL(sizes.Level(1).Width(), 3);
+    ASSERT_EQUAL(sizes.Level(1).Height(), 2);
+    ASSERT_EQUAL(sizes.Level(3)(0, 0), '.');
+    ASSERT_THROWS(static_cast<void>(sizes.Level(4)), std::out_of_range);
+
+    // Частый символ блока, при равенстве — не фон: тонкая линия не пропадает
+    Plotter lines(8, 8, ' ');
+    lines.DrawLine(0, 3, 7, 3, '#');
+    lines.DrawRectangle(0, 6, 1, 7, 'x', true);
+    CanvasPyramid dominant(std::as_const(lines).GetCanvas());
+    ASSERT_EQUAL(std::string(dominant.Level(1).Data(), 16), "    ####    x   ");
+    ASSERT_EQUAL(std::string(dominant.Level(2).Data(), 4), "##  ");
+    ASSERT_EQUAL(dominant.Level(3)(0, 0), '#');
+
+    // Усреднение яркости: шахматная доска из ' ' и '#' дает средний символ
+    Canvas checker(2, 2, ' ');
+    checker(0, 0) = '#';
+    checker(1, 1) = '#';
+    CanvasPyramid averaged(checker, { ' ', '+', '#' });
+    ASSERT_EQUAL(averaged.Level(1)(0, 0), '+');
+    ASSERT_THROWS(CanvasPyramid(checker, { '#' }), std::invalid_argument);
+
+    // Перестраиваются только грязные плитки и только для запрошенного уровня
+    Plotter scene(256, 256, ' ');
+    scene.DrawCircle(128, 128, 100, '*');
+    CanvasPyramid pyramid(std::as_const(scene).GetCanvas());
+    ASSERT_EQUAL(pyramid.LevelCount(), 9);
+    static_cast<void>(pyramid.Level(8));
+    long long rebuilt = pyramid.RebuiltTiles();
+    scene.GetCanvas()(100, 100) = '@';
+    ASSERT_EQUAL(pyramid.Update(), 1);
+    ASSERT_EQUAL(pyramid.RebuiltTiles(), rebuilt + 1);
+    static_cast<void>(pyramid.Level(1));
+    ASSERT_EQUAL(pyramid.RebuiltTiles(), rebuilt + 2);
+    static_cast<void>(pyramid.Level(1));
+    ASSERT_EQUAL(pyramid.RebuiltTiles(), rebuilt + 2);
+    static_cast<void>(pyramid.Level(8));
+    ASSERT_EQUAL(pyramid.RebuiltTiles(), rebuilt + 9);
+
+    // Явная отметка без сравнения, после нее сравнение изменений не находит
+    scene.DrawLine(200, 10, 250, 10, '=');
+    pyramid.Invalidate(200, 10, 250, 10);
+    ASSERT_EQUAL(pyramid.Update(), 0);
+
+    // Постепенно обновленная пирамида совпадает с построенной заново
+    scene.DrawRectangle(20, 30, 90, 60, '#', true);
+    ASSERT_EQUAL(pyramid.Update(), 6);
+    CanvasPyramid fresh(std::as_const(scene).GetCanvas());
+    for (int level = 0; level < pyramid.LevelCount(); ++level)
+    {
+        const Canvas& updated = pyramid.Level(level);
+        ASSERT(std::equal(updated.Data(), updated.Data() + updated.Size(), fresh.Level(level).Data()));
+    }
+
+    // Окно просмотра: масштаб 1 — сам канвас, 1/2 и 0.3 — уровень 1, увеличение повторяет пиксели
+    Canvas view(256, 256);
+    pyramid.RenderViewport(view, 0.0, 0.0, 1.0);
+    ASSERT(std::equal(view.Data(), view.Data() + view.Size(), std::as_const(scene).GetCanvas().Data()));
+    Canvas half(128, 128);
+    pyramid.RenderViewport(half, 0.0, 0.0, 0.5);
+    ASSERT(std::equal(half.Data(), half.Data() + half.Size(), pyramid.Level(1).Data()));
+    Canvas coarse(10, 10);
+    pyramid.RenderViewport(coarse, 60.0, 60.0, 0.3);
+    ASSERT_EQUAL(coarse(0, 0), pyramid.Level(1)(30, 30));
+    ASSERT_EQUAL(coarse(9, 9), pyramid.Level(1)(45, 45));
+    Canvas zoomed(4, 4);
+    pyramid.RenderViewport(zoomed, 99.0, 99.0, 2.0);
+    ASSERT_EQUAL(zoomed(2, 2), '@');
+    ASSERT_EQUAL(zoomed(3, 3), '@');
+    ASSERT_EQUAL(zoomed(1, 1), std::as_const(scene).GetCanvas()(99, 99));
+    Canvas outside(4, 4, '?');
+    pyramid.RenderViewport(outside, -10.0, 300.0, 1.0);
+    ASSERT_EQUAL(std::string(outside.Data(), 16), std::string(16, ' '));
+    ASSERT_THROWS(pyramid.RenderViewport(outside, 0.0, 0.0, 0.0), std::invalid_argument);
+
+    // Источник другого размера перестраивает пирамиду целиком
+    scene.GetCanvas() = Canvas(40, 20, ' ');
+    ASSERT_EQUAL(pyramid.Update(), 2);
+    ASSERT_EQUAL(pyramid.LevelCount(), 7);
+}
+
+void TestCellColors() {
+    const Color rgb = Color::Rgb(1, 2, 3);
+    ASSERT(rgb.GetKind() == Color::Kind::Rgb);
+    ASSERT_EQUAL(static_cast<int>(rgb.Green()), 2);
+    ASSERT_EQUAL(static_cast<int>(Color::Indexed(200).Index()), 200);
+    ASSERT(Color{}.IsDefault() && !Color::Indexed(0).IsDefault());
+
+    auto render = [](const Canvas& canvas)
+    {
+        std::ostringstream out;
+        canvas.Render(out);
+        return out.str();
+    };
+
+    // Без слоя цветов вывод прежний, со слоем — последовательность только на смену цветов
+    Canvas canvas(4, 2, '.');
+    std::copy_n("abcdefgh", 8, canvas.Data());
+    ASSERT_EQUAL(render(canvas), "abcd\nefgh\n");
+    canvas.EnableColors();
+    ASSERT_EQUAL(render(canvas), "abcd\nefgh\n");
+    canvas.SetColors(1, 0, { Color::Indexed(1), Color{} });
+    canvas.SetColors(2, 0, { Color::Indexed(1), Color{} });
+    ASSERT_EQUAL(render(canvas), "a\x1b[31mbc\x1b[0md\nefgh\n");
+
+    // Цвет символа переходит через конец строки, фон сбрасывается до перевода строки
+    canvas.FillColors(0, 0, 3, 1, { Color::Rgb(1, 2, 3), Color{} });
+    ASSERT_EQUAL(render(canvas), "\x1b[38;2;1;2;3mabcd\nefgh\n\x1b[0m");
+    canvas.SetColors(3, 0, { Color::Rgb(1, 2, 3), Color::Indexed(200) });
+    canvas.SetColors(0, 1, { Color::Indexed(9), Color::Indexed(12) });
+    ASSERT_EQUAL(render(canvas), "\x1b[38;2;1;2;3mabc\x1b[48;5;200md\x1b[49m\n\x1b[91;104me\x1b[38;2;1;2;3;49mfgh\n\x1b[0m");
+
+    // Копия и перемещение сохраняют цвета, Clear сбрасывает их
+    Canvas copy = canvas;
+    ASSERT(copy.Colors(0, 1) == (CellColors{ Color::Indexed(9), Color::Indexed(12) }));
+    const Canvas moved = std::move(copy);
+    ASSERT(moved.HasColors());
+    canvas.Clear(' ');
+    ASSERT_EQUAL(render(canvas), "    \n    \n");
+    canvas.DisableColors();
+    ASSERT(canvas.ColorData() == nullptr);
+    ASSERT_THROWS(canvas.FillColors(0, 0, 1, 1, {}), std::logic_error);
+
+    // Цветные варианты рисования включают слой и красят только нарисованные пиксели
+    const CellColors red{ Color::Indexed(1), Color{} };
+    const CellColors blue{ Color::Indexed(4), Color{} };
+    Plotter plotter(6, 4, ' ');
+    plotter.DrawLine(0, 0, 5, 0, '-', red);
+    plotter.DrawRectangle(1, 2, 2, 3, '#', blue, true);
+    plotter.DrawLine(0, 1, 5, 1, '=');
+    const Canvas& result = std::as_const(plotter).GetCanvas();
+    ASSERT(result.HasColors());
+    ASSERT(result.Colors(5, 0) == red);
+    ASSERT(result.Colors(2, 3) == blue);
+    ASSERT(result.Colors(3, 3) == CellColors{});
+    ASSERT(result.Colors(0, 1) == CellColors{});
+
+    // Заливка тем же символом меняет цвета всей области
+    plotter.FloodFill(4, 3, ' ', blue);
+    ASSERT_EQUAL(std::string(result.Data() + 12, 12), " ##    ##   ");
+    ASSERT(result.Colors(3, 2) == blue && result.Colors(5, 3) == blue);
+    ASSERT(result.Colors(0, 2) == CellColors{});
+    plotter.ScanlineFill(0, 0, '-', red);
+    ASSERT(result.Colors(0, 0) == red);
+    plotter.DrawCircle(2, 2, 1, 'o', red);
+    ASSERT(result.Colors(2, 1) == red);
+    plotter.DrawTriangle(0, 0, 0, 3, 5, 0, '*', blue, true);
+    ASSERT(result.Colors(0, 0) == blue);
+
+    // Вырезанная и вставленная область сохраняет цвета
+    const auto region = plotter.ExtractRegion(0, 0, 1, 1);
+    ASSERT(region->HasColors() && region->Colors(0, 0) == blue);
+    Plotter target(3, 3, '.');
+    target.PasteRegion(*region, 1, 1);
+    ASSERT(std::as_const(target).GetCanvas().Colors(1, 1) == blue);
+    ASSERT(std::as_const(target).GetCanvas().Colors(0, 0) == CellColors{});
+
+    // Масштабирование и перенос преобразованием тоже переносят цвета
+    const auto resized = std::as_const(plotter).Resize(12, 8);
+    ASSERT(resized->HasColors());
+    ASSERT(resized->Colors(0, 0) == blue);
+    ASSERT(resized->Colors(11, 0) == std::as_const(plotter).GetCanvas().Colors(5, 0));
+    Canvas plain(2, 2, ' ');
+    plain.EnableColors();
+    Plotter(2, 2, ' ').ResizeInto(plain);
+    ASSERT(!plain.HasColors());
+
+    Plotter transformed(4, 4, '.');
+    transformed.TransformRegion(*region, AffineTransform::Translation(2, 2), '.');
+    ASSERT(std::as_const(transformed).GetCanvas().Colors(2, 2) == blue);
+    ASSERT(std::as_const(transformed).GetCanvas().Colors(0, 0) == CellColors{});
+}
+
+void TestJsonView() {
+    {
+        const std::string text = R"( {"b": [1, -2.5e1, true, null, "x"], "a": {"s": "plain", "e": "q\"\\\/\n\u00e9\ud83d\ude00"},
+            "big": 3000000000, "empty": [], "obj": {}} )";
+        const json::DocumentView doc = json::DocumentView::Parse(text);
+        const json::ValueView& root = doc.GetRoot();
+        ASSERT(root.IsDict());
+        ASSERT_EQUAL(root.AsDict().size(), 5u);
+        // Члены отсортированы по ключу
+        ASSERT_EQUAL(root.AsDict()[0].key, "a");
+        ASSERT_EQUAL(root.AsDict()[4].key, "obj");
+
+        const auto items = root.Find("b")->AsArray();
+        ASSERT_EQUAL(items.size(), 5u);
+        ASSERT_EQUAL(items[0].AsInt(), 1);
+        ASSERT_EQUAL(items[1].AsDouble(), -25.0);
+        ASSERT(items[2].AsBool());
+        ASSERT(items[3].IsNull());
+        ASSERT_EQUAL(items[4].AsString(), "x");
+
+        // Строка без escape указывает прямо в текст
+        const std::string_view plain = root.Find("a")->Find("s")->AsString();
+        ASSERT_EQUAL(plain, "plain");
+        ASSERT(plain.data() >= text.data() && plain.data() < text.data() + text.size());
+        ASSERT_EQUAL(root.Find("a")->Find("e")->AsString(), "q\"\\/\n\xC3\xA9\xF0\x9F\x98\x80");
+
+        ASSERT(root.Find("big")->IsPureDouble());
+        ASSERT_EQUAL(root.Find("big")->AsDouble(), 3e9);
+        ASSERT(root.Find("empty")->AsArray().empty());
+        ASSERT(root.Find("obj")->AsDict().empty());
+        ASSERT(root.Find("missing") == nullptr);
+        ASSERT_THROWS(static_cast<void>(items[0].AsString()), std::logic_error);
+        ASSERT_THROWS(static_cast<void>(items[0].Find("a")), std::logic_error);
+    }
+
+    {
+        // Разбор и проверка за один проход: ошибка указывает строку и столбец
+        const std::vector<std::string> invalid = {
+            "", "[1, 2", "[1,]", "{\"a\" 1}", "{\"a\": 1, \"a\": 2}", "01", "1.", "-", "tru", "\"abc",
+            "\"\\x\"", "\"\\ud800\"", "[1] 2", "{1: 2}", "\"a\nb\"", std::string(600, '['),
+        };
+        for (const std::string& text : invalid) {
+            ASSERT_THROWS(json::DocumentView::Parse(text), json::ParsingError);
+        }
+        try {
+            json::DocumentView::Parse("{\n  \"a\": [1,\n  ]\n}");
+            ASSERT(false);
+        } catch (const json::ParsingError& e) {
+            ASSERT_EQUAL(std::string(e.what()), "Unexpected character ']' at line 3, column 3");
+        }
+
+        // Число вне диапазона double не превращается в 0, как и в json::Load
+        for (const std::string text : { "1e400", "-1e400", "[1, 1e-400]" }) {
+            ASSERT_THROWS(json::DocumentView::Parse(text), json::ParsingError);
+            std::stringstream ss(text);
+            ASSERT_THROWS(json::Load(ss), json::ParsingError);
+        }
+        try {
+            json::DocumentView::Parse("[0,\n 1e400]");
+            ASSERT(false);
+        } catch (const json::ParsingError& e) {
+            ASSERT(std::string(e.what()).starts_with("Number is out of range"));
+        }
+        ASSERT_EQUAL(json::DocumentView::Parse("1.7e308").GetRoot().AsDouble(), 1.7e308);
+    }
+
+    {
+        // Оба парсера видят один и тот же конфиг
+        const std::string text = R"({"width": 12, "height": 7, "background_char": "\"", "plotter_type": "grayscale",
+            "palette": " .:-=+*#%@", "threads": 3, "unused": [{"x": [1, 2]}, "tail"]})";
+        std::stringstream ss(text);
+        const PlotterConfig from_stream = Config::LoadFromString(ss);
+        const PlotterConfig from_view = Config::LoadFromString(std::string_view(text));
+        ASSERT_EQUAL(from_view.width, 12);
+        ASSERT_EQUAL(from_view.background_char, '"');
+        ASSERT_EQUAL(from_view.threads, 3);
+        ASSERT_EQUAL(from_view.plotter_type, from_stream.plotter_type);
+        ASSERT(from_view.palette == from_stream.palette);
+
+        const std::string path = "json_view_test.json";
+        {
+            std::ofstream out(path);
+            out << text;
+        }
+        const PlotterConfig from_file = Config::LoadFromFile(path);
+        std::remove(path.c_str());
+        ASSERT_EQUAL(from_file.height, 7);
+        ASSERT(from_file.palette == from_view.palette);
+        ASSERT_THROWS(Config::LoadFromFile("missing_config.json"), std::runtime_error);
+    }
+}
+
+void TestScene() {
+    const auto same_canvas = [](const Canvas& lhs, const Canvas& rhs) {
+        return lhs.Size() == rhs.Size() && std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data());
+    };
+
+    {
+        const std::string text = R"({
+            "name": "test scene",
+            "config": {"width": 12, "height": 6, "background_char": ".", "plotter_type": "grayscale", "palette": " .:-=+*#%@"},
+            "commands": [
+                {"op": "rect", "x1": 0, "y1": 0, "x2": 11, "y2": 5, "brush": "#"},
+                {"op": "line", "x1": 1, "y1": 1, "x2": 10, "y2": 4, "brightness": 0.5},
+                {"op": "circle", "x": 5, "y": 3, "radius": 2, "fill": true, "brightness": 1.0, "dither": "ordered"},
+                {"op": "scanline_fill", "x": 10, "y": 1, "brush": "+"},
+                {"op": "filter", "name": "invert"}
+            ]
+        })";
+        const auto plotter = Scene::Load(text);
+        ASSERT(dynamic_cast<GrayscalePlotter*>(plotter.get()) != nullptr);
+
+        GrayscalePlotter expected(12, 6, '.', { ' ', '.', ':', '-', '=', '+', '*', '#', '%', '@' });
+        expected.Plotter::DrawRectangle(0, 0, 11, 5, '#');
+        expected.DrawLine(1, 1, 10, 4, 0.5);
+        expected.DrawCircle(5, 3, 2, 1.0, true, Dither::Ordered);
+        expected.Plotter::ScanlineFill(10, 1, '+');
+        expected.InvertBrightness();
+        ASSERT(same_canvas(std::as_const(*plotter).GetCanvas(), std::as_const(expected).GetCanvas()));
+
+        // Готовый plotter: раздел "config" не создает новый
+        GrayscalePlotter target(12, 6, '.', { ' ', '.', ':', '-', '=', '+', '*', '#', '%', '@' });
+        ASSERT_EQUAL(Scene::Execute(text, target), 5u);
+        ASSERT(same_canvas(std::as_const(target).GetCanvas(), std::as_const(expected).GetCanvas()));
+
+        // Файл читается так же, как строка
+        const std::string path = "scene_test.json";
+        {
+            std::ofstream out(path);
+            out << text;
+        }
+        const auto from_file = Scene::LoadFile(path);
+        std::remove(path.c_str());
+        ASSERT(same_canvas(std::as_const(*from_file).GetCanvas(), std::as_const(expected).GetCanvas()));
+    }
+
+    {
+        // Без раздела "config" — конфиг по умолчанию
+        const auto plotter = Scene::Load(R"({"commands": [{"op": "line", "x1": 0, "y1": 0, "x2": 3, "y2": 0, "brush": "*"}]})");
+        ASSERT_EQUAL(std::as_const(*plotter).GetCanvas().Width(), Config::DefaultConfig().width);
+        ASSERT_EQUAL(std::as_const(*plotter).GetCanvas()(3, 0), '*');
+        ASSERT_EQUAL(Scene::Load("{}")->GetCanvas().Height(), Config::DefaultConfig().height);
+    }
+
+    {
+        // Execute не строит plotter по разделу "config", поэтому неполный раздел допустим
+        const std::string text =
+            R"({"config": {"width": 10}, "commands": [{"op": "line", "x1": 0, "y1": 0, "x2": 3, "y2": 0, "brush": "*"}]})";
+        Plotter plotter(8, 4, ' ');
+        ASSERT_EQUAL(Scene::Execute(text, plotter), 1u);
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas().Width(), 8);
+        ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(3, 0), '*');
+
+        const std::string path = "scene_partial_config_test.json";
+        {
+            std::ofstream out(path);
+            out << text;
+        }
+        Plotter from_file(8, 4, ' ');
+        ASSERT_EQUAL(Scene::ExecuteFile(path, from_file), 1u);
+        std::remove(path.c_str());
+        ASSERT_EQUAL(std::as_const(from_file).GetCanvas()(3, 0), '*');
+
+        // Load создает plotter по разделу, и неполный раздел — ошибка
+        ASSERT_THROWS(Scene::Load(text), ConfigParserError);
+    }
+
+    {
+        Plotter plotter(8, 4, ' ');
+        try {
+            Scene::Execute(R"({"commands": [{"op": "clear"}, {"op": "spiral"}]})", plotter);
+            ASSERT(false);
+        } catch (const SceneError& e) {
+            ASSERT_EQUAL(std::string(e.what()), "Scene command 1: unknown op 'spiral'");
+        }
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "line", "x1": 0, "y1": 0, "x2": 1, "brush": "#"}]})", plotter),
+            SceneError);
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "line", "x1": 0, "y1": 0, "x2": 1, "y2": 1.5, "brush": "#"}]})",
+            plotter), SceneError);
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "filter", "name": "invert"}]})", plotter), SceneError);
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "line", "x1": 0, "y1": 0, "x2": 1, "y2": 1, "brightness": 1}]})",
+            plotter), SceneError);
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [], "config": {}})", plotter), json::ParsingError);
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "clear"},]})", plotter), json::ParsingError);
+        ASSERT_THROWS(Scene::Execute(R"([{"op": "clear"}])", plotter), json::ParsingError);
+        ASSERT_THROWS(Scene::Load(R"({"config": {"width": 0, "height": 5, "background_char": " ", "plotter_type": "basic"}})"),
+            SceneError);
+
+        // Нулевая кисть зарезервирована для разметки пикселей и не доходит до канваса
+        ASSERT_THROWS(Scene::Execute(R"({"commands": [{"op": "rect", "x1": 0, "y1": 0, "x2": 3, "y2": 3, "brush": "\u0000"}]})",
+            plotter), SceneError);
+        ASSERT_THROWS(plotter.DrawLine(0, 0, 3, 3, '\0'), std::invalid_argument);
+        ASSERT_THROWS(plotter.DrawRectangle(0, 0, 3, 3, '\0', true), std::invalid_argument);
+        ASSERT_THROWS(plotter.DrawTriangle(0, 0, 3, 0, 0, 3, '\0'), std::invalid_argument);
+        ASSERT_THROWS(plotter.DrawCircle(3, 2, 1, '\0', CellColors{}), std::invalid_argument);
+        ASSERT_THROWS(plotter.FloodFill(0, 0, '\0'), std::invalid_argument);
+        ASSERT_THROWS(plotter.ScanlineFill(0, 0, '\0'), std::invalid_argument);
+        const Canvas& canvas = std::as_const(plotter).GetCanvas();
+        ASSERT(std::find(canvas.Data(), canvas.Data() + canvas.Size(), '\0') == canvas.Data() + canvas.Size());
+
+        // Заливка тем же символом проходит через маркер и оставляет рисунок без нулей
+        plotter.DrawRectangle(0, 0, 3, 3, '#', true);
+        plotter.FloodFill(1, 1, '#', CellColors{ Color::Indexed(1), Color{} });
+        ASSERT_EQUAL(canvas(2, 2), '#');
+        ASSERT(std::find(canvas.Data(), canvas.Data() + canvas.Size(), '\0') == canvas.Data() + canvas.Size());
+    }
+}
+
+void TestBinaryScene() {
+    const auto same_canvas = [](const Canvas& lhs, const Canvas& rhs) {
+        return lhs.Size() == rhs.Size() && std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data());
+    };
+
+    const std::string text = R"({
+        "config": {"width": 20, "height": 8, "background_char": " ", "plotter_type": "grayscale", "palette": " .:-=+*#%@", "threads": 2},
+        "commands": [
+            {"op": "linear_gradient", "x1": 0, "y1": 0, "x2": 19, "y2": 7, "start": 0.1, "end": 0.7, "dither": "ordered"},
+            {"op": "triangle", "x1": 1, "y1": 1, "x2": 15, "y2": 2, "x3": 4, "y3": 6, "fill": true, "brush": "#"},
+            {"op": "clear"},
+            {"op": "circle", "x": 10, "y": 4, "radius": 3, "brightness": 0.9, "dither": "atkinson"},
+            {"op": "filter", "name": "gaussian_blur", "size": 3},
+            {"op": "clear"},
+            {"op": "rect", "x1": 2, "y1": 1, "x2": 17, "y2": 6, "fill": true, "brightness": 0.33},
+            {"op": "filter", "name": "threshold", "value": 0.25},
+            {"op": "line", "x1": 0, "y1": 7, "x2": 19, "y2": 0, "brush": "*"}
+        ]
+    })";
+    const std::string path = "binary_scene_test.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        BinaryScene::Compile(text, out);
+    }
+
+    {
+        const BinaryScene scene(path);
+        ASSERT_EQUAL(scene.CommandCount(), 9u);
+        ASSERT_EQUAL(scene.GetConfig().width, 20);
+        ASSERT_EQUAL(scene.GetConfig().threads, 2);
+        ASSERT_EQUAL(scene.GetConfig().plotter_type, "grayscale");
+        ASSERT_EQUAL(scene.GetConfig().palette.size(), 10u);
+        ASSERT(scene.Command(3).dither == Dither::Atkinson);
+        ASSERT_EQUAL(scene.Command(3).values[0], 0.9);
+        ASSERT_EQUAL(scene.Command(8).brush, '*');
+        ASSERT_THROWS(static_cast<void>(scene.Command(9)), std::out_of_range);
+
+        // Двоичная сцена рисует то же, что текстовая
+        const auto plotter = scene.CreatePlotter();
+        scene.Execute(*plotter);
+        ASSERT(same_canvas(std::as_const(*plotter).GetCanvas(), Scene::Load(text)->GetCanvas()));
+
+        // Состояние после первых n команд совпадает с исполнением с начала
+        for (size_t end = 0; end <= scene.CommandCount(); ++end) {
+            const auto expected = scene.CreatePlotter();
+            for (size_t i = 0; i < end; ++i) {
+                Scene::ExecuteCommand(scene.Command(i), *expected);
+            }
+            const auto partial = scene.CreatePlotter();
+            scene.ExecuteUntil(*partial, end);
+            ASSERT(same_canvas(std::as_const(*partial).GetCanvas(), std::as_const(*expected).GetCanvas()));
+        }
+    }
+
+    {
+        // Поврежденный и обрезанный файлы
+        std::string bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), {});
+        }
+        const auto write = [&path](const std::string& content) {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << content;
+        };
+
+        write(bytes.substr(0, bytes.size() - 20));
+        ASSERT_THROWS(BinaryScene{ path }, BinarySceneError);
+        write(bytes.substr(0, 100));
+        ASSERT_THROWS(BinaryScene{ path }, BinarySceneError);
+        std::string corrupted = bytes;
+        corrupted[0] = 'X';
+        write(corrupted);
+        ASSERT_THROWS(BinaryScene{ path }, BinarySceneError);
+        corrupted = bytes;
+        corrupted[BinaryScene::HEADER_SIZE] = 100;
+        write(corrupted);
+        const BinaryScene scene(path);
+        const auto plotter = scene.CreatePlotter();
+        ASSERT_THROWS(scene.Execute(*plotter), BinarySceneError);
+    }
+    std::remove(path.c_str());
+
+    {
+        std::stringstream out;
+        ASSERT_THROWS(BinaryScene::Compile(R"({"commands": [{"op": "line"}]})", out), SceneError);
+        ASSERT_THROWS(BinaryScene::Compile(R"({"commands": [)", out), json::ParsingError);
+    }
+}
+
+void TestLiveScene() {
+    const auto same_canvas = [](const Canvas& lhs, const Canvas& rhs) {
+        return lhs.Size() == rhs.Size() && std::equal(lhs.Data(), lhs.Data() + lhs.Size(), rhs.Data());
+    };
+    const auto full_render = [](const PlotterConfig& config, const std::vector<SceneCommand>& commands) {
+        auto plotter = PlotterFactory::CreatePlotter(config);
+        for (const SceneCommand& command : commands) {
+            Scene::ExecuteCommand(command, *plotter);
+        }
+        return plotter;
+    };
+    const auto command = [](const std::string& json) {
+        return Scene::ParseCommand(json::DocumentView::Parse(json).GetRoot());
+    };
+
+    PlotterConfig config{ 40, 20, ' ', { ' ', '.', ':', '-', '=', '+', '*', '#', '%', '@' }, "grayscale", 1 };
+    std::vector<SceneCommand> commands{
+        command(R"({"op": "linear_gradient", "x1": 0, "y1": 0, "x2": 39, "y2": 19, "start": 0.1, "end": 0.5, "dither": "ordered"})"),
+        command(R"({"op": "rect", "x1": 3, "y1": 2, "x2": 12, "y2": 8, "fill": true, "brightness": 0.7, "dither": "ordered"})"),
+        command(R"({"op": "circle", "x": 25, "y": 10, "radius": 6, "brush": "#"})"),
+        command(R"({"op": "triangle", "x1": 30, "y1": 1, "x2": 38, "y2": 4, "x3": 33, "y3": 9, "fill": true, "brightness": 0.3})"),
+        command(R"({"op": "radial_gradient", "x": 10, "y": 15, "radius": 4, "start": 0.9, "end": 0.2, "dither": "ordered"})"),
+        command(R"({"op": "filter", "name": "invert"})"),
+        command(R"({"op": "line", "x1": 0, "y1": 19, "x2": 15, "y2": 11, "brush": "*"})"),
+    };
+    LiveScene scene(config, commands);
+    ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), full_render(config, commands)->GetCanvas()));
+
+    {
+        // Без изменений ничего не перерисовывается
+        const SceneUpdate update = scene.Update(config, commands);
+        ASSERT(!update.config.Any());
+        ASSERT_EQUAL(update.changed_commands, 0u);
+        ASSERT_EQUAL(update.RepaintedPixels(), 0);
+    }
+
+    // Правки одной команды: сдвиг фигур и смена яркости дают ту же картинку, что полная перерисовка
+    unsigned seed = 12345;
+    const auto next = [&seed](const int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int>((seed >> 16) % static_cast<unsigned>(bound));
+    };
+    for (int step = 0; step < 40; ++step) {
+        const size_t index = 1 + next(4);
+        SceneCommand& edited = commands[index];
+        const int dx = next(7) - 3;
+        const int dy = next(5) - 2;
+        edited.args[0] += dx;
+        edited.args[1] += dy;
+        if (edited.op != SceneOp::Circle && edited.op != SceneOp::RadialGradient) {
+            edited.args[2] += dx;
+            edited.args[3] += dy;
+        }
+        edited.values[0] = next(10) / 10.0;
+
+        const SceneUpdate update = scene.Update(config, commands);
+        ASSERT(update.changed_commands <= 1u);
+        ASSERT(!update.reallocated);
+        ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), full_render(config, commands)->GetCanvas()));
+    }
+    {
+        // Маленькая правка перерисовывает только свою область
+        commands[3].values[0] = commands[3].values[0] > 0.5 ? 0.2 : 0.8;
+        const SceneUpdate update = scene.Update(config, commands);
+        ASSERT(!update.full_render);
+        ASSERT(update.RepaintedPixels() < config.width * config.height);
+        ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), full_render(config, commands)->GetCanvas()));
+    }
+
+    {
+        // Окружность радиуса 0 выходит за свой радиус: сдвиг и удаление не оставляют лишних пикселей
+        std::vector<SceneCommand> dots{ command(R"({"op": "circle", "x": 5, "y": 5, "radius": 0, "brush": "#"})") };
+        LiveScene dot_scene(config, dots);
+        ASSERT(same_canvas(std::as_const(dot_scene.GetPlotter()).GetCanvas(), full_render(config, dots)->GetCanvas()));
+        dots[0].args[0] += 3;
+        dot_scene.Update(config, dots);
+        ASSERT(same_canvas(std::as_const(dot_scene.GetPlotter()).GetCanvas(), full_render(config, dots)->GetCanvas()));
+        dots.clear();
+        const SceneUpdate update = dot_scene.Update(config, dots);
+        ASSERT(!update.full_render);
+        ASSERT(same_canvas(std::as_const(dot_scene.GetPlotter()).GetCanvas(), full_render(config, dots)->GetCanvas()));
+    }
+
+    {
+        // Палитра того же размера: символы переводятся на месте
+        PlotterConfig recolored = config;
+        recolored.palette = { ' ', ',', ';', '~', 'x', 'o', 'O', 'X', '&', '$' };
+        const auto expected = full_render(config, commands);
+        dynamic_cast<GrayscalePlotter&>(*expected).SetPalette(recolored.palette);
+        const SceneUpdate update = scene.Update(recolored, commands);
+        ASSERT(update.config.palette);
+        ASSERT(update.remapped);
+        ASSERT(!update.reallocated);
+        ASSERT_EQUAL(update.RepaintedPixels(), 0);
+        ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), std::as_const(*expected).GetCanvas()));
+        config = recolored;
+    }
+
+    {
+        // Новый размер: plotter создается заново
+        PlotterConfig resized = config;
+        resized.width = 50;
+        resized.height = 12;
+        const SceneUpdate update = scene.Update(resized, commands);
+        ASSERT(update.config.size);
+        ASSERT(update.reallocated);
+        ASSERT_EQUAL(std::as_const(scene.GetPlotter()).GetCanvas().Width(), 50);
+        ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), full_render(resized, commands)->GetCanvas()));
+        config = resized;
+    }
+
+    {
+        // Заливка зависит от соседних пикселей: сцена перерисовывается целиком
+        commands.push_back(command(R"({"op": "flood_fill", "x": 0, "y": 0, "brush": "@"})"));
+        scene.Update(config, commands);
+        commands[2].args[0] += 2;
+        const SceneUpdate update = scene.Update(config, commands);
+        ASSERT(update.full_render);
+        ASSERT(same_canvas(std::as_const(scene.GetPlotter()).GetCanvas(), full_render(config, commands)->GetCanvas()));
+    }
+
+    {
+        // Наблюдение за файлами: сохранение сцены и конфига обновляет кадр
+        const std::filesystem::path dir = "live_scene_test";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        const std::filesystem::path scene_path = dir / "scene.json";
+        const std::filesystem::path config_path = dir / "config.json";
+        const auto write = [](const std::filesystem::path& path, const std::string& content) {
+            std::ofstream out(path, std::ios::trunc);
+            out << content;
+        };
+        const auto scene_text = [](const int x) {
+            return R"({"commands": [{"op": "rect", "x1": )" + std::to_string(x)
+                + R"(, "y1": 1, "x2": 6, "y2": 4, "fill": true, "brush": "#"}]})";
+        };
+        write(scene_path, scene_text(1));
+        write(config_path, R"({"width": 10, "height": 6, "background_char": ".", "plotter_type": "basic", "threads": 1})");
+
+        SceneWatcher watcher(scene_path, config_path);
+        ASSERT_EQUAL(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas()(1, 1), '#');
+        ASSERT(!watcher.Poll(std::chrono::milliseconds(0)));
+
+        write(scene_path, scene_text(3));
+        auto reload = watcher.Poll(std::chrono::milliseconds(1000));
+        ASSERT(reload.has_value());
+        ASSERT(!reload->error);
+        ASSERT_EQUAL(reload->update.changed_commands, 1u);
+        ASSERT_EQUAL(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas()(1, 1), '.');
+        ASSERT_EQUAL(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas()(3, 1), '#');
+
+        write(config_path, R"({"width": 12, "height": 6, "background_char": ".", "plotter_type": "basic", "threads": 1})");
+        reload = watcher.Poll(std::chrono::milliseconds(1000));
+        ASSERT(reload.has_value());
+        ASSERT(reload->update.reallocated);
+        ASSERT_EQUAL(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas().Width(), 12);
+
+        // Ошибка в файле оставляет прежний кадр
+        write(scene_path, R"({"commands": [{"op": "rect"}]})");
+        reload = watcher.Poll(std::chrono::milliseconds(1000));
+        ASSERT(reload.has_value());
+        ASSERT(reload->error.has_value());
+        ASSERT_EQUAL(std::as_const(watcher.GetScene().GetPlotter()).GetCanvas()(3, 1), '#');
+
+        std::filesystem::remove_all(dir);
+    }
+}
+
+void TestBenchmarkRegression() {
+    using namespace bench;
+    const auto near = [](const double lhs, const double rhs, const double eps) { return std::abs(lhs - rhs) < eps; };
+
+    {
+        // Таблица критических значений: U = 0 при n1 = n2 = 5, нормальное приближение дает p ~ 0.0122
+        const MannWhitneyResult separated = MannWhitneyU({ 1, 2, 3, 4, 5 }, { 6, 7, 8, 9, 10 });
+        ASSERT_EQUAL(separated.u, 0.0);
+        ASSERT(separated.z < 0.0);
+        ASSERT(near(separated.p_value, 0.0122, 1e-3));
+
+        const MannWhitneyResult reversed = MannWhitneyU({ 6, 7, 8, 9, 10 }, { 1, 2, 3, 4, 5 });
+        ASSERT_EQUAL(reversed.u, 25.0);
+        ASSERT(near(reversed.p_value, separated.p_value, 1e-12));
+
+        // Одинаковые и полностью совпадающие выборки неразличимы
+        ASSERT_EQUAL(MannWhitneyU({ 3, 3, 3 }, { 3, 3, 3 }).p_value, 1.0);
+        ASSERT(MannWhitneyU({ 1, 4, 2, 5 }, { 2, 5, 1, 4 }).p_value > 0.9);
+        ASSERT_EQUAL(MannWhitneyU({}, { 1, 2 }).p_value, 1.0);
+
+        // Наименьшее p — у полностью разделенных выборок: при 5 и 5 замерах alpha 0.01 недостижимо
+        ASSERT(near(MinimumPValue(5, 5), separated.p_value, 1e-12));
+        ASSERT(MinimumPValue(5, 5) > 0.01);
+        ASSERT(MinimumPValue(5, 30) < 0.01);
+        ASSERT(MinimumPValue(30, 30) < 1e-6);
+        ASSERT_EQUAL(MinimumPValue(0, 5), 1.0);
+    }
+
+    ASSERT_EQUAL(Percentile({ 1, 2, 3, 4 }, 50.0), 2.0);
+    ASSERT_EQUAL(Percentile({ 1, 2, 3, 4 }, 99.0), 4.0);
+    ASSERT_EQUAL(Percentile({ 7 }, 0.0), 7.0);
+
+    const auto make_result = [](const std::string& name, const double scale) {
+        BenchmarkResult result;
+        result.name = name;
+        result.params = { { "size", "10" } };
+        result.unit = "pixels";
+        for (int i = 0; i < 20; ++i) {
+            result.samples_ns.push_back(scale * (1000.0 + (i * 37) % 50));
+        }
+        std::vector<double> sorted = result.samples_ns;
+        std::sort(sorted.begin(), sorted.end());
+        result.median_ns = Percentile(sorted, 50.0);
+        return result;
+    };
+
+    {
+        const std::vector<BenchmarkResult> baseline{ make_result("same", 1.0), make_result("slow", 1.0),
+            make_result("fast", 1.0), make_result("small", 1.0), make_result("gone", 1.0) };
+        const std::vector<BenchmarkResult> current{ make_result("same", 1.0), make_result("slow", 1.3),
+            make_result("fast", 0.7), make_result("small", 1.08), make_result("added", 1.0) };
+        const auto comparisons = CompareResults(baseline, current);
+        ASSERT_EQUAL(comparisons.size(), 6u);
+        ASSERT_EQUAL(comparisons[0].id, "same/size=10");
+        ASSERT(comparisons[0].verdict == Verdict::Unchanged);
+        ASSERT(comparisons[1].verdict == Verdict::Slower);
+        ASSERT(near(comparisons[1].delta, 0.3, 1e-9));
+        ASSERT(comparisons[1].p_value < 0.01);
+        ASSERT(comparisons[2].verdict == Verdict::Faster);
+        // Значимо, но меньше порога
+        ASSERT(comparisons[3].p_value < 0.01);
+        ASSERT(comparisons[3].verdict == Verdict::Unchanged);
+        ASSERT(comparisons[4].verdict == Verdict::New);
+        ASSERT_EQUAL(comparisons[5].id, "gone/size=10");
+        ASSERT(comparisons[5].verdict == Verdict::Missing);
+        ASSERT(HasRegressions(comparisons));
+        ASSERT(!HasRegressions(CompareResults(baseline, baseline)));
+
+        std::ostringstream table;
+        PrintDeltaTable(table, comparisons);
+        ASSERT(table.str().find("slow/size=10") != std::string::npos);
+        ASSERT(table.str().find("SLOWER") != std::string::npos);
+        ASSERT(table.str().find("+30.0%") != std::string::npos);
+        ASSERT(table.str().find("1 slower, 1 faster, 2 unchanged, 1 new, 1 missing") != std::string::npos);
+    }
+
+    {
+        // Отчет BenchmarkSuite читается обратно с теми же Id и замерами
+        BenchmarkSuite suite("test", { std::chrono::milliseconds(1), 5, std::chrono::milliseconds(1) });
+        suite.SetFilter("keep");
+        int counter = 0;
+        ASSERT(suite.Run("keep", { { "b", "2" }, { "a", "1" } }, "items", 10.0, [&counter]() { DoNotOptimize(++counter); }));
+        ASSERT(!suite.Run("skip", {}, "items", 1.0, [&counter]() { ++counter; }));
+        ASSERT_EQUAL(suite.Results().size(), 1u);
+        const BenchmarkResult& result = suite.Results().front();
+        ASSERT_EQUAL(result.samples_ns.size(), 5u);
+        ASSERT(result.warmup_iterations > 0);
+        ASSERT(result.min_ns <= result.median_ns && result.median_ns <= result.p99_ns && result.p99_ns <= result.max_ns);
+
+        const std::string path = "benchmark_report_test.json";
+        {
+            std::ofstream out(path);
+            suite.WriteJson(out);
+        }
+        const auto loaded = LoadResults(path);
+        std::remove(path.c_str());
+        ASSERT_EQUAL(loaded.size(), 1u);
+        ASSERT_EQUAL(loaded[0].Id(), "keep/b=2/a=1");
+        ASSERT_EQUAL(loaded[0].unit, "items");
+        ASSERT_EQUAL(loaded[0].samples_ns.size(), 5u);
+        ASSERT(near(loaded[0].median_ns, result.median_ns, result.median_ns * 1e-5));
+
+        {
+            std::ofstream out(path);
+            out << R"({"benchmarks": [{"id": "x"}]})";
+        }
+        ASSERT_THROWS(LoadResults(path), std::runtime_error);
+        std::remove(path.c_str());
+    }
+}
+
+void TestProfiling() {
+    namespace profiling = plotter::profiling;
+    profiling::Reset();
+    if constexpr (!profiling::ENABLED)
+    {
+        // Выключенные макросы не регистрируют зондов, снимок пуст
+        Plotter plotter(20, 10, ' ');
+        plotter.DrawRectangle(0, 0, 19, 9, '#');
+        plotter.ScanlineFill(5, 5, '.');
+        const profiling::Snapshot snapshot = profiling::TakeSnapshot();
+        ASSERT(snapshot.timers.empty());
+        ASSERT(snapshot.counters.empty());
+        ASSERT(snapshot.maxima.empty());
+        return;
+    }
+
+    {
+        Plotter plotter(20, 10, ' ');
+        plotter.DrawRectangle(0, 0, 19, 9, '#');
+        plotter.ScanlineFill(5, 5, '.');
+
+        const profiling::Snapshot snapshot = profiling::TakeSnapshot();
+        ASSERT_EQUAL(snapshot.timers.at("Plotter::DrawRectangle").calls, 1u);
+        // Контур рисуется четырьмя линиями, время прямоугольника включает их время
+        ASSERT_EQUAL(snapshot.timers.at("Plotter::DrawLine").calls, 4u);
+        ASSERT(snapshot.timers.at("Plotter::DrawRectangle").total_ns >= snapshot.timers.at("Plotter::DrawLine").total_ns);
+        ASSERT_EQUAL(snapshot.timers.at("Plotter::ScanlineFill").calls, 1u);
+        // 60 пикселей контура с повторно закрашенными углами и 18 * 8 внутри
+        ASSERT_EQUAL(snapshot.counters.at("pixels_written"), 60u + 18u * 8u);
+        ASSERT_EQUAL(snapshot.counters.at("spans_emitted"), 8u);
+        ASSERT(snapshot.maxima.at("scanline_fill.stack_high_water") > 0u);
+        ASSERT(!snapshot.timers.contains("Plotter::FloodFill"));
+
+        std::ostringstream table;
+        profiling::PrintSnapshot(table, snapshot);
+        ASSERT(table.str().find("Plotter::ScanlineFill") != std::string::npos);
+        ASSERT(table.str().find("pixels_written") != std::string::npos);
+    }
+
+    {
+        // Значения завершившегося потока сохраняются и складываются с остальными
+        Canvas canvas(4, 4, ' ');
+        std::thread worker([&canvas]() { canvas.FillRegion(0, 0, 2, 2, '#'); });
+        worker.join();
+        canvas.FillRegion(0, 0, 3, 0, '+');
+        ASSERT_EQUAL(profiling::TakeSnapshot().counters.at("pixels_written"), 60u + 18u * 8u + 9u + 4u);
+    }
+
+    profiling::Reset();
+    ASSERT(profiling::TakeSnapshot().counters.empty());
+}
+
+void TestSetPalette() {
+    GrayscalePlotter plotter(4, 1, ' ');
+    plotter.GetCanvas()(0, 0) = '@';
+    plotter.GetCanvas()(1, 0) = '=';
+    plotter.GetCanvas()(2, 0) = '*';
+    plotter.GetCanvas()(3, 0) = 'x';
+
+    plotter.SetPalette({ ' ', '+', '#' });
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '#');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(1, 0), ' ');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(2, 0), '+');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(3, 0), ' ');
+
+    plotter.SetPalette({ '0', '1' });
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '1');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(2, 0), '0');
+
+    ASSERT_THROWS(plotter.SetPalette({ '0' }), std::invalid_argument);
+    // Нулевой символ палитры стал бы маркером примитива
+    ASSERT_THROWS(plotter.SetPalette({ ' ', '\0', '#' }), std::invalid_argument);
+    ASSERT_THROWS(GrayscalePlotter(4, 1, ' ', { '\0', '#' }), std::invalid_argument);
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), '1');
+}
+
+void TestBrightnessView() {
+    GrayscalePlotter plotter(6, 4, ' ', { ' ', '+', '#' });
+    plotter.DrawRectangle(2, 1, 4, 2, 1.0, true);
+    plotter.GetCanvas()(0, 3) = '+';
+
+    const auto matrix = plotter.GetBrightnessMatrix();
+    const BrightnessView view = plotter.GetBrightnessView();
+    ASSERT_EQUAL(view.Width(), 6);
+    ASSERT_EQUAL(view.Height(), 4);
+    ASSERT(!view.IsLevelView());
+    for (int y = 0; y < view.Height(); ++y)
+    {
+        for (int x = 0; x < view.Width(); ++x)
+        {
+            ASSERT_EQUAL(view(x, y), matrix[y][x]);
+        }
+    }
+
+    const BrightnessView sub = view.Subview(2, 1, 3, 2);
+    ASSERT_EQUAL(sub(0, 0), 1.0);
+    ASSERT_EQUAL(sub.Stride(), 6u);
+    ASSERT_THROWS(static_cast<void>(view.Subview(4, 0, 3, 1)), std::out_of_range);
+    ASSERT_THROWS(static_cast<void>(view.at(6, 0)), std::out_of_range);
+
+    std::vector<float> floats(8 * 4, -1.0f);
+    plotter.ExportBrightness(floats.data(), 8);
+    ASSERT_EQUAL(floats[1 * 8 + 2], 1.0f);
+    ASSERT_EQUAL(floats[3 * 8 + 0], 0.5f);
+    ASSERT_EQUAL(floats[0 * 8 + 6], -1.0f);
+
+    std::vector<std::uint8_t> levels(6 * 4);
+    plotter.ExportBrightness(levels.data(), 6);
+    ASSERT_EQUAL(static_cast<int>(levels[3 * 6]), 128);
+
+    plotter.EnableBrightnessPlane();
+    plotter.InvertBrightness();
+    ASSERT(plotter.GetBrightnessView().IsLevelView());
+    ASSERT_EQUAL(plotter.GetBrightnessView()(2, 1), 0.0);
+}
+
+void TestBrightnessPlane() {
+    auto snapshot = [](const GrayscalePlotter& plotter)
+    {
+        std::ostringstream os;
+        plotter.Render(os);
+        return os.str();
+    };
+
+    GrayscalePlotter plotter(30, 20, ' ');
+    plotter.DrawLinearGradient(0, 0, 29, 19, 0.0, 1.0);
+    plotter.DrawCircle(10, 10, 5, 0.9, true);
+    const auto original = snapshot(plotter);
+
+    plotter.EnableBrightnessPlane();
+    ASSERT(plotter.HasBrightnessPlane());
+    ASSERT_EQUAL(snapshot(plotter), original);
+
+    // Смена палитры не теряет яркость
+    plotter.SetPalette({ ' ', '+', '#' });
+    ASSERT(snapshot(plotter) != original);
+    plotter.SetPalette(GrayscalePlotter::DefaultPalette());
+    ASSERT_EQUAL(snapshot(plotter), original);
+
+    // Рисование и запись в канвас в обход слоя
+    plotter.DrawRectangle(20, 2, 25, 6, 1.0, true);
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(22, 4), '@');
+    plotter.GetCanvas()(0, 0) = '@';
+    plotter.InvertBrightness();
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(0, 0), ' ');
+    ASSERT_EQUAL(std::as_const(plotter).GetCanvas()(22, 4), ' ');
+
+    {
+        // Неконстантный доступ к канвасу не огрубляет яркость пикселей, символы которых не менялись
+        GrayscalePlotter fine(30, 20, ' ');
+        fine.EnableBrightnessPlane();
+        fine.DrawLinearGradient(0, 0, 29, 19, 0.0, 1.0);
+        std::vector<std::uint8_t> before(30 * 20);
+        fine.ExportBrightness(before.data(), 30);
+        fine.GetCanvas()(0, 0) = '@';
+        // Тождественное преобразование сверяет слой с символами
+        fine.AdjustBrightness(1.0);
+        std::vector<std::uint8_t> after(30 * 20);
+        fine.ExportBrightness(after.data(), 30);
+        ASSERT(after[0] > 200);
+        ASSERT(std::equal(before.begin() + 1, before.end(), after.begin() + 1));
+
+        // Символы из слоя пересчитываются один раз при одновременном константном чтении
+        fine.DrawLinearGradient(0, 0, 29, 19, 1.0, 0.0);
+        std::string first;
+        std::string second;
+        std::thread reader([&snapshot, &fine, &first]() { first = snapshot(fine); });
+        second = snapshot(fine);
+        reader.join();
+        ASSERT_EQUAL(first, second);
+    }
+
+    // Цепочка в режиме слоя совпадает с прямыми вызовами
+    GrayscalePlotter direct(30, 20, ' ');
+    GrayscalePlotter fused(30, 20, ' ');
+    for (GrayscalePlotter* p : { &direct, &fused })
+    {
+        p->DrawLinearGradient(0, 0, 29, 19, 0.0, 1.0);
+        p->EnableBrightnessPlane();
+    }
+    direct.AdjustBrightness(1.3);
+    direct.ApplyGaussianBlur(3);
+    direct.ApplyGaussianBlur(3);
+    direct.InvertBrightness();
+    fused.Pipeline().Scale(1.3).GaussianBlur(3).GaussianBlur(3).Invert().Apply();
+    ASSERT_EQUAL(snapshot(direct), snapshot(fused));
+
+    fused.DisableBrightnessPlane();
+    ASSERT(!fused.HasBrightnessPlane());
+    ASSERT_EQUAL(snapshot(direct), snapshot(fused));
+}
+
 void TestCanvas() {
     Canvas c(3, 2, '.');
     ASSERT_EQUAL(c.Width(), 3);
@@ -139,6 +2249,8 @@ void TestCanvas() {
     ASSERT_THROWS(Canvas(0, 1), std::invalid_argument);
     ASSERT_THROWS(Canvas(1, 0), std::invalid_argument);
     ASSERT_THROWS(Canvas(1, 1, '\0'), std::invalid_argument);
+    ASSERT_THROWS(c.Clear('\0'), std::invalid_argument);
+    ASSERT_EQUAL(c(2, 1), '.');
 
 }
 
@@ -160,6 +2272,14 @@ void TestConfigParsing() {
         ASSERT_EQUAL(cfg.background_char, '@');
         ASSERT_EQUAL(cfg.plotter_type, "grayscale");
         ASSERT_EQUAL(cfg.palette.size(), 3u);
+        ASSERT_EQUAL(cfg.threads, 1);
+    }
+
+    {
+        std::string json = R"({"width": 10, "height": 5, "background_char": " ", "plotter_type": "basic", "threads": 4})";
+        std::stringstream ss(json);
+        auto cfg = Config::LoadFromString(ss);
+        ASSERT_EQUAL(cfg.threads, 4);
     }
 
     {
@@ -234,6 +2354,30 @@ int main() {
     // RUN_TEST(tr, TestCanvas);
     // RUN_TEST(tr, TestConfigParsing);
     // RUN_TEST(tr, TestFileSystem);
+    // RUN_TEST(tr, TestParallelFilters);
+    // RUN_TEST(tr, TestPointLookupTables);
+    // RUN_TEST(tr, TestFilterPipeline);
+    // RUN_TEST(tr, TestBrightnessPlane);
+    // RUN_TEST(tr, TestSetPalette);
+    // RUN_TEST(tr, TestBrightnessView);
+    // RUN_TEST(tr, TestGradientRasterizers);
+    // RUN_TEST(tr, TestRankFilters);
+    // RUN_TEST(tr, TestDetectEdges);
+    // RUN_TEST(tr, TestContrastStretching);
+    // RUN_TEST(tr, TestCanvasStatistics);
+    // RUN_TEST(tr, TestLoadImage);
+    // RUN_TEST(tr, TestFramePipeline);
+    // RUN_TEST(tr, TestDithering);
+    // RUN_TEST(tr, TestResize);
+    // RUN_TEST(tr, TestTransformRegion);
+    // RUN_TEST(tr, TestCanvasPyramid);
+    // RUN_TEST(tr, TestCellColors);
+    // RUN_TEST(tr, TestJsonView);
+    // RUN_TEST(tr, TestScene);
+    // RUN_TEST(tr, TestBinaryScene);
+    // RUN_TEST(tr, TestLiveScene);
+    // RUN_TEST(tr, TestBenchmarkRegression);
+    // RUN_TEST(tr, TestProfiling);
 
     DemoRunner::RunAllDemos();
 }
\ No newline at end of file